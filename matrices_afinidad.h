@@ -0,0 +1,235 @@
+/*
+ * matrices_afinidad.h
+ *
+ * Fijación de hilos y procesos a CPUs según la topología de la máquina, leída de
+ * /sys/devices/system/cpu/cpu<N>/topology (paquete, núcleo y hermanos SMT) y
+ * limitada a las CPUs que permite sched_getaffinity (cgroups, taskset):
+ *
+ *   compacta  los trabajadores llenan un núcleo (todos sus hilos SMT), después el
+ *             siguiente del mismo paquete y después el siguiente paquete: comparten
+ *             L2/L3 y se comunican barato
+ *   dispersa  primero un trabajador por núcleo alternando paquetes y sólo después los
+ *             segundos hilos SMT: máximo ancho de banda y cachés por trabajador
+ *
+ * Con un_hilo_por_nucleo se descartan los hermanos SMT: nunca hay dos trabajadores
+ * en el mismo núcleo físico. El trabajador w va a la CPU cpus[w % num_cpus] del plan.
+ *
+ *   fijar_hilo          pthread_setaffinity_np sobre un hilo ya creado
+ *   fijar_proceso       sched_setaffinity (pid 0: el proceso o hilo que llama)
+ *   enlazar_hilos_openmp  enlaza los hilos OpenMP con OMP_PLACES (las CPUs del plan,
+ *                         en su orden) y OMP_PROC_BIND; libgomp enlaza así también
+ *                         los equipos anidados, cada uno dentro de los lugares de su
+ *                         hilo padre, y el hilo principal sigue la misma regla
+ *
+ * Requiere _GNU_SOURCE definido antes del primer #include del programa. Todas las
+ * funciones son static inline, como en matrices_arena.h.
+ */
+
+#ifndef MATRICES_AFINIDAD_H
+#define MATRICES_AFINIDAD_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+/* Máximo de CPUs lógicas que se consideran */
+#define AFINIDAD_MAX_CPUS 1024
+
+typedef enum {
+    AFINIDAD_NINGUNA,   /* el planificador decide, como hasta ahora */
+    AFINIDAD_COMPACTA,
+    AFINIDAD_DISPERSA
+} PoliticaAfinidad;
+
+/* Una CPU lógica y su posición en la topología */
+typedef struct {
+    int cpu;
+    int paquete;
+    int nucleo;   /* core_id dentro del paquete */
+    int smt;      /* posición entre los hermanos SMT permitidos del núcleo (0, 1, ...) */
+} CpuLogica;
+
+/* Orden de asignación de CPUs a trabajadores */
+typedef struct {
+    PoliticaAfinidad politica;
+    int un_hilo_por_nucleo;
+    int num_cpus;
+    CpuLogica cpus[AFINIDAD_MAX_CPUS];
+} PlanAfinidad;
+
+static inline const char* nombre_afinidad(PoliticaAfinidad politica) {
+    return politica == AFINIDAD_COMPACTA ? "compacta" : politica == AFINIDAD_DISPERSA ? "dispersa" : "ninguna";
+}
+
+/* Lee la política de una opción; devuelve -1 si no es válida */
+static inline int parsear_afinidad(const char* texto, PoliticaAfinidad* politica) {
+    if (strcmp(texto, "ninguna") == 0) {
+        *politica = AFINIDAD_NINGUNA;
+    } else if (strcmp(texto, "compacta") == 0) {
+        *politica = AFINIDAD_COMPACTA;
+    } else if (strcmp(texto, "dispersa") == 0) {
+        *politica = AFINIDAD_DISPERSA;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+/* Entero de un archivo de sysfs, o defecto si no se puede leer */
+static inline int leer_entero_sysfs(int cpu, const char* archivo, int defecto) {
+    char ruta[128];
+    snprintf(ruta, sizeof(ruta), "/sys/devices/system/cpu/cpu%d/topology/%s", cpu, archivo);
+    FILE* f = fopen(ruta, "r");
+    int valor = defecto;
+    if (f != NULL) {
+        if (fscanf(f, "%d", &valor) != 1) {
+            valor = defecto;
+        }
+        fclose(f);
+    }
+    return valor;
+}
+
+static inline int comparar_compacta(const void* a, const void* b) {
+    const CpuLogica *x = (const CpuLogica*)a, *y = (const CpuLogica*)b;
+    if (x->paquete != y->paquete) return x->paquete - y->paquete;
+    if (x->nucleo != y->nucleo) return x->nucleo - y->nucleo;
+    if (x->smt != y->smt) return x->smt - y->smt;
+    return x->cpu - y->cpu;
+}
+
+static inline int comparar_dispersa(const void* a, const void* b) {
+    const CpuLogica *x = (const CpuLogica*)a, *y = (const CpuLogica*)b;
+    if (x->smt != y->smt) return x->smt - y->smt;
+    if (x->nucleo != y->nucleo) return x->nucleo - y->nucleo;
+    if (x->paquete != y->paquete) return x->paquete - y->paquete;
+    return x->cpu - y->cpu;
+}
+
+/* Lee la topología de las CPUs permitidas y las ordena según la política. Sin
+ * sysfs cada CPU cuenta como un núcleo propio. Devuelve el número de CPUs del plan.
+ */
+static inline int planificar_afinidad(PlanAfinidad* plan, PoliticaAfinidad politica, int un_hilo_por_nucleo) {
+    cpu_set_t permitidas;
+    plan->politica = politica;
+    plan->un_hilo_por_nucleo = un_hilo_por_nucleo;
+    plan->num_cpus = 0;
+    if (sched_getaffinity(0, sizeof(permitidas), &permitidas) != 0) {
+        CPU_ZERO(&permitidas);
+        CPU_SET(0, &permitidas);
+    }
+    for (int cpu = 0; cpu < CPU_SETSIZE && plan->num_cpus < AFINIDAD_MAX_CPUS; cpu++) {
+        if (!CPU_ISSET(cpu, &permitidas)) {
+            continue;
+        }
+        CpuLogica* c = &plan->cpus[plan->num_cpus++];
+        c->cpu = cpu;
+        c->paquete = leer_entero_sysfs(cpu, "physical_package_id", 0);
+        c->nucleo = leer_entero_sysfs(cpu, "core_id", cpu);
+        c->smt = 0;
+    }
+
+    /* Posición SMT: cuántas CPUs permitidas del mismo núcleo tienen un número menor */
+    for (int a = 0; a < plan->num_cpus; a++) {
+        for (int b = 0; b < a; b++) {
+            if (plan->cpus[b].paquete == plan->cpus[a].paquete && plan->cpus[b].nucleo == plan->cpus[a].nucleo) {
+                plan->cpus[a].smt++;
+            }
+        }
+    }
+    if (un_hilo_por_nucleo) {
+        int quedan = 0;
+        for (int a = 0; a < plan->num_cpus; a++) {
+            if (plan->cpus[a].smt == 0) {
+                plan->cpus[quedan++] = plan->cpus[a];
+            }
+        }
+        plan->num_cpus = quedan;
+    }
+    qsort(plan->cpus, plan->num_cpus, sizeof(CpuLogica),
+          politica == AFINIDAD_DISPERSA ? comparar_dispersa : comparar_compacta);
+    return plan->num_cpus;
+}
+
+/* CPU del trabajador w, o -1 si el plan no fija nada */
+static inline int cpu_trabajador(const PlanAfinidad* plan, int w) {
+    if (plan == NULL || plan->politica == AFINIDAD_NINGUNA || plan->num_cpus == 0) {
+        return -1;
+    }
+    return plan->cpus[w % plan->num_cpus].cpu;
+}
+
+/* Fija un hilo ya creado a una CPU (cpu < 0: no hace nada) */
+static inline int fijar_hilo(pthread_t hilo, int cpu) {
+    if (cpu < 0) {
+        return 0;
+    }
+    cpu_set_t conjunto;
+    CPU_ZERO(&conjunto);
+    CPU_SET(cpu, &conjunto);
+    return pthread_setaffinity_np(hilo, sizeof(conjunto), &conjunto);
+}
+
+/* Fija un proceso (0: el que llama) a una CPU (cpu < 0: no hace nada) */
+static inline int fijar_proceso(pid_t pid, int cpu) {
+    if (cpu < 0) {
+        return 0;
+    }
+    cpu_set_t conjunto;
+    CPU_ZERO(&conjunto);
+    CPU_SET(cpu, &conjunto);
+    return sched_setaffinity(pid, sizeof(conjunto), &conjunto);
+}
+
+/* Imprime la asignación de los num_trabajadores trabajadores ("hilo", "proceso") */
+static inline void informar_afinidad(const PlanAfinidad* plan, int num_trabajadores, const char* trabajador) {
+    if (plan->politica == AFINIDAD_NINGUNA) {
+        printf("- Afinidad: ninguna (el planificador decide)\n");
+        return;
+    }
+    printf("- Afinidad %s%s: %d CPUs disponibles\n", nombre_afinidad(plan->politica),
+           plan->un_hilo_por_nucleo ? " (un trabajador por núcleo)" : "", plan->num_cpus);
+    if (num_trabajadores > plan->num_cpus) {
+        printf("  Advertencia: %d trabajadores para %d CPUs; varios comparten CPU\n", num_trabajadores, plan->num_cpus);
+    }
+    for (int w = 0; w < num_trabajadores; w++) {
+        const CpuLogica* c = &plan->cpus[w % plan->num_cpus];
+        printf("  %s %d -> CPU %d (paquete %d, núcleo %d, smt %d)\n", trabajador, w, c->cpu, c->paquete, c->nucleo,
+               c->smt);
+    }
+}
+
+#ifdef _OPENMP
+
+/* Enlaza los hilos OpenMP a las CPUs del plan. libgomp sólo lee OMP_PLACES y
+ * OMP_PROC_BIND al cargarse, así que la primera vez se ponen en el entorno y el
+ * programa se vuelve a ejecutar a sí mismo (/proc/self/exe) con los mismos argv; en
+ * esa segunda ejecución ya están y la función vuelve sin hacer nada. Si el usuario ya
+ * fijó alguna de las dos variables, se respeta. enlace es el valor de OMP_PROC_BIND:
+ * "close" pone el hilo w en la CPU w del plan; "spread" reparte los lugares entre los
+ * hilos de cada nivel para que los equipos anidados no se pisen. Llamar antes de
+ * imprimir nada o de abrir la primera región paralela.
+ */
+static inline void enlazar_hilos_openmp(const PlanAfinidad* plan, const char* enlace, char* argv[]) {
+    if (cpu_trabajador(plan, 0) < 0 || getenv("OMP_PLACES") != NULL || getenv("OMP_PROC_BIND") != NULL) {
+        return;
+    }
+    static char lugares[AFINIDAD_MAX_CPUS * 8];
+    size_t usado = 0;
+    for (int w = 0; w < plan->num_cpus; w++) {
+        usado += snprintf(lugares + usado, sizeof(lugares) - usado, "%s{%d}", w > 0 ? "," : "", plan->cpus[w].cpu);
+    }
+    setenv("OMP_PLACES", lugares, 1);
+    setenv("OMP_PROC_BIND", enlace, 1);
+    fflush(stdout);
+    execv("/proc/self/exe", argv);
+    fprintf(stderr, "No se pudo reiniciar el programa para enlazar los hilos OpenMP; siguen sin fijar\n");
+}
+
+#endif /* _OPENMP */
+
+#endif /* MATRICES_AFINIDAD_H */
@@ -0,0 +1,435 @@
+/*
+ * matrices_aproximado.h
+ *
+ * Producto aproximado C ~ A * B (A m x k, B k x n, contiguas por filas) que reduce
+ * la dimensión interior k a s << k y hace un único producto denso m x s x n con
+ * gemm_bloques_openmp:
+ *
+ *   muestreo     columnas de A y filas de B con reemplazo, con probabilidad
+ *                p_i = |A_i| |B_i| / sum_j |A_j| |B_j| y escaladas por 1/(s p_i);
+ *                los índices repetidos se suman en una sola columna
+ *   gaussiano    C = (A S)(S^T B) con S (k x s) de entradas N(0, 1/s); A S y S^T B
+ *                son a su vez productos densos
+ *   countsketch  igual, pero cada fila de S tiene un único +-1 en una columna al
+ *                azar: A S y S^T B se forman en una pasada sobre A y B
+ *
+ * Los tres son estimadores insesgados de A * B. Su error cuadrático esperado es,
+ * con N = |A B|_F:
+ *
+ *   muestreo     ((sum_i |A_i| |B_i|)^2 - N^2) / s
+ *   sketches     (|A|_F^2 |B|_F^2 + N^2) / s
+ *
+ * N se estima antes del producto con SONDAS_APROXIMADO vectores gaussianos g
+ * (E |A B g|^2 = N^2), usando los kernels tall-skinny de matrices_estrecho.h, y
+ * después se corrige con la norma del propio resultado. Con un error relativo
+ * objetivo se despeja s (y se repite con más muestras si la corrección lo pide);
+ * con un presupuesto de muestras se usa s directamente. En ambos casos se informa
+ * del error relativo estimado. Si s no abarata el producto se hace el exacto.
+ *
+ * Sólo se define al compilar con -fopenmp, como los kernels de matrices_bloques.h.
+ */
+
+#ifndef MATRICES_APROXIMADO_H
+#define MATRICES_APROXIMADO_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+typedef enum {
+    APROX_NINGUNO,      /* producto exacto */
+    APROX_MUESTREO,
+    APROX_GAUSSIANO,
+    APROX_COUNTSKETCH
+} MetodoAproximado;
+
+/* Resultado de un producto aproximado */
+typedef struct {
+    int muestras;            /* dimensión interior reducida s (k si fue exacto) */
+    int columnas_distintas;  /* con muestreo, índices distintos tras sumar repetidos */
+    int exacto;              /* s no compensaba: se hizo A * B */
+    int rondas;              /* productos reducidos hechos (más de 1 si se corrigió s) */
+    double norma_producto;   /* estimación de |A B|_F */
+    double error_estimado;   /* error relativo de Frobenius esperado */
+} InformeAproximado;
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* Vectores gaussianos con los que se estima |A B|_F antes del producto */
+#define SONDAS_APROXIMADO 16
+
+/* Productos como mucho con un error objetivo, y holgura sobre el objetivo con la
+ * que se acepta el error estimado sin repetir
+ */
+#define RONDAS_APROXIMADO 3
+#define TOLERANCIA_APROXIMADO 1.1
+
+static inline const char* nombre_aproximado(MetodoAproximado metodo) {
+    return metodo == APROX_MUESTREO ? "muestreo" : metodo == APROX_GAUSSIANO ? "gaussiano"
+         : metodo == APROX_COUNTSKETCH ? "countsketch" : "exacto";
+}
+
+/* Lee el método de una opción; devuelve -1 si no es válido */
+static inline int parsear_aproximado(const char* texto, MetodoAproximado* metodo) {
+    if (strcmp(texto, "muestreo") == 0) {
+        *metodo = APROX_MUESTREO;
+    } else if (strcmp(texto, "gaussiano") == 0) {
+        *metodo = APROX_GAUSSIANO;
+    } else if (strcmp(texto, "countsketch") == 0) {
+        *metodo = APROX_COUNTSKETCH;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+/* N(0, 1) por Box-Muller */
+static inline double normal_aleatoria(unsigned int* semilla) {
+    double u1 = (rand_r(semilla) + 1.0) / ((double)RAND_MAX + 2.0);
+    double u2 = rand_r(semilla) / ((double)RAND_MAX + 1.0);
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+/* Término de error del método: el numerador de error^2 * s sin el N^2 */
+static inline double cociente_error(MetodoAproximado metodo, double suma_normas, double frob_a, double frob_b,
+                                    double norma2) {
+    if (norma2 <= 0.0) {
+        return 0.0;
+    }
+    if (metodo == APROX_MUESTREO) {
+        double c = suma_normas * suma_normas / norma2 - 1.0;
+        return c > 0.0 ? c : 0.0;
+    }
+    return frob_a * frob_a * frob_b * frob_b / norma2 + 1.0;
+}
+
+/* Muestras para un error relativo objetivo (como mínimo 1) */
+static inline long muestras_para_error(double cociente, double error_objetivo) {
+    double s = ceil(cociente / (error_objetivo * error_objetivo));
+    return s < 1.0 ? 1 : s > 1e9 ? 1000000000L : (long)s;
+}
+
+/* Indica si el producto reducido con s muestras cuesta al menos lo que el exacto */
+static inline int aproximado_no_compensa(MetodoAproximado metodo, int m, int k, int n, long s) {
+    if (s >= k) {
+        return 1;
+    }
+    if (metodo == APROX_GAUSSIANO) {
+        return (double)m * k * s + (double)s * k * n + (double)m * s * n >= (double)m * k * n;
+    }
+    return 0;
+}
+
+#ifdef _OPENMP
+#include <omp.h>
+#include "matrices_bloques.h"
+#include "matrices_estrecho.h"
+#include "matrices_cadena.h"
+
+static inline double* reservar_aproximado(size_t elementos) {
+    double* ptr = (double*)malloc((elementos > 0 ? elementos : 1) * sizeof(double));
+    if (ptr == NULL) {
+        fprintf(stderr, "Error en la asignación de memoria para el producto aproximado\n");
+        exit(EXIT_FAILURE);
+    }
+    return ptr;
+}
+
+/* normas[i] = |A[:, i]|_2 (A m x k). Cada hilo recorre todas las filas sobre su
+ * tramo de columnas, de modo que lee segmentos contiguos y no comparte sumas.
+ */
+static inline void normas_columnas(const double* A, int m, int k, double* normas, int num_hilos) {
+    #pragma omp parallel num_threads(num_hilos)
+    {
+        int h = omp_get_thread_num(), total = omp_get_num_threads();
+        int j0 = (int)((long)k * h / total), j1 = (int)((long)k * (h + 1) / total);
+        for (int j = j0; j < j1; j++) {
+            normas[j] = 0.0;
+        }
+        for (int i = 0; i < m; i++) {
+            const double* a = A + (size_t)i * k;
+            for (int j = j0; j < j1; j++) {
+                normas[j] += a[j] * a[j];
+            }
+        }
+        for (int j = j0; j < j1; j++) {
+            normas[j] = sqrt(normas[j]);
+        }
+    }
+}
+
+/* normas[i] = |B[i, :]|_2 (B k x n) */
+static inline void normas_filas(const double* B, int k, int n, double* normas, int num_hilos) {
+    #pragma omp parallel for schedule(static) num_threads(num_hilos)
+    for (int i = 0; i < k; i++) {
+        const double* b = B + (size_t)i * n;
+        double s = 0.0;
+        for (int j = 0; j < n; j++) {
+            s += b[j] * b[j];
+        }
+        normas[i] = sqrt(s);
+    }
+}
+
+/* Estima |A B|_F como sqrt(mean_g |A (B g)|^2) con SONDAS_APROXIMADO vectores g
+ * gaussianos: dos productos tall-skinny, O((m + n) k) en lugar de O(m k n)
+ */
+static inline double estimar_norma_producto(const double* A, const double* B, int m, int k, int n,
+                                            unsigned int* semilla, int num_hilos) {
+    double* G = reservar_aproximado((size_t)n * SONDAS_APROXIMADO);
+    double* BG = reservar_aproximado((size_t)k * SONDAS_APROXIMADO);
+    double* ABG = reservar_aproximado((size_t)m * SONDAS_APROXIMADO);
+    for (size_t i = 0; i < (size_t)n * SONDAS_APROXIMADO; i++) {
+        G[i] = normal_aleatoria(semilla);
+    }
+    gemm_estrecho_openmp(B, n, G, SONDAS_APROXIMADO, BG, SONDAS_APROXIMADO, k, n, SONDAS_APROXIMADO, num_hilos);
+    gemm_estrecho_openmp(A, k, BG, SONDAS_APROXIMADO, ABG, SONDAS_APROXIMADO, m, k, SONDAS_APROXIMADO, num_hilos);
+    double suma = 0.0;
+    for (size_t i = 0; i < (size_t)m * SONDAS_APROXIMADO; i++) {
+        suma += ABG[i] * ABG[i];
+    }
+    free(G);
+    free(BG);
+    free(ABG);
+    return sqrt(suma / SONDAS_APROXIMADO);
+}
+
+/* Muestreo columna-fila: As (m x d) y Bs (d x n) con los d índices distintos de s
+ * muestras; la escala cuenta / (s p_i) va entera en la columna de A. Devuelve d.
+ */
+static inline int muestrear_columnas_filas(const double* A, const double* B, int m, int k, int n,
+                                           const double* pesos, double suma_pesos, long s, unsigned int* semilla,
+                                           double** As, double** Bs, int num_hilos) {
+    double* acumulada = reservar_aproximado(k);
+    int* cuenta = (int*)calloc(k, sizeof(int));
+    if (cuenta == NULL) {
+        fprintf(stderr, "Error en la asignación de memoria para el producto aproximado\n");
+        exit(EXIT_FAILURE);
+    }
+    double total = 0.0;
+    for (int i = 0; i < k; i++) {
+        total += pesos[i];
+        acumulada[i] = total;
+    }
+    for (long t = 0; t < s; t++) {
+        double u = rand_r(semilla) / ((double)RAND_MAX + 1.0) * total;
+        int lo = 0, hi = k - 1;
+        while (lo < hi) {
+            int medio = (lo + hi) / 2;
+            if (acumulada[medio] <= u) {
+                lo = medio + 1;
+            } else {
+                hi = medio;
+            }
+        }
+        cuenta[lo]++;
+    }
+
+    int* indices = (int*)malloc(k * sizeof(int));
+    double* escala = reservar_aproximado(k);
+    if (indices == NULL) {
+        fprintf(stderr, "Error en la asignación de memoria para el producto aproximado\n");
+        exit(EXIT_FAILURE);
+    }
+    int d = 0;
+    for (int i = 0; i < k; i++) {
+        if (cuenta[i] > 0) {
+            indices[d] = i;
+            escala[d] = cuenta[i] / (s * (pesos[i] / suma_pesos));
+            d++;
+        }
+    }
+    *As = reservar_aproximado((size_t)m * d);
+    *Bs = reservar_aproximado((size_t)d * n);
+    #pragma omp parallel num_threads(num_hilos)
+    {
+        #pragma omp for schedule(static) nowait
+        for (int i = 0; i < m; i++) {
+            const double* a = A + (size_t)i * k;
+            double* as = *As + (size_t)i * d;
+            for (int t = 0; t < d; t++) {
+                as[t] = a[indices[t]] * escala[t];
+            }
+        }
+        #pragma omp for schedule(static)
+        for (int t = 0; t < d; t++) {
+            memcpy(*Bs + (size_t)t * n, B + (size_t)indices[t] * n, n * sizeof(double));
+        }
+    }
+    free(acumulada);
+    free(cuenta);
+    free(indices);
+    free(escala);
+    return d;
+}
+
+/* CountSketch: As = A S (m x s) y Bs = S^T B (s x n) con S[i][cubeta[i]] = signo[i] */
+static inline void countsketch(const double* A, const double* B, int m, int k, int n, int s,
+                               unsigned int* semilla, double** As, double** Bs, int num_hilos) {
+    int* cubeta = (int*)malloc(k * sizeof(int));
+    double* signo = reservar_aproximado(k);
+    if (cubeta == NULL) {
+        fprintf(stderr, "Error en la asignación de memoria para el producto aproximado\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < k; i++) {
+        cubeta[i] = rand_r(semilla) % s;
+        signo[i] = (rand_r(semilla) & 1) ? 1.0 : -1.0;
+    }
+    *As = reservar_aproximado((size_t)m * s);
+    *Bs = reservar_aproximado((size_t)s * n);
+    #pragma omp parallel num_threads(num_hilos)
+    {
+        #pragma omp for schedule(static) nowait
+        for (int i = 0; i < m; i++) {
+            const double* a = A + (size_t)i * k;
+            double* as = *As + (size_t)i * s;
+            memset(as, 0, s * sizeof(double));
+            for (int p = 0; p < k; p++) {
+                as[cubeta[p]] += signo[p] * a[p];
+            }
+        }
+        /* Cada hilo acumula todas las filas de B sobre su tramo de columnas */
+        int h = omp_get_thread_num(), total = omp_get_num_threads();
+        int j0 = (int)((long)n * h / total), j1 = (int)((long)n * (h + 1) / total);
+        for (int t = 0; t < s; t++) {
+            memset(*Bs + (size_t)t * n + j0, 0, (j1 - j0) * sizeof(double));
+        }
+        for (int p = 0; p < k; p++) {
+            const double* b = B + (size_t)p * n;
+            double* bs = *Bs + (size_t)cubeta[p] * n;
+            for (int j = j0; j < j1; j++) {
+                bs[j] += signo[p] * b[j];
+            }
+        }
+    }
+    free(cubeta);
+    free(signo);
+}
+
+/* Sketch gaussiano: As = A S (m x s) y Bs = S^T B (s x n), ambos con gemm_bloques_openmp */
+static inline void sketch_gaussiano(const double* A, const double* B, int m, int k, int n, int s,
+                                    unsigned int* semilla, const ModeloCadena* modelo, double** As, double** Bs,
+                                    int num_hilos) {
+    double* St = reservar_aproximado((size_t)s * k);
+    double* S = reservar_aproximado((size_t)k * s);
+    double escala = 1.0 / sqrt((double)s);
+    for (int t = 0; t < s; t++) {
+        for (int p = 0; p < k; p++) {
+            double v = normal_aleatoria(semilla) * escala;
+            St[(size_t)t * k + p] = v;
+            S[(size_t)p * s + t] = v;
+        }
+    }
+    *As = reservar_aproximado((size_t)m * s);
+    *Bs = reservar_aproximado((size_t)s * n);
+    gemm_bloques_openmp(A, k, S, s, *As, s, m, k, s, modelo->bloques[clase_perfil(m, k, s)], num_hilos);
+    gemm_bloques_openmp(St, k, B, n, *Bs, n, s, k, n, modelo->bloques[clase_perfil(s, k, n)], num_hilos);
+    free(St);
+    free(S);
+}
+
+/* Forma As y Bs con s muestras y hace C = As * Bs; devuelve la dimensión interior usada */
+static inline int producto_reducido(const double* A, const double* B, double* C, int m, int k, int n,
+                                    MetodoAproximado metodo, long s, const double* pesos, double suma_pesos,
+                                    unsigned int* semilla, const ModeloCadena* modelo, int num_hilos) {
+    double *As, *Bs;
+    int d = (int)s;
+    if (metodo == APROX_MUESTREO) {
+        d = muestrear_columnas_filas(A, B, m, k, n, pesos, suma_pesos, s, semilla, &As, &Bs, num_hilos);
+    } else if (metodo == APROX_COUNTSKETCH) {
+        countsketch(A, B, m, k, n, d, semilla, &As, &Bs, num_hilos);
+    } else {
+        sketch_gaussiano(A, B, m, k, n, d, semilla, modelo, &As, &Bs, num_hilos);
+    }
+    gemm_bloques_openmp(As, d, Bs, n, C, n, m, d, n, modelo->bloques[clase_perfil(m, d, n)], num_hilos);
+    free(As);
+    free(Bs);
+    return d;
+}
+
+/* |A B|_F^2 despejado del resultado: E |C~|^2 = N^2 + error esperado, que es lineal
+ * en N^2. Mucho más precisa que las sondas cuando A B está dominada por pocas
+ * direcciones; si sale negativa (ruido) se usa |C~|^2.
+ */
+static inline double norma2_a_posteriori(MetodoAproximado metodo, double norma2_c, double suma_normas,
+                                         double frob_a, double frob_b, long s) {
+    double n2;
+    if (metodo == APROX_MUESTREO) {
+        if (s < 2) {
+            return norma2_c;
+        }
+        n2 = (norma2_c - suma_normas * suma_normas / s) / (1.0 - 1.0 / s);
+    } else {
+        n2 = (norma2_c - frob_a * frob_a * frob_b * frob_b / s) / (1.0 + 1.0 / s);
+    }
+    return n2 > 0.0 ? n2 : norma2_c;
+}
+
+/* C (m x n) ~ A (m x k) * B (k x n). Con error_objetivo > 0 las muestras salen de
+ * la estimación previa de |A B|_F; si el error estimado con la norma despejada del
+ * resultado supera el objetivo, se repite con más muestras (hasta RONDAS_APROXIMADO
+ * productos). Sin objetivo se usan muestras. Rellena inf.
+ */
+static inline void multiplicar_aproximado(const double* A, const double* B, double* C, int m, int k, int n,
+                                          MetodoAproximado metodo, double error_objetivo, long muestras,
+                                          unsigned int semilla, const ModeloCadena* modelo, int num_hilos,
+                                          InformeAproximado* inf) {
+    double* normas_a = reservar_aproximado(k);
+    double* normas_b = reservar_aproximado(k);
+    normas_columnas(A, m, k, normas_a, num_hilos);
+    normas_filas(B, k, n, normas_b, num_hilos);
+    double suma_normas = 0.0, frob_a = 0.0, frob_b = 0.0;
+    for (int i = 0; i < k; i++) {
+        /* Reutiliza normas_a como pesos |A_i| |B_i| del muestreo */
+        frob_a += normas_a[i] * normas_a[i];
+        frob_b += normas_b[i] * normas_b[i];
+        normas_a[i] *= normas_b[i];
+        suma_normas += normas_a[i];
+    }
+    frob_a = sqrt(frob_a);
+    frob_b = sqrt(frob_b);
+
+    memset(inf, 0, sizeof(*inf));
+    inf->norma_producto = estimar_norma_producto(A, B, m, k, n, &semilla, num_hilos);
+    double cociente = cociente_error(metodo, suma_normas, frob_a, frob_b,
+                                     inf->norma_producto * inf->norma_producto);
+    long s = error_objetivo > 0.0 ? muestras_para_error(cociente, error_objetivo) : muestras;
+
+    for (inf->rondas = 1;; inf->rondas++) {
+        if (aproximado_no_compensa(metodo, m, k, n, s) || suma_normas == 0.0) {
+            gemm_bloques_openmp(A, k, B, n, C, n, m, k, n, modelo->bloques[clase_perfil(m, k, n)], num_hilos);
+            inf->muestras = inf->columnas_distintas = k;
+            inf->exacto = 1;
+            inf->error_estimado = 0.0;
+            break;
+        }
+        inf->columnas_distintas = producto_reducido(A, B, C, m, k, n, metodo, s, normas_a, suma_normas, &semilla,
+                                                    modelo, num_hilos);
+        inf->muestras = (int)s;
+
+        double norma2_c = 0.0;
+        #pragma omp parallel for reduction(+:norma2_c) schedule(static) num_threads(num_hilos)
+        for (long i = 0; i < (long)m * n; i++) {
+            norma2_c += C[i] * C[i];
+        }
+        double norma2 = norma2_a_posteriori(metodo, norma2_c, suma_normas, frob_a, frob_b, s);
+        cociente = cociente_error(metodo, suma_normas, frob_a, frob_b, norma2);
+        inf->norma_producto = sqrt(norma2);
+        inf->error_estimado = sqrt(cociente / s);
+        if (error_objetivo <= 0.0 || inf->rondas == RONDAS_APROXIMADO
+            || inf->error_estimado <= error_objetivo * TOLERANCIA_APROXIMADO) {
+            break;
+        }
+        s = muestras_para_error(cociente, error_objetivo);
+    }
+    free(normas_a);
+    free(normas_b);
+}
+
+#endif /* _OPENMP */
+
+#endif /* MATRICES_APROXIMADO_H */
@@ -0,0 +1,140 @@
+/*
+ * matrices_arena.h
+ *
+ * Espacio de trabajo (arena) reutilizable para las multiplicaciones.
+ * La arena reserva una sola vez una región grande con mmap, alineada y con
+ * páginas grandes sugeridas al núcleo (MADV_HUGEPAGE), y entrega bloques
+ * consecutivos de ella. Liberar es simplemente volver a una marca anterior, de
+ * modo que en un bucle de larga duración no hay malloc/free ni fallos de
+ * página nuevos después de la primera iteración.
+ *
+ * Uso típico:
+ *   Arena* arena = arena_crear(64 << 20);
+ *   for (...) {
+ *       size_t marca = arena_marca(arena);
+ *       double** C = arena_matriz(arena, filas, columnas);
+ *       multiplicar_matrices_en(A, B, C, ...);
+ *       arena_restaurar(arena, marca);
+ *   }
+ *   printf("pico: %zu bytes\n", arena_pico(arena));
+ *   arena_destruir(arena);
+ *
+ * Todas las funciones son static inline para poder incluir el archivo desde cada
+ * programa sin cambiar su línea de compilación.
+ */
+
+#ifndef MATRICES_ARENA_H
+#define MATRICES_ARENA_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <sys/mman.h>
+
+/* Alineación de cada bloque entregado (línea de caché y ancho AVX-512) */
+#define ARENA_ALINEACION 64
+
+/* Tamaño de página grande al que se redondea la región */
+#define ARENA_PAGINA_GRANDE (2UL << 20)
+
+typedef struct {
+    char* base;        /* inicio de la región mapeada */
+    size_t capacidad;  /* bytes disponibles en la región */
+    size_t usado;      /* bytes entregados actualmente */
+    size_t pico;       /* máximo de usado desde la creación */
+} Arena;
+
+/* Crea una arena con al menos capacidad bytes. La memoria se compromete de forma
+ * perezosa, así que una capacidad holgada no cuesta RAM hasta que se usa.
+ * Devuelve NULL si no se pudo mapear la región.
+ */
+static inline Arena* arena_crear(size_t capacidad) {
+    Arena* arena = (Arena*)malloc(sizeof(Arena));
+    if (arena == NULL) {
+        return NULL;
+    }
+
+    /* mmap rechaza longitud 0 (p. ej. Strassen por debajo del corte): una capacidad
+     * nula también se redondea a una página grande
+     */
+    if (capacidad == 0) {
+        capacidad = 1;
+    }
+    capacidad = (capacidad + ARENA_PAGINA_GRANDE - 1) & ~(ARENA_PAGINA_GRANDE - 1);
+    void* ptr = mmap(NULL, capacidad, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED) {
+        free(arena);
+        return NULL;
+    }
+#ifdef MADV_HUGEPAGE
+    madvise(ptr, capacidad, MADV_HUGEPAGE);
+#endif
+
+    arena->base = (char*)ptr;
+    arena->capacidad = capacidad;
+    arena->usado = 0;
+    arena->pico = 0;
+    return arena;
+}
+
+/* Libera la región y la propia arena */
+static inline void arena_destruir(Arena* arena) {
+    if (arena == NULL) {
+        return;
+    }
+    munmap(arena->base, arena->capacidad);
+    free(arena);
+}
+
+/* Entrega bytes alineados a ARENA_ALINEACION, o NULL si no hay espacio */
+static inline void* arena_reservar(Arena* arena, size_t bytes) {
+    size_t inicio = (arena->usado + ARENA_ALINEACION - 1) & ~(size_t)(ARENA_ALINEACION - 1);
+    if (inicio + bytes > arena->capacidad) {
+        return NULL;
+    }
+    arena->usado = inicio + bytes;
+    if (arena->usado > arena->pico) {
+        arena->pico = arena->usado;
+    }
+    return arena->base + inicio;
+}
+
+/* Posición actual, para devolver más tarde todo lo reservado después de ella */
+static inline size_t arena_marca(const Arena* arena) {
+    return arena->usado;
+}
+
+/* Devuelve a la arena todos los bloques reservados después de la marca */
+static inline void arena_restaurar(Arena* arena, size_t marca) {
+    arena->usado = marca;
+}
+
+/* Devuelve a la arena todos los bloques (el pico se conserva) */
+static inline void arena_reiniciar(Arena* arena) {
+    arena->usado = 0;
+}
+
+/* Máximo de bytes en uso simultáneo desde la creación */
+static inline size_t arena_pico(const Arena* arena) {
+    return arena->pico;
+}
+
+/* Reserva en la arena una matriz double filas x columnas con el mismo formato que
+ * reservar_matriz: datos contiguos en matriz[0] y matriz[i] apuntando a cada fila.
+ * No se libera con liberar_matriz sino restaurando la arena.
+ */
+static inline double** arena_matriz(Arena* arena, int filas, int columnas) {
+    double** matriz = (double**)arena_reservar(arena, filas * sizeof(double*));
+    double* datos = (double*)arena_reservar(arena, (size_t)filas * columnas * sizeof(double));
+    if (matriz == NULL || datos == NULL) {
+        fprintf(stderr, "Espacio de trabajo insuficiente para una matriz de %zu bytes\n",
+                (size_t)filas * (columnas * sizeof(double) + sizeof(double*)));
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < filas; i++) {
+        matriz[i] = datos + (size_t)i * columnas;
+    }
+    return matriz;
+}
+
+#endif /* MATRICES_ARENA_H */
@@ -0,0 +1,198 @@
+/*
+ * matrices_asincrono.c
+ *
+ * Demostración y medida de la API asíncrona de matrices_asincrono.h. Se calcula un
+ * grafo de productos n x n:
+ *
+ *   C[i] = A[i] * B[i]            para i en [0, productos)    (independientes)
+ *   D[j] = C[2j] * C[2j + 1]      para j en [0, productos/2)  (dependen de dos C)
+ *
+ * de dos maneras:
+ *
+ *   bloqueante  cada producto en su turno con gemm_bloques_openmp y todos los hilos,
+ *               como las llamadas multiplicar_matrices(...) de los demás programas
+ *   asíncrona   todos los productos se envían al ejecutor con sus dependencias; el
+ *               hilo principal queda libre mientras tanto y sólo espera al final
+ *
+ * Se informa del tiempo de cada forma, de lo que tardó el envío (lo que el llamador
+ * estuvo ocupado) y de la diferencia entre los resultados, que debe ser 0: las
+ * bandas usan el mismo kernel y el mismo orden de suma por fila.
+ *
+ * Uso:
+ *   gcc -O3 -march=native matrices_asincrono.c -o matrices_asincrono -fopenmp -pthread -lm
+ *   ./matrices_asincrono -g 64 -n 128 -h 4
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <getopt.h>
+#include <omp.h>
+#include "matrices_asincrono.h"
+
+/* Reserva un bloque de num_elementos doubles */
+double* reservar(size_t num_elementos) {
+    double* ptr = (double*)malloc(num_elementos * sizeof(double));
+    if (ptr == NULL) {
+        fprintf(stderr, "Error en la asignación de memoria\n");
+        exit(EXIT_FAILURE);
+    }
+    return ptr;
+}
+
+/* Función para mostrar ayuda */
+void mostrar_ayuda() {
+    printf("Uso: ./matrices_asincrono [-g productos] [-n dimensión] [-h hilos] [-p perfil]\n");
+    printf("Opciones:\n");
+    printf("  -g, --productos     Productos independientes A[i] * B[i] (por defecto: 64)\n");
+    printf("  -n, --tamano        Dimensión de las matrices cuadradas (por defecto: 128)\n");
+    printf("  -h, --hilos         Hilos del ejecutor y de la versión bloqueante (por defecto: 4)\n");
+    printf("  -p, --perfil        Perfil de matrices_autotune (por defecto: ~/.cache/matrices/perfil.txt)\n");
+    printf("  -a, --ayuda         Mostrar esta ayuda\n");
+}
+
+int main(int argc, char* argv[]) {
+    int productos = 64;
+    int n = 128;
+    int num_hilos = 4;
+    const char* ruta_perfil = NULL;
+
+    static struct option opciones_largas[] = {
+        {"productos", required_argument, 0, 'g'},
+        {"tamano", required_argument, 0, 'n'},
+        {"hilos", required_argument, 0, 'h'},
+        {"perfil", required_argument, 0, 'p'},
+        {"ayuda", no_argument, 0, 'a'},
+        {0, 0, 0, 0}
+    };
+
+    int opcion;
+    while ((opcion = getopt_long(argc, argv, "g:n:h:p:a", opciones_largas, NULL)) != -1) {
+        switch (opcion) {
+            case 'g':
+                productos = atoi(optarg);
+                if (productos < 2) {
+                    fprintf(stderr, "Se necesitan al menos 2 productos\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'n':
+                n = atoi(optarg);
+                if (n <= 0) {
+                    fprintf(stderr, "La dimensión de las matrices debe ser positiva\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'h':
+                num_hilos = atoi(optarg);
+                if (num_hilos <= 0) {
+                    fprintf(stderr, "El número de hilos debe ser positivo\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'p':
+                ruta_perfil = optarg;
+                break;
+            case 'a':
+                mostrar_ayuda();
+                return EXIT_SUCCESS;
+            default:
+                mostrar_ayuda();
+                return EXIT_FAILURE;
+        }
+    }
+
+    int pares = productos / 2;
+    size_t tam = (size_t)n * n;
+    double* A = reservar(productos * tam);
+    double* B = reservar(productos * tam);
+    double* C = reservar(productos * tam);
+    double* D = reservar(pares * tam);
+    double* C_ref = reservar(productos * tam);
+    double* D_ref = reservar(pares * tam);
+    srand(1234);
+    for (size_t i = 0; i < productos * tam; i++) {
+        A[i] = (double)(rand() % 10);
+        B[i] = (double)(rand() % 10);
+    }
+
+    ModeloCadena modelo;
+    cargar_modelo_cadena(ruta_perfil, &modelo);
+    Bloques bl = modelo.bloques[clase_perfil(n, n, n)];
+
+    /* Bloqueante: un producto tras otro, cada uno con todos los hilos */
+    double inicio = omp_get_wtime();
+    for (int i = 0; i < productos; i++) {
+        gemm_bloques_openmp(A + i * tam, n, B + i * tam, n, C_ref + i * tam, n, n, n, n, bl, num_hilos);
+    }
+    for (int j = 0; j < pares; j++) {
+        gemm_bloques_openmp(C_ref + 2 * j * tam, n, C_ref + (2 * j + 1) * tam, n, D_ref + j * tam, n, n, n, n, bl,
+                            num_hilos);
+    }
+    double tiempo_bloqueante = omp_get_wtime() - inicio;
+
+    /* Asíncrona: se envía todo el grafo y sólo se espera al final */
+    Ejecutor e;
+    if (ejecutor_crear(&e, num_hilos, &modelo) != 0) {
+        fprintf(stderr, "Error al crear los hilos del ejecutor\n");
+        return EXIT_FAILURE;
+    }
+    Futuro** fC = (Futuro**)malloc(productos * sizeof(Futuro*));
+    Futuro** fD = (Futuro**)malloc((pares > 0 ? pares : 1) * sizeof(Futuro*));
+    if (fC == NULL || fD == NULL) {
+        fprintf(stderr, "Error en la asignación de memoria para los futuros\n");
+        return EXIT_FAILURE;
+    }
+    inicio = omp_get_wtime();
+    for (int i = 0; i < productos; i++) {
+        fC[i] = gemm_asincrono(&e, A + i * tam, B + i * tam, C + i * tam, n, n, n, NULL, 0);
+    }
+    for (int j = 0; j < pares; j++) {
+        fD[j] = gemm_asincrono(&e, C + 2 * j * tam, C + (2 * j + 1) * tam, D + j * tam, n, n, n, &fC[2 * j], 2);
+    }
+    double tiempo_envio = omp_get_wtime() - inicio;
+    for (int j = 0; j < pares; j++) {
+        futuro_esperar(fD[j]);
+    }
+    for (int i = 0; i < productos; i++) {
+        futuro_esperar(fC[i]);
+    }
+    double tiempo_asincrono = omp_get_wtime() - inicio;
+    for (int i = 0; i < productos; i++) {
+        futuro_liberar(fC[i]);
+    }
+    for (int j = 0; j < pares; j++) {
+        futuro_liberar(fD[j]);
+    }
+    ejecutor_destruir(&e);
+
+    double max_diff = 0.0;
+    for (size_t i = 0; i < productos * tam; i++) {
+        max_diff = fmax(max_diff, fabs(C[i] - C_ref[i]));
+    }
+    for (size_t i = 0; i < pares * tam; i++) {
+        max_diff = fmax(max_diff, fabs(D[i] - D_ref[i]));
+    }
+
+    double flops = 2.0 * n * n * (double)n * (productos + pares);
+    printf("Grafo de %d productos %dx%d (%d independientes y %d que dependen de dos) con %d hilos.\n",
+           productos + pares, n, n, productos, pares, num_hilos);
+    printf("- Bloqueante (un producto tras otro): %.6f segundos, %.3f GFLOP/s\n", tiempo_bloqueante,
+           flops / tiempo_bloqueante / 1e9);
+    printf("- Asíncrona (ejecutor compartido):    %.6f segundos, %.3f GFLOP/s\n", tiempo_asincrono,
+           flops / tiempo_asincrono / 1e9);
+    printf("- Tiempo del llamador enviando el grafo: %.6f segundos\n", tiempo_envio);
+    printf("- Aceleración: %.2fx\n", tiempo_bloqueante / tiempo_asincrono);
+    printf("- Diferencia máxima entre ambas: %e\n", max_diff);
+
+    free(fC);
+    free(fD);
+    free(A);
+    free(B);
+    free(C);
+    free(D);
+    free(C_ref);
+    free(D_ref);
+    return EXIT_SUCCESS;
+}
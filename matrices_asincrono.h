@@ -0,0 +1,314 @@
+/*
+ * matrices_asincrono.h
+ *
+ * Productos C = A * B asíncronos sobre un ejecutor compartido: el conjunto de hilos
+ * de matrices_pool.h (el mismo que usa matrices_servicio), creado una vez, con su
+ * cola en modo creciente. gemm_asincrono no bloquea: devuelve un Futuro y el
+ * llamador sigue trabajando mientras el producto se calcula.
+ *
+ *   - Dependencias: un producto puede esperar a otros futuros (p. ej. porque lee su
+ *     C); no entra en la cola hasta que todos terminan, y al terminar el último sus
+ *     bandas se encolan desde el propio hilo trabajador, sin pasar por el llamador.
+ *   - Reparto: cada producto se divide en tantas bandas de filas como su trabajo
+ *     justifique (ASINCRONO_TRABAJO_BANDA multiplicaciones-suma por banda, como
+ *     mucho una por hilo). Un producto pequeño es una sola tarea y ocupa un hilo, de
+ *     modo que los productos independientes se reparten los núcleos libres en lugar
+ *     de ocupar la máquina entera por turnos; uno grande usa todos los hilos.
+ *   - Cada banda usa gemm_bloques_openmp con un hilo y los bloques del perfil.
+ *
+ * Uso:
+ *   Ejecutor e;
+ *   ejecutor_crear(&e, num_hilos, &modelo);          (modelo NULL: bloques por defecto)
+ *   Futuro* f1 = gemm_asincrono(&e, A, B, T, m, k, n, NULL, 0);
+ *   Futuro* f2 = gemm_asincrono(&e, T, D, C, m, n, p, &f1, 1);   (usa T: espera a f1)
+ *   ... otro trabajo ...
+ *   futuro_esperar(f2);
+ *   futuro_liberar(f1);
+ *   futuro_liberar(f2);
+ *   ejecutor_destruir(&e);                           (espera a lo pendiente)
+ *
+ * futuro_al_terminar registra una continuación que el hilo trabajador llama al
+ * terminar el producto; es el punto de enganche de matrices_asincrono.hpp, que
+ * ofrece co_await y std::future en C++20 sobre estas mismas funciones. Un producto
+ * cuenta como pendiente para ejecutor_esperar_todo hasta que sus continuaciones
+ * vuelven, incluidos los productos que envíen.
+ *
+ * Un futuro se libera con futuro_liberar cuando el llamador ya no lo necesita,
+ * aunque no haya terminado: el ejecutor guarda su propia referencia hasta el final.
+ * Todas las funciones son static inline, como en matrices_arena.h. Requiere
+ * -fopenmp (por gemm_bloques_openmp) y -pthread.
+ */
+
+#ifndef MATRICES_ASINCRONO_H
+#define MATRICES_ASINCRONO_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "matrices_bloques.h"
+#include "matrices_cadena.h"
+#include "matrices_pool.h"
+
+/* Multiplicaciones-suma a partir de las cuales se crea otra banda de filas */
+#define ASINCRONO_TRABAJO_BANDA (1L << 22)
+
+typedef struct Futuro Futuro;
+
+/* Continuación que se llama (fuera del cerrojo del ejecutor) al terminar un futuro */
+typedef void (*ContinuacionFuturo)(Futuro* futuro, void* arg);
+
+typedef struct {
+    ContinuacionFuturo funcion;
+    void* arg;
+} Continuacion;
+
+typedef struct Ejecutor Ejecutor;
+
+struct Futuro {
+    Ejecutor* ejecutor;
+    const double* A;
+    const double* B;
+    double* C;
+    int m, k, n;
+    Bloques bloques;
+    int bandas;                   /* tareas en que se divide el producto */
+    int bandas_pendientes;
+    int dependencias_pendientes;  /* futuros de los que depende aún sin terminar */
+    Futuro** dependientes;        /* futuros que esperan a este */
+    int num_dependientes;
+    int cap_dependientes;
+    Continuacion* continuaciones;
+    int num_continuaciones;
+    int cap_continuaciones;
+    int terminado;
+    int referencias;              /* llamador + ejecutor mientras no termina */
+    pthread_cond_t listo;
+};
+
+/* El cerrojo del ejecutor protege los futuros; se toma antes que el del conjunto de
+ * hilos (encolar_bandas encola con él tomado), nunca al revés
+ */
+struct Ejecutor {
+    PoolHilos pool;               /* cola creciente: se encola desde los trabajadores */
+    const ModeloCadena* modelo;
+    int en_vuelo;                 /* futuros enviados y aún sin terminar */
+    pthread_mutex_t mutex;
+    pthread_cond_t vacio;         /* en_vuelo llegó a 0 */
+};
+
+static inline void ejecutar_banda(void* datos, int fila_inicio, int fila_fin);
+
+/* Garantiza sitio para un elemento más en un arreglo dinámico (con el cerrojo tomado) */
+static inline void* asincrono_crecer(void* arreglo, int num, int* cap, size_t tam) {
+    if (num < *cap) {
+        return arreglo;
+    }
+    *cap = *cap > 0 ? 2 * *cap : 4;
+    arreglo = realloc(arreglo, *cap * tam);
+    if (arreglo == NULL) {
+        fprintf(stderr, "Error en la asignación de memoria del ejecutor asíncrono\n");
+        exit(EXIT_FAILURE);
+    }
+    return arreglo;
+}
+
+/* Encola las bandas de un futuro listo en el conjunto de hilos (con el cerrojo del
+ * ejecutor tomado; la cola creciente no bloquea)
+ */
+static inline void encolar_bandas(Ejecutor* e, Futuro* f) {
+    for (int b = 0; b < f->bandas; b++) {
+        TareaPool t;
+        t.funcion = ejecutar_banda;
+        t.datos = f;
+        t.inicio = (int)((long)f->m * b / f->bandas);
+        t.fin = (int)((long)f->m * (b + 1) / f->bandas);
+        pool_encolar(&e->pool, &t, 1);
+    }
+}
+
+/* Libera la memoria de un futuro sin referencias */
+static inline void destruir_futuro(Futuro* f) {
+    pthread_cond_destroy(&f->listo);
+    free(f->dependientes);
+    free(f->continuaciones);
+    free(f);
+}
+
+/* Marca un futuro como terminado, libera a sus dependientes y llama a sus
+ * continuaciones. El futuro deja de contar en en_vuelo cuando las continuaciones
+ * han vuelto, así que ejecutor_esperar_todo también espera al código que reanudan
+ * (p. ej. el resto de una corrutina) y a los productos que envíen. Se entra con el
+ * cerrojo tomado y se sale sin él.
+ */
+static inline void completar_futuro(Ejecutor* e, Futuro* f) {
+    f->terminado = 1;
+    for (int d = 0; d < f->num_dependientes; d++) {
+        Futuro* dep = f->dependientes[d];
+        if (--dep->dependencias_pendientes == 0) {
+            encolar_bandas(e, dep);
+        }
+    }
+    pthread_cond_broadcast(&f->listo);
+    pthread_mutex_unlock(&e->mutex);
+
+    /* Ya nadie añade continuaciones: futuro_al_terminar ve terminado y no registra */
+    for (int c = 0; c < f->num_continuaciones; c++) {
+        f->continuaciones[c].funcion(f, f->continuaciones[c].arg);
+    }
+
+    pthread_mutex_lock(&e->mutex);
+    if (--e->en_vuelo == 0) {
+        pthread_cond_broadcast(&e->vacio);
+    }
+    int sin_referencias = --f->referencias == 0;
+    pthread_mutex_unlock(&e->mutex);
+    if (sin_referencias) {
+        destruir_futuro(f);
+    }
+}
+
+/* Tarea del conjunto de hilos: multiplica una banda y, si era la última de su
+ * producto, completa el futuro
+ */
+static inline void ejecutar_banda(void* datos, int fila_inicio, int fila_fin) {
+    Futuro* f = (Futuro*)datos;
+    Ejecutor* e = f->ejecutor;
+    gemm_bloques_openmp(f->A + (size_t)fila_inicio * f->k, f->k, f->B, f->n,
+                        f->C + (size_t)fila_inicio * f->n, f->n, fila_fin - fila_inicio, f->k, f->n,
+                        f->bloques, 1);
+
+    pthread_mutex_lock(&e->mutex);
+    if (--f->bandas_pendientes == 0) {
+        completar_futuro(e, f);
+    } else {
+        pthread_mutex_unlock(&e->mutex);
+    }
+}
+
+/* Crea el ejecutor con num_hilos hilos; modelo (puede ser NULL) da los bloques por
+ * clase de tamaño. Devuelve 0, o -1 si no se pudieron crear los hilos.
+ */
+static inline int ejecutor_crear(Ejecutor* e, int num_hilos, const ModeloCadena* modelo) {
+    memset(e, 0, sizeof(*e));
+    e->modelo = modelo;
+    pthread_mutex_init(&e->mutex, NULL);
+    pthread_cond_init(&e->vacio, NULL);
+    return pool_iniciar(&e->pool, num_hilos, 64, POOL_CRECIENTE, 1);
+}
+
+/* Espera a que terminen todos los productos enviados y sus continuaciones. No debe
+ * llamarse desde una continuación: esperaría a su propio futuro.
+ */
+static inline void ejecutor_esperar_todo(Ejecutor* e) {
+    pthread_mutex_lock(&e->mutex);
+    while (e->en_vuelo > 0) {
+        pthread_cond_wait(&e->vacio, &e->mutex);
+    }
+    pthread_mutex_unlock(&e->mutex);
+}
+
+/* Espera a lo pendiente, detiene los hilos y libera el ejecutor */
+static inline void ejecutor_destruir(Ejecutor* e) {
+    ejecutor_esperar_todo(e);
+    pool_detener(&e->pool);
+    pthread_mutex_destroy(&e->mutex);
+    pthread_cond_destroy(&e->vacio);
+}
+
+/* Envía C (m x n) = A (m x k) * B (k x n), contiguas por filas, para cuando hayan
+ * terminado los num_dependencias futuros de dependencias. No bloquea.
+ */
+static inline Futuro* gemm_asincrono(Ejecutor* e, const double* A, const double* B, double* C, int m, int k, int n,
+                                     Futuro* const* dependencias, int num_dependencias) {
+    Futuro* f = (Futuro*)calloc(1, sizeof(Futuro));
+    if (f == NULL) {
+        fprintf(stderr, "Error en la asignación de memoria de un futuro\n");
+        exit(EXIT_FAILURE);
+    }
+    Bloques defecto = BLOQUES_POR_DEFECTO;
+    f->ejecutor = e;
+    f->A = A;
+    f->B = B;
+    f->C = C;
+    f->m = m;
+    f->k = k;
+    f->n = n;
+    f->bloques = e->modelo != NULL ? e->modelo->bloques[clase_perfil(m, k, n)] : defecto;
+    long bandas = (long)m * k * n / ASINCRONO_TRABAJO_BANDA + 1;
+    bandas = bandas < e->pool.num_hilos ? bandas : e->pool.num_hilos;
+    f->bandas = (int)(bandas < m ? bandas : m);
+    f->bandas = f->bandas > 0 ? f->bandas : 1;
+    f->bandas_pendientes = f->bandas;
+    f->referencias = 2;
+    pthread_cond_init(&f->listo, NULL);
+
+    pthread_mutex_lock(&e->mutex);
+    e->en_vuelo++;
+    for (int d = 0; d < num_dependencias; d++) {
+        Futuro* dep = dependencias[d];
+        if (dep != NULL && !dep->terminado) {
+            dep->dependientes = (Futuro**)asincrono_crecer(dep->dependientes, dep->num_dependientes,
+                                                           &dep->cap_dependientes, sizeof(Futuro*));
+            dep->dependientes[dep->num_dependientes++] = f;
+            f->dependencias_pendientes++;
+        }
+    }
+    if (f->dependencias_pendientes == 0) {
+        encolar_bandas(e, f);
+    }
+    pthread_mutex_unlock(&e->mutex);
+    return f;
+}
+
+/* Indica si el producto ya terminó (no bloquea) */
+static inline int futuro_listo(Futuro* f) {
+    pthread_mutex_lock(&f->ejecutor->mutex);
+    int listo = f->terminado;
+    pthread_mutex_unlock(&f->ejecutor->mutex);
+    return listo;
+}
+
+/* Bloquea hasta que el producto termina */
+static inline void futuro_esperar(Futuro* f) {
+    pthread_mutex_lock(&f->ejecutor->mutex);
+    while (!f->terminado) {
+        pthread_cond_wait(&f->listo, &f->ejecutor->mutex);
+    }
+    pthread_mutex_unlock(&f->ejecutor->mutex);
+}
+
+/* Registra una continuación para cuando el producto termine; la llama un hilo del
+ * ejecutor. Devuelve 0 si quedó registrada, o 1 si el futuro ya había terminado (y
+ * entonces no se llama: el llamador sigue por su cuenta).
+ */
+static inline int futuro_al_terminar(Futuro* f, ContinuacionFuturo continuacion, void* arg) {
+    pthread_mutex_lock(&f->ejecutor->mutex);
+    int terminado = f->terminado;
+    if (!terminado) {
+        f->continuaciones = (Continuacion*)asincrono_crecer(f->continuaciones, f->num_continuaciones,
+                                                            &f->cap_continuaciones, sizeof(Continuacion));
+        f->continuaciones[f->num_continuaciones].funcion = continuacion;
+        f->continuaciones[f->num_continuaciones].arg = arg;
+        f->num_continuaciones++;
+    }
+    pthread_mutex_unlock(&f->ejecutor->mutex);
+    return terminado;
+}
+
+/* Suelta la referencia del llamador; el futuro se libera cuando también ha terminado.
+ * No debe usarse después (tampoco como dependencia).
+ */
+static inline void futuro_liberar(Futuro* f) {
+    if (f == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&f->ejecutor->mutex);
+    int sin_referencias = --f->referencias == 0;
+    pthread_mutex_unlock(&f->ejecutor->mutex);
+    if (sin_referencias) {
+        destruir_futuro(f);
+    }
+}
+
+#endif /* MATRICES_ASINCRONO_H */
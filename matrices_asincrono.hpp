@@ -0,0 +1,115 @@
+/*
+ * matrices_asincrono.hpp
+ *
+ * Envoltorio C++20 de matrices_asincrono.h para aplicaciones que lanzan muchos
+ * productos y siguen trabajando mientras se calculan:
+ *
+ *   matrices::Ejecutor ejecutor(num_hilos);
+ *   auto t = matrices::gemm_async(ejecutor, A, B, T, m, k, n);
+ *   auto c = matrices::gemm_async(ejecutor, T, D, C, m, n, p, {&t});   // espera a t
+ *   co_await c;                    // dentro de una corrutina; se reanuda en un hilo
+ *                                  // del ejecutor al terminar el producto
+ *   c.futuro().wait();             // o bien un std::future<void>
+ *
+ * Resultado es un manejador con semántica de movimiento sobre un Futuro del
+ * ejecutor (lo libera al destruirse) y un awaitable: await_suspend registra la
+ * reanudación con futuro_al_terminar, y si el producto ya terminó la corrutina
+ * continúa sin suspenderse. El ejecutor y las matrices deben vivir hasta que
+ * terminen los productos que las usan.
+ *
+ * Compilar con g++ -std=c++20 -fopenmp -pthread.
+ */
+
+#ifndef MATRICES_ASINCRONO_HPP
+#define MATRICES_ASINCRONO_HPP
+
+#include <coroutine>
+#include <future>
+#include <initializer_list>
+#include <stdexcept>
+#include <vector>
+#include "matrices_asincrono.h"
+
+namespace matrices {
+
+// Ejecutor compartido: crea los hilos al construirse y espera a lo pendiente al destruirse
+class Ejecutor {
+public:
+    explicit Ejecutor(int num_hilos, const ModeloCadena* modelo = nullptr) {
+        if (ejecutor_crear(&e_, num_hilos, modelo) != 0) {
+            ejecutor_destruir(&e_);
+            throw std::runtime_error("no se pudieron crear los hilos del ejecutor");
+        }
+    }
+    ~Ejecutor() { ejecutor_destruir(&e_); }
+    Ejecutor(const Ejecutor&) = delete;
+    Ejecutor& operator=(const Ejecutor&) = delete;
+
+    ::Ejecutor* nativo() { return &e_; }
+    void esperar_todo() { ejecutor_esperar_todo(&e_); }
+
+private:
+    ::Ejecutor e_;
+};
+
+// Producto en curso: awaitable, convertible a std::future y utilizable como dependencia
+class Resultado {
+public:
+    explicit Resultado(Futuro* f) : f_(f) {}
+    Resultado(Resultado&& otro) noexcept : f_(otro.f_) { otro.f_ = nullptr; }
+    Resultado& operator=(Resultado&& otro) noexcept {
+        if (this != &otro) {
+            futuro_liberar(f_);
+            f_ = otro.f_;
+            otro.f_ = nullptr;
+        }
+        return *this;
+    }
+    Resultado(const Resultado&) = delete;
+    Resultado& operator=(const Resultado&) = delete;
+    ~Resultado() { futuro_liberar(f_); }
+
+    bool listo() const { return futuro_listo(f_); }
+    void esperar() const { futuro_esperar(f_); }
+    Futuro* nativo() const { return f_; }
+
+    // std::future que se cumple desde el hilo del ejecutor que termina el producto
+    std::future<void> futuro() const {
+        auto* promesa = new std::promise<void>();
+        std::future<void> f = promesa->get_future();
+        auto cumplir = [](Futuro*, void* arg) {
+            auto* p = static_cast<std::promise<void>*>(arg);
+            p->set_value();
+            delete p;
+        };
+        if (futuro_al_terminar(f_, cumplir, promesa) != 0) {
+            cumplir(f_, promesa);
+        }
+        return f;
+    }
+
+    bool await_ready() const { return futuro_listo(f_); }
+    bool await_suspend(std::coroutine_handle<> h) const {
+        auto reanudar = [](Futuro*, void* arg) { std::coroutine_handle<>::from_address(arg).resume(); };
+        return futuro_al_terminar(f_, reanudar, h.address()) == 0;
+    }
+    void await_resume() const {}
+
+private:
+    Futuro* f_;
+};
+
+// Envía C (m x n) = A (m x k) * B (k x n) para cuando terminen las dependencias
+inline Resultado gemm_async(Ejecutor& ejecutor, const double* A, const double* B, double* C, int m, int k, int n,
+                            std::initializer_list<const Resultado*> dependencias = {}) {
+    std::vector<Futuro*> deps;
+    deps.reserve(dependencias.size());
+    for (const Resultado* r : dependencias) {
+        deps.push_back(r->nativo());
+    }
+    return Resultado(gemm_asincrono(ejecutor.nativo(), A, B, C, m, k, n, deps.data(), (int)deps.size()));
+}
+
+}  // namespace matrices
+
+#endif /* MATRICES_ASINCRONO_HPP */
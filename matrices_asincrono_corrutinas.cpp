@@ -0,0 +1,177 @@
+/*
+ * matrices_asincrono_corrutinas.cpp
+ *
+ * Demostración y prueba del envoltorio C++20 de matrices_asincrono.hpp:
+ *
+ *   - el hilo principal envía P = A * B y espera con std::future (futuro().wait());
+ *   - una corrutina envía T = A * B y C = T * D (que depende de T), hace co_await
+ *     de C, sigue en el hilo del ejecutor que lo terminó, envía desde allí
+ *     E = C * D y hace co_await de E;
+ *   - el hilo principal llama a esperar_todo, que debe volver sólo cuando la
+ *     corrutina ha terminado, incluido el producto que envió.
+ *
+ * Cada resultado se compara con el producto i-k-j; el programa termina con error
+ * si alguno difiere o si esperar_todo vuelve antes que la corrutina. (Si C ya
+ * estuviera lista al llegar al co_await, la corrutina seguiría en el hilo principal
+ * sin suspenderse; se informa, pero no es un error.)
+ *
+ * Uso:
+ *   g++ -std=c++20 -O3 -march=native matrices_asincrono_corrutinas.cpp -o matrices_asincrono_corrutinas -fopenmp -pthread
+ *   ./matrices_asincrono_corrutinas -n 200 -h 4
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <thread>
+#include <vector>
+#include <getopt.h>
+#include "matrices_asincrono.hpp"
+
+// Corrutina que empieza al llamarla y libera su estado sola al terminar
+struct TareaSuelta {
+    struct promise_type {
+        TareaSuelta get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+// Lo que la corrutina deja para el hilo principal
+struct EstadoCorrutina {
+    std::atomic<bool> terminada{false};
+    std::thread::id hilo_reanudado;
+};
+
+// C (m x n) = A (m x k) * B (k x n) en orden i-k-j, como referencia
+static std::vector<double> producto_ikj(const std::vector<double>& A, const std::vector<double>& B, int m, int k, int n) {
+    std::vector<double> C((size_t)m * n, 0.0);
+    for (int i = 0; i < m; i++) {
+        for (int p = 0; p < k; p++) {
+            double a = A[(size_t)i * k + p];
+            for (int j = 0; j < n; j++) {
+                C[(size_t)i * n + j] += a * B[(size_t)p * n + j];
+            }
+        }
+    }
+    return C;
+}
+
+static double diferencia_maxima(const std::vector<double>& X, const std::vector<double>& Y) {
+    double max_diff = 0.0;
+    for (size_t i = 0; i < X.size(); i++) {
+        max_diff = std::fmax(max_diff, std::fabs(X[i] - Y[i]));
+    }
+    return max_diff;
+}
+
+// T = A * B, C = T * D y, ya reanudada en el ejecutor, E = C * D
+static TareaSuelta encadenar(matrices::Ejecutor& ejecutor, const std::vector<double>& A, const std::vector<double>& B,
+                             const std::vector<double>& D, std::vector<double>& T, std::vector<double>& C,
+                             std::vector<double>& E, int n, EstadoCorrutina& estado) {
+    auto t = matrices::gemm_async(ejecutor, A.data(), B.data(), T.data(), n, n, n);
+    auto c = matrices::gemm_async(ejecutor, T.data(), D.data(), C.data(), n, n, n, {&t});
+    co_await c;
+
+    // Aquí ya estamos en un hilo del ejecutor; la pausa hace visible si alguien
+    // deja de esperar a este tramo de la corrutina
+    estado.hilo_reanudado = std::this_thread::get_id();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    auto e = matrices::gemm_async(ejecutor, C.data(), D.data(), E.data(), n, n, n);
+    co_await e;
+    estado.terminada = true;
+}
+
+// Función para mostrar ayuda
+static void mostrar_ayuda() {
+    std::printf("Uso: ./matrices_asincrono_corrutinas [-n dimensión] [-h hilos]\n");
+    std::printf("Opciones:\n");
+    std::printf("  -n, --tamano        Dimensión de las matrices cuadradas (por defecto: 200)\n");
+    std::printf("  -h, --hilos         Hilos del ejecutor (por defecto: 4)\n");
+    std::printf("  -a, --ayuda         Mostrar esta ayuda\n");
+}
+
+int main(int argc, char* argv[]) {
+    int n = 200;
+    int num_hilos = 4;
+
+    static struct option opciones_largas[] = {
+        {"tamano", required_argument, 0, 'n'},
+        {"hilos", required_argument, 0, 'h'},
+        {"ayuda", no_argument, 0, 'a'},
+        {0, 0, 0, 0}
+    };
+
+    int opcion;
+    while ((opcion = getopt_long(argc, argv, "n:h:a", opciones_largas, NULL)) != -1) {
+        switch (opcion) {
+            case 'n':
+                n = std::atoi(optarg);
+                if (n <= 0) {
+                    std::fprintf(stderr, "La dimensión de las matrices debe ser positiva\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'h':
+                num_hilos = std::atoi(optarg);
+                if (num_hilos <= 0) {
+                    std::fprintf(stderr, "El número de hilos debe ser positivo\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'a':
+                mostrar_ayuda();
+                return EXIT_SUCCESS;
+            default:
+                mostrar_ayuda();
+                return EXIT_FAILURE;
+        }
+    }
+
+    size_t tam = (size_t)n * n;
+    std::vector<double> A(tam), B(tam), D(tam), P(tam), T(tam), C(tam), E(tam);
+    std::srand(1234);
+    for (size_t i = 0; i < tam; i++) {
+        A[i] = (double)(std::rand() % 10);
+        B[i] = (double)(std::rand() % 10);
+        D[i] = (double)(std::rand() % 10);
+    }
+
+    EstadoCorrutina estado;
+    bool completa;
+    {
+        matrices::Ejecutor ejecutor(num_hilos);
+
+        // std::future sobre un producto suelto
+        auto p = matrices::gemm_async(ejecutor, A.data(), B.data(), P.data(), n, n, n);
+        p.futuro().wait();
+
+        // Cadena con co_await; el hilo principal sólo espera al final
+        encadenar(ejecutor, A, B, D, T, C, E, n, estado);
+        ejecutor.esperar_todo();
+        completa = estado.terminada;
+    }
+
+    std::vector<double> ref_P = producto_ikj(A, B, n, n, n);
+    std::vector<double> ref_C = producto_ikj(ref_P, D, n, n, n);
+    std::vector<double> ref_E = producto_ikj(ref_C, D, n, n, n);
+    double dif_P = diferencia_maxima(P, ref_P);
+    double dif_C = diferencia_maxima(C, ref_C);
+    double dif_E = diferencia_maxima(E, ref_E);
+
+    std::printf("Productos %dx%d con un ejecutor de %d hilos.\n", n, n, num_hilos);
+    std::printf("- Diferencia máxima de P = A * B (std::future): %e\n", dif_P);
+    std::printf("- Diferencia máxima de C = (A * B) * D (co_await con dependencia): %e\n", dif_C);
+    std::printf("- Diferencia máxima de E = C * D (enviado desde la corrutina): %e\n", dif_E);
+    std::printf("- Corrutina reanudada en un hilo del ejecutor: %s\n",
+                estado.hilo_reanudado != std::this_thread::get_id() ? "sí" : "no");
+    std::printf("- Corrutina terminada al volver esperar_todo: %s\n", completa ? "sí" : "no");
+
+    bool correcto = completa && dif_P == 0.0 && dif_C == 0.0 && dif_E == 0.0;
+    return correcto ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,780 @@
+/*
+ * matrices_auto.c
+ *
+ * Punto de entrada único que elige el programa de multiplicación adecuado
+ * (matrices_secuencial, matrices_hilos, matrices_procesos, matrices_openmp o
+ * matrices_mpi), el número de hilos, los tamaños de bloque y el algoritmo
+ * (ingenuo, bloques o Strassen) a partir de la forma del problema.
+ *
+ * La primera vez en cada máquina se ejecuta una calibración corta:
+ *   - GFLOP/s del kernel ingenuo con B dentro y fuera de caché
+ *   - GFLOP/s del kernel por bloques
+ *   - ancho de banda de memoria (triada de STREAM)
+ *   - coste de crear y esperar un hilo y un proceso
+ *   - tamaños de caché (sysfs) y número de CPUs
+ * y se guarda en $XDG_CACHE_HOME/matrices/calibracion.txt (o ~/.cache/...), como
+ * líneas clave=valor. Si el archivo es de otra máquina (nombre, CPUs o modelo de
+ * CPU distintos) se vuelve a calibrar.
+ *
+ * Con la calibración se estima el tiempo de cada candidato con un modelo de
+ * techo (máximo entre cómputo y tráfico de memoria) más el coste de arranque de
+ * hilos o procesos, y se ejecuta el más rápido con las opciones traducidas.
+ * matrices_hilos y matrices_procesos trabajan con enteros, así que sólo son
+ * candidatos con --dtype int; MPI sólo se considera con --mpi.
+ *
+ * Si matrices_autotune dejó un perfil para esta máquina, los bloques y el
+ * rendimiento del algoritmo por bloques salen de él en lugar de la heurística, y
+ * matrices_openmp carga el resto de parámetros (unroll, orden) por su cuenta.
+ *
+ * Uso:
+ *   gcc -O2 matrices_auto.c -o matrices_auto -pthread -lm
+ *   ./matrices_auto -t 2000                 (elige y ejecuta)
+ *   ./matrices_auto -r 50 -c 50 -q 50 --plan  (sólo muestra el plan)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <getopt.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/wait.h>
+#include "matrices_perfil.h"
+
+/* Debe coincidir con CORTE_STRASSEN de matrices_strassen.h */
+#define CORTE_STRASSEN 128
+
+/* Coste de arranque de mpirun si la calibración no lo trae (segundos) */
+#define COSTO_MPI_POR_DEFECTO 0.3
+
+/* Resultados de la calibración de una máquina */
+typedef struct {
+    char maquina[256];              /* nombre|cpus|modelo de CPU */
+    int ncpu;
+    double gflops_ingenuo_pequeno;  /* i-j-k con B en caché (n = 64) */
+    double gflops_ingenuo_grande;   /* i-j-k con B fuera de L2 (n = 512) */
+    double gflops_bloques;          /* i-k-j por bloques (n = 512) */
+    double ancho_banda_gbs;         /* triada a = b + s * c */
+    double costo_hilo_us;           /* pthread_create + pthread_join */
+    double costo_proceso_us;        /* fork + waitpid */
+    double costo_mpi_s;             /* arranque de mpirun (editable en el archivo) */
+    long cache_l1;                  /* bytes de datos por núcleo */
+    long cache_l2;
+    long cache_l3;
+} Calibracion;
+
+typedef enum {
+    BACKEND_SECUENCIAL,
+    BACKEND_HILOS,
+    BACKEND_PROCESOS,
+    BACKEND_OPENMP,
+    BACKEND_MPI
+} Backend;
+
+static const char* nombres_backend[] = {
+    "matrices_secuencial", "matrices_hilos", "matrices_procesos", "matrices_openmp", "matrices_mpi"
+};
+
+/* Un candidato del plan con su estimación */
+typedef struct {
+    Backend backend;
+    int hilos;
+    const char* algoritmo;  /* ingenuo, bloques o strassen */
+    int mc, kc, nc;
+    int del_perfil;         /* bloques tomados del perfil de matrices_autotune */
+    double segundos;
+} Candidato;
+
+/* Función para obtener el tiempo actual en segundos */
+double ahora() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Función para reservar un arreglo de doubles con valores pequeños */
+double* reservar_llenar(size_t num_elementos) {
+    double* v = (double*)malloc(num_elementos * sizeof(double));
+    if (v == NULL) {
+        fprintf(stderr, "Error en la asignación de memoria para la calibración\n");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < num_elementos; i++) {
+        v[i] = (double)(i % 10);
+    }
+    return v;
+}
+
+/* Kernel ingenuo i-j-k, el mismo recorrido que los programas originales */
+void kernel_ingenuo(const double* A, const double* B, double* C, int n) {
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            double suma = 0.0;
+            for (int k = 0; k < n; k++) {
+                suma += A[i * n + k] * B[k * n + j];
+            }
+            C[i * n + j] = suma;
+        }
+    }
+}
+
+/* Kernel por bloques i-k-j, el mismo recorrido que gemm_bloques_openmp */
+void kernel_bloques(const double* A, const double* B, double* C, int n, int mc, int kc, int nc) {
+    memset(C, 0, (size_t)n * n * sizeof(double));
+    for (int ic = 0; ic < n; ic += mc) {
+        int i_fin = ic + mc < n ? ic + mc : n;
+        for (int jc = 0; jc < n; jc += nc) {
+            int j_fin = jc + nc < n ? jc + nc : n;
+            for (int pc = 0; pc < n; pc += kc) {
+                int p_fin = pc + kc < n ? pc + kc : n;
+                for (int i = ic; i < i_fin; i++) {
+                    for (int p = pc; p < p_fin; p++) {
+                        double a = A[i * n + p];
+                        for (int j = jc; j < j_fin; j++) {
+                            C[i * n + j] += a * B[p * n + j];
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+/* Mide GFLOP/s de un kernel n x n repitiendo hasta superar un tiempo mínimo */
+double medir_gflops(int n, int bloques) {
+    double* A = reservar_llenar((size_t)n * n);
+    double* B = reservar_llenar((size_t)n * n);
+    double* C = reservar_llenar((size_t)n * n);
+    int repeticiones = 0;
+    double inicio = ahora(), tiempo;
+    do {
+        if (bloques) {
+            kernel_bloques(A, B, C, n, 64, 256, 128);
+        } else {
+            kernel_ingenuo(A, B, C, n);
+        }
+        repeticiones++;
+        tiempo = ahora() - inicio;
+    } while (tiempo < 0.05);
+    /* Evita que el compilador elimine el cálculo */
+    if (C[n + 1] < 0.0) {
+        printf("%f\n", C[n + 1]);
+    }
+    free(A);
+    free(B);
+    free(C);
+    return 2.0 * n * n * n * repeticiones / tiempo / 1e9;
+}
+
+/* Triada de STREAM sobre arreglos mayores que la caché: mejor de tres pasadas, en GB/s */
+double medir_ancho_banda() {
+    size_t n = 4u << 20;
+    double* a = reservar_llenar(n);
+    double* b = reservar_llenar(n);
+    double* c = reservar_llenar(n);
+    double mejor = 1e30;
+    for (int r = 0; r < 3; r++) {
+        double inicio = ahora();
+        for (size_t i = 0; i < n; i++) {
+            a[i] = b[i] + 3.0 * c[i];
+        }
+        double t = ahora() - inicio;
+        if (t < mejor) {
+            mejor = t;
+        }
+    }
+    if (a[n / 2] < 0.0) {
+        printf("%f\n", a[n / 2]);
+    }
+    free(a);
+    free(b);
+    free(c);
+    return 3.0 * n * sizeof(double) / mejor / 1e9;
+}
+
+static void* hilo_vacio(void* arg) {
+    return arg;
+}
+
+/* Coste medio de crear y esperar un hilo, en microsegundos */
+double medir_costo_hilo() {
+    const int N = 64;
+    double inicio = ahora();
+    for (int i = 0; i < N; i++) {
+        pthread_t hilo;
+        if (pthread_create(&hilo, NULL, hilo_vacio, NULL) != 0) {
+            return 50.0;
+        }
+        pthread_join(hilo, NULL);
+    }
+    return (ahora() - inicio) / N * 1e6;
+}
+
+/* Coste medio de fork + waitpid, en microsegundos */
+double medir_costo_proceso() {
+    const int N = 16;
+    double inicio = ahora();
+    for (int i = 0; i < N; i++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            _exit(0);
+        }
+        if (pid < 0) {
+            return 500.0;
+        }
+        waitpid(pid, NULL, 0);
+    }
+    return (ahora() - inicio) / N * 1e6;
+}
+
+/* Lee un tamaño de sysfs como "48K" o "2M"; devuelve bytes o 0 */
+long leer_tamano_cache(const char* ruta) {
+    FILE* f = fopen(ruta, "r");
+    if (f == NULL) {
+        return 0;
+    }
+    long valor = 0;
+    char unidad = 0;
+    if (fscanf(f, "%ld%c", &valor, &unidad) < 1) {
+        valor = 0;
+    }
+    fclose(f);
+    if (unidad == 'K') {
+        valor <<= 10;
+    } else if (unidad == 'M') {
+        valor <<= 20;
+    }
+    return valor;
+}
+
+/* Rellena cache_l1/l2/l3 desde /sys/devices/system/cpu/cpu0/cache, con valores
+ * típicos si sysfs no está disponible
+ */
+void detectar_caches(Calibracion* cal) {
+    cal->cache_l1 = 32L << 10;
+    cal->cache_l2 = 256L << 10;
+    cal->cache_l3 = 8L << 20;
+    for (int indice = 0; indice < 8; indice++) {
+        char ruta[128], tipo[32] = "";
+        int nivel = 0;
+        snprintf(ruta, sizeof(ruta), "/sys/devices/system/cpu/cpu0/cache/index%d/level", indice);
+        FILE* f = fopen(ruta, "r");
+        if (f == NULL) {
+            break;
+        }
+        if (fscanf(f, "%d", &nivel) != 1) {
+            nivel = 0;
+        }
+        fclose(f);
+        snprintf(ruta, sizeof(ruta), "/sys/devices/system/cpu/cpu0/cache/index%d/type", indice);
+        f = fopen(ruta, "r");
+        if (f != NULL) {
+            if (fscanf(f, "%31s", tipo) != 1) {
+                tipo[0] = '\0';
+            }
+            fclose(f);
+        }
+        if (strcmp(tipo, "Instruction") == 0) {
+            continue;
+        }
+        snprintf(ruta, sizeof(ruta), "/sys/devices/system/cpu/cpu0/cache/index%d/size", indice);
+        long bytes = leer_tamano_cache(ruta);
+        if (bytes <= 0) {
+            continue;
+        }
+        if (nivel == 1) {
+            cal->cache_l1 = bytes;
+        } else if (nivel == 2) {
+            cal->cache_l2 = bytes;
+        } else if (nivel == 3) {
+            cal->cache_l3 = bytes;
+        }
+    }
+}
+
+/* Ejecuta la calibración completa (alrededor de un segundo) */
+void calibrar(Calibracion* cal) {
+    cal->ncpu = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (cal->ncpu < 1) {
+        cal->ncpu = 1;
+    }
+    identificar_maquina(cal->maquina, sizeof(cal->maquina));
+    detectar_caches(cal);
+    cal->gflops_ingenuo_pequeno = medir_gflops(64, 0);
+    cal->gflops_ingenuo_grande = medir_gflops(512, 0);
+    cal->gflops_bloques = medir_gflops(512, 1);
+    cal->ancho_banda_gbs = medir_ancho_banda();
+    cal->costo_hilo_us = medir_costo_hilo();
+    cal->costo_proceso_us = medir_costo_proceso();
+    cal->costo_mpi_s = COSTO_MPI_POR_DEFECTO;
+}
+
+/* Lee la calibración del archivo; devuelve 0 si está completa y es de esta máquina */
+int cargar_calibracion(const char* ruta, Calibracion* cal) {
+    FILE* f = fopen(ruta, "r");
+    if (f == NULL) {
+        return -1;
+    }
+    memset(cal, 0, sizeof(*cal));
+    cal->costo_mpi_s = COSTO_MPI_POR_DEFECTO;
+    char linea[512];
+    int campos = 0;
+    while (fgets(linea, sizeof(linea), f) != NULL) {
+        if (linea[0] == '#') {
+            continue;
+        }
+        char* igual = strchr(linea, '=');
+        if (igual == NULL) {
+            continue;
+        }
+        *igual = '\0';
+        char* valor = igual + 1;
+        valor[strcspn(valor, "\n")] = '\0';
+        if (strcmp(linea, "maquina") == 0) {
+            snprintf(cal->maquina, sizeof(cal->maquina), "%s", valor);
+        } else if (strcmp(linea, "ncpu") == 0) {
+            cal->ncpu = atoi(valor);
+        } else if (strcmp(linea, "gflops_ingenuo_pequeno") == 0) {
+            cal->gflops_ingenuo_pequeno = atof(valor);
+        } else if (strcmp(linea, "gflops_ingenuo_grande") == 0) {
+            cal->gflops_ingenuo_grande = atof(valor);
+        } else if (strcmp(linea, "gflops_bloques") == 0) {
+            cal->gflops_bloques = atof(valor);
+        } else if (strcmp(linea, "ancho_banda_gbs") == 0) {
+            cal->ancho_banda_gbs = atof(valor);
+        } else if (strcmp(linea, "costo_hilo_us") == 0) {
+            cal->costo_hilo_us = atof(valor);
+        } else if (strcmp(linea, "costo_proceso_us") == 0) {
+            cal->costo_proceso_us = atof(valor);
+        } else if (strcmp(linea, "costo_mpi_s") == 0) {
+            cal->costo_mpi_s = atof(valor);
+            continue;
+        } else if (strcmp(linea, "cache_l1") == 0) {
+            cal->cache_l1 = atol(valor);
+        } else if (strcmp(linea, "cache_l2") == 0) {
+            cal->cache_l2 = atol(valor);
+        } else if (strcmp(linea, "cache_l3") == 0) {
+            cal->cache_l3 = atol(valor);
+        } else {
+            continue;
+        }
+        campos++;
+    }
+    fclose(f);
+
+    char maquina[256];
+    identificar_maquina(maquina, sizeof(maquina));
+    if (campos < 11 || strcmp(maquina, cal->maquina) != 0) {
+        return -1;
+    }
+    if (cal->gflops_ingenuo_pequeno <= 0.0 || cal->gflops_ingenuo_grande <= 0.0
+        || cal->gflops_bloques <= 0.0 || cal->ancho_banda_gbs <= 0.0) {
+        return -1;
+    }
+    return 0;
+}
+
+/* Guarda la calibración como líneas clave=valor */
+int guardar_calibracion(const char* ruta, const Calibracion* cal) {
+    FILE* f = fopen(ruta, "w");
+    if (f == NULL) {
+        return -1;
+    }
+    fprintf(f, "# Calibración de matrices_auto (borrar o usar --recalibrar para repetirla)\n");
+    fprintf(f, "maquina=%s\n", cal->maquina);
+    fprintf(f, "ncpu=%d\n", cal->ncpu);
+    fprintf(f, "gflops_ingenuo_pequeno=%.4f\n", cal->gflops_ingenuo_pequeno);
+    fprintf(f, "gflops_ingenuo_grande=%.4f\n", cal->gflops_ingenuo_grande);
+    fprintf(f, "gflops_bloques=%.4f\n", cal->gflops_bloques);
+    fprintf(f, "ancho_banda_gbs=%.4f\n", cal->ancho_banda_gbs);
+    fprintf(f, "costo_hilo_us=%.3f\n", cal->costo_hilo_us);
+    fprintf(f, "costo_proceso_us=%.3f\n", cal->costo_proceso_us);
+    fprintf(f, "costo_mpi_s=%.3f\n", cal->costo_mpi_s);
+    fprintf(f, "cache_l1=%ld\n", cal->cache_l1);
+    fprintf(f, "cache_l2=%ld\n", cal->cache_l2);
+    fprintf(f, "cache_l3=%ld\n", cal->cache_l3);
+    fclose(f);
+    return 0;
+}
+
+/* GFLOP/s esperados del kernel ingenuo por hilo: el rápido si B cabe en L2 */
+double gflops_ingenuo(const Calibracion* cal, int k, int n) {
+    double bytes_B = 8.0 * k * n;
+    return bytes_B <= cal->cache_l2 ? cal->gflops_ingenuo_pequeno : cal->gflops_ingenuo_grande;
+}
+
+/* Tamaños de bloque: los del perfil si hay uno; si no, el panel kc x nc de B ocupa
+ * la mitad de L2 y cada hilo recibe al menos cuatro bloques de mc filas
+ */
+void elegir_bloques(const Calibracion* cal, const Bloques* perfil, int m, int k, int n,
+                    int hilos, Candidato* c) {
+    if (perfil != NULL) {
+        c->mc = perfil->mc;
+        c->kc = perfil->kc;
+        c->nc = perfil->nc;
+        c->del_perfil = 1;
+        return;
+    }
+    c->kc = k < 256 ? k : 256;
+    c->nc = (int)(cal->cache_l2 / 2 / (8L * c->kc)) / 16 * 16;
+    if (c->nc < 16) {
+        c->nc = 16;
+    }
+    if (c->nc > n) {
+        c->nc = n;
+    }
+    c->mc = (m / (4 * hilos)) / 8 * 8;
+    if (c->mc < 8) {
+        c->mc = 8;
+    }
+    if (c->mc > 128) {
+        c->mc = 128;
+    }
+}
+
+/* Niveles de Strassen que aplicaría matrices_openmp para m x k x n */
+int niveles_strassen(int m, int k, int n) {
+    int niveles = 0;
+    while (m >= 2 * CORTE_STRASSEN && k >= 2 * CORTE_STRASSEN && n >= 2 * CORTE_STRASSEN) {
+        m = (m + 1) / 2;
+        k = (k + 1) / 2;
+        n = (n + 1) / 2;
+        niveles++;
+    }
+    return niveles;
+}
+
+/* Estimación de techo: lo más lento entre cómputo y memoria, más el arranque */
+double estimar(const Calibracion* cal, Backend backend, const char* algoritmo,
+               int m, int k, int n, int hilos) {
+    double flops = 2.0 * m * k * n;
+    double bytes = 8.0 * ((double)m * k + (double)k * n + (double)m * n);
+    double bw = cal->ancho_banda_gbs * 1e9;
+    double arranque = hilos * cal->costo_hilo_us * 1e-6;
+    /* Más hilos que CPUs sólo añaden arranque, no cómputo */
+    int paralelos = hilos < cal->ncpu ? hilos : cal->ncpu;
+    double calculo;
+
+    if (strcmp(algoritmo, "ingenuo") == 0) {
+        calculo = flops / (gflops_ingenuo(cal, k, n) * 1e9 * paralelos);
+    } else if (strcmp(algoritmo, "bloques") == 0) {
+        calculo = flops / (cal->gflops_bloques * 1e9 * paralelos);
+    } else {
+        /* Cada nivel cambia 8 productos por 7 y añade 18 sumas de cuartos que van a memoria */
+        int niveles = niveles_strassen(m, k, n);
+        double productos = 1.0, extra = 0.0;
+        double mm = m, kk = k, nn = n;
+        for (int l = 0; l < niveles; l++) {
+            mm /= 2;
+            kk /= 2;
+            nn /= 2;
+            extra += productos * 8.0 * 3.0 * (5 * mm * kk + 5 * kk * nn + 8 * mm * nn);
+            productos *= 7.0;
+        }
+        calculo = flops * pow(7.0 / 8.0, niveles) / (cal->gflops_bloques * 1e9 * paralelos)
+                  + extra / bw;
+    }
+
+    switch (backend) {
+        case BACKEND_SECUENCIAL:
+            arranque = 0.0;
+            break;
+        case BACKEND_PROCESOS:
+            arranque = hilos * cal->costo_proceso_us * 1e-6 + bytes / bw;
+            break;
+        case BACKEND_MPI:
+            arranque = cal->costo_mpi_s + hilos * cal->costo_proceso_us * 1e-6 + 2.0 * bytes / bw;
+            break;
+        default:
+            break;
+    }
+    double memoria = bytes / bw;
+    return (calculo > memoria ? calculo : memoria) + arranque;
+}
+
+/* Recorre todos los candidatos admitidos y deja el mejor de cada backend en mejores[] */
+void planificar(const Calibracion* cal, int m, int k, int n, const char* dtype,
+                int hilos_max, int permitir_mpi, Candidato mejores[5], int validos[5]) {
+    int es_int = strcmp(dtype, "int") == 0;
+    int es_f64 = strcmp(dtype, "f64") == 0 || es_int;
+    int es_f32 = strcmp(dtype, "f32") == 0;
+    static const char* algoritmos[] = {"ingenuo", "bloques", "strassen"};
+
+    /* Con perfil, el rendimiento por hilo del algoritmo por bloques es el medido por
+     * matrices_autotune para esta clase de tamaño
+     */
+    Calibracion ajustada = *cal;
+    Bloques perfil;
+    int hilos_perfil;
+    double gflops_perfil;
+    int hay_perfil = (es_f64 || es_f32)
+        && cargar_perfil(NULL, es_f32 ? "f32" : "f64", m, k, n, &perfil, &hilos_perfil, &gflops_perfil) == 0;
+    if (hay_perfil) {
+        int usados = hilos_perfil < cal->ncpu ? hilos_perfil : cal->ncpu;
+        ajustada.gflops_bloques = gflops_perfil / usados;
+        cal = &ajustada;
+    }
+
+    for (int b = 0; b < 5; b++) {
+        validos[b] = 0;
+    }
+    for (int b = 0; b < 5; b++) {
+        Backend backend = (Backend)b;
+        if ((backend == BACKEND_HILOS || backend == BACKEND_PROCESOS) && !es_int) {
+            continue;
+        }
+        if (backend == BACKEND_MPI && !permitir_mpi) {
+            continue;
+        }
+        /* Hilos probados: 1, 2, 4, ... y hilos_max */
+        for (int h = 1; h <= hilos_max; h = (h * 2 > hilos_max && h < hilos_max) ? hilos_max : h * 2) {
+            if (backend == BACKEND_SECUENCIAL && h > 1) {
+                break;
+            }
+            /* Sólo matrices_openmp tiene los algoritmos por bloques (f64 y f32) y Strassen (f64) */
+            int num_alg = backend != BACKEND_OPENMP ? 1 : es_f64 ? 3 : es_f32 ? 2 : 1;
+            for (int a = 0; a < num_alg; a++) {
+                if (a == 2 && niveles_strassen(m, k, n) == 0) {
+                    continue;
+                }
+                Candidato c = {backend, h, algoritmos[a], 0, 0, 0, 0, 0.0};
+                elegir_bloques(cal, hay_perfil ? &perfil : NULL, m, k, n, h, &c);
+                c.segundos = estimar(cal, backend, c.algoritmo, m, k, n, h);
+                if (!validos[b] || c.segundos < mejores[b].segundos) {
+                    mejores[b] = c;
+                    validos[b] = 1;
+                }
+            }
+            if (h == hilos_max) {
+                break;
+            }
+        }
+    }
+}
+
+/* Función para mostrar ayuda */
+void mostrar_ayuda() {
+    printf("Uso: ./matrices_auto [-t tamaño | -r filasA -c columnasA -q columnasB] [-d tipo] [opciones]\n");
+    printf("Opciones:\n");
+    printf("  -t, --tamano      Tamaño de las matrices cuadradas (por defecto: 1000)\n");
+    printf("  -r, --filasA      Filas de A (y de C)\n");
+    printf("  -c, --columnasA   Columnas de A (y filas de B)\n");
+    printf("  -q, --columnasB   Columnas de B (y de C)\n");
+    printf("  -d, --dtype       f64, f32, mixed o int (por defecto: f64)\n");
+    printf("  -h, --hilos-max   Máximo de hilos o procesos (por defecto: CPUs en línea)\n");
+    printf("  -p, --imprimir    Pasar -p/-i al programa elegido\n");
+    printf("      --mpi         Considerar también matrices_mpi (lanzado con mpirun)\n");
+    printf("      --plan        Mostrar el plan sin ejecutarlo\n");
+    printf("      --cache ruta  Archivo de calibración (por defecto: ~/.cache/matrices/calibracion.txt)\n");
+    printf("      --recalibrar  Repetir la calibración aunque exista el archivo\n");
+    printf("      --dir ruta    Directorio de los programas (por defecto: el de matrices_auto)\n");
+    printf("  -a, --ayuda       Mostrar esta ayuda\n");
+}
+
+int main(int argc, char* argv[]) {
+    int filasA = 1000, columnasA = 1000, columnasB = 1000;
+    const char* dtype = "f64";
+    int hilos_max = 0;
+    int imprimir = 0;
+    int permitir_mpi = 0;
+    int solo_plan = 0;
+    int recalibrar = 0;
+    char ruta_cache[600] = "";
+    char directorio[512] = "";
+
+    static struct option opciones_largas[] = {
+        {"tamano", required_argument, 0, 't'},
+        {"filasA", required_argument, 0, 'r'},
+        {"columnasA", required_argument, 0, 'c'},
+        {"columnasB", required_argument, 0, 'q'},
+        {"dtype", required_argument, 0, 'd'},
+        {"hilos-max", required_argument, 0, 'h'},
+        {"imprimir", no_argument, 0, 'p'},
+        {"mpi", no_argument, 0, 'M'},
+        {"plan", no_argument, 0, 'P'},
+        {"cache", required_argument, 0, 'C'},
+        {"recalibrar", no_argument, 0, 'R'},
+        {"dir", required_argument, 0, 'D'},
+        {"ayuda", no_argument, 0, 'a'},
+        {0, 0, 0, 0}
+    };
+
+    int opcion;
+    while ((opcion = getopt_long(argc, argv, "t:r:c:q:d:h:pa", opciones_largas, NULL)) != -1) {
+        switch (opcion) {
+            case 't':
+            case 'r':
+            case 'c':
+            case 'q': {
+                int dim = atoi(optarg);
+                if (dim <= 0) {
+                    fprintf(stderr, "Las dimensiones de las matrices deben ser positivas\n");
+                    return EXIT_FAILURE;
+                }
+                if (opcion == 't') filasA = columnasA = columnasB = dim;
+                if (opcion == 'r') filasA = dim;
+                if (opcion == 'c') columnasA = dim;
+                if (opcion == 'q') columnasB = dim;
+                break;
+            }
+            case 'd':
+                if (strcmp(optarg, "f64") != 0 && strcmp(optarg, "f32") != 0
+                    && strcmp(optarg, "mixed") != 0 && strcmp(optarg, "int") != 0) {
+                    fprintf(stderr, "Tipo de dato no válido: %s (use f64, f32, mixed o int)\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                dtype = optarg;
+                break;
+            case 'h':
+                hilos_max = atoi(optarg);
+                if (hilos_max <= 0) {
+                    fprintf(stderr, "El número de hilos debe ser positivo\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'p':
+                imprimir = 1;
+                break;
+            case 'M':
+                permitir_mpi = 1;
+                break;
+            case 'P':
+                solo_plan = 1;
+                break;
+            case 'C':
+                snprintf(ruta_cache, sizeof(ruta_cache), "%s", optarg);
+                break;
+            case 'R':
+                recalibrar = 1;
+                break;
+            case 'D':
+                snprintf(directorio, sizeof(directorio), "%s", optarg);
+                break;
+            case 'a':
+                mostrar_ayuda();
+                return EXIT_SUCCESS;
+            default:
+                mostrar_ayuda();
+                return EXIT_FAILURE;
+        }
+    }
+
+    // Cargar la calibración o hacerla y guardarla
+    if (ruta_cache[0] == '\0') {
+        ruta_cache_matrices("calibracion.txt", ruta_cache, sizeof(ruta_cache));
+    }
+    Calibracion cal;
+    if (recalibrar || cargar_calibracion(ruta_cache, &cal) != 0) {
+        fprintf(stderr, "Calibrando esta máquina (una sola vez)...\n");
+        calibrar(&cal);
+        if (guardar_calibracion(ruta_cache, &cal) != 0) {
+            fprintf(stderr, "Aviso: no se pudo guardar la calibración en %s: %s\n",
+                    ruta_cache, strerror(errno));
+        }
+    }
+    if (hilos_max == 0) {
+        hilos_max = cal.ncpu;
+    }
+
+    Candidato mejores[5];
+    int validos[5];
+    planificar(&cal, filasA, columnasA, columnasB, dtype, hilos_max, permitir_mpi, mejores, validos);
+
+    int elegido = -1;
+    for (int b = 0; b < 5; b++) {
+        if (validos[b] && (elegido < 0 || mejores[b].segundos < mejores[elegido].segundos)) {
+            elegido = b;
+        }
+    }
+
+    printf("Plan para A %dx%d * B %dx%d (%s), calibración en %s:\n",
+           filasA, columnasA, columnasA, columnasB, dtype, ruta_cache);
+    printf("  (ingenuo %.2f/%.2f GFLOP/s, bloques %.2f GFLOP/s, %.1f GB/s, hilo %.1f us, proceso %.1f us)\n",
+           cal.gflops_ingenuo_pequeno, cal.gflops_ingenuo_grande, cal.gflops_bloques,
+           cal.ancho_banda_gbs, cal.costo_hilo_us, cal.costo_proceso_us);
+    for (int b = 0; b < 5; b++) {
+        if (!validos[b]) {
+            continue;
+        }
+        printf("  %c %-20s %3d hilos  %-9s  estimado %.6f s\n", b == elegido ? '*' : ' ',
+               nombres_backend[b], mejores[b].hilos, mejores[b].algoritmo, mejores[b].segundos);
+    }
+
+    // Traducir la petición a la línea de comandos del programa elegido
+    Candidato c = mejores[elegido];
+    if (directorio[0] == '\0') {
+        snprintf(directorio, sizeof(directorio), "%s", argv[0]);
+        char* barra = strrchr(directorio, '/');
+        if (barra != NULL) {
+            *barra = '\0';
+        } else {
+            snprintf(directorio, sizeof(directorio), ".");
+        }
+    }
+    char programa[700], dimA[16], dimK[16], dimN[16], hilos[16], bloques[48];
+    snprintf(programa, sizeof(programa), "%s/%s", directorio, nombres_backend[c.backend]);
+    snprintf(dimA, sizeof(dimA), "%d", filasA);
+    snprintf(dimK, sizeof(dimK), "%d", columnasA);
+    snprintf(dimN, sizeof(dimN), "%d", columnasB);
+    snprintf(hilos, sizeof(hilos), "%d", c.hilos);
+    snprintf(bloques, sizeof(bloques), "%d,%d,%d", c.mc, c.kc, c.nc);
+    int con_dtype = strcmp(dtype, "int") != 0 && strcmp(dtype, "f64") != 0;
+
+    const char* args[32];
+    int na = 0;
+    if (c.backend == BACKEND_MPI) {
+        args[na++] = "mpirun";
+        args[na++] = "-np";
+        args[na++] = hilos;
+    }
+    args[na++] = programa;
+    args[na++] = "-r"; args[na++] = dimA;
+    args[na++] = "-c"; args[na++] = dimK;
+    if (c.backend == BACKEND_SECUENCIAL) {
+        args[na++] = "-p"; args[na++] = dimK;
+    }
+    args[na++] = "-q"; args[na++] = dimN;
+    switch (c.backend) {
+        case BACKEND_HILOS:
+            args[na++] = "-t"; args[na++] = hilos;
+            if (imprimir) args[na++] = "-p";
+            break;
+        case BACKEND_PROCESOS:
+            args[na++] = "-p"; args[na++] = hilos;
+            if (imprimir) args[na++] = "-i";
+            break;
+        case BACKEND_OPENMP:
+            args[na++] = "-h"; args[na++] = hilos;
+            if (strcmp(c.algoritmo, "ingenuo") != 0) {
+                args[na++] = "--algoritmo"; args[na++] = c.algoritmo;
+                if (!c.del_perfil) {
+                    args[na++] = "--bloque"; args[na++] = bloques;
+                }
+            }
+            if (imprimir) args[na++] = "-p";
+            break;
+        default:
+            break;
+    }
+    if (con_dtype) {
+        args[na++] = "-d"; args[na++] = dtype;
+    }
+    args[na] = NULL;
+
+    printf("->");
+    for (int i = 0; i < na; i++) {
+        printf(" %s", args[i]);
+    }
+    printf("\n");
+    fflush(stdout);
+
+    if (solo_plan) {
+        return EXIT_SUCCESS;
+    }
+    execvp(args[0], (char* const*)args);
+    fprintf(stderr, "No se pudo ejecutar %s: %s\n", args[0], strerror(errno));
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,487 @@
+/*
+ * matrices_autotune.c
+ *
+ * Ajuste empírico de la multiplicación por bloques (matrices_bloques.h) en la
+ * máquina local. Para cada tipo de dato (f64, f32) y clase de tamaño (pequeno,
+ * mediano, grande) busca la mejor combinación de
+ *   mc, kc, nc   tamaños de bloque
+ *   unroll       1, 2 o 4 filas de B por pasada
+ *   orden        ikj o kij dentro del bloque
+ *   hilos        1, 2, 4, ... hasta las CPUs en línea
+ * y la escribe en el perfil (ver matrices_perfil.h) que matrices_openmp y
+ * matrices_auto leen al arrancar.
+ *
+ * El espacio se poda con los tamaños de caché de sysfs: el panel kc x nc de B
+ * debe caber en L2, las unroll filas de B más la fila de C en L1, y debe haber al
+ * menos un bloque de mc filas por hilo. Sobre lo que queda se hace un descenso por
+ * coordenadas: partiendo de una configuración razonable, se prueba cada valor de
+ * un parámetro con los demás fijos y se conserva el mejor, y así con cada
+ * parámetro, durante varias pasadas.
+ *
+ * Uso:
+ *   gcc -O3 -march=native matrices_autotune.c -o matrices_autotune -fopenmp -lm
+ *   ./matrices_autotune                               (todas las clases, f64 y f32)
+ *   ./matrices_autotune --clases pequeno,mediano --dtype f64
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <getopt.h>
+#include <omp.h>
+#include "matrices_perfil.h"
+
+#define MAX_EVALUADAS 512
+
+/* Valores de cada parámetro que se exploran */
+static const int valores_mc[] = {16, 32, 64, 128, 256};
+static const int valores_kc[] = {32, 64, 128, 256, 512};
+static const int valores_nc[] = {32, 64, 128, 256, 512, 1024, 2048};
+static const int valores_unroll[] = {1, 2, 4};
+#define NUM(v) ((int)(sizeof(v) / sizeof((v)[0])))
+
+/* Una configuración completa del espacio de búsqueda */
+typedef struct {
+    Bloques bl;
+    int hilos;
+} Configuracion;
+
+/* Tamaños de caché por núcleo en bytes */
+typedef struct {
+    long l1;
+    long l2;
+    long l3;
+} Caches;
+
+/* Resultado de una clase: la mejor configuración y su rendimiento */
+typedef struct {
+    int valido;
+    Configuracion conf;
+    double gflops;
+} Resultado;
+
+/* Lee un tamaño de sysfs como "48K" o "2M"; devuelve bytes o 0 */
+long leer_tamano_cache(const char* ruta) {
+    FILE* f = fopen(ruta, "r");
+    if (f == NULL) {
+        return 0;
+    }
+    long valor = 0;
+    char unidad = 0;
+    if (fscanf(f, "%ld%c", &valor, &unidad) < 1) {
+        valor = 0;
+    }
+    fclose(f);
+    if (unidad == 'K') {
+        valor <<= 10;
+    } else if (unidad == 'M') {
+        valor <<= 20;
+    }
+    return valor;
+}
+
+/* Cachés de datos de la CPU 0 desde sysfs, con valores típicos si no está disponible */
+Caches detectar_caches() {
+    Caches c = {32L << 10, 256L << 10, 8L << 20};
+    for (int indice = 0; indice < 8; indice++) {
+        char ruta[128], tipo[32] = "";
+        int nivel = 0;
+        snprintf(ruta, sizeof(ruta), "/sys/devices/system/cpu/cpu0/cache/index%d/level", indice);
+        FILE* f = fopen(ruta, "r");
+        if (f == NULL) {
+            break;
+        }
+        if (fscanf(f, "%d", &nivel) != 1) {
+            nivel = 0;
+        }
+        fclose(f);
+        snprintf(ruta, sizeof(ruta), "/sys/devices/system/cpu/cpu0/cache/index%d/type", indice);
+        f = fopen(ruta, "r");
+        if (f != NULL) {
+            if (fscanf(f, "%31s", tipo) != 1) {
+                tipo[0] = '\0';
+            }
+            fclose(f);
+        }
+        if (strcmp(tipo, "Instruction") == 0) {
+            continue;
+        }
+        snprintf(ruta, sizeof(ruta), "/sys/devices/system/cpu/cpu0/cache/index%d/size", indice);
+        long bytes = leer_tamano_cache(ruta);
+        if (bytes > 0 && nivel == 1) {
+            c.l1 = bytes;
+        } else if (bytes > 0 && nivel == 2) {
+            c.l2 = bytes;
+        } else if (bytes > 0 && nivel == 3) {
+            c.l3 = bytes;
+        }
+    }
+    return c;
+}
+
+/* Poda: devuelve 1 si la configuración tiene sentido para esta caché y tamaño n */
+int es_admisible(const Configuracion* conf, const Caches* caches, size_t tam_elem, int n) {
+    const Bloques* bl = &conf->bl;
+    /* Bloques mayores que la matriz equivalen al bloque de tamaño n: sólo se prueba el menor */
+    if ((bl->mc > n && bl->mc / 2 >= n) || (bl->kc > n && bl->kc / 2 >= n) || (bl->nc > n && bl->nc / 2 >= n)) {
+        return 0;
+    }
+    if ((long)(bl->kc * bl->nc * tam_elem) > caches->l2) {
+        return 0;
+    }
+    if ((long)((bl->unroll + 1) * bl->nc * tam_elem) > caches->l1) {
+        return 0;
+    }
+    if ((n + bl->mc - 1) / bl->mc < conf->hilos) {
+        return 0;
+    }
+    return 1;
+}
+
+/* Mide GFLOP/s de una configuración: una ejecución de calentamiento y repeticiones
+ * hasta superar 0.1 s; se queda con la mejor repetición
+ */
+double medir(const Configuracion* conf, int f32, void* A, void* B, void* C, int n) {
+    double mejor = 1e30, total = 0.0;
+    for (int r = 0; r < 50 && (r < 2 || total < 0.1); r++) {
+        double inicio = omp_get_wtime();
+        if (f32) {
+            gemm_bloques_openmp_f32((float*)A, n, (float*)B, n, (float*)C, n, n, n, n, conf->bl, conf->hilos);
+        } else {
+            gemm_bloques_openmp((double*)A, n, (double*)B, n, (double*)C, n, n, n, n, conf->bl, conf->hilos);
+        }
+        double t = omp_get_wtime() - inicio;
+        total += t;
+        if (r > 0 && t < mejor) {
+            mejor = t;
+        }
+    }
+    return 2.0 * n * n * n / mejor / 1e9;
+}
+
+/* Comprueba todas las combinaciones de unroll y orden contra un triple bucle en
+ * una forma irregular; devuelve la diferencia máxima
+ */
+double verificar_kernels() {
+    const int m = 67, k = 45, n = 53;
+    double* A = (double*)malloc((size_t)m * k * sizeof(double));
+    double* B = (double*)malloc((size_t)k * n * sizeof(double));
+    double* C = (double*)malloc((size_t)m * n * sizeof(double));
+    double* R = (double*)malloc((size_t)m * n * sizeof(double));
+    float* A32 = (float*)malloc((size_t)m * k * sizeof(float));
+    float* B32 = (float*)malloc((size_t)k * n * sizeof(float));
+    float* C32 = (float*)malloc((size_t)m * n * sizeof(float));
+    if (A == NULL || B == NULL || C == NULL || R == NULL || A32 == NULL || B32 == NULL || C32 == NULL) {
+        fprintf(stderr, "Error en la asignación de memoria para la verificación\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < m * k; i++) {
+        A[i] = (double)(rand() % 10);
+        A32[i] = (float)A[i];
+    }
+    for (int i = 0; i < k * n; i++) {
+        B[i] = (double)(rand() % 10);
+        B32[i] = (float)B[i];
+    }
+    for (int i = 0; i < m; i++) {
+        for (int j = 0; j < n; j++) {
+            double suma = 0.0;
+            for (int p = 0; p < k; p++) {
+                suma += A[i * k + p] * B[p * n + j];
+            }
+            R[i * n + j] = suma;
+        }
+    }
+
+    double max_diff = 0.0;
+    for (int u = 0; u < NUM(valores_unroll); u++) {
+        for (int o = 0; o < 2; o++) {
+            Bloques bl = {16, 16, 32, valores_unroll[u], (OrdenBloque)o};
+            gemm_bloques_openmp(A, k, B, n, C, n, m, k, n, bl, 2);
+            gemm_bloques_openmp_f32(A32, k, B32, n, C32, n, m, k, n, bl, 2);
+            for (int i = 0; i < m * n; i++) {
+                double d = fabs(C[i] - R[i]) + fabs((double)C32[i] - R[i]);
+                if (d > max_diff) {
+                    max_diff = d;
+                }
+            }
+        }
+    }
+    free(A);
+    free(B);
+    free(C);
+    free(R);
+    free(A32);
+    free(B32);
+    free(C32);
+    return max_diff;
+}
+
+/* Busca la mejor configuración para un tipo de dato y tamaño n */
+Resultado ajustar(int f32, int n, const Caches* caches, int hilos_max, int pasadas) {
+    size_t tam_elem = f32 ? sizeof(float) : sizeof(double);
+    void* A = malloc((size_t)n * n * tam_elem);
+    void* B = malloc((size_t)n * n * tam_elem);
+    void* C = malloc((size_t)n * n * tam_elem);
+    if (A == NULL || B == NULL || C == NULL) {
+        fprintf(stderr, "Error en la asignación de memoria para n = %d\n", n);
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < (size_t)n * n; i++) {
+        if (f32) {
+            ((float*)A)[i] = (float)(rand() % 10);
+            ((float*)B)[i] = (float)(rand() % 10);
+        } else {
+            ((double*)A)[i] = (double)(rand() % 10);
+            ((double*)B)[i] = (double)(rand() % 10);
+        }
+    }
+
+    int valores_hilos[32];
+    int num_hilos = 0;
+    for (int h = 1; h < hilos_max && num_hilos < 31; h *= 2) {
+        valores_hilos[num_hilos++] = h;
+    }
+    valores_hilos[num_hilos++] = hilos_max;
+
+    /* Punto de partida: kc = 256, panel de B en media L2, todos los hilos */
+    Configuracion mejor = {{64, 256, 128, 4, ORDEN_IKJ}, hilos_max};
+    while (mejor.bl.kc > n && mejor.bl.kc > valores_kc[0]) {
+        mejor.bl.kc /= 2;
+    }
+    mejor.bl.nc = 32;
+    while (mejor.bl.nc * 2 <= n && (long)(mejor.bl.kc * mejor.bl.nc * 2 * tam_elem) <= caches->l2 / 2) {
+        mejor.bl.nc *= 2;
+    }
+    while (mejor.bl.mc > 16 && (n + mejor.bl.mc - 1) / mejor.bl.mc < mejor.hilos) {
+        mejor.bl.mc /= 2;
+    }
+    double mejor_gflops = medir(&mejor, f32, A, B, C, n);
+
+    Configuracion evaluadas[MAX_EVALUADAS];
+    int num_evaluadas = 1, podadas = 0;
+    evaluadas[0] = mejor;
+
+    for (int pasada = 0; pasada < pasadas; pasada++) {
+        Configuracion inicio_pasada = mejor;
+        for (int parametro = 0; parametro < 6; parametro++) {
+            int num_valores = parametro == 0 ? NUM(valores_mc) : parametro == 1 ? NUM(valores_kc)
+                            : parametro == 2 ? NUM(valores_nc) : parametro == 3 ? NUM(valores_unroll)
+                            : parametro == 4 ? 2 : num_hilos;
+            for (int v = 0; v < num_valores; v++) {
+                Configuracion prueba = mejor;
+                switch (parametro) {
+                    case 0: prueba.bl.mc = valores_mc[v]; break;
+                    case 1: prueba.bl.kc = valores_kc[v]; break;
+                    case 2: prueba.bl.nc = valores_nc[v]; break;
+                    case 3: prueba.bl.unroll = valores_unroll[v]; break;
+                    case 4: prueba.bl.orden = (OrdenBloque)v; break;
+                    default: prueba.hilos = valores_hilos[v]; break;
+                }
+                int repetida = 0;
+                for (int e = 0; e < num_evaluadas && !repetida; e++) {
+                    repetida = memcmp(&evaluadas[e], &prueba, sizeof(prueba)) == 0;
+                }
+                if (repetida || num_evaluadas == MAX_EVALUADAS) {
+                    continue;
+                }
+                evaluadas[num_evaluadas++] = prueba;
+                if (!es_admisible(&prueba, caches, tam_elem, n)) {
+                    podadas++;
+                    continue;
+                }
+                double gflops = medir(&prueba, f32, A, B, C, n);
+                if (gflops > mejor_gflops) {
+                    mejor_gflops = gflops;
+                    mejor = prueba;
+                }
+            }
+        }
+        if (memcmp(&inicio_pasada, &mejor, sizeof(mejor)) == 0) {
+            break;
+        }
+    }
+
+    printf("  %d configuraciones probadas, %d podadas por tamaño de caché\n",
+           num_evaluadas - podadas, podadas);
+    free(A);
+    free(B);
+    free(C);
+    Resultado r = {1, mejor, mejor_gflops};
+    return r;
+}
+
+/* Escribe el perfil. Las entradas de clases no ajustadas ahora se conservan si
+ * el perfil anterior era de esta máquina.
+ */
+int guardar_perfil(const char* ruta, Resultado resultados[2][NUM_CLASES_PERFIL]) {
+    char maquina[256];
+    identificar_maquina(maquina, sizeof(maquina));
+    static const char* tipos[2] = {"f64", "f32"};
+
+    /* Completar con el perfil anterior */
+    FILE* f = fopen(ruta, "r");
+    if (f != NULL) {
+        char linea[512];
+        int de_esta_maquina = 0;
+        while (fgets(linea, sizeof(linea), f) != NULL) {
+            linea[strcspn(linea, "\n")] = '\0';
+            if (strncmp(linea, "maquina=", 8) == 0) {
+                de_esta_maquina = strcmp(linea + 8, maquina) == 0;
+                continue;
+            }
+            char d[8], c[16];
+            Resultado r = {1, {BLOQUES_POR_DEFECTO, 1}, 0.0};
+            if (!de_esta_maquina || parsear_linea_perfil(linea, d, c, &r.conf.bl, &r.conf.hilos, &r.gflops) != 0) {
+                continue;
+            }
+            for (int t = 0; t < 2; t++) {
+                for (int cl = 0; cl < NUM_CLASES_PERFIL; cl++) {
+                    if (!resultados[t][cl].valido && strcmp(d, tipos[t]) == 0
+                        && strcmp(c, nombres_clase_perfil[cl]) == 0) {
+                        resultados[t][cl] = r;
+                    }
+                }
+            }
+        }
+        fclose(f);
+    }
+
+    f = fopen(ruta, "w");
+    if (f == NULL) {
+        return -1;
+    }
+    fprintf(f, "# Perfil de matrices_autotune: mejor configuración por tipo de dato y clase de tamaño\n");
+    fprintf(f, "maquina=%s\n", maquina);
+    for (int t = 0; t < 2; t++) {
+        for (int cl = 0; cl < NUM_CLASES_PERFIL; cl++) {
+            Resultado* r = &resultados[t][cl];
+            if (!r->valido) {
+                continue;
+            }
+            fprintf(f, "%s %s mc=%d kc=%d nc=%d unroll=%d orden=%s hilos=%d gflops=%.3f\n",
+                    tipos[t], nombres_clase_perfil[cl], r->conf.bl.mc, r->conf.bl.kc, r->conf.bl.nc,
+                    r->conf.bl.unroll, nombre_orden(r->conf.bl.orden), r->conf.hilos, r->gflops);
+        }
+    }
+    fclose(f);
+    return 0;
+}
+
+/* Función para mostrar ayuda */
+void mostrar_ayuda() {
+    printf("Uso: ./matrices_autotune [--dtype f64,f32] [--clases pequeno,mediano,grande] [opciones]\n");
+    printf("Opciones:\n");
+    printf("  -d, --dtype       Tipos de dato a ajustar, separados por comas (por defecto: f64,f32)\n");
+    printf("  -c, --clases      Clases de tamaño a ajustar (por defecto: todas)\n");
+    printf("  -h, --hilos-max   Máximo de hilos a probar (por defecto: CPUs en línea)\n");
+    printf("  -n, --pasadas     Pasadas del descenso por coordenadas (por defecto: 2)\n");
+    printf("      --perfil ruta Archivo de perfil (por defecto: ~/.cache/matrices/perfil.txt)\n");
+    printf("  -a, --ayuda       Mostrar esta ayuda\n");
+}
+
+int main(int argc, char* argv[]) {
+    int ajustar_tipo[2] = {1, 1};
+    int ajustar_clase[NUM_CLASES_PERFIL] = {1, 1, 1};
+    int hilos_max = omp_get_num_procs();
+    int pasadas = 2;
+    char ruta_perfil[600] = "";
+
+    static struct option opciones_largas[] = {
+        {"dtype", required_argument, 0, 'd'},
+        {"clases", required_argument, 0, 'c'},
+        {"hilos-max", required_argument, 0, 'h'},
+        {"pasadas", required_argument, 0, 'n'},
+        {"perfil", required_argument, 0, 'P'},
+        {"ayuda", no_argument, 0, 'a'},
+        {0, 0, 0, 0}
+    };
+
+    int opcion;
+    while ((opcion = getopt_long(argc, argv, "d:c:h:n:a", opciones_largas, NULL)) != -1) {
+        switch (opcion) {
+            case 'd':
+                ajustar_tipo[0] = strstr(optarg, "f64") != NULL;
+                ajustar_tipo[1] = strstr(optarg, "f32") != NULL;
+                if (!ajustar_tipo[0] && !ajustar_tipo[1]) {
+                    fprintf(stderr, "Tipos de dato no válidos: %s (use f64 y/o f32)\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'c': {
+                int alguna = 0;
+                for (int cl = 0; cl < NUM_CLASES_PERFIL; cl++) {
+                    ajustar_clase[cl] = strstr(optarg, nombres_clase_perfil[cl]) != NULL;
+                    alguna |= ajustar_clase[cl];
+                }
+                if (!alguna) {
+                    fprintf(stderr, "Clases no válidas: %s (use pequeno, mediano y/o grande)\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            }
+            case 'h':
+                hilos_max = atoi(optarg);
+                if (hilos_max <= 0) {
+                    fprintf(stderr, "El número de hilos debe ser positivo\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'n':
+                pasadas = atoi(optarg);
+                if (pasadas <= 0) {
+                    fprintf(stderr, "El número de pasadas debe ser positivo\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'P':
+                snprintf(ruta_perfil, sizeof(ruta_perfil), "%s", optarg);
+                break;
+            case 'a':
+                mostrar_ayuda();
+                return EXIT_SUCCESS;
+            default:
+                mostrar_ayuda();
+                return EXIT_FAILURE;
+        }
+    }
+    if (ruta_perfil[0] == '\0') {
+        ruta_cache_matrices("perfil.txt", ruta_perfil, sizeof(ruta_perfil));
+    }
+
+    srand(1234);
+    double diferencia = verificar_kernels();
+    if (diferencia != 0.0) {
+        fprintf(stderr, "Los kernels por bloques no coinciden con la referencia (diferencia %e)\n", diferencia);
+        return EXIT_FAILURE;
+    }
+
+    Caches caches = detectar_caches();
+    printf("Cachés: L1 %ld KiB, L2 %ld KiB, L3 %ld KiB; hasta %d hilos\n",
+           caches.l1 >> 10, caches.l2 >> 10, caches.l3 >> 10, hilos_max);
+
+    Resultado resultados[2][NUM_CLASES_PERFIL];
+    memset(resultados, 0, sizeof(resultados));
+    for (int t = 0; t < 2; t++) {
+        for (int cl = 0; cl < NUM_CLASES_PERFIL; cl++) {
+            if (!ajustar_tipo[t] || !ajustar_clase[cl]) {
+                continue;
+            }
+            int n = tamano_clase_perfil[cl];
+            printf("%s %s (n = %d):\n", t ? "f32" : "f64", nombres_clase_perfil[cl], n);
+            resultados[t][cl] = ajustar(t, n, &caches, hilos_max, pasadas);
+            Configuracion* c = &resultados[t][cl].conf;
+            printf("  mejor: bloques %d,%d,%d unroll %d orden %s, %d hilos -> %.3f GFLOP/s\n",
+                   c->bl.mc, c->bl.kc, c->bl.nc, c->bl.unroll, nombre_orden(c->bl.orden),
+                   c->hilos, resultados[t][cl].gflops);
+        }
+    }
+
+    if (guardar_perfil(ruta_perfil, resultados) != 0) {
+        fprintf(stderr, "No se pudo escribir el perfil en %s\n", ruta_perfil);
+        return EXIT_FAILURE;
+    }
+    printf("Perfil guardado en %s\n", ruta_perfil);
+    return EXIT_SUCCESS;
+}
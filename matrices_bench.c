@@ -0,0 +1,626 @@
+/*
+ * matrices_bench.c
+ *
+ * Banco de rendimiento para detectar regresiones. Ejecuta una batería fija de
+ * productos (formas y números de hilos siempre iguales, bloques por defecto para
+ * que el resultado no dependa del perfil de matrices_autotune), toma el mejor de
+ * varias repeticiones y lo compara con la referencia guardada para esta máquina:
+ *
+ *   cuadrada_256     gemm_bloques_openmp 256 x 256 x 256
+ *   cuadrada_1024    gemm_bloques_openmp 1024 x 1024 x 1024
+ *   rectangular      gemm_bloques_openmp 2000 x 200 x 2000 (k pequeño)
+ *   gemv             gemm_estrecho_openmp 4096 x 4096 x 1
+ *   estrecha         gemm_estrecho_openmp 4096 x 1024 x 8
+ *   strassen         multiplicar_strassen_openmp_en 1024 x 1024 x 1024
+ *   morton           multiplicar_morton_openmp 1024 x 1024 x 1024 (ya en orden Z)
+ *   syrk             syrk_bloques_openmp 1024 x 512 (C = A * A^T)
+ *   symm, trmm       symm/trmm_bloques_openmp 1024 x 1024 x 512
+ *   lote_8, lote_32  multiplicar_lote_zancada, LOTE_BENCH productos n x n
+ *   dispersa         spmm_csr_hilos 2048 x 2048 x 256, A con DENSIDAD_BENCH (enteros)
+ *   traspuesta       trasponer_franja + multiplicar_filas_traspuesta 1024^3 (enteros)
+ *
+ * cada una con 1 hilo y con todas las CPUs. Los GFLOP/s cuentan sólo operaciones
+ * útiles: la mitad en syrk y trmm, 2 * nnz(A) * n en la dispersa y las de
+ * 2 m k n en Strassen (aunque haga menos). La referencia se guarda en
+ * $XDG_CACHE_HOME/matrices/bench.txt (o ~/.cache/matrices/bench.txt) con una
+ * sección por máquina, como el perfil:
+ *
+ *   maquina=<nombre>|<cpus>|<modelo de CPU>
+ *   <caso> hilos=<n> gflops=<x>
+ *
+ * Si no hay referencia de esta máquina se guarda la medida actual. Si alguna
+ * medida cae más de --umbral (fracción) por debajo de la suya, el programa
+ * termina con código 1, así que sirve como prueba en `make bench`.
+ *
+ * Uso:
+ *   gcc -O3 -march=native matrices_bench.c -o matrices_bench -fopenmp -lm
+ *   ./matrices_bench                    (compara; guarda si no hay referencia)
+ *   ./matrices_bench --guardar          (fija la medida actual como referencia)
+ */
+
+#define _GNU_SOURCE /* CPU_SET y pthread_setaffinity_np de matrices_afinidad.h (vía matrices_dispersas.h) */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <getopt.h>
+#include <omp.h>
+#include "matrices_perfil.h"
+#include "matrices_estrecho.h"
+#include "matrices_strassen.h"
+#include "matrices_morton.h"
+#include "matrices_simetricas.h"
+#include "matrices_lote.h"
+#include "matrices_dispersas.h"
+#include "matrices_traspuesta.h"
+
+#define MAX_CASOS 32
+#define MAX_HILOS_BENCH 2
+#define TAM_RUTA 600
+
+/* Kernel medido por un caso */
+typedef enum {
+    KERNEL_BLOQUES,
+    KERNEL_ESTRECHO,
+    KERNEL_STRASSEN,
+    KERNEL_MORTON,
+    KERNEL_SYRK,      /* m x k, C es m x m; n no se usa */
+    KERNEL_SYMM,
+    KERNEL_TRMM,
+    KERNEL_LOTE,      /* LOTE_BENCH productos m x m */
+    KERNEL_DISPERSA,
+    KERNEL_TRASPUESTA
+} KernelBench;
+
+/* Productos de cada caso de lote y densidad de A en el caso disperso */
+#define LOTE_BENCH 20000
+#define DENSIDAD_BENCH 0.05
+
+typedef struct {
+    const char* nombre;
+    KernelBench kernel;
+    int m, k, n;
+} CasoBench;
+
+static const CasoBench casos[] = {
+    {"cuadrada_256", KERNEL_BLOQUES, 256, 256, 256},
+    {"cuadrada_1024", KERNEL_BLOQUES, 1024, 1024, 1024},
+    {"rectangular", KERNEL_BLOQUES, 2000, 200, 2000},
+    {"gemv", KERNEL_ESTRECHO, 4096, 4096, 1},
+    {"estrecha", KERNEL_ESTRECHO, 4096, 1024, 8},
+    {"strassen", KERNEL_STRASSEN, 1024, 1024, 1024},
+    {"morton", KERNEL_MORTON, 1024, 1024, 1024},
+    {"syrk", KERNEL_SYRK, 1024, 512, 1024},
+    {"symm", KERNEL_SYMM, 1024, 1024, 512},
+    {"trmm", KERNEL_TRMM, 1024, 1024, 512},
+    {"lote_8", KERNEL_LOTE, 8, 8, 8},
+    {"lote_32", KERNEL_LOTE, 32, 32, 32},
+    {"dispersa", KERNEL_DISPERSA, 2048, 2048, 256},
+    {"traspuesta", KERNEL_TRASPUESTA, 1024, 1024, 1024},
+};
+#define NUM_CASOS ((int)(sizeof(casos) / sizeof(casos[0])))
+
+/* Medida de un caso con un número de hilos; referencia < 0 si no la hay */
+typedef struct {
+    int caso;
+    int hilos;
+    double gflops;
+    double referencia;
+} Medida;
+
+/* Reserva un bloque de num_elementos doubles */
+double* reservar(size_t num_elementos) {
+    double* ptr = (double*)malloc(num_elementos * sizeof(double));
+    if (ptr == NULL) {
+        fprintf(stderr, "Error en la asignación de memoria\n");
+        exit(EXIT_FAILURE);
+    }
+    return ptr;
+}
+
+/* Operandos de un caso, preparados una vez fuera de la medida */
+typedef struct {
+    double* A;
+    double* B;
+    double* C;
+    double** filasA;       /* punteros a fila sobre A, B y C (Strassen) */
+    double** filasB;
+    double** filasC;
+    Arena* arena;          /* temporales de Strassen */
+    MatrizMorton zA, zB, zC;
+    int** iA;              /* operandos enteros (dispersa y traspuesta) */
+    int** iB;
+    int** iBt;
+    int** iC;
+    MatrizCSR csr;
+    double operaciones;    /* operaciones útiles de una ejecución */
+} OperandosBench;
+
+/* Punteros a las filas de un bloque contiguo de filas x columnas doubles */
+double** punteros_fila(double* datos, int filas, int columnas) {
+    double** M = (double**)malloc(filas * sizeof(double*));
+    if (M == NULL) {
+        fprintf(stderr, "Error en la asignación de memoria\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < filas; i++) {
+        M[i] = datos + (size_t)i * columnas;
+    }
+    return M;
+}
+
+/* Matriz de enteros por punteros a fila con los datos contiguos en M[0]; densidad es
+ * la fracción de elementos no nulos (valores 1-9)
+ */
+int** reservar_enteros(int filas, int columnas, double densidad) {
+    int** M = (int**)malloc(filas * sizeof(int*));
+    int* datos = (int*)malloc((size_t)filas * columnas * sizeof(int));
+    if (M == NULL || datos == NULL) {
+        fprintf(stderr, "Error en la asignación de memoria\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < filas; i++) {
+        M[i] = datos + (size_t)i * columnas;
+        for (int j = 0; j < columnas; j++) {
+            M[i][j] = rand() % 10000 < densidad * 10000 ? rand() % 9 + 1 : 0;
+        }
+    }
+    return M;
+}
+
+void liberar_enteros(int** M) {
+    if (M != NULL) {
+        free(M[0]);
+        free(M);
+    }
+}
+
+/* Reserva y llena los operandos del caso y calcula sus operaciones útiles */
+void preparar_caso(const CasoBench* caso, OperandosBench* op) {
+    int m = caso->m, k = caso->k, n = caso->n;
+    memset(op, 0, sizeof(*op));
+    srand(1234);
+    op->operaciones = 2.0 * m * k * (double)n;
+
+    if (caso->kernel == KERNEL_DISPERSA || caso->kernel == KERNEL_TRASPUESTA) {
+        op->iA = reservar_enteros(m, k, caso->kernel == KERNEL_DISPERSA ? DENSIDAD_BENCH : 1.0);
+        op->iB = reservar_enteros(k, n, 1.0);
+        op->iC = reservar_enteros(m, n, 0.0);
+        if (caso->kernel == KERNEL_DISPERSA) {
+            op->csr = densa_a_csr(op->iA, m, k);
+            op->operaciones = 2.0 * op->csr.nnz * n;
+        } else {
+            op->iBt = reservar_enteros(n, k, 0.0);
+        }
+        return;
+    }
+
+    /* Tamaños de A, B y C en doubles */
+    size_t tamA = (size_t)m * k, tamB = (size_t)k * n, tamC = (size_t)m * n;
+    if (caso->kernel == KERNEL_SYRK) {
+        tamB = 0;
+        tamC = (size_t)m * m;
+        op->operaciones = (double)m * (m + 1) * k;
+    } else if (caso->kernel == KERNEL_TRMM) {
+        op->operaciones = (double)m * (m + 1) * n;
+    } else if (caso->kernel == KERNEL_LOTE) {
+        tamA = tamB = tamC = (size_t)LOTE_BENCH * m * m;
+        op->operaciones = 2.0 * m * m * (double)m * LOTE_BENCH;
+    }
+    op->A = reservar(tamA);
+    op->B = reservar(tamB > 0 ? tamB : 1);
+    op->C = reservar(tamC);
+    for (size_t i = 0; i < tamA; i++) {
+        op->A[i] = (double)(rand() % 10);
+    }
+    for (size_t i = 0; i < tamB; i++) {
+        op->B[i] = (double)(rand() % 10);
+    }
+
+    if (caso->kernel == KERNEL_STRASSEN) {
+        op->filasA = punteros_fila(op->A, m, k);
+        op->filasB = punteros_fila(op->B, k, n);
+        op->filasC = punteros_fila(op->C, m, n);
+        op->arena = arena_crear(espacio_strassen(m, k, n, CORTE_STRASSEN));
+        if (op->arena == NULL) {
+            fprintf(stderr, "No se pudo crear el espacio de trabajo de Strassen\n");
+            exit(EXIT_FAILURE);
+        }
+    } else if (caso->kernel == KERNEL_MORTON) {
+        int niveles = niveles_morton(m, k, n);
+        double** filasA = punteros_fila(op->A, m, k);
+        double** filasB = punteros_fila(op->B, k, n);
+        op->zA = reservar_morton(m, k, niveles);
+        op->zB = reservar_morton(k, n, niveles);
+        op->zC = reservar_morton(m, n, niveles);
+        convertir_a_morton(filasA, &op->zA);
+        convertir_a_morton(filasB, &op->zB);
+        free(filasA);
+        free(filasB);
+    }
+}
+
+/* Una ejecución del kernel del caso con hilos hilos */
+void ejecutar_caso(const CasoBench* caso, OperandosBench* op, int hilos) {
+    int m = caso->m, k = caso->k, n = caso->n;
+    Bloques bl = BLOQUES_POR_DEFECTO;
+    switch (caso->kernel) {
+        case KERNEL_BLOQUES:
+            gemm_bloques_openmp(op->A, k, op->B, n, op->C, n, m, k, n, bl, hilos);
+            break;
+        case KERNEL_ESTRECHO:
+            gemm_estrecho_openmp(op->A, k, op->B, n, op->C, n, m, k, n, hilos);
+            break;
+        case KERNEL_STRASSEN:
+            multiplicar_strassen_openmp_en(op->filasA, op->filasB, op->filasC, m, k, n, bl, CORTE_STRASSEN,
+                                           hilos, op->arena);
+            break;
+        case KERNEL_MORTON:
+            multiplicar_morton_openmp(&op->zA, &op->zB, &op->zC, hilos);
+            break;
+        case KERNEL_SYRK:
+            syrk_bloques_openmp(op->A, k, op->C, m, m, k, bl, hilos);
+            break;
+        case KERNEL_SYMM:
+            symm_bloques_openmp(op->A, k, op->B, n, op->C, n, m, n, bl, hilos);
+            break;
+        case KERNEL_TRMM:
+            trmm_bloques_openmp(op->A, k, op->B, n, op->C, n, m, n, 0, bl, hilos);
+            break;
+        case KERNEL_LOTE:
+            multiplicar_lote_zancada(op->A, (long)m * m, op->B, (long)m * m, op->C, (long)m * m, m,
+                                     LOTE_BENCH, hilos);
+            break;
+        case KERNEL_DISPERSA:
+            spmm_csr_hilos(&op->csr, op->iB, op->iC, n, hilos, NULL);
+            break;
+        case KERNEL_TRASPUESTA:
+            /* Como matrices_hilos -T: cada hilo traspone su franja de B y, tras la
+             * barrera, multiplica su rango de filas de A por Bt
+             */
+            #pragma omp parallel num_threads(hilos)
+            {
+                int id = omp_get_thread_num(), partes = omp_get_num_threads();
+                int j0, j1;
+                franja_traspuesta(n, id, partes, &j0, &j1);
+                trasponer_franja(op->iB, op->iBt, k, n, j0, j1);
+                #pragma omp barrier
+                multiplicar_filas_traspuesta(op->iA, op->iBt, op->iC, k, n, (int)((long)m * id / partes),
+                                             (int)((long)m * (id + 1) / partes));
+            }
+            break;
+    }
+}
+
+void liberar_caso(OperandosBench* op) {
+    free(op->A);
+    free(op->B);
+    free(op->C);
+    free(op->filasA);
+    free(op->filasB);
+    free(op->filasC);
+    if (op->arena != NULL) {
+        arena_destruir(op->arena);
+    }
+    if (op->zA.datos != NULL) {
+        liberar_morton(&op->zA);
+        liberar_morton(&op->zB);
+        liberar_morton(&op->zC);
+    }
+    if (op->csr.inicio_fila != NULL) {
+        liberar_csr(&op->csr);
+    }
+    liberar_enteros(op->iA);
+    liberar_enteros(op->iB);
+    liberar_enteros(op->iBt);
+    liberar_enteros(op->iC);
+}
+
+/* Mejor GFLOP/s de repeticiones ejecuciones del caso, tras una de calentamiento */
+double medir_caso(const CasoBench* caso, int hilos, int repeticiones) {
+    OperandosBench op;
+    preparar_caso(caso, &op);
+
+    double mejor = 0.0;
+    for (int r = -1; r < repeticiones; r++) {
+        double inicio = omp_get_wtime();
+        ejecutar_caso(caso, &op, hilos);
+        double tiempo = omp_get_wtime() - inicio;
+        if (r >= 0 && tiempo > 0.0) {
+            mejor = fmax(mejor, op.operaciones / tiempo / 1e9);
+        }
+    }
+    liberar_caso(&op);
+    return mejor;
+}
+
+/* Índice del caso con ese nombre o -1 */
+int buscar_caso(const char* nombre) {
+    for (int c = 0; c < NUM_CASOS; c++) {
+        if (strcmp(casos[c].nombre, nombre) == 0) {
+            return c;
+        }
+    }
+    return -1;
+}
+
+/* Marca en seleccion los casos de una lista separada por comas; -1 si alguno no existe */
+int parsear_casos(const char* texto, int* seleccion) {
+    char copia[256];
+    snprintf(copia, sizeof(copia), "%s", texto);
+    memset(seleccion, 0, NUM_CASOS * sizeof(int));
+    for (char* nombre = strtok(copia, ","); nombre != NULL; nombre = strtok(NULL, ",")) {
+        int c = buscar_caso(nombre);
+        if (c < 0) {
+            fprintf(stderr, "Caso desconocido: %s\n", nombre);
+            return -1;
+        }
+        seleccion[c] = 1;
+    }
+    return 0;
+}
+
+/* Rellena la referencia de cada medida con la sección de esta máquina.
+ * Devuelve cuántas medidas la tienen, o -1 si no hay referencia de esta máquina.
+ */
+int cargar_referencia(const char* ruta, Medida* medidas, int num) {
+    FILE* f = fopen(ruta, "r");
+    if (f == NULL) {
+        return -1;
+    }
+    char maquina[256];
+    identificar_maquina(maquina, sizeof(maquina));
+
+    char linea[512];
+    int de_esta_maquina = 0, hay_seccion = 0, encontradas = 0;
+    while (fgets(linea, sizeof(linea), f) != NULL) {
+        linea[strcspn(linea, "\n")] = '\0';
+        if (strncmp(linea, "maquina=", 8) == 0) {
+            de_esta_maquina = strcmp(linea + 8, maquina) == 0;
+            hay_seccion |= de_esta_maquina;
+            continue;
+        }
+        char nombre[64];
+        int hilos;
+        double gflops;
+        if (!de_esta_maquina || sscanf(linea, "%63s hilos=%d gflops=%lf", nombre, &hilos, &gflops) != 3) {
+            continue;
+        }
+        for (int i = 0; i < num; i++) {
+            if (medidas[i].hilos == hilos && strcmp(casos[medidas[i].caso].nombre, nombre) == 0) {
+                encontradas += medidas[i].referencia < 0.0;
+                medidas[i].referencia = gflops;
+            }
+        }
+    }
+    fclose(f);
+    return hay_seccion ? encontradas : -1;
+}
+
+/* Escribe las medidas como referencia de esta máquina. Se conservan las secciones
+ * de otras máquinas y, de la propia, los casos que no se han medido ahora.
+ */
+int guardar_referencia(const char* ruta, const Medida* medidas, int num) {
+    char maquina[256];
+    identificar_maquina(maquina, sizeof(maquina));
+
+    /* Texto anterior: otras máquinas por un lado, líneas propias no medidas por otro */
+    size_t cap_otras = 4096, cap_propias = 4096, len_otras = 0, len_propias = 0;
+    char* otras = (char*)malloc(cap_otras);
+    char* propias = (char*)malloc(cap_propias);
+    if (otras == NULL || propias == NULL) {
+        fprintf(stderr, "Error en la asignación de memoria\n");
+        exit(EXIT_FAILURE);
+    }
+    otras[0] = propias[0] = '\0';
+    FILE* f = fopen(ruta, "r");
+    if (f != NULL) {
+        char linea[512];
+        int de_esta_maquina = 0;
+        while (fgets(linea, sizeof(linea), f) != NULL) {
+            if (linea[0] == '#') {
+                continue;
+            }
+            if (strncmp(linea, "maquina=", 8) == 0) {
+                char id[512];
+                snprintf(id, sizeof(id), "%s", linea + 8);
+                id[strcspn(id, "\n")] = '\0';
+                de_esta_maquina = strcmp(id, maquina) == 0;
+                if (de_esta_maquina) {
+                    continue;
+                }
+            }
+            char nombre[64];
+            int hilos;
+            double gflops;
+            if (de_esta_maquina) {
+                if (sscanf(linea, "%63s hilos=%d gflops=%lf", nombre, &hilos, &gflops) != 3) {
+                    continue;
+                }
+                int medida = 0;
+                for (int i = 0; i < num; i++) {
+                    medida |= medidas[i].hilos == hilos && strcmp(casos[medidas[i].caso].nombre, nombre) == 0;
+                }
+                if (medida) {
+                    continue;
+                }
+            }
+            char** destino = de_esta_maquina ? &propias : &otras;
+            size_t* len = de_esta_maquina ? &len_propias : &len_otras;
+            size_t* capacidad = de_esta_maquina ? &cap_propias : &cap_otras;
+            size_t l = strlen(linea);
+            if (*len + l + 1 > *capacidad) {
+                *capacidad = 2 * (*len + l + 1);
+                char* nuevo = (char*)realloc(*destino, *capacidad);
+                if (nuevo == NULL) {
+                    fprintf(stderr, "Error en la asignación de memoria\n");
+                    exit(EXIT_FAILURE);
+                }
+                *destino = nuevo;
+            }
+            memcpy(*destino + *len, linea, l + 1);
+            *len += l;
+        }
+        fclose(f);
+    }
+
+    f = fopen(ruta, "w");
+    if (f == NULL) {
+        free(otras);
+        free(propias);
+        return -1;
+    }
+    fprintf(f, "# Referencia de matrices_bench: mejor GFLOP/s por caso y número de hilos\n");
+    fputs(otras, f);
+    fprintf(f, "maquina=%s\n", maquina);
+    fputs(propias, f);
+    for (int i = 0; i < num; i++) {
+        fprintf(f, "%s hilos=%d gflops=%.3f\n", casos[medidas[i].caso].nombre, medidas[i].hilos, medidas[i].gflops);
+    }
+    fclose(f);
+    free(otras);
+    free(propias);
+    return 0;
+}
+
+/* Función para mostrar ayuda */
+void mostrar_ayuda() {
+    printf("Uso: ./matrices_bench [--guardar] [--umbral u] [--repeticiones r] [--casos lista] [--referencia ruta]\n");
+    printf("Opciones:\n");
+    printf("  -g, --guardar       Guardar la medida actual como referencia de esta máquina\n");
+    printf("  -u, --umbral        Caída relativa de GFLOP/s que se considera regresión (por defecto: 0.10)\n");
+    printf("  -r, --repeticiones  Repeticiones por medida; se toma la mejor (por defecto: 3)\n");
+    printf("  -c, --casos         Casos separados por comas (por defecto: todos)\n");
+    printf("  -h, --hilos         Número de hilos del caso paralelo (por defecto: CPUs disponibles)\n");
+    printf("  -f, --referencia    Archivo de referencia (por defecto: ~/.cache/matrices/bench.txt)\n");
+    printf("  -a, --ayuda         Mostrar esta ayuda\n");
+    printf("Casos:");
+    for (int c = 0; c < NUM_CASOS; c++) {
+        printf(" %s", casos[c].nombre);
+    }
+    printf("\n");
+}
+
+int main(int argc, char* argv[]) {
+    int guardar = 0;
+    double umbral = 0.10;
+    int repeticiones = 3;
+    int hilos_paralelo = omp_get_num_procs();
+    int seleccion[NUM_CASOS];
+    for (int c = 0; c < NUM_CASOS; c++) {
+        seleccion[c] = 1;
+    }
+    char ruta[TAM_RUTA];
+    ruta[0] = '\0';
+
+    static struct option opciones_largas[] = {
+        {"guardar", no_argument, 0, 'g'},
+        {"umbral", required_argument, 0, 'u'},
+        {"repeticiones", required_argument, 0, 'r'},
+        {"casos", required_argument, 0, 'c'},
+        {"hilos", required_argument, 0, 'h'},
+        {"referencia", required_argument, 0, 'f'},
+        {"ayuda", no_argument, 0, 'a'},
+        {0, 0, 0, 0}
+    };
+
+    int opcion;
+    while ((opcion = getopt_long(argc, argv, "gu:r:c:h:f:a", opciones_largas, NULL)) != -1) {
+        switch (opcion) {
+            case 'g':
+                guardar = 1;
+                break;
+            case 'u':
+                umbral = atof(optarg);
+                if (umbral <= 0.0 || umbral >= 1.0) {
+                    fprintf(stderr, "El umbral debe estar entre 0 y 1\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'r':
+                repeticiones = atoi(optarg);
+                if (repeticiones <= 0) {
+                    fprintf(stderr, "El número de repeticiones debe ser positivo\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'c':
+                if (parsear_casos(optarg, seleccion) != 0) {
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'h':
+                hilos_paralelo = atoi(optarg);
+                if (hilos_paralelo <= 0) {
+                    fprintf(stderr, "El número de hilos debe ser positivo\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'f':
+                snprintf(ruta, sizeof(ruta), "%s", optarg);
+                break;
+            case 'a':
+                mostrar_ayuda();
+                return EXIT_SUCCESS;
+            default:
+                mostrar_ayuda();
+                return EXIT_FAILURE;
+        }
+    }
+    if (ruta[0] == '\0') {
+        ruta_cache_matrices("bench.txt", ruta, sizeof(ruta));
+    }
+
+    /* 1 hilo y el caso paralelo (si es distinto) para cada caso seleccionado */
+    int hilos[MAX_HILOS_BENCH] = {1, hilos_paralelo};
+    int num_hilos = hilos_paralelo > 1 ? 2 : 1;
+    Medida medidas[MAX_CASOS * MAX_HILOS_BENCH];
+    int num = 0;
+    for (int c = 0; c < NUM_CASOS; c++) {
+        for (int h = 0; h < num_hilos && seleccion[c]; h++) {
+            medidas[num++] = (Medida){c, hilos[h], 0.0, -1.0};
+        }
+    }
+    int con_referencia = cargar_referencia(ruta, medidas, num);
+    if (con_referencia < 0) {
+        guardar = 1;
+    }
+
+    char maquina[256];
+    identificar_maquina(maquina, sizeof(maquina));
+    printf("Banco de rendimiento en %s (mejor de %d repeticiones).\n", maquina, repeticiones);
+    printf("%-14s %16s %6s %10s %10s %8s\n", "caso", "m x k x n", "hilos", "GFLOP/s", "referencia", "cambio");
+    int regresiones = 0;
+    for (int i = 0; i < num; i++) {
+        const CasoBench* caso = &casos[medidas[i].caso];
+        medidas[i].gflops = medir_caso(caso, medidas[i].hilos, repeticiones);
+        char forma[48];
+        snprintf(forma, sizeof(forma), "%dx%dx%d", caso->m, caso->k, caso->n);
+        printf("%-14s %16s %6d %10.3f", caso->nombre, forma, medidas[i].hilos, medidas[i].gflops);
+        if (medidas[i].referencia > 0.0) {
+            double cambio = medidas[i].gflops / medidas[i].referencia - 1.0;
+            int regresion = cambio < -umbral;
+            regresiones += regresion;
+            printf(" %10.3f %+7.1f%%%s\n", medidas[i].referencia, 100.0 * cambio, regresion ? "  REGRESIÓN" : "");
+        } else {
+            printf(" %10s %8s\n", "-", "-");
+        }
+        fflush(stdout);
+    }
+
+    if (guardar) {
+        if (guardar_referencia(ruta, medidas, num) != 0) {
+            fprintf(stderr, "No se pudo escribir la referencia en %s\n", ruta);
+            return EXIT_FAILURE;
+        }
+        printf("Referencia %s en %s\n", con_referencia < 0 ? "creada" : "actualizada", ruta);
+    }
+    if (regresiones > 0) {
+        printf("%d medidas por debajo de la referencia en más de un %.0f%%\n", regresiones, 100.0 * umbral);
+        return guardar ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    if (con_referencia > 0) {
+        printf("Sin regresiones (umbral: %.0f%%)\n", 100.0 * umbral);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,128 @@
+/*
+ * matrices_bloques.h
+ *
+ * Multiplicación por bloques de caché parametrizable, compartida por
+ * matrices_openmp y matrices_autotune. Los parámetros se agrupan en Bloques:
+ *   mc, kc, nc  tamaño de los bloques de A (mc x kc) y de los paneles de B (kc x nc)
+ *   unroll      filas de B (1, 2 o 4) que se combinan en cada pasada sobre una fila de C
+ *   orden       recorrido dentro de un bloque: i-k-j (fila de C fija) o k-i-j (filas de B fijas)
+ *
+ * Los kernels se generan con una macro para double (gemm_bloques_openmp) y float
+ * (gemm_bloques_openmp_f32) y sólo se definen al compilar con -fopenmp; sin él el
+ * archivo aporta únicamente los tipos (es lo que necesita matrices_auto).
+ */
+
+#ifndef MATRICES_BLOQUES_H
+#define MATRICES_BLOQUES_H
+
+#include <string.h>
+
+/* Recorrido de los índices dentro de un bloque */
+typedef enum {
+    ORDEN_IKJ,  /* para cada fila de C, acumula las kc filas de B */
+    ORDEN_KIJ   /* para cada grupo de filas de B, actualiza las mc filas de C */
+} OrdenBloque;
+
+/* Tamaños de bloque de caché y forma del micro-kernel */
+typedef struct {
+    int mc;
+    int kc;
+    int nc;
+    int unroll;
+    OrdenBloque orden;
+} Bloques;
+
+/* Bloques por defecto: un panel kc x nc de B (256 KiB) cabe en L2 y mc x kc de A en L1/L2 */
+#define BLOQUES_POR_DEFECTO {64, 256, 128, 1, ORDEN_IKJ}
+
+static inline const char* nombre_orden(OrdenBloque orden) {
+    return orden == ORDEN_KIJ ? "kij" : "ikj";
+}
+
+#ifdef _OPENMP
+
+/* Genera para el tipo TIPO:
+ *   acumular_fila<S>(c, a, b, ldb, j0, j1, u): c[j] += sum_t a[t] * b[t * ldb + j], t < u
+ *   acumular_paneles<S>(A, lda, B, ldb, C, ldc, filas, k, ancho, bl): el bloque de C
+ *       (filas x ancho) += A (filas x k) * B (k x ancho), recorriendo k en paneles de kc
+ *   gemm_bloques_openmp<S>(A, lda, B, ldb, C, ldc, m, k, n, bl, num_hilos): C = A * B
+ * Cada hilo se queda con bloques de mc filas de C, que sólo él escribe.
+ * acumular_paneles también lo usa gemm_bloques_epilogo (matrices_epilogo.h).
+ */
+#define DEFINIR_GEMM_BLOQUES(S, TIPO)                                                       \
+    static inline void acumular_fila##S(TIPO* c, const TIPO* a, const TIPO* b, int ldb,     \
+                                        int j0, int j1, int u) {                            \
+        if (u == 4) {                                                                       \
+            const TIPO *b0 = b, *b1 = b + ldb, *b2 = b + 2 * ldb, *b3 = b + 3 * ldb;        \
+            TIPO a0 = a[0], a1 = a[1], a2 = a[2], a3 = a[3];                                \
+            for (int j = j0; j < j1; j++) {                                                 \
+                c[j] += a0 * b0[j] + a1 * b1[j] + a2 * b2[j] + a3 * b3[j];                  \
+            }                                                                               \
+        } else if (u == 2) {                                                                \
+            const TIPO *b0 = b, *b1 = b + ldb;                                              \
+            TIPO a0 = a[0], a1 = a[1];                                                      \
+            for (int j = j0; j < j1; j++) {                                                 \
+                c[j] += a0 * b0[j] + a1 * b1[j];                                            \
+            }                                                                               \
+        } else {                                                                            \
+            TIPO a0 = a[0];                                                                 \
+            for (int j = j0; j < j1; j++) {                                                 \
+                c[j] += a0 * b[j];                                                          \
+            }                                                                               \
+        }                                                                                   \
+    }                                                                                       \
+                                                                                            \
+    static inline void acumular_paneles##S(const TIPO* A, int lda, const TIPO* B, int ldb,   \
+                                          TIPO* C, int ldc, int filas, int k, int ancho,    \
+                                          Bloques bl) {                                     \
+        for (int pc = 0; pc < k; pc += bl.kc) {                                             \
+            int p_fin = pc + bl.kc < k ? pc + bl.kc : k;                                    \
+            int p_par = pc + (p_fin - pc) / bl.unroll * bl.unroll;                          \
+            if (bl.orden == ORDEN_IKJ) {                                                    \
+                for (int i = 0; i < filas; i++) {                                           \
+                    const TIPO* a = A + (size_t)i * lda;                                    \
+                    TIPO* c = C + (size_t)i * ldc;                                          \
+                    for (int p = pc; p < p_par; p += bl.unroll) {                           \
+                        acumular_fila##S(c, a + p, B + (size_t)p * ldb, ldb, 0, ancho,      \
+                                         bl.unroll);                                        \
+                    }                                                                       \
+                    for (int p = p_par; p < p_fin; p++) {                                   \
+                        acumular_fila##S(c, a + p, B + (size_t)p * ldb, ldb, 0, ancho, 1);  \
+                    }                                                                       \
+                }                                                                           \
+            } else {                                                                        \
+                for (int p = pc; p < p_fin; p += (p < p_par ? bl.unroll : 1)) {             \
+                    int u = p < p_par ? bl.unroll : 1;                                      \
+                    for (int i = 0; i < filas; i++) {                                       \
+                        acumular_fila##S(C + (size_t)i * ldc, A + (size_t)i * lda + p,      \
+                                         B + (size_t)p * ldb, ldb, 0, ancho, u);            \
+                    }                                                                       \
+                }                                                                           \
+            }                                                                               \
+        }                                                                                   \
+    }                                                                                       \
+                                                                                            \
+    static inline void gemm_bloques_openmp##S(const TIPO* A, int lda, const TIPO* B, int ldb,\
+                                              TIPO* C, int ldc, int m, int k, int n,        \
+                                              Bloques bl, int num_hilos) {                  \
+        _Pragma("omp parallel for schedule(dynamic) num_threads(num_hilos)")                \
+        for (int ic = 0; ic < m; ic += bl.mc) {                                             \
+            int i_fin = ic + bl.mc < m ? ic + bl.mc : m;                                    \
+            for (int i = ic; i < i_fin; i++) {                                              \
+                memset(C + (size_t)i * ldc, 0, n * sizeof(TIPO));                           \
+            }                                                                               \
+            for (int jc = 0; jc < n; jc += bl.nc) {                                         \
+                int j_fin = jc + bl.nc < n ? jc + bl.nc : n;                                \
+                acumular_paneles##S(A + (size_t)ic * lda, lda, B + jc, ldb,                 \
+                                    C + (size_t)ic * ldc + jc, ldc, i_fin - ic, k,          \
+                                    j_fin - jc, bl);                                        \
+            }                                                                               \
+        }                                                                                   \
+    }
+
+DEFINIR_GEMM_BLOQUES(, double)
+DEFINIR_GEMM_BLOQUES(_f32, float)
+
+#endif /* _OPENMP */
+
+#endif /* MATRICES_BLOQUES_H */
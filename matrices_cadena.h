@@ -0,0 +1,335 @@
+/*
+ * matrices_cadena.h
+ *
+ * Producto de una cadena M[0] * M[1] * ... * M[num-1] de matrices double contiguas
+ * por filas, con M[i] de dims[i] x dims[i+1]. El orden de los productos no cambia el
+ * resultado (salvo redondeo) pero sí el coste, a menudo en 10-100x:
+ *
+ *   ordenar_cadena  programación dinámica clásica de la cadena de matrices, pero con
+ *                   el coste de cada producto estimado por el modelo de la máquina
+ *                   (GFLOP/s medidos por matrices_autotune para cada clase de tamaño
+ *                   en perfil.txt) en lugar de contar sólo flops: un producto
+ *                   pequeño rinde menos por flop que uno grande.
+ *   ejecutar_cadena recorre el árbol elegido. Los resultados intermedios de la rama
+ *                   principal alternan entre dos buffers (ping-pong): cada nodo escribe
+ *                   en el buffer que no contiene a su hijo. Cuando los dos hijos de un
+ *                   nodo son productos, el más barato es una rama independiente con
+ *                   su propio par de buffers y se calcula a la vez que el otro, con los
+ *                   hilos repartidos en proporción al coste estimado de cada uno.
+ *
+ * Los buffers salen de una Arena (matrices_arena.h) que el llamador puede reutilizar
+ * entre cadenas; espacio_cadena da los bytes necesarios para un orden.
+ *
+ * Uso típico:
+ *   ModeloCadena modelo;
+ *   cargar_modelo_cadena(NULL, &modelo);
+ *   OrdenCadena orden = ordenar_cadena(dims, num, &modelo);
+ *   ejecutar_cadena(&orden, &modelo, M, C, arena, num_hilos);
+ *   liberar_orden_cadena(&orden);
+ *
+ * La planificación no necesita OpenMP; la ejecución sólo se define con -fopenmp,
+ * como los kernels de matrices_bloques.h, que son los que usa en cada producto.
+ */
+
+#ifndef MATRICES_CADENA_H
+#define MATRICES_CADENA_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "matrices_arena.h"
+#include "matrices_perfil.h"
+
+/* Máximo de matrices en una cadena */
+#define CADENA_MAX 64
+
+/* Coste de los productos: bloques y GFLOP/s por clase de tamaño de perfil.txt */
+typedef struct {
+    Bloques bloques[NUM_CLASES_PERFIL];
+    double gflops[NUM_CLASES_PERFIL];
+    int clases_medidas;  /* clases leídas del perfil; con 0 el coste son sólo flops */
+} ModeloCadena;
+
+/* Orden elegido para una cadena */
+typedef struct {
+    int num;           /* matrices de la cadena */
+    int dims[CADENA_MAX + 1];
+    int* corte;        /* corte[i * num + j] = s: el producto i..j es (i..s) * (s+1..j) */
+    double* coste;     /* coste[i * num + j]: segundos estimados del mejor orden de i..j */
+} OrdenCadena;
+
+/* Carga el modelo f64 del perfil (ruta NULL: ruta por defecto). Las clases que
+ * falten toman los GFLOP/s de la clase medida más cercana y los bloques por defecto;
+ * sin perfil todas valen 1 GFLOP/s y el orden es el de mínimo número de flops.
+ */
+static inline void cargar_modelo_cadena(const char* ruta, ModeloCadena* modelo) {
+    Bloques defecto = BLOQUES_POR_DEFECTO;
+    modelo->clases_medidas = 0;
+    for (int c = 0; c < NUM_CLASES_PERFIL; c++) {
+        int t = tamano_clase_perfil[c], hilos;
+        double gflops;
+        modelo->bloques[c] = defecto;
+        modelo->gflops[c] = 0.0;
+        if (cargar_perfil(ruta, "f64", t, t, t, &modelo->bloques[c], &hilos, &gflops) == 0 && gflops > 0.0) {
+            modelo->gflops[c] = gflops;
+            modelo->clases_medidas++;
+        }
+    }
+    for (int c = 0; c < NUM_CLASES_PERFIL; c++) {
+        if (modelo->gflops[c] > 0.0) {
+            continue;
+        }
+        double cercana = 1.0;
+        for (int d = 1; d < NUM_CLASES_PERFIL && cercana == 1.0; d++) {
+            if (c - d >= 0 && modelo->gflops[c - d] > 0.0) {
+                cercana = modelo->gflops[c - d];
+            } else if (c + d < NUM_CLASES_PERFIL && modelo->gflops[c + d] > 0.0) {
+                cercana = modelo->gflops[c + d];
+            }
+        }
+        modelo->gflops[c] = modelo->clases_medidas > 0 ? cercana : 1.0;
+    }
+}
+
+/* Segundos estimados de un producto m x k por k x n */
+static inline double coste_producto(const ModeloCadena* modelo, int m, int k, int n) {
+    return 2.0 * m * k * n / (modelo->gflops[clase_perfil(m, k, n)] * 1e9);
+}
+
+/* Programación dinámica sobre los subintervalos i..j por longitud creciente */
+static inline OrdenCadena ordenar_cadena(const int* dims, int num, const ModeloCadena* modelo) {
+    OrdenCadena o;
+    if (num < 1 || num > CADENA_MAX) {
+        fprintf(stderr, "La cadena debe tener entre 1 y %d matrices\n", CADENA_MAX);
+        exit(EXIT_FAILURE);
+    }
+    o.num = num;
+    memcpy(o.dims, dims, (num + 1) * sizeof(int));
+    o.corte = (int*)calloc((size_t)num * num, sizeof(int));
+    o.coste = (double*)calloc((size_t)num * num, sizeof(double));
+    if (o.corte == NULL || o.coste == NULL) {
+        fprintf(stderr, "Error en la asignación de memoria para el orden de la cadena\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int longitud = 2; longitud <= num; longitud++) {
+        for (int i = 0; i + longitud - 1 < num; i++) {
+            int j = i + longitud - 1;
+            double mejor = -1.0;
+            for (int s = i; s < j; s++) {
+                double c = o.coste[i * num + s] + o.coste[(s + 1) * num + j]
+                           + coste_producto(modelo, dims[i], dims[s + 1], dims[j + 1]);
+                if (mejor < 0.0 || c < mejor) {
+                    mejor = c;
+                    o.corte[i * num + j] = s;
+                }
+            }
+            o.coste[i * num + j] = mejor;
+        }
+    }
+    return o;
+}
+
+static inline void liberar_orden_cadena(OrdenCadena* o) {
+    free(o->corte);
+    free(o->coste);
+    o->corte = NULL;
+    o->coste = NULL;
+}
+
+/* Flops del producto i..j con el orden elegido */
+static inline double flops_orden(const OrdenCadena* o, int i, int j) {
+    if (i == j) {
+        return 0.0;
+    }
+    int s = o->corte[i * o->num + j];
+    return flops_orden(o, i, s) + flops_orden(o, s + 1, j)
+           + 2.0 * o->dims[i] * o->dims[s + 1] * o->dims[j + 1];
+}
+
+/* Flops de multiplicar la cadena de izquierda a derecha, como en el orden escrito */
+static inline double flops_izquierda(const int* dims, int num) {
+    double flops = 0.0;
+    for (int t = 1; t < num; t++) {
+        flops += 2.0 * dims[0] * dims[t] * dims[t + 1];
+    }
+    return flops;
+}
+
+/* Escribe la parentización de i..j (matrices numeradas desde 1) en texto */
+static inline void describir_orden(const OrdenCadena* o, int i, int j, char* texto, size_t tam) {
+    size_t usado = strlen(texto);
+    if (i == j) {
+        snprintf(texto + usado, tam - usado, "M%d", i + 1);
+        return;
+    }
+    int s = o->corte[i * o->num + j];
+    snprintf(texto + usado, tam - usado, "(");
+    describir_orden(o, i, s, texto, tam);
+    usado = strlen(texto);
+    snprintf(texto + usado, tam - usado, " ");
+    describir_orden(o, s + 1, j, texto, tam);
+    usado = strlen(texto);
+    snprintf(texto + usado, tam - usado, ")");
+}
+
+/* Mayor intermedio (en elementos) de los productos de i..j, incluido el propio i..j */
+static inline size_t mayor_intermedio(const OrdenCadena* o, int i, int j) {
+    if (i == j) {
+        return 0;
+    }
+    int s = o->corte[i * o->num + j];
+    size_t propio = (size_t)o->dims[i] * o->dims[j + 1];
+    size_t izq = mayor_intermedio(o, i, s), der = mayor_intermedio(o, s + 1, j);
+    size_t mayor = izq > der ? izq : der;
+    return propio > mayor ? propio : mayor;
+}
+
+/* Indica si el hijo izquierdo de i..j (partido en s) es la rama principal: el de
+ * más coste; el otro, si también es un producto, se calcula como rama independiente
+ */
+static inline int izquierda_principal(const OrdenCadena* o, int i, int j, int s) {
+    return o->coste[i * o->num + s] >= o->coste[(s + 1) * o->num + j];
+}
+
+/* Bytes de buffers de un par ping-pong de elementos doubles, con la alineación de la arena */
+static inline size_t bytes_par_cadena(size_t elementos) {
+    size_t bytes = (elementos * sizeof(double) + ARENA_ALINEACION - 1) & ~(size_t)(ARENA_ALINEACION - 1);
+    return 2 * bytes;
+}
+
+/* Bytes de arena que necesitan los pares de las ramas independientes de i..j */
+static inline size_t espacio_ramas(const OrdenCadena* o, int i, int j) {
+    if (i == j) {
+        return 0;
+    }
+    int s = o->corte[i * o->num + j];
+    size_t total = espacio_ramas(o, i, s) + espacio_ramas(o, s + 1, j);
+    if (s > i && s + 1 < j) {
+        int izq = izquierda_principal(o, i, j, s);
+        total += izq ? bytes_par_cadena(mayor_intermedio(o, s + 1, j))
+                     : bytes_par_cadena(mayor_intermedio(o, i, s));
+    }
+    return total;
+}
+
+/* Bytes de arena que necesita ejecutar_cadena: el par de la rama principal (los
+ * intermedios, sin el resultado final, que va a C) y los de las ramas independientes
+ */
+static inline size_t espacio_cadena(const OrdenCadena* o) {
+    if (o->num < 2) {
+        return 0;
+    }
+    int s = o->corte[o->num - 1];
+    size_t izq = mayor_intermedio(o, 0, s), der = mayor_intermedio(o, s + 1, o->num - 1);
+    return bytes_par_cadena(izq > der ? izq : der) + espacio_ramas(o, 0, o->num - 1);
+}
+
+#ifdef _OPENMP
+#include <omp.h>
+#include "matrices_bloques.h"
+
+/* Par de buffers de la arena; las ramas concurrentes reservan a la vez */
+static inline void reservar_par_cadena(Arena* arena, size_t elementos, double* par[2]) {
+    #pragma omp critical(arena_cadena)
+    {
+        par[0] = (double*)arena_reservar(arena, elementos * sizeof(double));
+        par[1] = (double*)arena_reservar(arena, elementos * sizeof(double));
+    }
+    if (par[0] == NULL || par[1] == NULL) {
+        fprintf(stderr, "Espacio de trabajo insuficiente para la cadena\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+/* destino = producto de i..j (i < j). Los hijos que son productos se escriben en el
+ * buffer del par que no es destino, así que el par sólo se lee y escribe alternando.
+ */
+static inline void cadena_rec(const OrdenCadena* o, const ModeloCadena* modelo, const double* const* M,
+                              int i, int j, double* destino, double* par[2], Arena* arena, int num_hilos) {
+    int s = o->corte[i * o->num + j];
+    int m = o->dims[i], k = o->dims[s + 1], n = o->dims[j + 1];
+    double* siguiente = destino == par[0] ? par[1] : par[0];
+    const double* X = M[i];
+    const double* Y = M[j];
+
+    if (s > i && s + 1 < j) {
+        /* Dos productos: la rama más barata con su propio par, a la vez que la principal */
+        int izq = izquierda_principal(o, i, j, s);
+        int pi = izq ? i : s + 1, pj = izq ? s : j;
+        int ri = izq ? s + 1 : i, rj = izq ? j : s;
+        double* par_rama[2];
+        reservar_par_cadena(arena, mayor_intermedio(o, ri, rj), par_rama);
+        double cp = o->coste[pi * o->num + pj], cr = o->coste[ri * o->num + rj];
+        int hilos_rama = (int)(num_hilos * cr / (cp + cr) + 0.5);
+        hilos_rama = hilos_rama < 1 ? 1 : hilos_rama > num_hilos - 1 ? num_hilos - 1 : hilos_rama;
+        if (num_hilos > 1) {
+            #pragma omp parallel sections num_threads(2)
+            {
+                #pragma omp section
+                cadena_rec(o, modelo, M, pi, pj, siguiente, par, arena, num_hilos - hilos_rama);
+                #pragma omp section
+                cadena_rec(o, modelo, M, ri, rj, par_rama[0], par_rama, arena, hilos_rama);
+            }
+        } else {
+            cadena_rec(o, modelo, M, pi, pj, siguiente, par, arena, 1);
+            cadena_rec(o, modelo, M, ri, rj, par_rama[0], par_rama, arena, 1);
+        }
+        X = izq ? siguiente : par_rama[0];
+        Y = izq ? par_rama[0] : siguiente;
+    } else if (s > i) {
+        cadena_rec(o, modelo, M, i, s, siguiente, par, arena, num_hilos);
+        X = siguiente;
+    } else if (s + 1 < j) {
+        cadena_rec(o, modelo, M, s + 1, j, siguiente, par, arena, num_hilos);
+        Y = siguiente;
+    }
+
+    gemm_bloques_openmp(X, k, Y, n, destino, n, m, k, n, modelo->bloques[clase_perfil(m, k, n)], num_hilos);
+}
+
+/* C (dims[0] x dims[num]) = M[0] * ... * M[num-1] con el orden o. Los buffers
+ * intermedios salen de arena (se devuelven al terminar); con arena NULL se usa una
+ * temporal de espacio_cadena bytes.
+ */
+static inline void ejecutar_cadena(const OrdenCadena* o, const ModeloCadena* modelo, const double* const* M,
+                                   double* C, Arena* arena, int num_hilos) {
+    if (o->num == 1) {
+        memcpy(C, M[0], (size_t)o->dims[0] * o->dims[1] * sizeof(double));
+        return;
+    }
+    Arena* propia = NULL;
+    if (arena == NULL) {
+        propia = arena = arena_crear(espacio_cadena(o) + ARENA_ALINEACION);
+        if (arena == NULL) {
+            fprintf(stderr, "No se pudo crear el espacio de trabajo de la cadena\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    size_t marca = arena_marca(arena);
+
+    /* Las ramas independientes abren regiones paralelas anidadas */
+    int niveles_previos = omp_get_max_active_levels();
+    omp_set_max_active_levels(CADENA_MAX);
+
+    int s = o->corte[o->num - 1];
+    size_t izq = mayor_intermedio(o, 0, s), der = mayor_intermedio(o, s + 1, o->num - 1);
+    double* par[2];
+    reservar_par_cadena(arena, izq > der ? izq : der, par);
+    cadena_rec(o, modelo, M, 0, o->num - 1, C, par, arena, num_hilos);
+
+    omp_set_max_active_levels(niveles_previos);
+    arena_restaurar(arena, marca);
+    arena_destruir(propia);
+}
+
+/* Ordena y ejecuta la cadena en un paso */
+static inline void multiplicar_cadena(const double* const* M, const int* dims, int num, double* C,
+                                      const ModeloCadena* modelo, Arena* arena, int num_hilos) {
+    OrdenCadena o = ordenar_cadena(dims, num, modelo);
+    ejecutar_cadena(&o, modelo, M, C, arena, num_hilos);
+    liberar_orden_cadena(&o);
+}
+
+#endif /* _OPENMP */
+
+#endif /* MATRICES_CADENA_H */
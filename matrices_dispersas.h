@@ -0,0 +1,524 @@
+/*
+ * matrices_dispersas.h
+ *
+ * Formatos dispersos para las matrices de enteros por punteros a fila de
+ * matrices_hilos y productos con hilos POSIX:
+ *
+ *   MatrizCSR  filas comprimidas: los no nulos de la fila i son
+ *              columna/valor[inicio_fila[i] .. inicio_fila[i + 1])
+ *   MatrizCSC  columnas comprimidas: lo mismo por columnas (fila/valor)
+ *   MatrizBSR  CSR por bloques densos de BSR_LADO x BSR_LADO: cada bloque no nulo se
+ *              guarda entero (con sus ceros) y el bucle interior es denso
+ *
+ * Productos (C siempre densa salvo en SpGEMM):
+ *   spmm_csr_hilos / spmm_bsr_hilos  C = A dispersa * B densa
+ *   gemm_densa_csc_hilos             C = A densa * B dispersa (B en CSC: cada C[i][j]
+ *                                    es un producto escalar disperso contra la fila A[i])
+ *   spgemm_hilos                     C = A * B, ambas CSR, resultado CSR (Gustavson en
+ *                                    dos pasadas: cuenta de no nulos por fila y llenado)
+ *
+ * Todos reciben un PlanAfinidad (matrices_afinidad.h): el hilo h se fija a la CPU
+ * cpu_trabajador(plan, h), como en ejecutar_hilos de matrices_hilos; NULL no fija nada.
+ *
+ * Las filas se reparten entre hilos con particion_nnz, que corta donde el número
+ * acumulado de no nulos llega a t/partes del total, en lugar de dar a cada hilo el
+ * mismo número de filas como multiplicar_matrices: con filas de densidad muy
+ * desigual el reparto por filas deja hilos parados.
+ *
+ * Requiere _GNU_SOURCE (por matrices_afinidad.h). Todas las funciones son static
+ * inline, como en matrices_arena.h.
+ */
+
+#ifndef MATRICES_DISPERSAS_H
+#define MATRICES_DISPERSAS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "matrices_afinidad.h"
+
+/* Densidad por debajo de la cual un operando va por la ruta dispersa */
+#define UMBRAL_DISPERSO 0.10
+
+/* Lado de los bloques de BSR y relleno medio mínimo de los bloques no nulos para
+ * preferir BSR a CSR en la selección automática
+ */
+#define BSR_LADO 4
+#define UMBRAL_RELLENO_BSR 0.5
+
+typedef struct {
+    int filas;
+    int columnas;
+    long nnz;
+    long* inicio_fila;  /* filas + 1 entradas */
+    int* columna;
+    int* valor;
+} MatrizCSR;
+
+typedef struct {
+    int filas;
+    int columnas;
+    long nnz;
+    long* inicio_columna;  /* columnas + 1 entradas */
+    int* fila;
+    int* valor;
+} MatrizCSC;
+
+typedef struct {
+    int filas;
+    int columnas;
+    int filas_bloque;      /* ceil(filas / BSR_LADO) */
+    long nbloques;
+    long nnz;              /* no nulos reales, para medir el relleno */
+    long* inicio_fila;     /* filas_bloque + 1 entradas */
+    int* columna_bloque;
+    int* valor;            /* nbloques bloques de BSR_LADO x BSR_LADO por filas */
+} MatrizBSR;
+
+/* Reserva con salida en error, como crear_matriz */
+static inline void* reservar_disperso(size_t bytes) {
+    void* p = malloc(bytes > 0 ? bytes : 1);
+    if (p == NULL) {
+        fprintf(stderr, "Error en la asignación de memoria para una matriz dispersa\n");
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+/* Fracción de elementos no nulos */
+static inline double densidad_matriz(int** M, int filas, int columnas) {
+    long nnz = 0;
+    for (int i = 0; i < filas; i++) {
+        for (int j = 0; j < columnas; j++) {
+            nnz += M[i][j] != 0;
+        }
+    }
+    return (double)nnz / ((double)filas * columnas);
+}
+
+static inline MatrizCSR densa_a_csr(int** M, int filas, int columnas) {
+    MatrizCSR A = {filas, columnas, 0, NULL, NULL, NULL};
+    A.inicio_fila = (long*)reservar_disperso((filas + 1) * sizeof(long));
+    A.inicio_fila[0] = 0;
+    for (int i = 0; i < filas; i++) {
+        long nnz_fila = 0;
+        for (int j = 0; j < columnas; j++) {
+            nnz_fila += M[i][j] != 0;
+        }
+        A.inicio_fila[i + 1] = A.inicio_fila[i] + nnz_fila;
+    }
+    A.nnz = A.inicio_fila[filas];
+    A.columna = (int*)reservar_disperso(A.nnz * sizeof(int));
+    A.valor = (int*)reservar_disperso(A.nnz * sizeof(int));
+    for (int i = 0; i < filas; i++) {
+        long k = A.inicio_fila[i];
+        for (int j = 0; j < columnas; j++) {
+            if (M[i][j] != 0) {
+                A.columna[k] = j;
+                A.valor[k] = M[i][j];
+                k++;
+            }
+        }
+    }
+    return A;
+}
+
+static inline void csr_a_densa(const MatrizCSR* A, int** M) {
+    for (int i = 0; i < A->filas; i++) {
+        memset(M[i], 0, A->columnas * sizeof(int));
+        for (long k = A->inicio_fila[i]; k < A->inicio_fila[i + 1]; k++) {
+            M[i][A->columna[k]] = A->valor[k];
+        }
+    }
+}
+
+static inline void liberar_csr(MatrizCSR* A) {
+    free(A->inicio_fila);
+    free(A->columna);
+    free(A->valor);
+    A->inicio_fila = NULL;
+    A->columna = A->valor = NULL;
+}
+
+static inline MatrizCSC densa_a_csc(int** M, int filas, int columnas) {
+    MatrizCSC B = {filas, columnas, 0, NULL, NULL, NULL};
+    B.inicio_columna = (long*)calloc(columnas + 1, sizeof(long));
+    if (B.inicio_columna == NULL) {
+        fprintf(stderr, "Error en la asignación de memoria para una matriz dispersa\n");
+        exit(EXIT_FAILURE);
+    }
+    /* Contar por columnas recorriendo por filas y acumular */
+    for (int i = 0; i < filas; i++) {
+        for (int j = 0; j < columnas; j++) {
+            B.inicio_columna[j + 1] += M[i][j] != 0;
+        }
+    }
+    for (int j = 0; j < columnas; j++) {
+        B.inicio_columna[j + 1] += B.inicio_columna[j];
+    }
+    B.nnz = B.inicio_columna[columnas];
+    B.fila = (int*)reservar_disperso(B.nnz * sizeof(int));
+    B.valor = (int*)reservar_disperso(B.nnz * sizeof(int));
+    long* siguiente = (long*)reservar_disperso(columnas * sizeof(long));
+    memcpy(siguiente, B.inicio_columna, columnas * sizeof(long));
+    for (int i = 0; i < filas; i++) {
+        for (int j = 0; j < columnas; j++) {
+            if (M[i][j] != 0) {
+                B.fila[siguiente[j]] = i;
+                B.valor[siguiente[j]] = M[i][j];
+                siguiente[j]++;
+            }
+        }
+    }
+    free(siguiente);
+    return B;
+}
+
+static inline void liberar_csc(MatrizCSC* B) {
+    free(B->inicio_columna);
+    free(B->fila);
+    free(B->valor);
+    B->inicio_columna = NULL;
+    B->fila = B->valor = NULL;
+}
+
+static inline MatrizBSR densa_a_bsr(int** M, int filas, int columnas) {
+    MatrizBSR A = {filas, columnas, (filas + BSR_LADO - 1) / BSR_LADO, 0, 0, NULL, NULL, NULL};
+    int columnas_bloque = (columnas + BSR_LADO - 1) / BSR_LADO;
+    A.inicio_fila = (long*)reservar_disperso((A.filas_bloque + 1) * sizeof(long));
+    /* Primera pasada: bloques no nulos por fila de bloques */
+    A.inicio_fila[0] = 0;
+    for (int bi = 0; bi < A.filas_bloque; bi++) {
+        long bloques = 0;
+        for (int bj = 0; bj < columnas_bloque; bj++) {
+            int no_nulo = 0;
+            for (int i = bi * BSR_LADO; i < (bi + 1) * BSR_LADO && i < filas && !no_nulo; i++) {
+                for (int j = bj * BSR_LADO; j < (bj + 1) * BSR_LADO && j < columnas; j++) {
+                    if (M[i][j] != 0) {
+                        no_nulo = 1;
+                        break;
+                    }
+                }
+            }
+            bloques += no_nulo;
+        }
+        A.inicio_fila[bi + 1] = A.inicio_fila[bi] + bloques;
+    }
+    A.nbloques = A.inicio_fila[A.filas_bloque];
+    A.columna_bloque = (int*)reservar_disperso(A.nbloques * sizeof(int));
+    A.valor = (int*)reservar_disperso((size_t)A.nbloques * BSR_LADO * BSR_LADO * sizeof(int));
+    /* Segunda pasada: copiar los bloques no nulos con sus ceros */
+    for (int bi = 0; bi < A.filas_bloque; bi++) {
+        long b = A.inicio_fila[bi];
+        for (int bj = 0; bj < columnas_bloque; bj++) {
+            int bloque[BSR_LADO * BSR_LADO] = {0};
+            long nnz_bloque = 0;
+            for (int r = 0; r < BSR_LADO && bi * BSR_LADO + r < filas; r++) {
+                for (int c = 0; c < BSR_LADO && bj * BSR_LADO + c < columnas; c++) {
+                    int v = M[bi * BSR_LADO + r][bj * BSR_LADO + c];
+                    bloque[r * BSR_LADO + c] = v;
+                    nnz_bloque += v != 0;
+                }
+            }
+            if (nnz_bloque > 0) {
+                memcpy(A.valor + (size_t)b * BSR_LADO * BSR_LADO, bloque, sizeof(bloque));
+                A.columna_bloque[b] = bj;
+                A.nnz += nnz_bloque;
+                b++;
+            }
+        }
+    }
+    return A;
+}
+
+/* Fracción de los elementos guardados en bloques que no son ceros de relleno */
+static inline double relleno_bsr(const MatrizBSR* A) {
+    return A->nbloques > 0 ? (double)A->nnz / ((double)A->nbloques * BSR_LADO * BSR_LADO) : 0.0;
+}
+
+static inline void liberar_bsr(MatrizBSR* A) {
+    free(A->inicio_fila);
+    free(A->columna_bloque);
+    free(A->valor);
+    A->inicio_fila = NULL;
+    A->columna_bloque = A->valor = NULL;
+}
+
+/* Reparte las filas [0, filas) en partes tramos con aproximadamente el mismo número
+ * de no nulos: el tramo t es [limites[t], limites[t + 1]). inicio tiene filas + 1
+ * entradas acumuladas (inicio_fila de CSR o de BSR).
+ */
+static inline void particion_nnz(const long* inicio, int filas, int partes, int* limites) {
+    long total = inicio[filas];
+    limites[0] = 0;
+    for (int t = 1; t < partes; t++) {
+        long objetivo = total * t / partes;
+        /* Primera fila cuyo inicio acumulado alcanza el objetivo (búsqueda binaria) */
+        int bajo = limites[t - 1], alto = filas;
+        while (bajo < alto) {
+            int medio = bajo + (alto - bajo) / 2;
+            if (inicio[medio] < objetivo) {
+                bajo = medio + 1;
+            } else {
+                alto = medio;
+            }
+        }
+        limites[t] = bajo;
+    }
+    limites[partes] = filas;
+}
+
+/* C[i] = A[i] * B para las filas [i0, i1) (A en CSR, B y C densas) */
+static inline void spmm_csr_filas(const MatrizCSR* A, int** B, int** C, int columnasB, int i0, int i1) {
+    for (int i = i0; i < i1; i++) {
+        int* c = C[i];
+        memset(c, 0, columnasB * sizeof(int));
+        for (long k = A->inicio_fila[i]; k < A->inicio_fila[i + 1]; k++) {
+            int a = A->valor[k];
+            const int* b = B[A->columna[k]];
+            for (int j = 0; j < columnasB; j++) {
+                c[j] += a * b[j];
+            }
+        }
+    }
+}
+
+/* Lo mismo con A en BSR para las filas de bloque [bi0, bi1) */
+static inline void spmm_bsr_filas(const MatrizBSR* A, int** B, int** C, int columnasB, int bi0, int bi1) {
+    for (int bi = bi0; bi < bi1; bi++) {
+        int filas_aqui = A->filas - bi * BSR_LADO < BSR_LADO ? A->filas - bi * BSR_LADO : BSR_LADO;
+        for (int r = 0; r < filas_aqui; r++) {
+            memset(C[bi * BSR_LADO + r], 0, columnasB * sizeof(int));
+        }
+        for (long b = A->inicio_fila[bi]; b < A->inicio_fila[bi + 1]; b++) {
+            const int* bloque = A->valor + (size_t)b * BSR_LADO * BSR_LADO;
+            int p0 = A->columna_bloque[b] * BSR_LADO;
+            int cols_aqui = A->columnas - p0 < BSR_LADO ? A->columnas - p0 : BSR_LADO;
+            for (int r = 0; r < filas_aqui; r++) {
+                int* c = C[bi * BSR_LADO + r];
+                for (int q = 0; q < cols_aqui; q++) {
+                    int a = bloque[r * BSR_LADO + q];
+                    const int* fila_b = B[p0 + q];
+                    for (int j = 0; j < columnasB; j++) {
+                        c[j] += a * fila_b[j];
+                    }
+                }
+            }
+        }
+    }
+}
+
+/* C[i][j] = A[i] . B[:, j] para las filas [i0, i1) (A densa, B en CSC) */
+static inline void gemm_densa_csc_filas(int** A, const MatrizCSC* B, int** C, int i0, int i1) {
+    for (int i = i0; i < i1; i++) {
+        const int* a = A[i];
+        for (int j = 0; j < B->columnas; j++) {
+            int s = 0;
+            for (long k = B->inicio_columna[j]; k < B->inicio_columna[j + 1]; k++) {
+                s += a[B->fila[k]] * B->valor[k];
+            }
+            C[i][j] = s;
+        }
+    }
+}
+
+/* SpGEMM, primera pasada: no nulos de cada fila de C en [i0, i1). marcador tiene
+ * B->columnas entradas inicializadas a -1.
+ */
+static inline void spgemm_contar_filas(const MatrizCSR* A, const MatrizCSR* B, long* conteo, int* marcador,
+                                       int i0, int i1) {
+    for (int i = i0; i < i1; i++) {
+        long n = 0;
+        for (long ka = A->inicio_fila[i]; ka < A->inicio_fila[i + 1]; ka++) {
+            int p = A->columna[ka];
+            for (long kb = B->inicio_fila[p]; kb < B->inicio_fila[p + 1]; kb++) {
+                if (marcador[B->columna[kb]] != i) {
+                    marcador[B->columna[kb]] = i;
+                    n++;
+                }
+            }
+        }
+        conteo[i] = n;
+    }
+}
+
+static inline int comparar_enteros(const void* a, const void* b) {
+    int x = *(const int*)a, y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+/* SpGEMM, segunda pasada: llena las filas [i0, i1) de C (con inicio_fila ya
+ * calculado) acumulando en un vector denso; las columnas quedan ordenadas.
+ */
+static inline void spgemm_llenar_filas(const MatrizCSR* A, const MatrizCSR* B, MatrizCSR* C, int* acumulador,
+                                       int* marcador, int i0, int i1) {
+    for (int i = i0; i < i1; i++) {
+        long inicio = C->inicio_fila[i], n = 0;
+        for (long ka = A->inicio_fila[i]; ka < A->inicio_fila[i + 1]; ka++) {
+            int p = A->columna[ka], a = A->valor[ka];
+            for (long kb = B->inicio_fila[p]; kb < B->inicio_fila[p + 1]; kb++) {
+                int j = B->columna[kb];
+                if (marcador[j] != i) {
+                    marcador[j] = i;
+                    acumulador[j] = 0;
+                    C->columna[inicio + n++] = j;
+                }
+                acumulador[j] += a * B->valor[kb];
+            }
+        }
+        qsort(C->columna + inicio, n, sizeof(int), comparar_enteros);
+        for (long k = inicio; k < inicio + n; k++) {
+            C->valor[k] = acumulador[C->columna[k]];
+        }
+    }
+}
+
+/* Trabajo de un hilo sobre un tramo de filas; tipo elige el producto */
+typedef enum {
+    TAREA_SPMM_CSR,
+    TAREA_SPMM_BSR,
+    TAREA_DENSA_CSC,
+    TAREA_SPGEMM_CONTAR,
+    TAREA_SPGEMM_LLENAR
+} TipoTareaDispersa;
+
+typedef struct {
+    TipoTareaDispersa tipo;
+    const MatrizCSR* A;
+    const MatrizBSR* A_bsr;
+    const MatrizCSR* B;
+    const MatrizCSC* B_csc;
+    int** A_densa;
+    int** B_densa;
+    int** C;
+    MatrizCSR* C_csr;
+    long* conteo;
+    int columnasB;
+    int inicio;
+    int fin;
+} TareaDispersa;
+
+static inline void* ejecutar_tarea_dispersa(void* arg) {
+    TareaDispersa* t = (TareaDispersa*)arg;
+    int* marcador = NULL;
+    int* acumulador = NULL;
+    if (t->tipo == TAREA_SPGEMM_CONTAR || t->tipo == TAREA_SPGEMM_LLENAR) {
+        marcador = (int*)reservar_disperso(t->B->columnas * sizeof(int));
+        for (int j = 0; j < t->B->columnas; j++) {
+            marcador[j] = -1;
+        }
+        acumulador = (int*)reservar_disperso(t->B->columnas * sizeof(int));
+    }
+    switch (t->tipo) {
+        case TAREA_SPMM_CSR:
+            spmm_csr_filas(t->A, t->B_densa, t->C, t->columnasB, t->inicio, t->fin);
+            break;
+        case TAREA_SPMM_BSR:
+            spmm_bsr_filas(t->A_bsr, t->B_densa, t->C, t->columnasB, t->inicio, t->fin);
+            break;
+        case TAREA_DENSA_CSC:
+            gemm_densa_csc_filas(t->A_densa, t->B_csc, t->C, t->inicio, t->fin);
+            break;
+        case TAREA_SPGEMM_CONTAR:
+            spgemm_contar_filas(t->A, t->B, t->conteo, marcador, t->inicio, t->fin);
+            break;
+        case TAREA_SPGEMM_LLENAR:
+            spgemm_llenar_filas(t->A, t->B, t->C_csr, acumulador, marcador, t->inicio, t->fin);
+            break;
+    }
+    free(marcador);
+    free(acumulador);
+    return NULL;
+}
+
+/* Lanza una tarea por hilo con los tramos de limites, fija cada hilo a su CPU del
+ * plan (NULL: ninguna) y espera a que terminen
+ */
+static inline void ejecutar_tareas_dispersas(TareaDispersa plantilla, const int* limites, int num_hilos,
+                                             const PlanAfinidad* plan) {
+    pthread_t* hilos = (pthread_t*)reservar_disperso(num_hilos * sizeof(pthread_t));
+    TareaDispersa* tareas = (TareaDispersa*)reservar_disperso(num_hilos * sizeof(TareaDispersa));
+    for (int h = 0; h < num_hilos; h++) {
+        tareas[h] = plantilla;
+        tareas[h].inicio = limites[h];
+        tareas[h].fin = limites[h + 1];
+        if (pthread_create(&hilos[h], NULL, ejecutar_tarea_dispersa, &tareas[h]) != 0) {
+            fprintf(stderr, "Error al crear el hilo %d\n", h);
+            exit(EXIT_FAILURE);
+        }
+        if (fijar_hilo(hilos[h], cpu_trabajador(plan, h)) != 0) {
+            fprintf(stderr, "No se pudo fijar el hilo %d a su CPU\n", h);
+        }
+    }
+    for (int h = 0; h < num_hilos; h++) {
+        if (pthread_join(hilos[h], NULL) != 0) {
+            fprintf(stderr, "Error al esperar por el hilo %d\n", h);
+            exit(EXIT_FAILURE);
+        }
+    }
+    free(tareas);
+    free(hilos);
+}
+
+/* C = A * B con A en CSR y B, C densas; filas repartidas por no nulos */
+static inline void spmm_csr_hilos(const MatrizCSR* A, int** B, int** C, int columnasB, int num_hilos,
+                                  const PlanAfinidad* plan) {
+    int* limites = (int*)reservar_disperso((num_hilos + 1) * sizeof(int));
+    TareaDispersa t = {TAREA_SPMM_CSR, A, NULL, NULL, NULL, NULL, B, C, NULL, NULL, columnasB, 0, 0};
+    particion_nnz(A->inicio_fila, A->filas, num_hilos, limites);
+    ejecutar_tareas_dispersas(t, limites, num_hilos, plan);
+    free(limites);
+}
+
+/* C = A * B con A en BSR; filas de bloque repartidas por bloques no nulos */
+static inline void spmm_bsr_hilos(const MatrizBSR* A, int** B, int** C, int columnasB, int num_hilos,
+                                  const PlanAfinidad* plan) {
+    int* limites = (int*)reservar_disperso((num_hilos + 1) * sizeof(int));
+    TareaDispersa t = {TAREA_SPMM_BSR, NULL, A, NULL, NULL, NULL, B, C, NULL, NULL, columnasB, 0, 0};
+    particion_nnz(A->inicio_fila, A->filas_bloque, num_hilos, limites);
+    ejecutar_tareas_dispersas(t, limites, num_hilos, plan);
+    free(limites);
+}
+
+/* C = A * B con A densa (filas x B->filas) y B en CSC; A es densa, así que el
+ * reparto por no nulos coincide con el reparto por filas
+ */
+static inline void gemm_densa_csc_hilos(int** A, int filas, const MatrizCSC* B, int** C, int num_hilos,
+                                        const PlanAfinidad* plan) {
+    int* limites = (int*)reservar_disperso((num_hilos + 1) * sizeof(int));
+    TareaDispersa t = {TAREA_DENSA_CSC, NULL, NULL, NULL, B, A, NULL, C, NULL, NULL, B->columnas, 0, 0};
+    for (int h = 0; h <= num_hilos; h++) {
+        limites[h] = (int)((long)filas * h / num_hilos);
+    }
+    ejecutar_tareas_dispersas(t, limites, num_hilos, plan);
+    free(limites);
+}
+
+/* C = A * B con A y B en CSR; devuelve C en CSR con las columnas ordenadas */
+static inline MatrizCSR spgemm_hilos(const MatrizCSR* A, const MatrizCSR* B, int num_hilos,
+                                     const PlanAfinidad* plan) {
+    MatrizCSR C = {A->filas, B->columnas, 0, NULL, NULL, NULL};
+    int* limites = (int*)reservar_disperso((num_hilos + 1) * sizeof(int));
+    long* conteo = (long*)reservar_disperso((A->filas + 1) * sizeof(long));
+    TareaDispersa t = {TAREA_SPGEMM_CONTAR, A, NULL, B, NULL, NULL, NULL, NULL, &C, conteo, B->columnas, 0, 0};
+    particion_nnz(A->inicio_fila, A->filas, num_hilos, limites);
+    ejecutar_tareas_dispersas(t, limites, num_hilos, plan);
+
+    C.inicio_fila = (long*)reservar_disperso((A->filas + 1) * sizeof(long));
+    C.inicio_fila[0] = 0;
+    for (int i = 0; i < A->filas; i++) {
+        C.inicio_fila[i + 1] = C.inicio_fila[i] + conteo[i];
+    }
+    C.nnz = C.inicio_fila[A->filas];
+    C.columna = (int*)reservar_disperso(C.nnz * sizeof(int));
+    C.valor = (int*)reservar_disperso(C.nnz * sizeof(int));
+
+    t.tipo = TAREA_SPGEMM_LLENAR;
+    ejecutar_tareas_dispersas(t, limites, num_hilos, plan);
+    free(conteo);
+    free(limites);
+    return C;
+}
+
+#endif /* MATRICES_DISPERSAS_H */
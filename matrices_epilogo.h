@@ -0,0 +1,150 @@
+/*
+ * matrices_epilogo.h
+ *
+ * Producto con epílogo fusionado, compartido por matrices_secuencial, matrices_openmp
+ * y la capa C++ de matrices_matriz.hpp:
+ *
+ *   C = relu(alpha * A * B + beta * E + bias)
+ *
+ * donde E es la matriz que pondera beta (normalmente la propia C), bias un sesgo por
+ * columna y relu opcional. Cada bloque de ANCHO_EPILOGO columnas de una fila de C se
+ * acumula en registros y el epílogo se aplica antes de escribirlo: C se recorre una
+ * sola vez y no hay matrices intermedias. Con beta == 0 no se lee E (puede ser NULL
+ * y C puede estar sin inicializar).
+ *
+ *   gemm_epilogo_filas          filas [i0, i1) de C; el llamador reparte las filas
+ *                               entre hilos si quiere
+ *   gemm_bloques_epilogo        el kernel por bloques de matrices_bloques.h con el
+ *                               epílogo aplicado a cada bloque mc x nc de C al
+ *                               terminar su último panel kc (sólo con -fopenmp)
+ *   aplicar_epilogo_referencia  el mismo epílogo en una pasada aparte sobre AB ya
+ *                               calculado, para verificar la versión fusionada
+ *
+ * Las matrices se guardan por filas con dimensión principal ld (como reservar_matriz:
+ * A[0] y columnas). Como en matrices_bloques.h, todo se genera con una macro para
+ * double (sin sufijo) y float (_f32).
+ */
+
+#ifndef MATRICES_EPILOGO_H
+#define MATRICES_EPILOGO_H
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "matrices_bloques.h"
+
+/* Ancho del bloque de columnas de C que se acumula en registros antes del epílogo */
+#define ANCHO_EPILOGO 8
+
+#define DEFINIR_EPILOGO(S, TIPO)                                                              \
+    /* Parámetros del epílogo fusionado: C = relu(alpha * A * B + beta * E + bias) */         \
+    typedef struct {                                                                          \
+        TIPO alpha;                                                                           \
+        TIPO beta;         /* con beta == 0 no se lee E */                                    \
+        const TIPO* bias;  /* sesgo por columna de longitud n, o NULL */                      \
+        int relu;          /* aplicar max(0, x) al resultado */                               \
+    } Epilogo##S;                                                                             \
+                                                                                              \
+    /* Epílogo de un elemento: ab es (A * B)(i, j) y e el valor de E(i, j) */                 \
+    static inline TIPO epilogo_elemento##S(const Epilogo##S* ep, TIPO ab, TIPO e, int j) {   \
+        TIPO v = ep->alpha * ab;                                                              \
+        if (ep->beta != 0) {                                                                  \
+            v += ep->beta * e;                                                                \
+        }                                                                                     \
+        if (ep->bias != NULL) {                                                               \
+            v += ep->bias[j];                                                                 \
+        }                                                                                     \
+        if (ep->relu && v < 0) {                                                              \
+            v = 0;                                                                            \
+        }                                                                                     \
+        return v;                                                                             \
+    }                                                                                         \
+                                                                                              \
+    /* Filas [i0, i1) de C (m x n) = epílogo(A (m x k) * B (k x n), E). E puede ser C */      \
+    static inline void gemm_epilogo_filas##S(const TIPO* A, int lda, const TIPO* B, int ldb, \
+                                             const TIPO* E, int lde, TIPO* C, int ldc,        \
+                                             int i0, int i1, int k, int n,                    \
+                                             const Epilogo##S* ep) {                          \
+        for (int i = i0; i < i1; i++) {                                                       \
+            const TIPO* a = A + (size_t)i * lda;                                              \
+            const TIPO* e = ep->beta != 0 ? E + (size_t)i * lde : NULL;                       \
+            TIPO* c = C + (size_t)i * ldc;                                                    \
+            for (int j0 = 0; j0 < n; j0 += ANCHO_EPILOGO) {                                   \
+                int ancho = n - j0 < ANCHO_EPILOGO ? n - j0 : ANCHO_EPILOGO;                  \
+                TIPO acc[ANCHO_EPILOGO] = {0};                                                \
+                for (int p = 0; p < k; p++) {                                                 \
+                    TIPO aip = a[p];                                                          \
+                    const TIPO* b = B + (size_t)p * ldb + j0;                                 \
+                    for (int jj = 0; jj < ancho; jj++) {                                      \
+                        acc[jj] += aip * b[jj];                                               \
+                    }                                                                         \
+                }                                                                             \
+                for (int jj = 0; jj < ancho; jj++) {                                          \
+                    c[j0 + jj] = epilogo_elemento##S(ep, acc[jj], e != NULL ? e[j0 + jj] : 0, \
+                                                     j0 + jj);                                \
+                }                                                                             \
+            }                                                                                 \
+        }                                                                                     \
+    }                                                                                         \
+                                                                                              \
+    /* C = epílogo(AB, C) en una pasada aparte (referencia sin fusionar) */                   \
+    static inline void aplicar_epilogo_referencia##S(TIPO* const* AB, TIPO* const* C,        \
+                                                     int filas, int columnas,                 \
+                                                     const Epilogo##S* ep) {                  \
+        for (int i = 0; i < filas; i++) {                                                     \
+            for (int j = 0; j < columnas; j++) {                                              \
+                C[i][j] = epilogo_elemento##S(ep, AB[i][j], C[i][j], j);                      \
+            }                                                                                 \
+        }                                                                                     \
+    }
+
+DEFINIR_EPILOGO(, double)
+DEFINIR_EPILOGO(_f32, float)
+
+#ifdef _OPENMP
+
+#define DEFINIR_GEMM_BLOQUES_EPILOGO(S, TIPO)                                                 \
+    /* C (m x n) = epílogo(A (m x k) * B (k x n), E) por bloques de caché. Cada bloque        \
+     * mc x nc se acumula en un búfer del hilo (E puede ser C: su valor se lee al final)      \
+     * y el epílogo se aplica al escribirlo en C, tras el último panel kc */                  \
+    static inline void gemm_bloques_epilogo##S(const TIPO* A, int lda, const TIPO* B, int ldb,\
+                                               const TIPO* E, int lde, TIPO* C, int ldc,      \
+                                               int m, int k, int n, Bloques bl,               \
+                                               const Epilogo##S* ep, int num_hilos) {         \
+        _Pragma("omp parallel num_threads(num_hilos)")                                        \
+        {                                                                                     \
+            TIPO* bloque = (TIPO*)malloc((size_t)bl.mc * bl.nc * sizeof(TIPO));               \
+            if (bloque == NULL) {                                                             \
+                fprintf(stderr, "Error en la asignación de memoria del bloque de C\n");       \
+                exit(EXIT_FAILURE);                                                           \
+            }                                                                                 \
+            _Pragma("omp for schedule(dynamic)")                                              \
+            for (int ic = 0; ic < m; ic += bl.mc) {                                           \
+                int filas = ic + bl.mc < m ? bl.mc : m - ic;                                  \
+                for (int jc = 0; jc < n; jc += bl.nc) {                                       \
+                    int ancho = jc + bl.nc < n ? bl.nc : n - jc;                              \
+                    for (int i = 0; i < filas; i++) {                                         \
+                        memset(bloque + (size_t)i * bl.nc, 0, ancho * sizeof(TIPO));          \
+                    }                                                                         \
+                    acumular_paneles##S(A + (size_t)ic * lda, lda, B + jc, ldb, bloque,       \
+                                        bl.nc, filas, k, ancho, bl);                          \
+                    for (int i = 0; i < filas; i++) {                                         \
+                        const TIPO* t = bloque + (size_t)i * bl.nc;                           \
+                        const TIPO* e = ep->beta != 0 ? E + (size_t)(ic + i) * lde + jc : NULL;\
+                        TIPO* c = C + (size_t)(ic + i) * ldc + jc;                            \
+                        for (int j = 0; j < ancho; j++) {                                     \
+                            c[j] = epilogo_elemento##S(ep, t[j], e != NULL ? e[j] : 0, jc + j);\
+                        }                                                                     \
+                    }                                                                         \
+                }                                                                             \
+            }                                                                                 \
+            free(bloque);                                                                     \
+        }                                                                                     \
+    }
+
+DEFINIR_GEMM_BLOQUES_EPILOGO(, double)
+DEFINIR_GEMM_BLOQUES_EPILOGO(_f32, float)
+
+#endif /* _OPENMP */
+
+#endif /* MATRICES_EPILOGO_H */
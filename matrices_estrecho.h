@@ -0,0 +1,261 @@
+/*
+ * matrices_estrecho.h
+ *
+ * Productos con B estrecha: GEMV (n == 1) y tall-skinny (n <= ESTRECHO_MAX_COLUMNAS).
+ * Con tan pocas columnas cada elemento de A se usa n veces como mucho, así que el
+ * producto está limitado por el ancho de banda de memoria y lo que importa es leer
+ * A una sola vez, de forma secuencial y sin echar de la caché a B y a C:
+ *
+ *   - B (k x n, pequeña) se empaqueta con n redondeado a 4, 8 o 16 columnas para
+ *     que el bucle interior tenga un ancho fijo y se vectorice; una fila de C se
+ *     acumula entera en registros mientras se recorre una fila de A.
+ *   - Cada fila de A se prefetcha ESTRECHO_DISTANCIA elementos por delante con
+ *     localidad 0 (no temporal): A se lee una vez y no debe desplazar a B.
+ *   - Se recorren varias filas de A a la vez (4 en GEMV, 2 o 4 en tall-skinny):
+ *     cada carga de x o de una fila de B sirve a todas ellas y los acumuladores
+ *     independientes evitan quedar limitados por la latencia de la suma.
+ *
+ * Con OpenMP (gemm_estrecho_openmp) se reparten filas de A si hay al menos
+ * ESTRECHO_FILAS_POR_HILO por hilo; si m es pequeño (p. ej. A muy ancha) se reparte
+ * la dimensión k: cada hilo calcula un C parcial sobre su tramo de k y después se
+ * suman los parciales en orden fijo, así que el resultado no depende de la planificación.
+ *
+ * Todas las funciones son static inline, como en matrices_arena.h.
+ */
+
+#ifndef MATRICES_ESTRECHO_H
+#define MATRICES_ESTRECHO_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Máximo de columnas de B para las que compensa este camino */
+#define ESTRECHO_MAX_COLUMNAS 16
+
+/* Distancia de prefetch en elementos de A (512 bytes: ocho líneas de caché) */
+#define ESTRECHO_DISTANCIA 64
+
+/* Filas mínimas por hilo para repartir por filas en lugar de por k */
+#define ESTRECHO_FILAS_POR_HILO 8
+
+/* y[i * ldy] = A[i][p0..p1) . x[p0..p1) para i en [i0, i1). Se recorren cuatro filas
+ * de A a la vez para que cada elemento de x cargado sirva a cuatro productos.
+ */
+static inline void gemv_rango(const double* A, int lda, const double* x, double* y, int ldy,
+                              int i0, int i1, int p0, int p1) {
+    int i = i0;
+    for (; i + 4 <= i1; i += 4) {
+        const double* a[4] = {A + (size_t)i * lda, A + (size_t)(i + 1) * lda,
+                              A + (size_t)(i + 2) * lda, A + (size_t)(i + 3) * lda};
+        double s[4][4] = {{0}};
+        int p = p0;
+        for (; p + 4 <= p1; p += 4) {
+            if (((p - p0) & 7) == 0) {
+                for (int r = 0; r < 4; r++) {
+                    __builtin_prefetch(a[r] + p + ESTRECHO_DISTANCIA, 0, 0);
+                }
+            }
+            for (int r = 0; r < 4; r++) {
+                for (int t = 0; t < 4; t++) {
+                    s[r][t] += a[r][p + t] * x[p + t];
+                }
+            }
+        }
+        for (int r = 0; r < 4; r++) {
+            double total = (s[r][0] + s[r][1]) + (s[r][2] + s[r][3]);
+            for (int q = p; q < p1; q++) {
+                total += a[r][q] * x[q];
+            }
+            y[(size_t)(i + r) * ldy] = total;
+        }
+    }
+    /* Filas sobrantes, de una en una */
+    for (; i < i1; i++) {
+        const double* a = A + (size_t)i * lda;
+        double s[4] = {0};
+        int p = p0;
+        for (; p + 4 <= p1; p += 4) {
+            if (((p - p0) & 7) == 0) {
+                __builtin_prefetch(a + p + ESTRECHO_DISTANCIA, 0, 0);
+            }
+            for (int t = 0; t < 4; t++) {
+                s[t] += a[p + t] * x[p + t];
+            }
+        }
+        double total = (s[0] + s[1]) + (s[2] + s[3]);
+        for (; p < p1; p++) {
+            total += a[p] * x[p];
+        }
+        y[(size_t)i * ldy] = total;
+    }
+}
+
+/* Genera estrecho_rango_<NP>: D[i][0..nd) = A[i][p0..p1) * Bp[p0..p1) para i en
+ * [i0, i1), con Bp empaquetada a NP columnas y D de dimensión principal ldd. Se
+ * acumulan FR filas de C a la vez, de modo que cada fila de Bp cargada sirve a FR
+ * filas de A; las filas sobrantes se hacen de una en una.
+ */
+#define DEFINIR_ESTRECHO(NP, FR)                                                            \
+    static inline void estrecho_rango_##NP(const double* A, int lda, const double* Bp,      \
+                                           double* D, int ldd, int nd, int i0, int i1,      \
+                                           int p0, int p1) {                                \
+        int i = i0;                                                                         \
+        for (; i + FR <= i1; i += FR) {                                                     \
+            const double* a = A + (size_t)i * lda;                                          \
+            double acc[FR][NP] = {{0}};                                                     \
+            for (int p = p0; p < p1; p++) {                                                 \
+                if (((p - p0) & 7) == 0) {                                                  \
+                    for (int r = 0; r < FR; r++) {                                          \
+                        __builtin_prefetch(a + (size_t)r * lda + p + ESTRECHO_DISTANCIA, 0, 0); \
+                    }                                                                       \
+                }                                                                           \
+                const double* b = Bp + (size_t)p * NP;                                      \
+                for (int r = 0; r < FR; r++) {                                              \
+                    double ar = a[(size_t)r * lda + p];                                     \
+                    for (int j = 0; j < NP; j++) {                                          \
+                        acc[r][j] += ar * b[j];                                             \
+                    }                                                                       \
+                }                                                                           \
+            }                                                                               \
+            for (int r = 0; r < FR; r++) {                                                  \
+                double* d = D + (size_t)(i + r) * ldd;                                      \
+                for (int j = 0; j < nd; j++) {                                              \
+                    d[j] = acc[r][j];                                                       \
+                }                                                                           \
+            }                                                                               \
+        }                                                                                   \
+        for (; i < i1; i++) {                                                               \
+            const double* a = A + (size_t)i * lda;                                          \
+            double acc[NP] = {0};                                                           \
+            for (int p = p0; p < p1; p++) {                                                 \
+                if (((p - p0) & 7) == 0) {                                                  \
+                    __builtin_prefetch(a + p + ESTRECHO_DISTANCIA, 0, 0);                   \
+                }                                                                           \
+                const double* b = Bp + (size_t)p * NP;                                      \
+                for (int j = 0; j < NP; j++) {                                              \
+                    acc[j] += a[p] * b[j];                                                  \
+                }                                                                           \
+            }                                                                               \
+            double* d = D + (size_t)i * ldd;                                                \
+            for (int j = 0; j < nd; j++) {                                                  \
+                d[j] = acc[j];                                                              \
+            }                                                                               \
+        }                                                                                   \
+    }
+
+DEFINIR_ESTRECHO(4, 4)
+DEFINIR_ESTRECHO(8, 4)
+DEFINIR_ESTRECHO(16, 2)
+
+/* Columnas empaquetadas para n columnas de B: 1 (GEMV), 4, 8 o 16 */
+static inline int columnas_empaquetadas(int n) {
+    return n == 1 ? 1 : n <= 4 ? 4 : n <= 8 ? 8 : 16;
+}
+
+/* Copia B (k x n, ldb) a un bloque k x np con ceros en las columnas de relleno */
+static inline double* empaquetar_estrecho(const double* B, int ldb, int k, int n, int np) {
+    double* Bp = (double*)malloc((size_t)k * np * sizeof(double));
+    if (Bp == NULL) {
+        fprintf(stderr, "Error en la asignación de memoria para B empaquetada\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int p = 0; p < k; p++) {
+        memcpy(Bp + (size_t)p * np, B + (size_t)p * ldb, n * sizeof(double));
+        memset(Bp + (size_t)p * np + n, 0, (np - n) * sizeof(double));
+    }
+    return Bp;
+}
+
+/* D[i][0..nd) (ldd) = A[i][p0..p1) * Bp[p0..p1) para i en [i0, i1) */
+static inline void estrecho_rango(const double* A, int lda, const double* Bp, int np, double* D, int ldd,
+                                  int nd, int i0, int i1, int p0, int p1) {
+    switch (np) {
+        case 1:
+            gemv_rango(A, lda, Bp, D, ldd, i0, i1, p0, p1);
+            break;
+        case 4:
+            estrecho_rango_4(A, lda, Bp, D, ldd, nd, i0, i1, p0, p1);
+            break;
+        case 8:
+            estrecho_rango_8(A, lda, Bp, D, ldd, nd, i0, i1, p0, p1);
+            break;
+        default:
+            estrecho_rango_16(A, lda, Bp, D, ldd, nd, i0, i1, p0, p1);
+            break;
+    }
+}
+
+/* C (m x n) = A (m x k) * B (k x n) con n <= ESTRECHO_MAX_COLUMNAS. Devuelve -1 si
+ * B es demasiado ancha.
+ */
+static inline int gemm_estrecho(const double* A, int lda, const double* B, int ldb, double* C, int ldc,
+                                int m, int k, int n) {
+    if (n < 1 || n > ESTRECHO_MAX_COLUMNAS) {
+        return -1;
+    }
+    int np = columnas_empaquetadas(n);
+    double* Bp = empaquetar_estrecho(B, ldb, k, n, np);
+    estrecho_rango(A, lda, Bp, np, C, ldc, n, 0, m, 0, k);
+    free(Bp);
+    return 0;
+}
+
+/* Indica si gemm_estrecho_openmp reparte k (pocas filas) en lugar de filas */
+static inline int estrecho_reparte_k(int m, int num_hilos) {
+    return num_hilos > 1 && m < ESTRECHO_FILAS_POR_HILO * num_hilos;
+}
+
+#ifdef _OPENMP
+#include <omp.h>
+
+/* Versión OpenMP de gemm_estrecho: reparto por filas o, con pocas filas, por k con
+ * reducción de los C parciales
+ */
+static inline int gemm_estrecho_openmp(const double* A, int lda, const double* B, int ldb, double* C, int ldc,
+                                       int m, int k, int n, int num_hilos) {
+    if (n < 1 || n > ESTRECHO_MAX_COLUMNAS) {
+        return -1;
+    }
+    int np = columnas_empaquetadas(n);
+    double* Bp = empaquetar_estrecho(B, ldb, k, n, np);
+
+    if (!estrecho_reparte_k(m, num_hilos)) {
+        #pragma omp parallel num_threads(num_hilos)
+        {
+            int h = omp_get_thread_num(), total = omp_get_num_threads();
+            int i0 = (int)((long)m * h / total), i1 = (int)((long)m * (h + 1) / total);
+            estrecho_rango(A, lda, Bp, np, C, ldc, n, i0, i1, 0, k);
+        }
+    } else {
+        /* Un C parcial m x n por hilo sobre su tramo de k */
+        double* parciales = (double*)calloc((size_t)num_hilos * m * n, sizeof(double));
+        if (parciales == NULL) {
+            fprintf(stderr, "Error en la asignación de memoria para los parciales\n");
+            exit(EXIT_FAILURE);
+        }
+        #pragma omp parallel num_threads(num_hilos)
+        {
+            int h = omp_get_thread_num(), total = omp_get_num_threads();
+            int p0 = (int)((long)k * h / total), p1 = (int)((long)k * (h + 1) / total);
+            estrecho_rango(A, lda, Bp, np, parciales + (size_t)h * m * n, n, n, 0, m, p0, p1);
+        }
+        for (int i = 0; i < m; i++) {
+            for (int j = 0; j < n; j++) {
+                double s = 0.0;
+                for (int h = 0; h < num_hilos; h++) {
+                    s += parciales[((size_t)h * m + i) * n + j];
+                }
+                C[(size_t)i * ldc + j] = s;
+            }
+        }
+        free(parciales);
+    }
+
+    free(Bp);
+    return 0;
+}
+
+#endif /* _OPENMP */
+
+#endif /* MATRICES_ESTRECHO_H */
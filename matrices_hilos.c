@@ -1,9 +1,14 @@
+#define _GNU_SOURCE // pthread_setaffinity_np y CPU_SET (matrices_afinidad.h)
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <pthread.h>
 #include <time.h>
 #include <unistd.h>
 #include <getopt.h>
+#include "matrices_traspuesta.h"
+#include "matrices_dispersas.h"
+#include "matrices_afinidad.h"
 
 // Estructura para pasar datos a los hilos
 typedef struct
@@ -13,30 +18,55 @@ typedef struct
     int **C;
     int fila_inicio;
     int fila_fin;
-    int n;
+    int columnasA; // columnas de A y filas de B
+    int columnasB; // columnas de B y de C
+    int **Bt;      // B traspuesta (columnasB x columnasA), sólo en modo traspuesta
+    int id;        // índice del hilo, para repartir la trasposición
+    int num_hilos;
 } DatosHilo;
 
+// Formato de A en la ruta dispersa (-f)
+typedef enum
+{
+    FORMATO_AUTO,
+    FORMATO_CSR,
+    FORMATO_BSR
+} FormatoDisperso;
+
+// Plan de afinidad del programa (-a); NULL deja los hilos al planificador
+static const PlanAfinidad *plan_afinidad = NULL;
+
 // Prototipos de funciones
-int **crear_matriz(int n);
-void llenar_matriz_aleatoria(int **matriz, int n);
-void imprimir_matriz(int **matriz, int n);
-void liberar_matriz(int **matriz, int n);
+int **crear_matriz(int filas, int columnas);
+void llenar_matriz_aleatoria(int **matriz, int filas, int columnas);
+void llenar_matriz_dispersa(int **matriz, int filas, int columnas, double densidad);
+void imprimir_matriz(int **matriz, int filas, int columnas);
+void liberar_matriz(int **matriz, int filas);
 void *multiplicar_matrices_hilo(void *arg);
-void multiplicar_matrices(int **A, int **B, int **C, int n, int num_hilos);
-
-// Función para crear una matriz cuadrada de tamaño n x n
-int **crear_matriz(int n)
+void *trasponer_matriz_hilo(void *arg);
+void *trasponer_en_sitio_hilo(void *arg);
+void *multiplicar_traspuesta_hilo(void *arg);
+void ejecutar_hilos(void *(*funcion)(void *), DatosHilo *datos_hilos, int num_hilos);
+void repartir_filas(DatosHilo *datos_hilos, int filasA, int num_hilos);
+void multiplicar_matrices(int **A, int **B, int **C, int filasA, int columnasA, int columnasB, int num_hilos);
+void multiplicar_matrices_traspuesta(int **A, int **B, int **C, int filasA, int columnasA, int columnasB, int num_hilos,
+                                     int en_sitio, double *tiempo_traspuesta);
+const char *multiplicar_dispersa(int **A, int **B, int **C, int filasA, int columnasA, int columnasB, int num_hilos,
+                                 int A_dispersa, int B_dispersa, FormatoDisperso formato, double *tiempo_conversion);
+
+// Función para crear una matriz de tamaño filas x columnas
+int **crear_matriz(int filas, int columnas)
 {
-    int **matriz = (int **)malloc(n * sizeof(int *));
+    int **matriz = (int **)malloc(filas * sizeof(int *));
     if (matriz == NULL)
     {
         fprintf(stderr, "Error en la asignación de memoria\n");
         exit(EXIT_FAILURE);
     }
 
-    for (int i = 0; i < n; i++)
+    for (int i = 0; i < filas; i++)
     {
-        matriz[i] = (int *)malloc(n * sizeof(int));
+        matriz[i] = (int *)malloc(columnas * sizeof(int));
         if (matriz[i] == NULL)
         {
             fprintf(stderr, "Error en la asignación de memoria\n");
@@ -48,23 +78,36 @@ int **crear_matriz(int n)
 }
 
 // Función para llenar una matriz con números aleatorios
-void llenar_matriz_aleatoria(int **matriz, int n)
+void llenar_matriz_aleatoria(int **matriz, int filas, int columnas)
 {
-    for (int i = 0; i < n; i++)
+    for (int i = 0; i < filas; i++)
     {
-        for (int j = 0; j < n; j++)
+        for (int j = 0; j < columnas; j++)
         {
             matriz[i][j] = rand() % 10; // Números aleatorios entre 0 y 9
         }
     }
 }
 
+// Función para llenar una matriz dispersa: cada elemento es no nulo (entre 1 y 9) con
+// probabilidad densidad
+void llenar_matriz_dispersa(int **matriz, int filas, int columnas, double densidad)
+{
+    for (int i = 0; i < filas; i++)
+    {
+        for (int j = 0; j < columnas; j++)
+        {
+            matriz[i][j] = (double)rand() / RAND_MAX < densidad ? 1 + rand() % 9 : 0;
+        }
+    }
+}
+
 // Función para imprimir una matriz
-void imprimir_matriz(int **matriz, int n)
+void imprimir_matriz(int **matriz, int filas, int columnas)
 {
-    for (int i = 0; i < n; i++)
+    for (int i = 0; i < filas; i++)
     {
-        for (int j = 0; j < n; j++)
+        for (int j = 0; j < columnas; j++)
         {
             printf("%d ", matriz[i][j]);
         }
@@ -73,9 +116,9 @@ void imprimir_matriz(int **matriz, int n)
 }
 
 // Función para liberar la memoria de una matriz
-void liberar_matriz(int **matriz, int n)
+void liberar_matriz(int **matriz, int filas)
 {
-    for (int i = 0; i < n; i++)
+    for (int i = 0; i < filas; i++)
     {
         free(matriz[i]);
     }
@@ -91,14 +134,15 @@ void *multiplicar_matrices_hilo(void *arg)
     int **C = datos->C;
     int fila_inicio = datos->fila_inicio;
     int fila_fin = datos->fila_fin;
-    int n = datos->n;
+    int columnasA = datos->columnasA;
+    int columnasB = datos->columnasB;
 
     for (int i = fila_inicio; i < fila_fin; i++)
     {
-        for (int j = 0; j < n; j++)
+        for (int j = 0; j < columnasB; j++)
         {
             C[i][j] = 0;
-            for (int k = 0; k < n; k++)
+            for (int k = 0; k < columnasA; k++)
             {
                 C[i][j] += A[i][k] * B[k][j];
             }
@@ -108,30 +152,87 @@ void *multiplicar_matrices_hilo(void *arg)
     pthread_exit(NULL);
 }
 
-// Función para multiplicar matrices utilizando hilos
-void multiplicar_matrices(int **A, int **B, int **C, int n, int num_hilos)
+// Función que ejecutará cada hilo para trasponer su franja de B en Bt
+void *trasponer_matriz_hilo(void *arg)
+{
+    DatosHilo *datos = (DatosHilo *)arg;
+    int j0, j1;
+
+    franja_traspuesta(datos->columnasB, datos->id, datos->num_hilos, &j0, &j1);
+    trasponer_franja(datos->B, datos->Bt, datos->columnasA, datos->columnasB, j0, j1);
+
+    pthread_exit(NULL);
+}
+
+// Función que ejecutará cada hilo para trasponer en su sitio sus filas de bloque de B
+// (cuadrada); el reparto es cíclico porque cada fila de bloque recorre menos bloques
+void *trasponer_en_sitio_hilo(void *arg)
+{
+    DatosHilo *datos = (DatosHilo *)arg;
+
+    trasponer_en_sitio_franja(datos->B, datos->columnasB, datos->id, datos->num_hilos);
+
+    pthread_exit(NULL);
+}
+
+// Función que ejecutará cada hilo para multiplicar sus filas de A por las filas de Bt
+void *multiplicar_traspuesta_hilo(void *arg)
+{
+    DatosHilo *datos = (DatosHilo *)arg;
+
+    multiplicar_filas_traspuesta(datos->A, datos->Bt, datos->C, datos->columnasA, datos->columnasB,
+                                 datos->fila_inicio, datos->fila_fin);
+
+    pthread_exit(NULL);
+}
+
+// Función para lanzar num_hilos hilos con la función dada y esperar a que terminen
+void ejecutar_hilos(void *(*funcion)(void *), DatosHilo *datos_hilos, int num_hilos)
 {
     pthread_t *hilos = (pthread_t *)malloc(num_hilos * sizeof(pthread_t));
-    DatosHilo *datos_hilos = (DatosHilo *)malloc(num_hilos * sizeof(DatosHilo));
 
-    if (hilos == NULL || datos_hilos == NULL)
+    if (hilos == NULL)
     {
         fprintf(stderr, "Error en la asignación de memoria para hilos\n");
         exit(EXIT_FAILURE);
     }
 
-    int filas_por_hilo = n / num_hilos;
-    int filas_restantes = n % num_hilos;
+    for (int i = 0; i < num_hilos; i++)
+    {
+        if (pthread_create(&hilos[i], NULL, funcion, (void *)&datos_hilos[i]) != 0)
+        {
+            fprintf(stderr, "Error al crear el hilo %d\n", i);
+            exit(EXIT_FAILURE);
+        }
+        if (fijar_hilo(hilos[i], cpu_trabajador(plan_afinidad, i)) != 0)
+        {
+            fprintf(stderr, "No se pudo fijar el hilo %d a su CPU\n", i);
+        }
+    }
+
+    // Esperar a que todos los hilos terminen
+    for (int i = 0; i < num_hilos; i++)
+    {
+        if (pthread_join(hilos[i], NULL) != 0)
+        {
+            fprintf(stderr, "Error al esperar por el hilo %d\n", i);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    free(hilos);
+}
+
+// Función para repartir las filas de A (y de C) equitativamente entre los hilos
+void repartir_filas(DatosHilo *datos_hilos, int filasA, int num_hilos)
+{
+    int filas_por_hilo = filasA / num_hilos;
+    int filas_restantes = filasA % num_hilos;
     int fila_actual = 0;
 
-    // Crear hilos para multiplicar las matrices
     for (int i = 0; i < num_hilos; i++)
     {
-        datos_hilos[i].A = A;
-        datos_hilos[i].B = B;
-        datos_hilos[i].C = C;
         datos_hilos[i].fila_inicio = fila_actual;
-        datos_hilos[i].n = n;
 
         // Distribuir filas restantes equitativamente
         int filas_este_hilo = filas_por_hilo;
@@ -143,34 +244,160 @@ void multiplicar_matrices(int **A, int **B, int **C, int n, int num_hilos)
 
         fila_actual += filas_este_hilo;
         datos_hilos[i].fila_fin = fila_actual;
+    }
+}
 
-        if (pthread_create(&hilos[i], NULL, multiplicar_matrices_hilo, (void *)&datos_hilos[i]) != 0)
-        {
-            fprintf(stderr, "Error al crear el hilo %d\n", i);
-            exit(EXIT_FAILURE);
-        }
+// Función para multiplicar matrices utilizando hilos
+void multiplicar_matrices(int **A, int **B, int **C, int filasA, int columnasA, int columnasB, int num_hilos)
+{
+    DatosHilo *datos_hilos = (DatosHilo *)malloc(num_hilos * sizeof(DatosHilo));
+
+    if (datos_hilos == NULL)
+    {
+        fprintf(stderr, "Error en la asignación de memoria para hilos\n");
+        exit(EXIT_FAILURE);
     }
 
-    // Esperar a que todos los hilos terminen
     for (int i = 0; i < num_hilos; i++)
     {
-        if (pthread_join(hilos[i], NULL) != 0)
+        datos_hilos[i].A = A;
+        datos_hilos[i].B = B;
+        datos_hilos[i].C = C;
+        datos_hilos[i].columnasA = columnasA;
+        datos_hilos[i].columnasB = columnasB;
+        datos_hilos[i].Bt = NULL;
+        datos_hilos[i].id = i;
+        datos_hilos[i].num_hilos = num_hilos;
+    }
+    repartir_filas(datos_hilos, filasA, num_hilos);
+
+    // Crear hilos para multiplicar las matrices
+    ejecutar_hilos(multiplicar_matrices_hilo, datos_hilos, num_hilos);
+
+    free(datos_hilos);
+}
+
+// Función para multiplicar matrices traspondiendo antes B: cada C[i][j] pasa a ser el
+// producto escalar de dos filas contiguas, A[i] y Bt[j], en lugar de recorrer B por columnas.
+// La trasposición también se reparte entre los hilos; su tiempo se devuelve aparte.
+// Con en_sitio (B cuadrada) no se reserva Bt: B se traspone sobre sí misma y, tras
+// multiplicar, se devuelve a su orden original; el tiempo incluye las dos pasadas.
+void multiplicar_matrices_traspuesta(int **A, int **B, int **C, int filasA, int columnasA, int columnasB, int num_hilos,
+                                     int en_sitio, double *tiempo_traspuesta)
+{
+    int **Bt = en_sitio ? B : crear_matriz(columnasB, columnasA);
+    DatosHilo *datos_hilos = (DatosHilo *)malloc(num_hilos * sizeof(DatosHilo));
+
+    if (datos_hilos == NULL)
+    {
+        fprintf(stderr, "Error en la asignación de memoria para hilos\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int i = 0; i < num_hilos; i++)
+    {
+        datos_hilos[i].A = A;
+        datos_hilos[i].B = B;
+        datos_hilos[i].C = C;
+        datos_hilos[i].columnasA = columnasA;
+        datos_hilos[i].columnasB = columnasB;
+        datos_hilos[i].Bt = Bt;
+        datos_hilos[i].id = i;
+        datos_hilos[i].num_hilos = num_hilos;
+    }
+    repartir_filas(datos_hilos, filasA, num_hilos);
+
+    clock_t inicio = clock();
+    ejecutar_hilos(en_sitio ? trasponer_en_sitio_hilo : trasponer_matriz_hilo, datos_hilos, num_hilos);
+    *tiempo_traspuesta = (double)(clock() - inicio) / CLOCKS_PER_SEC;
+
+    ejecutar_hilos(multiplicar_traspuesta_hilo, datos_hilos, num_hilos);
+
+    if (en_sitio)
+    {
+        inicio = clock();
+        ejecutar_hilos(trasponer_en_sitio_hilo, datos_hilos, num_hilos);
+        *tiempo_traspuesta += (double)(clock() - inicio) / CLOCKS_PER_SEC;
+    }
+    else
+        liberar_matriz(Bt, columnasB);
+
+    free(datos_hilos);
+}
+
+// Función para multiplicar con algún operando disperso (matrices_dispersas.h). Elige el
+// formato según qué operandos son dispersos y devuelve una descripción de la ruta:
+//   A y B dispersas -> SpGEMM CSR x CSR (el resultado se expande a C densa)
+//   sólo A dispersa -> BSR si sus bloques no nulos están llenos al menos a
+//                      UMBRAL_RELLENO_BSR (o con -f bsr), si no CSR
+//   sólo B dispersa -> B en CSC y productos escalares dispersos contra las filas de A
+// Las filas se reparten entre hilos por número de no nulos. El tiempo de conversión
+// desde el formato denso se devuelve aparte.
+const char *multiplicar_dispersa(int **A, int **B, int **C, int filasA, int columnasA, int columnasB, int num_hilos,
+                                 int A_dispersa, int B_dispersa, FormatoDisperso formato, double *tiempo_conversion)
+{
+    clock_t inicio = clock();
+
+    if (A_dispersa && B_dispersa)
+    {
+        MatrizCSR Acsr = densa_a_csr(A, filasA, columnasA);
+        MatrizCSR Bcsr = densa_a_csr(B, columnasA, columnasB);
+        *tiempo_conversion = (double)(clock() - inicio) / CLOCKS_PER_SEC;
+
+        MatrizCSR Ccsr = spgemm_hilos(&Acsr, &Bcsr, num_hilos, plan_afinidad);
+        csr_a_densa(&Ccsr, C);
+        liberar_csr(&Acsr);
+        liberar_csr(&Bcsr);
+        liberar_csr(&Ccsr);
+        return "SpGEMM (A y B en CSR)";
+    }
+
+    if (A_dispersa)
+    {
+        if (formato != FORMATO_CSR)
         {
-            fprintf(stderr, "Error al esperar por el hilo %d\n", i);
-            exit(EXIT_FAILURE);
+            MatrizBSR Absr = densa_a_bsr(A, filasA, columnasA);
+            if (formato == FORMATO_BSR || relleno_bsr(&Absr) >= UMBRAL_RELLENO_BSR)
+            {
+                *tiempo_conversion = (double)(clock() - inicio) / CLOCKS_PER_SEC;
+                spmm_bsr_hilos(&Absr, B, C, columnasB, num_hilos, plan_afinidad);
+                liberar_bsr(&Absr);
+                return "SpMM (A en BSR)";
+            }
+            liberar_bsr(&Absr);
         }
+        MatrizCSR Acsr = densa_a_csr(A, filasA, columnasA);
+        *tiempo_conversion = (double)(clock() - inicio) / CLOCKS_PER_SEC;
+        spmm_csr_hilos(&Acsr, B, C, columnasB, num_hilos, plan_afinidad);
+        liberar_csr(&Acsr);
+        return "SpMM (A en CSR)";
     }
 
-    free(hilos);
-    free(datos_hilos);
+    MatrizCSC Bcsc = densa_a_csc(B, columnasA, columnasB);
+    *tiempo_conversion = (double)(clock() - inicio) / CLOCKS_PER_SEC;
+    gemm_densa_csc_hilos(A, filasA, &Bcsc, C, num_hilos, plan_afinidad);
+    liberar_csc(&Bcsc);
+    return "A densa por B dispersa (B en CSC)";
 }
 
 void mostrar_ayuda()
 {
-    printf("Uso: ./programa [-n tamaño] [-t hilos] [-p]\n");
+    printf("Uso: ./programa [-n tamaño | -r filasA -c columnasA -q columnasB] [-t hilos] [-T [-I]] [-d dA[,dB]] [-a afinidad] [-p]\n");
     printf("Opciones:\n");
     printf("  -n, --tamano     Tamaño de las matrices cuadradas (por defecto: 4)\n");
+    printf("  -r, --filasA     Filas de A (y de C)\n");
+    printf("  -c, --columnasA  Columnas de A (y filas de B)\n");
+    printf("  -q, --columnasB  Columnas de B (y de C)\n");
     printf("  -t, --hilos      Número de hilos a utilizar (por defecto: 2)\n");
+    printf("  -T, --traspuesta Trasponer B y multiplicar por productos escalares de filas (sólo en la ruta densa)\n");
+    printf("  -I, --en-sitio   Con -T y B cuadrada, trasponer B sobre sí misma sin reservar otra matriz\n");
+    printf("  -d, --densidad   Densidad de A y de B al generarlas (por defecto: 1, densas)\n");
+    printf("  -u, --umbral     Densidad por debajo de la cual se usa la ruta dispersa (por defecto: %.2f)\n",
+           UMBRAL_DISPERSO);
+    printf("  -f, --formato    Formato de A dispersa: auto, csr o bsr (por defecto: auto)\n");
+    printf("  -v, --verificar  Comparar el resultado con la multiplicación densa\n");
+    printf("  -a, --afinidad   Fijar los hilos a CPUs: ninguna, compacta o dispersa (por defecto: ninguna)\n");
+    printf("  -N, --nucleos    Con -a, como mucho un hilo por núcleo físico (sin hermanos SMT)\n");
     printf("  -p, --imprimir   Imprimir las matrices (opcional)\n");
     printf("  -h, --ayuda      Mostrar esta ayuda\n");
 }
@@ -179,13 +406,33 @@ int main(int argc, char *argv[])
 {
     // Valores por defecto
     int n = 4;         // Tamaño de la matriz
+    int filasA = -1, columnasA = -1, columnasB = -1; // Dimensiones rectangulares (por defecto n)
     int num_hilos = 2; // Número de hilos
     int imprimir = 0;  // No imprimir matrices por defecto
+    int traspuesta = 0; // Multiplicar por B traspuesta
+    int en_sitio = 0;   // Trasponer B sobre sí misma
+    double densidadA = 1.0, densidadB = 1.0; // Densidad al generar A y B
+    double umbral = UMBRAL_DISPERSO;         // Umbral de la ruta dispersa
+    FormatoDisperso formato = FORMATO_AUTO;
+    int verificar = 0;
+    PoliticaAfinidad afinidad = AFINIDAD_NINGUNA;
+    int un_hilo_por_nucleo = 0;
 
     // Definir las opciones para getopt_long
     static struct option opciones_largas[] = {
         {"tamano", required_argument, 0, 'n'},
+        {"filasA", required_argument, 0, 'r'},
+        {"columnasA", required_argument, 0, 'c'},
+        {"columnasB", required_argument, 0, 'q'},
         {"hilos", required_argument, 0, 't'},
+        {"traspuesta", no_argument, 0, 'T'},
+        {"en-sitio", no_argument, 0, 'I'},
+        {"densidad", required_argument, 0, 'd'},
+        {"umbral", required_argument, 0, 'u'},
+        {"formato", required_argument, 0, 'f'},
+        {"verificar", no_argument, 0, 'v'},
+        {"afinidad", required_argument, 0, 'a'},
+        {"nucleos", no_argument, 0, 'N'},
         {"imprimir", no_argument, 0, 'p'},
         {"ayuda", no_argument, 0, 'h'},
         {0, 0, 0, 0}};
@@ -194,7 +441,7 @@ int main(int argc, char *argv[])
     int indice_opcion = 0;
 
     // Procesar los argumentos de la línea de comandos
-    while ((opcion = getopt_long(argc, argv, "n:t:ph", opciones_largas, &indice_opcion)) != -1)
+    while ((opcion = getopt_long(argc, argv, "n:r:c:q:t:TId:u:f:va:Nph", opciones_largas, &indice_opcion)) != -1)
     {
         switch (opcion)
         {
@@ -206,6 +453,24 @@ int main(int argc, char *argv[])
                 return EXIT_FAILURE;
             }
             break;
+        case 'r':
+        case 'c':
+        case 'q':
+        {
+            int dim = atoi(optarg);
+            if (dim <= 0)
+            {
+                fprintf(stderr, "Las dimensiones de las matrices deben ser positivas\n");
+                return EXIT_FAILURE;
+            }
+            if (opcion == 'r')
+                filasA = dim;
+            else if (opcion == 'c')
+                columnasA = dim;
+            else
+                columnasB = dim;
+            break;
+        }
         case 't':
             num_hilos = atoi(optarg);
             if (num_hilos <= 0)
@@ -214,6 +479,59 @@ int main(int argc, char *argv[])
                 return EXIT_FAILURE;
             }
             break;
+        case 'T':
+            traspuesta = 1;
+            break;
+        case 'I':
+            en_sitio = 1;
+            break;
+        case 'd':
+        {
+            // "dA" aplica la misma densidad a las dos matrices, "dA,dB" una a cada una
+            char *coma = strchr(optarg, ',');
+            densidadA = atof(optarg);
+            densidadB = coma != NULL ? atof(coma + 1) : densidadA;
+            if (densidadA <= 0 || densidadA > 1 || densidadB <= 0 || densidadB > 1)
+            {
+                fprintf(stderr, "Las densidades deben estar en (0, 1]\n");
+                return EXIT_FAILURE;
+            }
+            break;
+        }
+        case 'u':
+            umbral = atof(optarg);
+            if (umbral < 0 || umbral > 1)
+            {
+                fprintf(stderr, "El umbral debe estar en [0, 1]\n");
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'f':
+            if (strcmp(optarg, "auto") == 0)
+                formato = FORMATO_AUTO;
+            else if (strcmp(optarg, "csr") == 0)
+                formato = FORMATO_CSR;
+            else if (strcmp(optarg, "bsr") == 0)
+                formato = FORMATO_BSR;
+            else
+            {
+                fprintf(stderr, "Formato desconocido: %s (auto, csr o bsr)\n", optarg);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'v':
+            verificar = 1;
+            break;
+        case 'a':
+            if (parsear_afinidad(optarg, &afinidad) != 0)
+            {
+                fprintf(stderr, "Afinidad desconocida: %s (ninguna, compacta o dispersa)\n", optarg);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'N':
+            un_hilo_por_nucleo = 1;
+            break;
         case 'p':
             imprimir = 1;
             break;
@@ -229,29 +547,70 @@ int main(int argc, char *argv[])
         }
     }
 
+    // Las dimensiones no indicadas toman el tamaño cuadrado n
+    if (filasA < 0)
+        filasA = n;
+    if (columnasA < 0)
+        columnasA = n;
+    if (columnasB < 0)
+        columnasB = n;
+    if (en_sitio && (!traspuesta || columnasA != columnasB))
+    {
+        fprintf(stderr, "-I requiere -T y B cuadrada (-c igual a -q)\n");
+        return EXIT_FAILURE;
+    }
+
     // Ajustar el número de hilos si es mayor que el número de filas
-    if (num_hilos > n)
+    if (num_hilos > filasA)
     {
-        printf("Advertencia: Reduciendo el número de hilos a %d (igual al tamaño de la matriz)\n", n);
-        num_hilos = n;
+        printf("Advertencia: Reduciendo el número de hilos a %d (igual al número de filas de A)\n", filasA);
+        num_hilos = filasA;
     }
 
+    // Plan de afinidad: lo usa ejecutar_hilos para fijar cada hilo a su CPU
+    static PlanAfinidad plan;
+    planificar_afinidad(&plan, afinidad, un_hilo_por_nucleo);
+    plan_afinidad = &plan;
+
     // Inicializar el generador de números aleatorios
     srand(time(NULL));
 
     // Crear y llenar las matrices A y B
-    int **A = crear_matriz(n);
-    int **B = crear_matriz(n);
-    int **C = crear_matriz(n);
-
-    llenar_matriz_aleatoria(A, n);
-    llenar_matriz_aleatoria(B, n);
+    int **A = crear_matriz(filasA, columnasA);
+    int **B = crear_matriz(columnasA, columnasB);
+    int **C = crear_matriz(filasA, columnasB);
+
+    if (densidadA < 1.0)
+        llenar_matriz_dispersa(A, filasA, columnasA, densidadA);
+    else
+        llenar_matriz_aleatoria(A, filasA, columnasA);
+    if (densidadB < 1.0)
+        llenar_matriz_dispersa(B, columnasA, columnasB, densidadB);
+    else
+        llenar_matriz_aleatoria(B, columnasA, columnasB);
+
+    // Selección automática: un operando es disperso si su densidad real está por
+    // debajo del umbral
+    double densidad_realA = densidad_matriz(A, filasA, columnasA);
+    double densidad_realB = densidad_matriz(B, columnasA, columnasB);
+    int A_dispersa = densidad_realA < umbral;
+    int B_dispersa = densidad_realB < umbral;
 
     // Registrar el tiempo de inicio
     clock_t inicio = clock();
 
     // Multiplicar las matrices
-    multiplicar_matrices(A, B, C, n, num_hilos);
+    double tiempo_traspuesta = 0.0;
+    double tiempo_conversion = 0.0;
+    const char *ruta = NULL;
+    if (A_dispersa || B_dispersa)
+        ruta = multiplicar_dispersa(A, B, C, filasA, columnasA, columnasB, num_hilos, A_dispersa, B_dispersa,
+                                    formato, &tiempo_conversion);
+    else if (traspuesta)
+        multiplicar_matrices_traspuesta(A, B, C, filasA, columnasA, columnasB, num_hilos, en_sitio,
+                                        &tiempo_traspuesta);
+    else
+        multiplicar_matrices(A, B, C, filasA, columnasA, columnasB, num_hilos);
 
     // Registrar el tiempo de finalización
     clock_t fin = clock();
@@ -261,25 +620,51 @@ int main(int argc, char *argv[])
     if (imprimir)
     {
         printf("\nMatriz A:\n");
-        imprimir_matriz(A, n);
+        imprimir_matriz(A, filasA, columnasA);
 
         printf("\nMatriz B:\n");
-        imprimir_matriz(B, n);
+        imprimir_matriz(B, columnasA, columnasB);
 
         printf("\nMatriz Resultado (C = A * B):\n");
-        imprimir_matriz(C, n);
+        imprimir_matriz(C, filasA, columnasB);
     }
 
     // Imprimir estadísticas
     printf("\nEstadísticas:\n");
-    printf("- Tamaño de la matriz: %d x %d\n", n, n);
+    printf("- Tamaño de las matrices: %d x %d por %d x %d\n", filasA, columnasA, columnasA, columnasB);
     printf("- Número de hilos utilizados: %d\n", num_hilos);
+    informar_afinidad(&plan, num_hilos, "Hilo");
     printf("- Tiempo de ejecución: %.6f segundos\n", tiempo_total);
+    if (ruta != NULL)
+    {
+        printf("- Densidad de A: %.4f, de B: %.4f (umbral %.2f)\n", densidad_realA, densidad_realB, umbral);
+        printf("- Ruta: %s\n", ruta);
+        printf("- Tiempo de conversión al formato disperso: %.6f segundos\n", tiempo_conversion);
+        if (traspuesta)
+            printf("- Trasposición de B omitida: la ruta dispersa no usa -T%s\n", en_sitio ? " ni -I" : "");
+    }
+    else if (traspuesta && en_sitio)
+        printf("- Tiempo de trasposición de B en su sitio (ida y vuelta): %.6f segundos\n", tiempo_traspuesta);
+    else if (traspuesta)
+        printf("- Tiempo de trasposición de B: %.6f segundos\n", tiempo_traspuesta);
+
+    // Comparar con la multiplicación densa por filas
+    if (verificar)
+    {
+        int **referencia = crear_matriz(filasA, columnasB);
+        long diferencias = 0;
+        multiplicar_matrices(A, B, referencia, filasA, columnasA, columnasB, num_hilos);
+        for (int i = 0; i < filasA; i++)
+            for (int j = 0; j < columnasB; j++)
+                diferencias += C[i][j] != referencia[i][j];
+        printf("- Verificación: %ld elementos distintos de la multiplicación densa\n", diferencias);
+        liberar_matriz(referencia, filasA);
+    }
 
     // Liberar memoria
-    liberar_matriz(A, n);
-    liberar_matriz(B, n);
-    liberar_matriz(C, n);
+    liberar_matriz(A, filasA);
+    liberar_matriz(B, columnasA);
+    liberar_matriz(C, filasA);
 
     return EXIT_SUCCESS;
 }
\ No newline at end of file
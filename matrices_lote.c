@@ -0,0 +1,210 @@
+/*
+ * matrices_lote.c
+ *
+ * Multiplicación por lotes de muchas matrices pequeñas (4x4 a 32x32) con OpenMP.
+ * En lugar de llamar a multiplicar_matrices por cada producto (una reserva nueva
+ * de C y una fila por malloc cada vez), el lote se guarda en bloques contiguos y
+ * cada hilo procesa un rango de productos completos.
+ *
+ * Se admiten dos formas de describir el lote:
+ *   - zancada: la matriz b-ésima de A empieza en A + b * zancadaA (igual para B y C)
+ *   - punteros: arreglos de punteros A[b], B[b], C[b] a matrices independientes
+ *
+ * Para los tamaños 4, 8, 16 y 32 se generan en tiempo de compilación kernels
+ * especializados con los bucles completamente desenrollados y vectorizados; el
+ * resto de tamaños usa un kernel genérico. Los kernels están en matrices_lote.h.
+ *
+ * Uso:
+ *   gcc -O3 -march=native matrices_lote.c -o matrices_lote -fopenmp
+ *   ./matrices_lote -n <dimension> -b <tamaño_lote> [-h hilos] [-m zancada|punteros]
+ *
+ * Ejemplo:
+ *   ./matrices_lote -n 8 -b 1000000 -h 4
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <getopt.h>
+#include <omp.h>
+#include "matrices_lote.h"
+
+/* Reserva memoria alineada a 64 bytes (línea de caché) para num_elementos doubles */
+double* reservar_alineado(size_t num_elementos) {
+    size_t bytes = num_elementos * sizeof(double);
+    bytes = (bytes + 63) & ~(size_t)63;  /* aligned_alloc exige un múltiplo del alineamiento */
+    double* ptr = (double*)aligned_alloc(64, bytes);
+    if (ptr == NULL) {
+        fprintf(stderr, "Error en la asignación de memoria para el lote\n");
+        exit(EXIT_FAILURE);
+    }
+    return ptr;
+}
+
+/* Llena num_elementos doubles con valores aleatorios */
+void llenar_aleatorio(double* M, size_t num_elementos) {
+    for (size_t i = 0; i < num_elementos; i++) {
+        M[i] = (double)(rand() % 10);
+    }
+}
+
+/* Compara una muestra del lote contra el kernel genérico; devuelve la diferencia máxima */
+double verificar_lote(const double* A, const double* B, const double* C, int n, long num_lote) {
+    long tam = (long)n * n;
+    long paso = num_lote > 64 ? num_lote / 64 : 1;
+    double* ref = reservar_alineado(tam);
+    double max_diff = 0.0;
+
+    for (long b = 0; b < num_lote; b += paso) {
+        kernel_generico(A + b * tam, B + b * tam, ref, n);
+        for (long i = 0; i < tam; i++) {
+            double d = fabs(ref[i] - C[b * tam + i]);
+            if (d > max_diff) {
+                max_diff = d;
+            }
+        }
+    }
+
+    free(ref);
+    return max_diff;
+}
+
+/* Función para mostrar ayuda */
+void mostrar_ayuda() {
+    printf("Uso: ./matrices_lote [-n dimensión] [-b lote] [-h hilos] [-m modo] [-r repeticiones]\n");
+    printf("Opciones:\n");
+    printf("  -n, --tamano        Dimensión de cada matriz cuadrada (por defecto: 8)\n");
+    printf("  -b, --lote          Número de productos del lote (por defecto: 100000)\n");
+    printf("  -h, --hilos         Número de hilos OpenMP (por defecto: 4)\n");
+    printf("  -m, --modo          zancada o punteros (por defecto: zancada)\n");
+    printf("  -r, --repeticiones  Veces que se repite el lote al medir (por defecto: 5)\n");
+    printf("  -a, --ayuda         Mostrar esta ayuda\n");
+}
+
+int main(int argc, char* argv[]) {
+    int n = 8;
+    long num_lote = 100000;
+    int num_hilos = 4;
+    int usar_punteros = 0;
+    int repeticiones = 5;
+
+    static struct option opciones_largas[] = {
+        {"tamano", required_argument, 0, 'n'},
+        {"lote", required_argument, 0, 'b'},
+        {"hilos", required_argument, 0, 'h'},
+        {"modo", required_argument, 0, 'm'},
+        {"repeticiones", required_argument, 0, 'r'},
+        {"ayuda", no_argument, 0, 'a'},
+        {0, 0, 0, 0}
+    };
+
+    int opcion;
+    while ((opcion = getopt_long(argc, argv, "n:b:h:m:r:a", opciones_largas, NULL)) != -1) {
+        switch (opcion) {
+            case 'n':
+                n = atoi(optarg);
+                if (n <= 0) {
+                    fprintf(stderr, "La dimensión de las matrices debe ser positiva\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'b':
+                num_lote = atol(optarg);
+                if (num_lote <= 0) {
+                    fprintf(stderr, "El tamaño del lote debe ser positivo\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'h':
+                num_hilos = atoi(optarg);
+                if (num_hilos <= 0) {
+                    fprintf(stderr, "El número de hilos debe ser positivo\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'm':
+                if (strcmp(optarg, "zancada") == 0) {
+                    usar_punteros = 0;
+                } else if (strcmp(optarg, "punteros") == 0) {
+                    usar_punteros = 1;
+                } else {
+                    fprintf(stderr, "Modo no válido: %s (use zancada o punteros)\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'r':
+                repeticiones = atoi(optarg);
+                if (repeticiones <= 0) {
+                    fprintf(stderr, "El número de repeticiones debe ser positivo\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'a':
+                mostrar_ayuda();
+                return EXIT_SUCCESS;
+            default:
+                mostrar_ayuda();
+                return EXIT_FAILURE;
+        }
+    }
+
+    srand(1234);
+
+    /* El lote completo vive en tres bloques contiguos, una matriz tras otra */
+    long tam = (long)n * n;
+    double* A = reservar_alineado((size_t)num_lote * tam);
+    double* B = reservar_alineado((size_t)num_lote * tam);
+    double* C = reservar_alineado((size_t)num_lote * tam);
+    llenar_aleatorio(A, (size_t)num_lote * tam);
+    llenar_aleatorio(B, (size_t)num_lote * tam);
+
+    /* Arreglos de punteros para el modo punteros */
+    const double** ptrA = NULL;
+    const double** ptrB = NULL;
+    double** ptrC = NULL;
+    if (usar_punteros) {
+        ptrA = (const double**)malloc(num_lote * sizeof(double*));
+        ptrB = (const double**)malloc(num_lote * sizeof(double*));
+        ptrC = (double**)malloc(num_lote * sizeof(double*));
+        if (ptrA == NULL || ptrB == NULL || ptrC == NULL) {
+            fprintf(stderr, "Error en la asignación de memoria para los punteros del lote\n");
+            return EXIT_FAILURE;
+        }
+        for (long b = 0; b < num_lote; b++) {
+            ptrA[b] = A + b * tam;
+            ptrB[b] = B + b * tam;
+            ptrC[b] = C + b * tam;
+        }
+    }
+
+    double inicio = omp_get_wtime();
+    for (int r = 0; r < repeticiones; r++) {
+        if (usar_punteros) {
+            multiplicar_lote_punteros(ptrA, ptrB, ptrC, n, num_lote, num_hilos);
+        } else {
+            multiplicar_lote_zancada(A, tam, B, tam, C, tam, n, num_lote, num_hilos);
+        }
+    }
+    double tiempo = omp_get_wtime() - inicio;
+
+    double productos = (double)num_lote * repeticiones;
+    double diferencia = verificar_lote(A, B, C, n, num_lote);
+
+    printf("Multiplicación por lotes de %ld matrices %dx%d (%s, kernel %s) con %d hilos.\n",
+           num_lote, n, n, usar_punteros ? "punteros" : "zancada",
+           seleccionar_kernel(n) == kernel_generico ? "genérico" : "especializado", num_hilos);
+    printf("- Tiempo total (%d repeticiones): %.6f segundos\n", repeticiones, tiempo);
+    printf("- Productos por segundo: %.3e GEMM/s\n", productos / tiempo);
+    printf("- Rendimiento: %.3f GFLOP/s\n", 2.0 * n * n * n * productos / tiempo / 1e9);
+    printf("- Diferencia máxima frente al kernel genérico: %e\n", diferencia);
+
+    free(ptrA);
+    free(ptrB);
+    free(ptrC);
+    free(A);
+    free(B);
+    free(C);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,116 @@
+/*
+ * matrices_lote.h
+ *
+ * Kernels de la multiplicación por lotes de matrices pequeñas n x n (por filas,
+ * sin relleno), compartidos por matrices_lote y matrices_bench:
+ *
+ *   kernel_generico            cualquier n, orden i-k-j
+ *   kernel_4 ... kernel_32     n fijo en compilación, bucles desenrollados y
+ *                              vectorizados (DEFINIR_KERNEL_FIJO)
+ *   seleccionar_kernel         el especializado para n o el genérico
+ *   multiplicar_lote_zancada   lote descrito con zancadas
+ *   multiplicar_lote_punteros  lote descrito con arreglos de punteros
+ *
+ * Cada hilo OpenMP procesa un rango de productos completos. Todas las funciones
+ * son static inline, como en matrices_arena.h.
+ */
+
+#ifndef MATRICES_LOTE_H
+#define MATRICES_LOTE_H
+
+/* Firma común de los kernels de un producto n x n (fila mayor, sin relleno) */
+typedef void (*KernelLote)(const double* A, const double* B, double* C, int n);
+
+/* Permite usar #pragma dentro de macros con argumentos ya sustituidos */
+#define PRAGMA_(x) _Pragma(#x)
+#define PRAGMA(x) PRAGMA_(x)
+
+/* Kernel genérico para cualquier n: orden i-k-j con acumulación por filas de C */
+static inline void kernel_generico(const double* A, const double* B, double* C, int n) {
+    for (int i = 0; i < n; i++) {
+        double* c = C + i * n;
+        for (int j = 0; j < n; j++) {
+            c[j] = 0.0;
+        }
+        for (int k = 0; k < n; k++) {
+            double a = A[i * n + k];
+            const double* b = B + k * n;
+            for (int j = 0; j < n; j++) {
+                c[j] += a * b[j];
+            }
+        }
+    }
+}
+
+/* Genera un kernel con N conocido en compilación. La fila de C se acumula en un
+ * arreglo local que el compilador mantiene en registros; los bucles sobre k se
+ * desenrollan por completo y el bucle sobre j se vectoriza.
+ */
+#define DEFINIR_KERNEL_FIJO(N)                                                        \
+    static inline void kernel_##N(const double* restrict A, const double* restrict B, \
+                                  double* restrict C, int n) {                        \
+        (void)n;                                                                      \
+        for (int i = 0; i < N; i++) {                                                 \
+            double c[N];                                                              \
+            PRAGMA(omp simd)                                                          \
+            for (int j = 0; j < N; j++) {                                             \
+                c[j] = 0.0;                                                           \
+            }                                                                         \
+            PRAGMA(GCC unroll N)                                                      \
+            for (int k = 0; k < N; k++) {                                             \
+                double a = A[i * N + k];                                              \
+                PRAGMA(omp simd)                                                      \
+                for (int j = 0; j < N; j++) {                                         \
+                    c[j] += a * B[k * N + j];                                         \
+                }                                                                     \
+            }                                                                         \
+            PRAGMA(omp simd)                                                          \
+            for (int j = 0; j < N; j++) {                                             \
+                C[i * N + j] = c[j];                                                  \
+            }                                                                         \
+        }                                                                             \
+    }
+
+DEFINIR_KERNEL_FIJO(4)
+DEFINIR_KERNEL_FIJO(8)
+DEFINIR_KERNEL_FIJO(16)
+DEFINIR_KERNEL_FIJO(32)
+
+/* Devuelve el kernel especializado para n, o el genérico si no hay uno */
+static inline KernelLote seleccionar_kernel(int n) {
+    switch (n) {
+        case 4:  return kernel_4;
+        case 8:  return kernel_8;
+        case 16: return kernel_16;
+        case 32: return kernel_32;
+        default: return kernel_generico;
+    }
+}
+
+/* Multiplica un lote descrito con zancadas: C[b] = A[b] * B[b] para b en [0, num_lote).
+ * Una zancada de 0 en A o B reutiliza la misma matriz para todo el lote.
+ */
+static inline void multiplicar_lote_zancada(const double* A, long zancadaA,
+                                            const double* B, long zancadaB,
+                                            double* C, long zancadaC,
+                                            int n, long num_lote, int num_hilos) {
+    KernelLote kernel = seleccionar_kernel(n);
+
+    #pragma omp parallel for schedule(static) num_threads(num_hilos)
+    for (long b = 0; b < num_lote; b++) {
+        kernel(A + b * zancadaA, B + b * zancadaB, C + b * zancadaC, n);
+    }
+}
+
+/* Multiplica un lote descrito con arreglos de punteros: C[b] = A[b] * B[b] */
+static inline void multiplicar_lote_punteros(const double* const* A, const double* const* B,
+                                             double* const* C, int n, long num_lote, int num_hilos) {
+    KernelLote kernel = seleccionar_kernel(n);
+
+    #pragma omp parallel for schedule(static) num_threads(num_hilos)
+    for (long b = 0; b < num_lote; b++) {
+        kernel(A[b], B[b], C[b], n);
+    }
+}
+
+#endif /* MATRICES_LOTE_H */
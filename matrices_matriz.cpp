@@ -0,0 +1,192 @@
+/*
+ * matrices_matriz.cpp
+ *
+ * Demostración y prueba de la capa Matrix<T> de matrices_matriz.hpp. Cada
+ * expresión se evalúa con una sola llamada al núcleo fusionado y se compara con
+ * el producto i-k-j y el epílogo aplicados por separado en double:
+ *
+ *   - C = relu(alpha * A * B + beta * C + bias) en double y en float;
+ *   - un bloque de C = bloque de A * bloque de B + D, todo vistas sin copia;
+ *   - C = A * C debe rechazarse (A o B no pueden solaparse con el destino).
+ *
+ * Uso:
+ *   g++ -std=c++20 -O3 -march=native matrices_matriz.cpp -o matrices_matriz -fopenmp
+ *   ./matrices_matriz -r 300 -c 200 -q 250 -h 4
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <vector>
+#include <getopt.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "matrices_matriz.hpp"
+
+// Referencia en double: R = relu(alpha * X * Y + beta * E + bias), sin fusionar
+template <class T>
+static std::vector<double> referencia(const matrices::MatrixView<T>& X, const matrices::MatrixView<T>& Y, double alpha,
+                                      double beta, const matrices::MatrixView<T>* E, const std::vector<T>* bias,
+                                      bool relu) {
+    int m = X.filas(), k = X.columnas(), n = Y.columnas();
+    std::vector<double> R((size_t)m * n, 0.0);
+    for (int i = 0; i < m; i++) {
+        for (int p = 0; p < k; p++) {
+            double x = X(i, p);
+            for (int j = 0; j < n; j++) {
+                R[(size_t)i * n + j] += x * Y(p, j);
+            }
+        }
+    }
+    for (int i = 0; i < m; i++) {
+        for (int j = 0; j < n; j++) {
+            double v = alpha * R[(size_t)i * n + j];
+            if (E != nullptr) {
+                v += beta * (*E)(i, j);
+            }
+            if (bias != nullptr) {
+                v += (*bias)[j];
+            }
+            R[(size_t)i * n + j] = relu && v < 0.0 ? 0.0 : v;
+        }
+    }
+    return R;
+}
+
+// ||C - R|| / ||R|| en norma de Frobenius
+template <class T>
+static double error_relativo(const std::vector<double>& R, const matrices::MatrixView<T>& C) {
+    double num = 0.0, den = 0.0;
+    for (int i = 0; i < C.filas(); i++) {
+        for (int j = 0; j < C.columnas(); j++) {
+            double r = R[(size_t)i * C.columnas() + j];
+            double d = (double)C(i, j) - r;
+            num += d * d;
+            den += r * r;
+        }
+    }
+    return den > 0.0 ? std::sqrt(num / den) : std::sqrt(num);
+}
+
+// Elementos de [-5, 5) con parte fraccionaria, para que float no sea exacto
+template <class T>
+static void llenar(const matrices::MatrixView<T>& M) {
+    for (int i = 0; i < M.filas(); i++) {
+        for (int j = 0; j < M.columnas(); j++) {
+            M(i, j) = (T)(std::rand() % 1000) / (T)100 - (T)5;
+        }
+    }
+}
+
+// C = relu(alpha * A * B + beta * C + bias) frente a la referencia; devuelve el error
+template <class T>
+static double probar_epilogo(int m, int k, int n) {
+    matrices::Matrix<T> A(m, k), B(k, n), C(m, n);
+    std::vector<T> bias(n);
+    llenar<T>(A);
+    llenar<T>(B);
+    llenar<T>(C);
+    for (int j = 0; j < n; j++) {
+        bias[j] = (T)(std::rand() % 10) - (T)5;
+    }
+    T alpha = (T)1.5, beta = (T)-0.5;
+
+    matrices::Matrix<T> C0 = C;
+    std::vector<double> R = referencia<T>(A, B, alpha, beta, &C0, &bias, true);
+    C = matrices::relu(alpha * A * B + beta * C + bias);
+    return error_relativo<T>(R, C);
+}
+
+// Función para mostrar ayuda
+static void mostrar_ayuda() {
+    std::printf("Uso: ./matrices_matriz [-r filasA] [-c columnasA] [-q columnasB] [-h hilos]\n");
+    std::printf("Opciones:\n");
+    std::printf("  -r, --filasA        Filas de A y de C (por defecto: 200)\n");
+    std::printf("  -c, --columnasA     Columnas de A y filas de B (por defecto: 150)\n");
+    std::printf("  -q, --columnasB     Columnas de B y de C (por defecto: 170)\n");
+    std::printf("  -h, --hilos         Hilos OpenMP (por defecto: los del entorno)\n");
+    std::printf("  -a, --ayuda         Mostrar esta ayuda\n");
+}
+
+int main(int argc, char* argv[]) {
+    int m = 200, k = 150, n = 170;
+
+    static struct option opciones_largas[] = {
+        {"filasA", required_argument, 0, 'r'},
+        {"columnasA", required_argument, 0, 'c'},
+        {"columnasB", required_argument, 0, 'q'},
+        {"hilos", required_argument, 0, 'h'},
+        {"ayuda", no_argument, 0, 'a'},
+        {0, 0, 0, 0}
+    };
+
+    int opcion;
+    while ((opcion = getopt_long(argc, argv, "r:c:q:h:a", opciones_largas, NULL)) != -1) {
+        switch (opcion) {
+            case 'r':
+            case 'c':
+            case 'q': {
+                int dim = std::atoi(optarg);
+                if (dim <= 0) {
+                    std::fprintf(stderr, "Las dimensiones de las matrices deben ser positivas\n");
+                    return EXIT_FAILURE;
+                }
+                (opcion == 'r' ? m : opcion == 'c' ? k : n) = dim;
+                break;
+            }
+            case 'h': {
+                int num_hilos = std::atoi(optarg);
+                if (num_hilos <= 0) {
+                    std::fprintf(stderr, "El número de hilos debe ser positivo\n");
+                    return EXIT_FAILURE;
+                }
+#ifdef _OPENMP
+                omp_set_num_threads(num_hilos);
+#endif
+                break;
+            }
+            case 'a':
+                mostrar_ayuda();
+                return EXIT_SUCCESS;
+            default:
+                mostrar_ayuda();
+                return EXIT_FAILURE;
+        }
+    }
+
+    std::srand(1234);
+    std::printf("Expresiones sobre A %dx%d y B %dx%d.\n", m, k, k, n);
+    std::printf("- Error relativo (double, C = relu(alpha * A * B + beta * C + bias)): %e\n",
+                probar_epilogo<double>(m, k, n));
+    std::printf("- Error relativo (float, C = relu(alpha * A * B + beta * C + bias)): %e\n",
+                probar_epilogo<float>(m, k, n));
+
+    // Vistas: el cuadrante inferior derecho de C a partir de bloques de A, B y D
+    matrices::Matrix<double> A(m, k), B(k, n), C(m, n), D(m, n);
+    llenar<double>(A);
+    llenar<double>(B);
+    llenar<double>(D);
+    int mb = m / 2, kb = k - k / 3, nb = n / 2;
+    auto Ab = A.bloque(m - mb, k - kb, mb, kb);
+    auto Bb = B.bloque(0, n - nb, kb, nb);
+    auto Db = D.bloque(0, 0, mb, nb);
+    auto Cb = C.bloque(m - mb, n - nb, mb, nb);
+    std::vector<double> R = referencia<double>(Ab, Bb, 1.0, 1.0, &Db, nullptr, false);
+    Cb = Ab * Bb + Db;
+    std::printf("- Error relativo (vistas, bloque de C = bloque de A * bloque de B + D): %e\n",
+                error_relativo<double>(R, Cb));
+
+    // A no puede solaparse con el destino
+    matrices::Matrix<double> Q(k, k);
+    matrices::Matrix<double> P(k, k);
+    bool rechazado = false;
+    try {
+        Q = P * Q;
+    } catch (const std::invalid_argument&) {
+        rechazado = true;
+    }
+    std::printf("- Destino solapado con un operando rechazado: %s\n", rechazado ? "sí" : "no");
+    return rechazado ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,302 @@
+/*
+ * matrices_matriz.hpp
+ *
+ * Capa C++20 de sólo cabecera sobre matrices_epilogo.h: Matrix<T> (dueña de sus
+ * datos, por filas) y MatrixView<T> (bloque sin copia de otra matriz, con dimensión
+ * principal ld), para T double o float, con plantillas de expresión:
+ *
+ *   matrices::Matrix<double> A(m, k), B(k, n), C(m, n);
+ *   std::vector<double> bias(n);
+ *   C = alpha * A * B + beta * C + bias;          // una sola llamada al núcleo
+ *   C = matrices::relu(A * B + bias);
+ *   C.bloque(0, 0, 64, 64) = A.bloque(0, 0, 64, k) * B.bloque(0, 0, k, 64);
+ *
+ * Los operadores no calculan nada: construyen un nodo (Escalada, Producto,
+ * Epilogada) con punteros a los operandos, y la asignación lo baja a una única
+ * llamada a gemm_epilogo_filas: el epílogo se aplica a cada bloque de C mientras
+ * sigue en registros, sin matrices intermedias ni pasadas extra por memoria. Con
+ * OpenMP las filas de C se reparten entre los hilos del equipo.
+ *
+ * El término beta puede ser el propio destino o una matriz disjunta; A y B no
+ * pueden solaparse con el destino. Las dimensiones incompatibles y los solapes no
+ * admitidos lanzan std::invalid_argument. Las expresiones guardan referencias a los
+ * operandos: deben asignarse en la misma sentencia.
+ *
+ * Compilar con g++ -std=c++20 (y -fopenmp para repartir las filas).
+ */
+
+#ifndef MATRICES_MATRIZ_HPP
+#define MATRICES_MATRIZ_HPP
+
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "matrices_epilogo.h"
+
+namespace matrices {
+
+// Tipo de epílogo y núcleo de matrices_epilogo.h para cada tipo de elemento
+template <class T>
+struct Nucleo;
+
+template <>
+struct Nucleo<double> {
+    using Epilogo = ::Epilogo;
+    static void filas(const double* A, int lda, const double* B, int ldb, const double* E, int lde, double* C,
+                      int ldc, int i0, int i1, int k, int n, const Epilogo* ep) {
+        gemm_epilogo_filas(A, lda, B, ldb, E, lde, C, ldc, i0, i1, k, n, ep);
+    }
+};
+
+template <>
+struct Nucleo<float> {
+    using Epilogo = ::Epilogo_f32;
+    static void filas(const float* A, int lda, const float* B, int ldb, const float* E, int lde, float* C,
+                      int ldc, int i0, int i1, int k, int n, const Epilogo* ep) {
+        gemm_epilogo_filas_f32(A, lda, B, ldb, E, lde, C, ldc, i0, i1, k, n, ep);
+    }
+};
+
+template <class T>
+struct Epilogada;
+
+// Bloque de una matriz guardada por filas: el elemento (i, j) está en datos[i * ld + j]
+template <class T>
+class MatrixView {
+    static_assert(std::is_same_v<T, double> || std::is_same_v<T, float>, "Matrix<T> sólo admite double y float");
+
+public:
+    MatrixView(T* datos, int filas, int columnas, int ld)
+        : datos_(datos), filas_(filas), columnas_(columnas), ld_(ld) {}
+
+    T* datos() const { return datos_; }
+    int filas() const { return filas_; }
+    int columnas() const { return columnas_; }
+    int ld() const { return ld_; }
+    T& operator()(int i, int j) const { return datos_[(std::size_t)i * ld_ + j]; }
+
+    // Sub-bloque filas x columnas que empieza en (fila0, col0), sin copiar
+    MatrixView bloque(int fila0, int col0, int filas, int columnas) const {
+        if (fila0 < 0 || col0 < 0 || filas < 0 || columnas < 0 || fila0 + filas > filas_
+            || col0 + columnas > columnas_) {
+            throw std::invalid_argument("bloque fuera de la matriz");
+        }
+        return MatrixView(datos_ + (std::size_t)fila0 * ld_ + col0, filas, columnas, ld_);
+    }
+
+    // Evalúa la expresión con una sola llamada al núcleo fusionado
+    MatrixView& operator=(const Epilogada<T>& x) {
+        asignar(x);
+        return *this;
+    }
+
+protected:
+    MatrixView() = default;
+    void asignar(const Epilogada<T>& x) const;
+
+    T* datos_ = nullptr;
+    int filas_ = 0;
+    int columnas_ = 0;
+    int ld_ = 0;
+};
+
+// Matriz dueña de sus datos (contiguos, ld == columnas); se usa donde se espera una vista
+template <class T>
+class Matrix : public MatrixView<T> {
+public:
+    Matrix(int filas, int columnas) : datos_propios_((std::size_t)filas * columnas) {
+        if (filas < 0 || columnas < 0) {
+            throw std::invalid_argument("dimensiones negativas");
+        }
+        apuntar(filas, columnas);
+    }
+    Matrix(const Matrix& otra) : MatrixView<T>(), datos_propios_(otra.datos_propios_) {
+        apuntar(otra.filas_, otra.columnas_);
+    }
+    Matrix(Matrix&& otra) noexcept : MatrixView<T>(), datos_propios_(std::move(otra.datos_propios_)) {
+        apuntar(otra.filas_, otra.columnas_);
+    }
+    Matrix& operator=(const Matrix& otra) {
+        datos_propios_ = otra.datos_propios_;
+        apuntar(otra.filas_, otra.columnas_);
+        return *this;
+    }
+    Matrix& operator=(Matrix&& otra) noexcept {
+        datos_propios_ = std::move(otra.datos_propios_);
+        apuntar(otra.filas_, otra.columnas_);
+        return *this;
+    }
+    Matrix& operator=(const Epilogada<T>& x) {
+        this->asignar(x);
+        return *this;
+    }
+
+    MatrixView<T> vista() const { return *this; }
+
+private:
+    void apuntar(int filas, int columnas) {
+        this->datos_ = datos_propios_.data();
+        this->filas_ = filas;
+        this->columnas_ = columnas;
+        this->ld_ = columnas;
+    }
+
+    std::vector<T> datos_propios_;
+};
+
+// factor * M, a la espera de multiplicarse o de sumarse como término beta
+template <class T>
+struct Escalada {
+    T factor;
+    MatrixView<T> m;
+};
+
+// alpha * A * B
+template <class T>
+struct Producto {
+    T alpha;
+    MatrixView<T> a;
+    MatrixView<T> b;
+};
+
+// relu(alpha * A * B + beta * E + bias): lo que baja a gemm_epilogo_filas
+template <class T>
+struct Epilogada {
+    Producto<T> producto;
+    T beta = 0;
+    MatrixView<T> e = MatrixView<T>(nullptr, 0, 0, 0);
+    const std::vector<T>* bias = nullptr;
+    bool relu = false;
+
+    Epilogada(const Producto<T>& p) : producto(p) {}  // NOLINT: un producto solo también se asigna
+};
+
+template <class T>
+Escalada<T> operator*(std::type_identity_t<T> factor, const MatrixView<T>& m) {
+    return {factor, m};
+}
+
+template <class T>
+Producto<T> operator*(const MatrixView<T>& a, const MatrixView<T>& b) {
+    return {T(1), a, b};
+}
+
+template <class T>
+Producto<T> operator*(const Escalada<T>& a, const MatrixView<T>& b) {
+    return {a.factor, a.m, b};
+}
+
+template <class T>
+Producto<T> operator*(std::type_identity_t<T> factor, const Producto<T>& p) {
+    return {factor * p.alpha, p.a, p.b};
+}
+
+template <class T>
+Epilogada<T> operator+(const Epilogada<T>& x, const Escalada<T>& e) {
+    if (x.e.datos() != nullptr) {
+        throw std::invalid_argument("la expresión admite un solo término beta * C");
+    }
+    Epilogada<T> r = x;
+    r.beta = e.factor;
+    r.e = e.m;
+    return r;
+}
+
+template <class T>
+Epilogada<T> operator+(const Producto<T>& p, const Escalada<T>& e) {
+    return Epilogada<T>(p) + e;
+}
+
+template <class T>
+Epilogada<T> operator+(const Epilogada<T>& x, const MatrixView<T>& m) {
+    return x + Escalada<T>{T(1), m};
+}
+
+template <class T>
+Epilogada<T> operator+(const Producto<T>& p, const MatrixView<T>& m) {
+    return Epilogada<T>(p) + Escalada<T>{T(1), m};
+}
+
+template <class T>
+Epilogada<T> operator+(const Epilogada<T>& x, const std::vector<T>& bias) {
+    if (x.bias != nullptr) {
+        throw std::invalid_argument("la expresión admite un solo sesgo");
+    }
+    Epilogada<T> r = x;
+    r.bias = &bias;
+    return r;
+}
+
+template <class T>
+Epilogada<T> operator+(const Producto<T>& p, const std::vector<T>& bias) {
+    return Epilogada<T>(p) + bias;
+}
+
+template <class T>
+Epilogada<T> relu(const Epilogada<T>& x) {
+    Epilogada<T> r = x;
+    r.relu = true;
+    return r;
+}
+
+template <class T>
+Epilogada<T> relu(const Producto<T>& p) {
+    return relu(Epilogada<T>(p));
+}
+
+// ¿Se solapan en memoria los bloques X e Y? (intervalos de su primer al último elemento)
+template <class T>
+bool se_solapan(const MatrixView<T>& X, const MatrixView<T>& Y) {
+    if (X.filas() == 0 || X.columnas() == 0 || Y.filas() == 0 || Y.columnas() == 0) {
+        return false;
+    }
+    const T* x_fin = &X(X.filas() - 1, X.columnas() - 1) + 1;
+    const T* y_fin = &Y(Y.filas() - 1, Y.columnas() - 1) + 1;
+    return X.datos() < y_fin && Y.datos() < x_fin;
+}
+
+template <class T>
+void MatrixView<T>::asignar(const Epilogada<T>& x) const {
+    const Producto<T>& p = x.producto;
+    int m = p.a.filas(), k = p.a.columnas(), n = p.b.columnas();
+    if (p.b.filas() != k || filas_ != m || columnas_ != n) {
+        throw std::invalid_argument("dimensiones incompatibles en C = alpha * A * B");
+    }
+    if (se_solapan(p.a, *this) || se_solapan(p.b, *this)) {
+        throw std::invalid_argument("A y B no pueden solaparse con el destino");
+    }
+    const T* e = nullptr;
+    int lde = 0;
+    if (x.beta != 0 && x.e.datos() != nullptr) {
+        if (x.e.filas() != m || x.e.columnas() != n) {
+            throw std::invalid_argument("dimensiones incompatibles en el término beta * C");
+        }
+        // El núcleo lee E(i, j) justo antes de escribir C(i, j): vale E == C, no un solape parcial
+        bool mismo = x.e.datos() == datos_ && x.e.ld() == ld_;
+        if (!mismo && se_solapan(x.e, *this)) {
+            throw std::invalid_argument("el término beta * C se solapa en parte con el destino");
+        }
+        e = x.e.datos();
+        lde = x.e.ld();
+    }
+    if (x.bias != nullptr && (int)x.bias->size() != n) {
+        throw std::invalid_argument("el sesgo debe tener una entrada por columna de C");
+    }
+
+    typename Nucleo<T>::Epilogo ep = {p.alpha, e != nullptr ? x.beta : T(0),
+                                      x.bias != nullptr ? x.bias->data() : nullptr, x.relu ? 1 : 0};
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < m; i++) {
+        Nucleo<T>::filas(p.a.datos(), p.a.ld(), p.b.datos(), p.b.ld(), e, lde, datos_, ld_, i, i + 1, k, n, &ep);
+    }
+#else
+    Nucleo<T>::filas(p.a.datos(), p.a.ld(), p.b.datos(), p.b.ld(), e, lde, datos_, ld_, 0, m, k, n, &ep);
+#endif
+}
+
+}  // namespace matrices
+
+#endif /* MATRICES_MATRIZ_HPP */
@@ -0,0 +1,313 @@
+/*
+ * matrices_morton.h
+ *
+ * Multiplicación recursiva "cache-oblivious" sobre matrices guardadas en orden
+ * de Morton (curva Z) por bloques. La matriz se divide en una rejilla de
+ * 2^niveles x 2^niveles bloques pequeños; cada bloque se guarda por filas y los
+ * bloques se colocan en orden Z, de modo que cada cuadrante de cada nivel de la
+ * recursión es un tramo contiguo de memoria:
+ *
+ *   +----+----+
+ *   | 0  | 1  |     cuadrante q de una submatriz de s x s bloques:
+ *   +----+----+     datos + q * (s/2)^2 * tf * tc
+ *   | 2  | 3  |
+ *   +----+----+
+ *
+ * La recursión C += A * B divide los tres operandos en cuadrantes hasta llegar a
+ * un bloque, así que en algún nivel los operandos caben en cada nivel de caché
+ * sin conocer sus tamaños: no hay nada que ajustar por máquina.
+ *
+ * Los tamaños de bloque (tf x tc) se eligen por matriz para que 2^niveles bloques
+ * cubran cada dimensión con el mínimo relleno; A, B y C comparten niveles. Con
+ * formas muy desiguales (p. ej. 20000 x 1 x 1) la rejilla común obliga a rellenar
+ * la dimensión pequeña hasta 2^niveles; morton_compensa lo detecta para que el
+ * llamador use otro algoritmo.
+ *
+ * Uso típico:
+ *   if (!morton_compensa(m, k, n)) { ...otro algoritmo... }
+ *   int niveles = niveles_morton(m, k, n);
+ *   MatrizMorton zA = reservar_morton(m, k, niveles), zB = ..., zC = ...;
+ *   convertir_a_morton(A, &zA);
+ *   convertir_a_morton(B, &zB);
+ *   multiplicar_morton(&zA, &zB, &zC);
+ *   convertir_desde_morton(&zC, C);
+ *
+ * Con -fopenmp se definen además convertir_a_morton_openmp, convertir_desde_morton_openmp
+ * y multiplicar_morton_openmp, que reparten la conversión por filas de bloques y la
+ * recursión en tareas (matrices_openmp y matrices_bench).
+ *
+ * Todas las funciones son static inline, como en matrices_arena.h.
+ */
+
+#ifndef MATRICES_MORTON_H
+#define MATRICES_MORTON_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Lado máximo de un bloque: tres bloques de 32 x 32 doubles (24 KiB) caben en L1 */
+#define MORTON_BLOQUE_MAX 32
+
+typedef struct {
+    double* datos;   /* 4^niveles bloques en orden Z, cada uno tf x tc por filas */
+    int filas;       /* dimensiones lógicas */
+    int columnas;
+    int tf;          /* filas y columnas de cada bloque */
+    int tc;
+    int niveles;     /* la rejilla es de 2^niveles x 2^niveles bloques */
+} MatrizMorton;
+
+/* Niveles mínimos para que ninguna dimensión necesite bloques mayores que MORTON_BLOQUE_MAX */
+static inline int niveles_morton(int m, int k, int n) {
+    int mayor = m > k ? m : k;
+    mayor = mayor > n ? mayor : n;
+    int niveles = 0;
+    while (((mayor + (1 << niveles) - 1) >> niveles) > MORTON_BLOQUE_MAX) {
+        niveles++;
+    }
+    return niveles;
+}
+
+/* Trabajo máximo admitido de la rejilla rellenada frente a m * k * n */
+#define MORTON_RELLENO_MAX 2.0
+
+/* Cociente entre los flops de la recursión (8^niveles bloques de tm x tk x tn,
+ * relleno incluido) y los m * k * n útiles. También acota el relleno de memoria de
+ * cada operando, que es el producto de dos de sus tres factores.
+ */
+static inline double relleno_morton(int m, int k, int n) {
+    int lado = 1 << niveles_morton(m, k, n);
+    double tm = (m + lado - 1) / lado, tk = (k + lado - 1) / lado, tn = (n + lado - 1) / lado;
+    return (double)lado * lado * lado * tm * tk * tn / ((double)m * k * n);
+}
+
+/* Indica si la forma m x k x n admite la rejilla común sin rellenar demasiado */
+static inline int morton_compensa(int m, int k, int n) {
+    return relleno_morton(m, k, n) <= MORTON_RELLENO_MAX;
+}
+
+/* Intercala los bits de x con ceros: ...b2 b1 b0 -> ...0 b2 0 b1 0 b0 */
+static inline unsigned esparcir_bits(unsigned x) {
+    x &= 0xFFFF;
+    x = (x | (x << 8)) & 0x00FF00FF;
+    x = (x | (x << 4)) & 0x0F0F0F0F;
+    x = (x | (x << 2)) & 0x33333333;
+    x = (x | (x << 1)) & 0x55555555;
+    return x;
+}
+
+/* Posición en orden Z del bloque (bi, bj): la fila aporta el bit alto de cada par */
+static inline size_t indice_morton(int bi, int bj) {
+    return ((size_t)esparcir_bits((unsigned)bi) << 1) | esparcir_bits((unsigned)bj);
+}
+
+/* Reserva una matriz filas x columnas en orden Z con la rejilla de niveles dada */
+static inline MatrizMorton reservar_morton(int filas, int columnas, int niveles) {
+    MatrizMorton z;
+    int lado = 1 << niveles;
+    z.filas = filas;
+    z.columnas = columnas;
+    z.niveles = niveles;
+    z.tf = (filas + lado - 1) / lado;
+    z.tc = (columnas + lado - 1) / lado;
+    size_t bytes = (size_t)lado * lado * z.tf * z.tc * sizeof(double);
+    bytes = (bytes + 63) & ~(size_t)63;  /* aligned_alloc exige un múltiplo del alineamiento */
+    z.datos = (double*)aligned_alloc(64, bytes);
+    if (z.datos == NULL) {
+        fprintf(stderr, "Error en la asignación de memoria para la matriz en orden Z\n");
+        exit(EXIT_FAILURE);
+    }
+    return z;
+}
+
+static inline void liberar_morton(MatrizMorton* z) {
+    free(z->datos);
+    z->datos = NULL;
+}
+
+/* Copia la fila de bloques bi de M (formato de reservar_matriz) a z, rellenando con
+ * ceros fuera de la matriz lógica. Las filas de bloque son independientes, así que
+ * la versión OpenMP las reparte entre hilos.
+ */
+static inline void fila_bloques_a_morton(double** M, MatrizMorton* z, int bi) {
+    int lado = 1 << z->niveles;
+    size_t tam_bloque = (size_t)z->tf * z->tc;
+    for (int bj = 0; bj < lado; bj++) {
+        double* bloque = z->datos + indice_morton(bi, bj) * tam_bloque;
+        int j0 = bj * z->tc;
+        int ancho = z->columnas - j0 < z->tc ? z->columnas - j0 : z->tc;
+        if (ancho < 0) {
+            ancho = 0;
+        }
+        for (int r = 0; r < z->tf; r++) {
+            int i = bi * z->tf + r;
+            double* destino = bloque + (size_t)r * z->tc;
+            if (i < z->filas && ancho > 0) {
+                memcpy(destino, M[i] + j0, ancho * sizeof(double));
+                memset(destino + ancho, 0, (z->tc - ancho) * sizeof(double));
+            } else {
+                memset(destino, 0, z->tc * sizeof(double));
+            }
+        }
+    }
+}
+
+/* Copia la fila de bloques bi de z a M, descartando el relleno */
+static inline void fila_bloques_desde_morton(const MatrizMorton* z, double** M, int bi) {
+    int lado = 1 << z->niveles;
+    size_t tam_bloque = (size_t)z->tf * z->tc;
+    for (int bj = 0; bj < lado; bj++) {
+        const double* bloque = z->datos + indice_morton(bi, bj) * tam_bloque;
+        int j0 = bj * z->tc;
+        int ancho = z->columnas - j0 < z->tc ? z->columnas - j0 : z->tc;
+        for (int r = 0; r < z->tf && ancho > 0; r++) {
+            int i = bi * z->tf + r;
+            if (i >= z->filas) {
+                break;
+            }
+            memcpy(M[i] + j0, bloque + (size_t)r * z->tc, ancho * sizeof(double));
+        }
+    }
+}
+
+/* Conversión completa desde el formato por filas de reservar_matriz */
+static inline void convertir_a_morton(double** M, MatrizMorton* z) {
+    for (int bi = 0; bi < (1 << z->niveles); bi++) {
+        fila_bloques_a_morton(M, z, bi);
+    }
+}
+
+/* Conversión completa hacia el formato por filas de reservar_matriz */
+static inline void convertir_desde_morton(const MatrizMorton* z, double** M) {
+    for (int bi = 0; bi < (1 << z->niveles); bi++) {
+        fila_bloques_desde_morton(z, M, bi);
+    }
+}
+
+/* Caso base: C (tm x tn) += A (tm x tk) * B (tk x tn), bloques contiguos por filas */
+static inline void bloque_morton(double* restrict C, const double* restrict A, const double* restrict B,
+                                 int tm, int tk, int tn) {
+    for (int i = 0; i < tm; i++) {
+        double* c = C + i * tn;
+        const double* a = A + i * tk;
+        for (int p = 0; p < tk; p++) {
+            double aip = a[p];
+            const double* b = B + p * tn;
+            for (int j = 0; j < tn; j++) {
+                c[j] += aip * b[j];
+            }
+        }
+    }
+}
+
+/* C += A * B sobre submatrices de s x s bloques en orden Z. Los bloques de A son
+ * tm x tk, los de B tk x tn y los de C tm x tn.
+ */
+static inline void morton_rec(double* C, const double* A, const double* B, int s,
+                              int tm, int tk, int tn) {
+    if (s == 1) {
+        bloque_morton(C, A, B, tm, tk, tn);
+        return;
+    }
+    int h = s / 2;
+    size_t qa = (size_t)h * h * tm * tk, qb = (size_t)h * h * tk * tn, qc = (size_t)h * h * tm * tn;
+    /* Cij += Ai0 * B0j + Ai1 * B1j */
+    morton_rec(C,          A,          B,          h, tm, tk, tn);
+    morton_rec(C + qc,     A,          B + qb,     h, tm, tk, tn);
+    morton_rec(C + 2 * qc, A + 2 * qa, B,          h, tm, tk, tn);
+    morton_rec(C + 3 * qc, A + 2 * qa, B + qb,     h, tm, tk, tn);
+    morton_rec(C,          A + qa,     B + 2 * qb, h, tm, tk, tn);
+    morton_rec(C + qc,     A + qa,     B + 3 * qb, h, tm, tk, tn);
+    morton_rec(C + 2 * qc, A + 3 * qa, B + 2 * qb, h, tm, tk, tn);
+    morton_rec(C + 3 * qc, A + 3 * qa, B + 3 * qb, h, tm, tk, tn);
+}
+
+/* C = A * B con los tres operandos en orden Z y los mismos niveles. Devuelve -1 si
+ * las formas no son compatibles.
+ */
+static inline int multiplicar_morton(const MatrizMorton* A, const MatrizMorton* B, MatrizMorton* C) {
+    if (A->niveles != B->niveles || A->niveles != C->niveles || A->columnas != B->filas
+        || C->filas != A->filas || C->columnas != B->columnas) {
+        return -1;
+    }
+    int lado = 1 << C->niveles;
+    memset(C->datos, 0, (size_t)lado * lado * C->tf * C->tc * sizeof(double));
+    morton_rec(C->datos, A->datos, B->datos, lado, A->tf, A->tc, B->tc);
+    return 0;
+}
+
+#ifdef _OPENMP
+
+/* Conversión a orden Z en paralelo: cada hilo copia filas de bloques completas */
+static inline void convertir_a_morton_openmp(double** M, MatrizMorton* z, int num_hilos) {
+    #pragma omp parallel for num_threads(num_hilos)
+    for (int bi = 0; bi < (1 << z->niveles); bi++) {
+        fila_bloques_a_morton(M, z, bi);
+    }
+}
+
+/* Conversión desde orden Z en paralelo */
+static inline void convertir_desde_morton_openmp(const MatrizMorton* z, double** M, int num_hilos) {
+    #pragma omp parallel for num_threads(num_hilos)
+    for (int bi = 0; bi < (1 << z->niveles); bi++) {
+        fila_bloques_desde_morton(z, M, bi);
+    }
+}
+
+/* Paso recursivo con tareas: cada cuadrante de C es una tarea que suma sus dos
+ * productos en orden, así que ninguna tarea escribe en el C de otra. Por debajo de
+ * corte bloques por lado se sigue con la recursión secuencial de matrices_morton.h.
+ */
+static inline void morton_rec_tareas(double* C, const double* A, const double* B, int s,
+                                     int tm, int tk, int tn, int corte) {
+    if (s <= corte) {
+        morton_rec(C, A, B, s, tm, tk, tn);
+        return;
+    }
+    int h = s / 2;
+    size_t qa = (size_t)h * h * tm * tk, qb = (size_t)h * h * tk * tn, qc = (size_t)h * h * tm * tn;
+    for (int q = 0; q < 4; q++) {
+        int fi = q >> 1, cj = q & 1;
+        /* Cq += A(fi,0) * B(0,cj) + A(fi,1) * B(1,cj) */
+        #pragma omp task firstprivate(fi, cj, q)
+        {
+            morton_rec_tareas(C + q * qc, A + 2 * fi * qa, B + cj * qb, h, tm, tk, tn, corte);
+            morton_rec_tareas(C + q * qc, A + (2 * fi + 1) * qa, B + (2 + cj) * qb, h, tm, tk, tn, corte);
+        }
+    }
+    #pragma omp taskwait
+}
+
+/* Multiplicación en orden Z con tareas OpenMP: C = A * B. Se generan tareas hasta
+ * tener al menos 8 por hilo; devuelve -1 si las formas no son compatibles.
+ */
+static inline int multiplicar_morton_openmp(const MatrizMorton* A, const MatrizMorton* B, MatrizMorton* C,
+                                            int num_hilos) {
+    if (A->niveles != B->niveles || A->niveles != C->niveles || A->columnas != B->filas
+        || C->filas != A->filas || C->columnas != B->columnas) {
+        return -1;
+    }
+    int lado = 1 << C->niveles;
+    size_t tam_bloque = (size_t)C->tf * C->tc;
+    int corte = lado;
+    while (corte > 1 && (long)(lado / corte) * (lado / corte) < 8L * num_hilos) {
+        corte /= 2;
+    }
+
+    #pragma omp parallel num_threads(num_hilos)
+    {
+        /* Cada hilo pone a cero (y toca primero) una parte de los bloques de C */
+        #pragma omp for
+        for (long b = 0; b < (long)lado * lado; b++) {
+            memset(C->datos + b * tam_bloque, 0, tam_bloque * sizeof(double));
+        }
+        #pragma omp single
+        morton_rec_tareas(C->datos, A->datos, B->datos, lado, A->tf, A->tc, B->tc, corte);
+    }
+    return 0;
+}
+
+#endif /* _OPENMP */
+
+#endif /* MATRICES_MORTON_H */
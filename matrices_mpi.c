@@ -1,47 +1,89 @@
 /*
  * matrices_mpi.c
  *
- * Multiplicación de matrices cuadradas con paralelización usando MPI.
+ * Multiplicación de matrices (cuadradas o rectangulares) con paralelización usando MPI.
  * Basado en el archivo matrices_secuencial.c, adaptado para distribución de trabajo
  * entre procesos MPI. Cada proceso calcula un conjunto de filas de la matriz resultado.
  *
  * Uso:
- *   mpicc matrices_mpi.c -o matrices_mpi
- *   mpirun -np <num_procesos> ./matrices_mpi -n <dimension_matriz>
+ *   mpicc matrices_mpi.c -o matrices_mpi -lm
+ *   mpirun -np <num_procesos> ./matrices_mpi -n <dimension_matriz> [-d f32|f64|mixed]
+ *   mpirun -np <num_procesos> ./matrices_mpi -r <filasA> -c <columnasA> -q <columnasB>
+ *   mpirun -np <num_procesos> ./matrices_mpi -n <dimension_matriz> -s estatico|coordinador|rma [-b minimo]
  *
  * Ejemplo:
  *   mpirun -np 4 ./matrices_mpi -n 1000
+ *   mpirun -np 4 ./matrices_mpi -n 1000 -d mixed
+ *   mpirun -np 4 ./matrices_mpi -n 2000 -s rma
  *
+ * Reparto de filas (-s):
+ *   estatico     cada proceso recibe de antemano el mismo número de filas (Scatterv y
+ *                Gatherv); el tiempo total lo marca el proceso más lento
+ *   coordinador  el root sólo coordina: cada proceso le pide un bloque de filas, recibe
+ *                esas filas de A, y al pedir el siguiente devuelve las de C
+ *   rma          sin coordinador: un contador en una ventana del root se incrementa con
+ *                MPI_Fetch_and_op y el número obtenido indica el bloque; las filas de A
+ *                se leen con MPI_Get y las de C se escriben con MPI_Put. El root también
+ *                calcula.
+ * En los dos modos dinámicos los bloques son guiados: empiezan grandes (las filas que
+ * quedan entre el doble de procesos que calculan) y se reducen hasta -b filas, de modo
+ * que los nodos rápidos se llevan más bloques y los lentos no retrasan el final.
  */
 
 #include <mpi.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
+#include <math.h>
+#include <string.h>
 #include <getopt.h>
+#include "matrices_precision.h"
 
-/* Reserva memoria contigua para una matriz de tamaño N x N */
-double* reservar_matriz(int N) {
-    return (double*)malloc(N * N * sizeof(double));
+/* Reserva memoria contigua para una matriz de tamaño filas x columnas */
+double* reservar_matriz(int filas, int columnas) {
+    return (double*)malloc((size_t)filas * columnas * sizeof(double));
 }
 
-/* Función para llenar una matriz N x N con valores aleatorios */
-void llenar_matriz(double* M, int N) {
-    for (int i = 0; i < N * N; i++) {
-        M[i] = (double)(rand() % 10);
+/* Función para llenar una matriz filas x columnas con valores aleatorios */
+void llenar_matriz(double* Mat, int filas, int columnas) {
+    for (long i = 0; i < (long)filas * columnas; i++) {
+        Mat[i] = (double)(rand() % 10);
     }
 }
 
-/* Función para imprimir una matriz N x N */
-void imprimir_matriz(double* M, int N) {
-    for (int i = 0; i < N; i++) {
-        for (int j = 0; j < N; j++) {
-            printf("%6.2f ", M[i * N + j]);
+/* Función para imprimir una matriz filas x columnas */
+void imprimir_matriz(double* Mat, int filas, int columnas) {
+    for (int i = 0; i < filas; i++) {
+        for (int j = 0; j < columnas; j++) {
+            printf("%6.2f ", Mat[i * columnas + j]);
         }
         printf("\n");
     }
 }
 
+/* Modos de reparto de las filas de A entre procesos */
+typedef enum {
+    REPARTO_ESTATICO,
+    REPARTO_COORDINADOR,
+    REPARTO_RMA
+} Reparto;
+
+/* Etiquetas de los mensajes del modo coordinador */
+#define ETIQUETA_PETICION 1   /* trabajador -> root: bloque terminado {inicio, filas} */
+#define ETIQUETA_RESULTADO 2  /* trabajador -> root: filas de C del bloque terminado */
+#define ETIQUETA_BLOQUE 3     /* root -> trabajador: siguiente bloque {inicio, filas}, filas 0 para terminar */
+#define ETIQUETA_FILAS_A 4    /* root -> trabajador: filas de A del bloque */
+
+/* Filas mínimas de un bloque guiado por defecto */
+#define BLOQUE_MINIMO 4
+
+/* Trabajo hecho por un proceso, para el informe de rendimiento por proceso */
+typedef struct {
+    double filas;
+    double bloques;
+    double tiempo_calculo;
+} TrabajoProceso;
+
 /* Obtiene el número de filas asignadas al proceso rank, dado N y size.
  * Se reparte la división entera, y los procesos con rank < (N % size) reciben una fila extra.
  */
@@ -55,19 +97,200 @@ int filas_por_proceso(int rank, int size, int N) {
     }
 }
 
-/* Calcula los desplazamientos (en número de elementos) para Scatterv/Gatherv */
-void calcular_desplazamientos(int* counts, int* displs, int size, int N) {
+/* Calcula los desplazamientos (en número de elementos) para Scatterv/Gatherv de una
+ * matriz de M filas con ancho elementos por fila */
+void calcular_desplazamientos(int* counts, int* displs, int size, int M, int ancho) {
     /* counts[i] = número de elementos (floats) que recibe el proceso i */
     /* displs[i] = desplazamiento (offset) en el arreglo global (en elementos) */
     int desplazamiento = 0;
     for (int i = 0; i < size; i++) {
-        int filas = filas_por_proceso(i, size, N);
-        counts[i] = filas * N;          // cada fila tiene N elementos
+        int filas = filas_por_proceso(i, size, M);
+        counts[i] = filas * ancho;      // cada fila tiene ancho elementos
         displs[i] = desplazamiento;
         desplazamiento += counts[i];
     }
 }
 
+/* Multiplica filas x K de A por B (K x N) con el kernel i-k-j del dtype
+ * (matrices_precision.h)
+ */
+void multiplicar_filas(TipoDato dtype, const void* A, const void* B, void* C, int filas, int K, int N) {
+    if (dtype == DTYPE_F64) {
+        multiplicar_filas_f64((const double*)A, K, (const double*)B, N, (double*)C, N, 0, filas, K, N);
+    } else if (dtype == DTYPE_F32) {
+        multiplicar_filas_f32((const float*)A, K, (const float*)B, N, (float*)C, N, 0, filas, K, N);
+    } else {
+        multiplicar_filas_mixta((const float*)A, K, (const float*)B, N, (double*)C, N, 0, filas, K, N);
+    }
+}
+
+/* Divide las M filas en bloques guiados para trabajadores procesos que calculan:
+ * cada bloque es ceil(restantes / (2 * trabajadores)) filas, pero no menos de minimo.
+ * inicios[b] es la primera fila del bloque b e inicios[num_bloques] = M. Devuelve
+ * num_bloques (como mucho M).
+ */
+int planificar_bloques_guiados(int M, int trabajadores, int minimo, int* inicios) {
+    int num_bloques = 0;
+    int fila = 0;
+    while (fila < M) {
+        int restantes = M - fila;
+        int filas = (restantes + 2 * trabajadores - 1) / (2 * trabajadores);
+        if (filas < minimo) {
+            filas = minimo;
+        }
+        if (filas > restantes) {
+            filas = restantes;
+        }
+        inicios[num_bloques++] = fila;
+        fila += filas;
+    }
+    inicios[num_bloques] = M;
+    return num_bloques;
+}
+
+/* Modo coordinador, lado del root: atiende peticiones de cualquier proceso hasta que
+ * no quedan bloques y todos los trabajadores han recibido la orden de terminar. Las
+ * filas de C llegan directamente a su sitio en C_salida.
+ */
+void coordinar_bloques(const char* A_envio, char* C_salida, int K, int N, const int* inicios, int num_bloques,
+                       int size, size_t tam_entrada, size_t tam_salida, MPI_Datatype tipo_entrada,
+                       MPI_Datatype tipo_salida) {
+    int siguiente = 0;
+    int activos = size - 1;
+    while (activos > 0) {
+        int hecho[2];
+        MPI_Status estado;
+        MPI_Recv(hecho, 2, MPI_INT, MPI_ANY_SOURCE, ETIQUETA_PETICION, MPI_COMM_WORLD, &estado);
+        int trabajador = estado.MPI_SOURCE;
+        if (hecho[1] > 0) {
+            MPI_Recv(C_salida + (size_t)hecho[0] * N * tam_salida, hecho[1] * N, tipo_salida, trabajador,
+                     ETIQUETA_RESULTADO, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        }
+        int bloque[2] = {0, 0};
+        if (siguiente < num_bloques) {
+            bloque[0] = inicios[siguiente];
+            bloque[1] = inicios[siguiente + 1] - inicios[siguiente];
+            siguiente++;
+        }
+        MPI_Send(bloque, 2, MPI_INT, trabajador, ETIQUETA_BLOQUE, MPI_COMM_WORLD);
+        if (bloque[1] > 0) {
+            MPI_Send(A_envio + (size_t)bloque[0] * K * tam_entrada, bloque[1] * K, tipo_entrada, trabajador,
+                     ETIQUETA_FILAS_A, MPI_COMM_WORLD);
+        } else {
+            activos--;
+        }
+    }
+}
+
+/* Modo coordinador, lado de un trabajador: pide bloques, los calcula y devuelve sus
+ * filas de C con la petición siguiente. max_filas es el mayor bloque posible.
+ */
+TrabajoProceso trabajar_coordinado(TipoDato dtype, const void* B_local, int K, int N, int max_filas,
+                                   size_t tam_entrada, size_t tam_salida, MPI_Datatype tipo_entrada,
+                                   MPI_Datatype tipo_salida) {
+    TrabajoProceso trabajo = {0.0, 0.0, 0.0};
+    void* A_bloque = malloc((size_t)max_filas * K * tam_entrada);
+    void* C_bloque = malloc((size_t)max_filas * N * tam_salida);
+    if (A_bloque == NULL || C_bloque == NULL) {
+        fprintf(stderr, "Error al asignar memoria para los bloques dinámicos\n");
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    int hecho[2] = {0, 0};
+    for (;;) {
+        MPI_Send(hecho, 2, MPI_INT, 0, ETIQUETA_PETICION, MPI_COMM_WORLD);
+        if (hecho[1] > 0) {
+            MPI_Send(C_bloque, hecho[1] * N, tipo_salida, 0, ETIQUETA_RESULTADO, MPI_COMM_WORLD);
+        }
+        int bloque[2];
+        MPI_Recv(bloque, 2, MPI_INT, 0, ETIQUETA_BLOQUE, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        if (bloque[1] == 0) {
+            break;
+        }
+        MPI_Recv(A_bloque, bloque[1] * K, tipo_entrada, 0, ETIQUETA_FILAS_A, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        double t = MPI_Wtime();
+        multiplicar_filas(dtype, A_bloque, B_local, C_bloque, bloque[1], K, N);
+        trabajo.tiempo_calculo += MPI_Wtime() - t;
+        trabajo.filas += bloque[1];
+        trabajo.bloques += 1.0;
+        hecho[0] = bloque[0];
+        hecho[1] = bloque[1];
+    }
+    free(A_bloque);
+    free(C_bloque);
+    return trabajo;
+}
+
+/* Modo rma: todos los procesos (root incluido) toman bloques con una suma atómica
+ * sobre el contador del root, leen sus filas de A y escriben las de C por RMA.
+ * A_envio y C_salida sólo se usan en el root.
+ */
+TrabajoProceso trabajar_rma(TipoDato dtype, int rank, void* A_envio, void* C_salida, const void* B_local, int M,
+                            int K, int N, const int* inicios, int num_bloques, int max_filas, size_t tam_entrada,
+                            size_t tam_salida, MPI_Datatype tipo_entrada, MPI_Datatype tipo_salida) {
+    TrabajoProceso trabajo = {0.0, 0.0, 0.0};
+    int contador = 0;
+    MPI_Win ventana_contador, ventana_A, ventana_C;
+    MPI_Win_create(rank == 0 ? &contador : NULL, rank == 0 ? sizeof(int) : 0, sizeof(int), MPI_INFO_NULL,
+                   MPI_COMM_WORLD, &ventana_contador);
+    MPI_Win_create(rank == 0 ? A_envio : NULL, rank == 0 ? (MPI_Aint)M * K * tam_entrada : 0, (int)tam_entrada,
+                   MPI_INFO_NULL, MPI_COMM_WORLD, &ventana_A);
+    MPI_Win_create(rank == 0 ? C_salida : NULL, rank == 0 ? (MPI_Aint)M * N * tam_salida : 0, (int)tam_salida,
+                   MPI_INFO_NULL, MPI_COMM_WORLD, &ventana_C);
+
+    void* A_bloque = malloc((size_t)max_filas * K * tam_entrada);
+    void* C_bloque = malloc((size_t)max_filas * N * tam_salida);
+    if (A_bloque == NULL || C_bloque == NULL) {
+        fprintf(stderr, "Error al asignar memoria para los bloques dinámicos\n");
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    MPI_Win_lock_all(0, ventana_contador);
+    MPI_Win_lock_all(0, ventana_A);
+    MPI_Win_lock_all(0, ventana_C);
+    for (;;) {
+        int uno = 1, bloque;
+        MPI_Fetch_and_op(&uno, &bloque, MPI_INT, 0, 0, MPI_SUM, ventana_contador);
+        MPI_Win_flush(0, ventana_contador);
+        if (bloque >= num_bloques) {
+            break;
+        }
+        int inicio = inicios[bloque], filas = inicios[bloque + 1] - inicios[bloque];
+        MPI_Get(A_bloque, filas * K, tipo_entrada, 0, (MPI_Aint)inicio * K, filas * K, tipo_entrada, ventana_A);
+        MPI_Win_flush(0, ventana_A);
+        double t = MPI_Wtime();
+        multiplicar_filas(dtype, A_bloque, B_local, C_bloque, filas, K, N);
+        trabajo.tiempo_calculo += MPI_Wtime() - t;
+        MPI_Put(C_bloque, filas * N, tipo_salida, 0, (MPI_Aint)inicio * N, filas * N, tipo_salida, ventana_C);
+        MPI_Win_flush(0, ventana_C);
+        trabajo.filas += filas;
+        trabajo.bloques += 1.0;
+    }
+    MPI_Win_unlock_all(ventana_C);
+    MPI_Win_unlock_all(ventana_A);
+    MPI_Win_unlock_all(ventana_contador);
+
+    /* MPI_Win_free es colectiva: al volver todas las filas de C están en el root */
+    MPI_Win_free(&ventana_C);
+    MPI_Win_free(&ventana_A);
+    MPI_Win_free(&ventana_contador);
+    free(A_bloque);
+    free(C_bloque);
+    return trabajo;
+}
+
+/* Error relativo en norma de Frobenius de C (double o float) frente a la referencia fp64 */
+double error_relativo(const double* referencia, const void* C, TipoDato dtype, long num_elementos) {
+    double num = 0.0, den = 0.0;
+    for (long i = 0; i < num_elementos; i++) {
+        double c = (dtype == DTYPE_F32) ? (double)((const float*)C)[i] : ((const double*)C)[i];
+        double d = c - referencia[i];
+        num += d * d;
+        den += referencia[i] * referencia[i];
+    }
+    return den > 0.0 ? sqrt(num / den) : sqrt(num);
+}
+
+
 #include <mpi.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -77,7 +300,11 @@ void calcular_desplazamientos(int* counts, int* displs, int size, int N) {
 int main(int argc, char* argv[]) {
     int rank, size;
     int N = 3;  // dimensión por defecto (3x3), si no se especifica -n
+    int M = -1, K = -1;  // A es M x K y B es K x N; por defecto M = K = N
     int opt;
+    TipoDato dtype = DTYPE_F64;
+    Reparto reparto = REPARTO_ESTATICO;
+    int bloque_minimo = BLOQUE_MINIMO;
 
     /* Inicializar MPI */
     MPI_Init(&argc, &argv);
@@ -85,22 +312,77 @@ int main(int argc, char* argv[]) {
     MPI_Comm_size(MPI_COMM_WORLD, &size);
 
     /* Procesar opciones de línea de comandos */
-    while ((opt = getopt(argc, argv, "n:")) != -1) {
+    while ((opt = getopt(argc, argv, "n:r:c:q:d:s:b:")) != -1) {
         switch (opt) {
             case 'n':
                 N = atoi(optarg);
                 break;
+            case 'r':
+                M = atoi(optarg);
+                break;
+            case 'c':
+                K = atoi(optarg);
+                break;
+            case 'q':
+                N = atoi(optarg);
+                break;
+            case 'd': {
+                int d = parsear_dtype(optarg);
+                if (d < 0) {
+                    if (rank == 0) {
+                        fprintf(stderr, "Tipo de dato no válido: %s (use f32, f64 o mixed)\n", optarg);
+                    }
+                    MPI_Finalize();
+                    exit(EXIT_FAILURE);
+                }
+                dtype = (TipoDato)d;
+                break;
+            }
+            case 's':
+                if (strcmp(optarg, "estatico") == 0) {
+                    reparto = REPARTO_ESTATICO;
+                } else if (strcmp(optarg, "coordinador") == 0) {
+                    reparto = REPARTO_COORDINADOR;
+                } else if (strcmp(optarg, "rma") == 0) {
+                    reparto = REPARTO_RMA;
+                } else {
+                    if (rank == 0) {
+                        fprintf(stderr, "Reparto no válido: %s (use estatico, coordinador o rma)\n", optarg);
+                    }
+                    MPI_Finalize();
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'b':
+                bloque_minimo = atoi(optarg);
+                if (bloque_minimo <= 0) {
+                    if (rank == 0) {
+                        fprintf(stderr, "El bloque mínimo debe ser un entero positivo.\n");
+                    }
+                    MPI_Finalize();
+                    exit(EXIT_FAILURE);
+                }
+                break;
             default:
                 if (rank == 0) {
-                    fprintf(stderr, "Uso: %s -n <dimension_matriz>\n", argv[0]);
+                    fprintf(stderr, "Uso: %s [-n <dimension_matriz> | -r <filasA> -c <columnasA> -q <columnasB>]"
+                                    " [-d f32|f64|mixed] [-s estatico|coordinador|rma] [-b minimo]\n", argv[0]);
                 }
                 MPI_Finalize();
                 exit(EXIT_FAILURE);
         }
     }
 
-    /* Verificar que N > 0 */
-    if (N <= 0) {
+    /* Las dimensiones no indicadas toman el valor de N (matrices cuadradas) */
+    if (M < 0) {
+        M = N;
+    }
+    if (K < 0) {
+        K = N;
+    }
+
+    /* Verificar que las dimensiones sean positivas */
+    if (M <= 0 || K <= 0 || N <= 0) {
         if (rank == 0) {
             fprintf(stderr, "La dimensión de la matriz debe ser un entero positivo.\n");
         }
@@ -108,12 +390,18 @@ int main(int argc, char* argv[]) {
         exit(EXIT_FAILURE);
     }
 
-    /* Verificar que N >= número de procesos, de lo contrario algunos procesos no tendrían filas */
-    if (N < size) {
+    /* Con un solo proceso no hay trabajadores a los que coordinar */
+    if (reparto == REPARTO_COORDINADOR && size == 1) {
+        fprintf(stderr, "Advertencia: el modo coordinador necesita al menos 2 procesos; se usa rma.\n");
+        reparto = REPARTO_RMA;
+    }
+
+    /* Verificar que M >= número de procesos, de lo contrario algunos procesos no tendrían filas */
+    if (reparto == REPARTO_ESTATICO && M < size) {
         if (rank == 0) {
             fprintf(stderr,
-                    "Advertencia: la dimensión de la matriz (%d) es menor que el número de procesos (%d).\n"
-                    "Algunos procesos no recibirán filas para procesar.\n", N, size);
+                    "Advertencia: el número de filas de A (%d) es menor que el número de procesos (%d).\n"
+                    "Algunos procesos no recibirán filas para procesar.\n", M, size);
         }
     }
 
@@ -122,15 +410,26 @@ int main(int argc, char* argv[]) {
     double* B = NULL;
     double* C = NULL;  // matriz resultado completa, sólo en root
 
+    /* Tamaño y tipo MPI de las entradas (A, B) y de la salida (C) según el dtype */
+    size_t tam_entrada = (dtype == DTYPE_F64) ? sizeof(double) : sizeof(float);
+    size_t tam_salida = (dtype == DTYPE_F32) ? sizeof(float) : sizeof(double);
+    MPI_Datatype tipo_entrada = (dtype == DTYPE_F64) ? MPI_DOUBLE : MPI_FLOAT;
+    MPI_Datatype tipo_salida = (dtype == DTYPE_F32) ? MPI_FLOAT : MPI_DOUBLE;
+
+    /* Entradas convertidas a float y resultado en el tipo de salida (sólo en root) */
+    float* A32 = NULL;
+    float* B32 = NULL;
+    void* C_salida = NULL;
+
     /* Cada proceso necesita espacio para B completo y su porción de A y C */
-    double* B_local = (double*)malloc(N * N * sizeof(double));  // se llenará vía MPI_Bcast
+    void* B_local = malloc((size_t)K * N * tam_entrada);  // se llenará vía MPI_Bcast
     if (B_local == NULL) {
         fprintf(stderr, "Error al asignar memoria para B_local en proceso %d\n", rank);
         MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
     }
 
     /* Calcular cuántas filas maneja cada proceso */
-    int filas_local = filas_por_proceso(rank, size, N);
+    int filas_local = filas_por_proceso(rank, size, M);
 
     /* Arreglos temporales para recuentos y desplazamientos */
     int* sendcounts = NULL;
@@ -140,9 +439,9 @@ int main(int argc, char* argv[]) {
 
     /* Sólo el root inicializa sendcounts y displs para distribuir A */
     if (rank == 0) {
-        A = reservar_matriz(N);
-        B = reservar_matriz(N);
-        C = reservar_matriz(N);  // se usará al final para recoger resultados
+        A = reservar_matriz(M, K);
+        B = reservar_matriz(K, N);
+        C = reservar_matriz(M, N);  // se usará al final para recoger resultados
 
         if (A == NULL || B == NULL || C == NULL) {
             fprintf(stderr, "Error al asignar memoria en root\n");
@@ -151,14 +450,36 @@ int main(int argc, char* argv[]) {
 
         /* Llenar A y B con valores aleatorios en root */
         srand(time(NULL));
-        llenar_matriz(A, N);
-        llenar_matriz(B, N);
+        llenar_matriz(A, M, K);
+        llenar_matriz(B, K, N);
+        if (dtype != DTYPE_F64) {
+            /* Datos no enteros: con enteros pequeños los productos f32 serían exactos */
+            fraccionar_datos(A, (size_t)M * K);
+            fraccionar_datos(B, (size_t)K * N);
+        }
+
+        /* Copias en simple precisión de las entradas para los modos f32 y mixed */
+        C_salida = (dtype == DTYPE_F32) ? malloc((size_t)M * N * sizeof(float)) : (void*)C;
+        if (dtype != DTYPE_F64) {
+            A32 = (float*)malloc((size_t)M * K * sizeof(float));
+            B32 = (float*)malloc((size_t)K * N * sizeof(float));
+            if (A32 == NULL || B32 == NULL || C_salida == NULL) {
+                fprintf(stderr, "Error al asignar memoria para las copias fp32 en root\n");
+                MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+            }
+            for (long i = 0; i < (long)M * K; i++) {
+                A32[i] = (float)A[i];
+            }
+            for (long i = 0; i < (long)K * N; i++) {
+                B32[i] = (float)B[i];
+            }
+        }
 
         /* Opcional: imprimir las matrices A y B
         printf("Matriz A (root):\n");
-        imprimir_matriz(A, N);
+        imprimir_matriz(A, M, K);
         printf("Matriz B (root):\n");
-        imprimir_matriz(B, N);
+        imprimir_matriz(B, K, N);
         */
 
         /* Preparar vectores para Scatterv y Gatherv */
@@ -172,23 +493,22 @@ int main(int argc, char* argv[]) {
             MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
         }
 
-        /* Calcular cómo repartir las filas de A entre procesos */
-        calcular_desplazamientos(sendcounts, displs, size, N);
+        /* Calcular cómo repartir las filas de A (de K elementos) entre procesos */
+        calcular_desplazamientos(sendcounts, displs, size, M, K);
 
-        /* Para recoger los resultados de C, la distribución es igual a la de A */
-        /* recvcounts[i] = filas_por_proceso(i)*N, y recvdispls = mismo desplazamiento */
-        for (int i = 0; i < size; i++) {
-            recvcounts[i] = sendcounts[i];   // misma lógica, mismos elementos
-            recvdispls[i] = displs[i];
-        }
+        /* Para recoger los resultados de C se reparten las mismas filas, de N elementos */
+        /* recvcounts[i] = filas_por_proceso(i)*N, y recvdispls acumula esos recuentos */
+        calcular_desplazamientos(recvcounts, recvdispls, size, M, N);
     }
 
     /* Broadcast de la dimensión N a todos los procesos */
     MPI_Bcast(&N, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    MPI_Bcast(&M, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    MPI_Bcast(&K, 1, MPI_INT, 0, MPI_COMM_WORLD);
 
     /* Cada proceso reserva espacio para su porción de A y C */
-    double* A_local = (double*)malloc(filas_local * N * sizeof(double));
-    double* C_local = (double*)malloc(filas_local * N * sizeof(double));
+    void* A_local = malloc((size_t)filas_local * K * tam_entrada);
+    void* C_local = malloc((size_t)filas_local * N * tam_salida);
     if (A_local == NULL || C_local == NULL) {
         fprintf(stderr, "Error al asignar memoria para A_local o C_local en proceso %d\n", rank);
         MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
@@ -197,90 +517,162 @@ int main(int argc, char* argv[]) {
     /* Root envía la matriz B completa a todos los procesos */
     /* Primero, root copia su B a B_local, otros procesos B_local no inicializado */
     if (rank == 0) {
-        for (int i = 0; i < N * N; i++) {
-            B_local[i] = B[i];
-        }
+        memcpy(B_local, (dtype == DTYPE_F64) ? (void*)B : (void*)B32, (size_t)K * N * tam_entrada);
     }
-    MPI_Bcast(B_local, N * N, MPI_DOUBLE, 0, MPI_COMM_WORLD);
-
-    /* Scatterv para distribuir las filas de A entre procesos */
-    MPI_Scatterv(
-        A,                /* buffer origen en root */
-        sendcounts,       /* número de elementos enviados a cada proceso */
-        displs,           /* desplazamientos en A (en elementos) */
-        MPI_DOUBLE,       /* tipo de datos */
-        A_local,          /* buffer destino local */
-        filas_local * N,  /* número de elementos que recibe este proceso */
-        MPI_DOUBLE,       /* tipo de datos */
-        0,                /* root */
-        MPI_COMM_WORLD
-    );
-
-    /* Sincronizar antes de comenzar la multiplicación y medir tiempo */
-    MPI_Barrier(MPI_COMM_WORLD);
-    double t_inicio = MPI_Wtime();
-
-    /* Inicializar C_local a cero */
-    for (int i = 0; i < filas_local * N; i++) {
-        C_local[i] = 0.0;
-    }
-
-    /* Multiplicación parcial: cada proceso calcula sus filas asignadas */
-    /* A_local tiene filas_local filas, cada una con N columnas */
-    /* B_local es N x N */
-    for (int i = 0; i < filas_local; i++) {
-        for (int j = 0; j < N; j++) {
-            double sum = 0.0;
-            for (int k = 0; k < N; k++) {
-                sum += A_local[i * N + k] * B_local[k * N + j];
-            }
-            C_local[i * N + j] = sum;
+    MPI_Bcast(B_local, K * N, tipo_entrada, 0, MPI_COMM_WORLD);
+
+    TrabajoProceso trabajo = {0.0, 0.0, 0.0};
+    double t_inicio, t_final;
+    int num_bloques = 1;
+    int* inicios = NULL;
+    if (reparto == REPARTO_ESTATICO) {
+        /* Scatterv para distribuir las filas de A entre procesos */
+        MPI_Scatterv(
+            (dtype == DTYPE_F64) ? (void*)A : (void*)A32, /* buffer origen en root */
+            sendcounts,       /* número de elementos enviados a cada proceso */
+            displs,           /* desplazamientos en A (en elementos) */
+            tipo_entrada,     /* tipo de datos */
+            A_local,          /* buffer destino local */
+            filas_local * K,  /* número de elementos que recibe este proceso */
+            tipo_entrada,     /* tipo de datos */
+            0,                /* root */
+            MPI_COMM_WORLD
+        );
+
+        /* Sincronizar antes de comenzar la multiplicación y medir tiempo */
+        MPI_Barrier(MPI_COMM_WORLD);
+        t_inicio = MPI_Wtime();
+
+        /* Multiplicación parcial: cada proceso calcula sus filas asignadas */
+        /* A_local tiene filas_local filas, cada una con K columnas */
+        /* B_local es K x N */
+        multiplicar_filas(dtype, A_local, B_local, C_local, filas_local, K, N);
+        trabajo.tiempo_calculo = MPI_Wtime() - t_inicio;
+        trabajo.filas = filas_local;
+        trabajo.bloques = 1.0;
+
+        /* Sincronizar para finalizar el tiempo de cálculo */
+        MPI_Barrier(MPI_COMM_WORLD);
+        t_final = MPI_Wtime();
+
+        /* Reunir todas las porciones de C_local en C (en root) */
+        MPI_Gatherv(
+            C_local,            /* buffer origen local */
+            filas_local * N,    /* número de elementos enviados por este proceso */
+            tipo_salida,        /* tipo de datos */
+            C_salida,           /* buffer destino en root */
+            recvcounts,         /* número de elementos que recibirá cada proceso */
+            recvdispls,         /* desplazamientos en C (en elementos) */
+            tipo_salida,        /* tipo de datos */
+            0,                  /* root */
+            MPI_COMM_WORLD
+        );
+    } else {
+        /* Reparto dinámico: bloques guiados que se piden al root o se toman por RMA */
+        int trabajadores = reparto == REPARTO_COORDINADOR ? size - 1 : size;
+        inicios = (int*)malloc((M + 1) * sizeof(int));
+        if (inicios == NULL) {
+            fprintf(stderr, "Error al asignar memoria para los bloques en proceso %d\n", rank);
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
         }
+        num_bloques = planificar_bloques_guiados(M, trabajadores, bloque_minimo, inicios);
+        int max_filas = inicios[1] - inicios[0];  /* el primer bloque es el mayor */
+        void* A_envio = (dtype == DTYPE_F64) ? (void*)A : (void*)A32;
+
+        MPI_Barrier(MPI_COMM_WORLD);
+        t_inicio = MPI_Wtime();
+        if (reparto == REPARTO_COORDINADOR && rank == 0) {
+            coordinar_bloques((const char*)A_envio, (char*)C_salida, K, N, inicios, num_bloques, size, tam_entrada,
+                              tam_salida, tipo_entrada, tipo_salida);
+        } else if (reparto == REPARTO_COORDINADOR) {
+            trabajo = trabajar_coordinado(dtype, B_local, K, N, max_filas, tam_entrada, tam_salida, tipo_entrada,
+                                          tipo_salida);
+        } else {
+            trabajo = trabajar_rma(dtype, rank, A_envio, C_salida, B_local, M, K, N, inicios, num_bloques, max_filas,
+                                   tam_entrada, tam_salida, tipo_entrada, tipo_salida);
+        }
+        MPI_Barrier(MPI_COMM_WORLD);
+        t_final = MPI_Wtime();
     }
-
-    /* Sincronizar para finalizar el tiempo de cálculo */
-    MPI_Barrier(MPI_COMM_WORLD);
-    double t_final = MPI_Wtime();
     double tiempo_local = t_final - t_inicio;
 
     /* Root puede calcular el tiempo máximo sobre todos los procesos */
     double tiempo_max;
     MPI_Reduce(&tiempo_local, &tiempo_max, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
 
-    /* Reunir todas las porciones de C_local en C (en root) */
-    MPI_Gatherv(
-        C_local,            /* buffer origen local */
-        filas_local * N,    /* número de elementos enviados por este proceso */
-        MPI_DOUBLE,         /* tipo de datos */
-        C,                  /* buffer destino en root */
-        recvcounts,         /* número de elementos que recibirá cada proceso */
-        recvdispls,         /* desplazamientos en C (en elementos) */
-        MPI_DOUBLE,         /* tipo de datos */
-        0,                  /* root */
-        MPI_COMM_WORLD
-    );
+    /* Trabajo de cada proceso para el informe de rendimiento */
+    TrabajoProceso* trabajos = NULL;
+    if (rank == 0) {
+        trabajos = (TrabajoProceso*)malloc(size * sizeof(TrabajoProceso));
+        if (trabajos == NULL) {
+            fprintf(stderr, "Error al asignar memoria para el informe por proceso\n");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+    }
+    MPI_Gather(&trabajo, 3, MPI_DOUBLE, trabajos, 3, MPI_DOUBLE, 0, MPI_COMM_WORLD);
 
     /* Solo el root muestra el tiempo total de ejecución */
     if (rank == 0) {
-        printf("Multiplicación de matrices cuadradas de dimensión %d realizada con %d procesos.\n", N, size);
+        printf("Multiplicación de matrices %d x %d por %d x %d realizada con %d procesos.\n", M, K, K, N, size);
         printf("Tiempo de ejecución (tiempo máximo de un proceso): %f segundos\n", tiempo_max);
+        if (reparto == REPARTO_ESTATICO) {
+            printf("Reparto estático: %d filas por proceso como máximo.\n", filas_por_proceso(0, size, M));
+        } else {
+            printf("Reparto %s: %d bloques guiados (de %d a %d filas).\n",
+                   reparto == REPARTO_COORDINADOR ? "con coordinador" : "por RMA (fetch-and-add)", num_bloques,
+                   inicios[1] - inicios[0], inicios[num_bloques] - inicios[num_bloques - 1]);
+        }
+        double total_gflops = 0.0;
+        for (int r = 0; r < size; r++) {
+            double gflops = trabajos[r].tiempo_calculo > 0.0
+                                ? 2.0 * trabajos[r].filas * K * N / trabajos[r].tiempo_calculo / 1e9 : 0.0;
+            total_gflops += gflops;
+            if (reparto == REPARTO_COORDINADOR && r == 0) {
+                printf("  Proceso 0: coordinador\n");
+                continue;
+            }
+            printf("  Proceso %d: %.0f filas en %.0f bloques, %f s de cálculo, %.3f GFLOP/s\n", r,
+                   trabajos[r].filas, trabajos[r].bloques, trabajos[r].tiempo_calculo, gflops);
+        }
+        printf("Rendimiento agregado de los procesos: %.3f GFLOP/s (obtenido: %.3f GFLOP/s)\n", total_gflops,
+               2.0 * M * K * N / tiempo_max / 1e9);
+
+        /* Comparar contra una referencia calculada en doble precisión */
+        if (dtype != DTYPE_F64) {
+            double* referencia = reservar_matriz(M, N);
+            if (referencia == NULL) {
+                fprintf(stderr, "Error al asignar memoria para la referencia fp64\n");
+                MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+            }
+            multiplicar_filas_f64(A, K, B, N, referencia, N, 0, M, K, N);
+            printf("Error relativo frente a fp64 (norma de Frobenius): %e\n",
+                   error_relativo(referencia, C_salida, dtype, (long)M * N));
+            free(referencia);
+        }
 
         /* Opcional: imprimir la matriz resultado C
         printf("Matriz Resultado C:\n");
-        imprimir_matriz(C, N);
+        imprimir_matriz(C, M, N);
         */
 
         /* Liberar memoria en root */
         free(A);
         free(B);
         free(C);
+        if (dtype == DTYPE_F32) {
+            free(C_salida);
+        }
+        free(A32);
+        free(B32);
         free(sendcounts);
         free(displs);
         free(recvcounts);
         free(recvdispls);
+        free(trabajos);
     }
 
     /* Liberar memoria en cada proceso */
+    free(inicios);
     free(A_local);
     free(B_local);
     free(C_local);
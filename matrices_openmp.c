@@ -1,105 +1,308 @@
+#define _GNU_SOURCE // sched_setaffinity y CPU_SET (matrices_afinidad.h)
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
+#include <math.h>
+#include <string.h>
 #include <getopt.h>
 #include <omp.h>
+#include "matrices_arena.h"
+#include "matrices_perfil.h"
+#include "matrices_morton.h"
+#include "matrices_strassen.h"
+#include "matrices_simetricas.h"
+#include "matrices_estrecho.h"
+#include "matrices_epilogo.h"
+#include "matrices_cadena.h"
+#include "matrices_potencia.h"
+#include "matrices_afinidad.h"
+#include "matrices_aproximado.h"
+#include "matrices_precision.h"
 
-// Prototipos de funciones
-double** reservar_matriz(int n);
-void liberar_matriz(double** matriz, int n);
-void llenar_matriz_aleatoria(double** matriz, int n);
-void imprimir_matriz(double** matriz, int n);
-double** multiplicar_matrices_openmp(double** A, double** B, int n, int num_hilos);
-void mostrar_ayuda();
+// Algoritmos de multiplicación disponibles para el caso básico
+typedef enum {
+    ALG_INGENUO,   // Triple bucle i-j-k original
+    ALG_BLOQUES,   // Bloques de caché mc x kc x nc (matrices_bloques.h), f64 y f32
+    ALG_STRASSEN,  // Strassen recursivo (matrices_strassen.h); hojas por bloques (sólo f64)
+    ALG_MORTON,    // Recursivo en orden Z (matrices_morton.h) con tareas OpenMP (sólo f64)
+    ALG_SYRK,      // C = A * A^T calculando un triángulo (matrices_simetricas.h, f64 o f32)
+    ALG_SYMM,      // C = S * B con S el triángulo inferior de A simetrizado (f64 o f32)
+    ALG_TRMM,      // C = T * B con T el triángulo inferior (o superior) de A (f64 o f32)
+    ALG_ESTRECHO   // GEMV y tall-skinny (matrices_estrecho.h), columnasB <= 16 (sólo f64)
+} Algoritmo;
 
-// Función para reservar memoria para una matriz cuadrada de tamaño n x n
-double** reservar_matriz(int n) {
-    double** matriz = (double**)malloc(n * sizeof(double*));
-    if (matriz == NULL) {
-        fprintf(stderr, "Error en la asignación de memoria para la matriz\n");
-        exit(EXIT_FAILURE);
-    }
-    
-    for (int i = 0; i < n; i++) {
-        matriz[i] = (double*)malloc(n * sizeof(double));
-        if (matriz[i] == NULL) {
-            fprintf(stderr, "Error en la asignación de memoria para la fila %d\n", i);
-            exit(EXIT_FAILURE);
-        }
-    }
-    
-    return matriz;
-}
+// Vista (sin copia) de un bloque de una matriz guardada por filas: el elemento
+// (i, j) está en datos[i * ld + j], con ld >= columnas la dimensión principal.
+typedef struct {
+    double* datos;
+    int filas;
+    int columnas;
+    int ld;
+} VistaMatriz;
 
-// Función para liberar la memoria de una matriz
-void liberar_matriz(double** matriz, int n) {
-    for (int i = 0; i < n; i++) {
-        free(matriz[i]);
-    }
-    free(matriz);
-}
+// reservar_matriz, liberar_matriz y error_relativo para double y float (sufijo _f32).
+// Los datos son un único bloque contiguo (matriz[0]) y matriz[i] apunta a cada
+// fila, de modo que se puede indexar con [i][j] y también crear vistas.
+DEFINIR_MATRIZ_FILAS(, double)
+DEFINIR_MATRIZ_FILAS(_f32, float)
+
+// Opciones de la línea de comandos
+typedef struct {
+    int filasA, columnasA, columnasB; // Dimensiones: A es filasA x columnasA, B es columnasA x columnasB
+    int num_hilos;           // Número de hilos
+    int imprimir;            // Imprimir las matrices
+    TipoDato dtype;
+    Epilogo ep;
+    int usar_epilogo;
+    int usar_bias;
+    int usar_vista;
+    int transA, transB;
+    int iteraciones;
+    int usar_arena;
+    int usar_bucle;          // --iteraciones > 1 o --arena
+    Algoritmo algoritmo;
+    Bloques bloques;
+    int bloques_explicitos;  // --bloque tiene prioridad sobre el perfil
+    int hilos_explicitos;    // -h tiene prioridad sobre el perfil
+    const char* ruta_perfil;
+    int verificar;
+    int superior;            // triángulo de A que usa trmm
+    int dims_cadena[CADENA_MAX + 1];
+    int num_cadena;          // matrices de --cadena (0: producto de A y B)
+    long exponente;          // --potencia k (-1: producto de A y B)
+    int solo_vector;         // --vector: x * A^k
+    PoliticaAfinidad afinidad;
+    int un_hilo_por_nucleo;
+    MetodoAproximado aproximado;
+    double error_objetivo;   // --error (0: no indicado)
+    long muestras;           // --muestras (0: no indicado)
+} Opciones;
+
+// Prototipos de funciones
+void llenar_matriz_aleatoria(double** matriz, int filas, int columnas);
+void imprimir_matriz(double** matriz, int filas, int columnas);
+VistaMatriz vista_matriz(double** matriz, int columnas_totales, int fila0, int col0, int filas, int columnas);
+double** multiplicar_matrices_openmp(double** A, double** B, int filasA, int columnasA, int columnasB,
+                                     int num_hilos);
+void multiplicar_matrices_openmp_en(double** A, double** B, double** C, int filasA, int columnasA,
+                                    int columnasB, int num_hilos);
+int gemm_vista_openmp(int transA, int transB, double alpha, VistaMatriz A, VistaMatriz B,
+                      double beta, VistaMatriz C, int num_hilos);
+void multiplicar_matrices_openmp_epilogo(double** A, double** B, double** C, int filasA, int columnasA,
+                                         int columnasB, Bloques bl, int num_hilos, const Epilogo* ep);
+void mostrar_ayuda();
+int parsear_opciones(int argc, char* argv[], Opciones* o);
+int validar_opciones(Opciones* o);
+int ejecutar_aproximado(const Opciones* o);
+int ejecutar_potencia(const Opciones* o);
+int ejecutar_cadena_matrices(const Opciones* o);
+int ejecutar_bucle(const Opciones* o, double** A, double** B);
+int ejecutar_vista(const Opciones* o, double** A, double** B);
+int ejecutar_epilogo(const Opciones* o, double** A, double** B);
+int ejecutar_bloques_f32(const Opciones* o, double** A, double** B);
+int ejecutar_morton(const Opciones* o, double** A, double** B);
+int ejecutar_estrecho(const Opciones* o, double** A, double** B);
+int ejecutar_estructurado(const Opciones* o, double** A, double** B);
+int ejecutar_bloques_strassen(const Opciones* o, double** A, double** B);
+int ejecutar_basico(const Opciones* o, double** A, double** B);
 
 // Función para llenar una matriz con valores aleatorios
-void llenar_matriz_aleatoria(double** matriz, int n) {
-    for (int i = 0; i < n; i++) {
-        for (int j = 0; j < n; j++) {
+void llenar_matriz_aleatoria(double** matriz, int filas, int columnas) {
+    for (int i = 0; i < filas; i++) {
+        for (int j = 0; j < columnas; j++) {
             matriz[i][j] = (double)(rand() % 10);
         }
     }
 }
 
 // Función para imprimir una matriz
-void imprimir_matriz(double** matriz, int n) {
-    for (int i = 0; i < n; i++) {
-        for (int j = 0; j < n; j++) {
+void imprimir_matriz(double** matriz, int filas, int columnas) {
+    for (int i = 0; i < filas; i++) {
+        for (int j = 0; j < columnas; j++) {
             printf("%lf ", matriz[i][j]);
         }
         printf("\n");
     }
 }
 
+// Función para crear una vista del bloque filas x columnas que empieza en (fila0, col0)
+// de una matriz reservada con reservar_matriz (que tiene columnas_totales columnas)
+VistaMatriz vista_matriz(double** matriz, int columnas_totales, int fila0, int col0, int filas, int columnas) {
+    VistaMatriz v = {matriz[0] + (size_t)fila0 * columnas_totales + col0, filas, columnas, columnas_totales};
+    return v;
+}
+
 // Función para multiplicar dos matrices usando OpenMP
-double** multiplicar_matrices_openmp(double** A, double** B, int n, int num_hilos) {
-    double** C = reservar_matriz(n);
-    
+double** multiplicar_matrices_openmp(double** A, double** B, int filasA, int columnasA, int columnasB,
+                                     int num_hilos) {
+    double** C = reservar_matriz(filasA, columnasB);
+    multiplicar_matrices_openmp_en(A, B, C, filasA, columnasA, columnasB, num_hilos);
+    return C;
+}
+
+// Función para multiplicar dos matrices usando OpenMP escribiendo en un C ya reservado
+// por el llamador (por ejemplo con arena_matriz), sin reservar memoria
+void multiplicar_matrices_openmp_en(double** A, double** B, double** C, int filasA, int columnasA,
+                                    int columnasB, int num_hilos) {
     // Establecer el número de hilos para OpenMP
     omp_set_num_threads(num_hilos);
     
     // Multiplicación de matrices con paralelización de OpenMP
     #pragma omp parallel for
-    for (int i = 0; i < n; i++) {
-        for (int j = 0; j < n; j++) {
+    for (int i = 0; i < filasA; i++) {
+        for (int j = 0; j < columnasB; j++) {
             C[i][j] = 0.0;
-            for (int k = 0; k < n; k++) {
+            for (int k = 0; k < columnasA; k++) {
                 C[i][j] += A[i][k] * B[k][j];
             }
         }
     }
+}
+
+// Multiplicación general sobre vistas con OpenMP: C = alpha * op(A) * op(B) + beta * C,
+// donde op(X) es X o su traspuesta según transA/transB. op(A) es m x k, op(B) es k x n
+// y C es m x n; todas pueden ser bloques de matrices mayores, sin copiar nada. Las
+// filas de C se reparten entre los hilos. Devuelve 0 si tiene éxito o -1 si las
+// dimensiones no son compatibles.
+int gemm_vista_openmp(int transA, int transB, double alpha, VistaMatriz A, VistaMatriz B,
+                      double beta, VistaMatriz C, int num_hilos) {
+    int m = transA ? A.columnas : A.filas;
+    int k = transA ? A.filas : A.columnas;
+    int kB = transB ? B.columnas : B.filas;
+    int n = transB ? B.filas : B.columnas;
+    if (k != kB || C.filas != m || C.columnas != n) {
+        return -1;
+    }
     
-    return C;
+    // Zancadas para recorrer op(A)(i, p) y op(B)(p, j) sin ramas en el bucle interno
+    long a_i = transA ? 1 : A.ld, a_p = transA ? A.ld : 1;
+    long b_p = transB ? 1 : B.ld, b_j = transB ? B.ld : 1;
+    
+    #pragma omp parallel for num_threads(num_hilos)
+    for (int i = 0; i < m; i++) {
+        double* c = C.datos + (size_t)i * C.ld;
+        const double* a = A.datos + i * a_i;
+        if (!transB) {
+            // B por filas: orden i-k-j, el bucle interno recorre B y C con paso unitario
+            for (int j = 0; j < n; j++) {
+                c[j] = (beta == 0.0) ? 0.0 : beta * c[j];
+            }
+            for (int p = 0; p < k; p++) {
+                double aip = alpha * a[p * a_p];
+                const double* b = B.datos + p * b_p;
+                for (int j = 0; j < n; j++) {
+                    c[j] += aip * b[j];
+                }
+            }
+        } else {
+            // B traspuesta: cada C(i, j) es un producto escalar de filas contiguas
+            for (int j = 0; j < n; j++) {
+                const double* b = B.datos + j * b_j;
+                double sum = 0.0;
+                for (int p = 0; p < k; p++) {
+                    sum += a[p * a_p] * b[p];
+                }
+                c[j] = alpha * sum + ((beta == 0.0) ? 0.0 : beta * c[j]);
+            }
+        }
+    }
+    return 0;
+}
+
+// Función para multiplicar dos matrices con OpenMP aplicando el epílogo sobre un C
+// del llamador (matrices_epilogo.h): el kernel por bloques aplica el epílogo a cada
+// bloque de C al terminar de acumularlo.
+void multiplicar_matrices_openmp_epilogo(double** A, double** B, double** C, int filasA, int columnasA,
+                                         int columnasB, Bloques bl, int num_hilos, const Epilogo* ep) {
+    gemm_bloques_epilogo(A[0], columnasA, B[0], columnasB, C[0], columnasB, C[0], columnasB,
+                         filasA, columnasA, columnasB, bl, ep, num_hilos);
 }
 
 // Función para mostrar ayuda
 void mostrar_ayuda() {
-    printf("Uso: ./programa [-t tamaño] [-h hilos] [-p]\n");
+    printf("Uso: ./programa [-t tamaño | -r filasA -c columnasA -q columnasB] [-h hilos] [-p] [-d f32|f64|mixed]\n");
     printf("Opciones:\n");
     printf("  -t, --tamano    Tamaño de las matrices cuadradas (por defecto: 3)\n");
+    printf("  -r, --filasA    Filas de A (y de C)\n");
+    printf("  -c, --columnasA Columnas de A (y filas de B)\n");
+    printf("  -q, --columnasB Columnas de B (y de C)\n");
     printf("  -h, --hilos     Número de hilos a utilizar con OpenMP (por defecto: 4)\n");
     printf("  -p, --imprimir  Imprimir las matrices (opcional)\n");
+    printf("  -d, --dtype     Tipo de dato: f64, f32 o mixed (por defecto: f64)\n");
+    printf("      --alpha a   Epílogo fusionado: C = relu(alpha*A*B + beta*C + bias)\n");
+    printf("      --beta b    Factor de C en el epílogo (por defecto: 0)\n");
+    printf("      --bias      Sumar un sesgo aleatorio por columna en el epílogo\n");
+    printf("      --relu      Aplicar max(0, x) en el epílogo\n");
+    printf("      --vista     Multiplicar bloques interiores de matrices mayores sin copiarlos\n");
+    printf("      --ta, --tb  Guardar A y/o B traspuestas y usar gemm con traspuesta (implica --vista)\n");
+    printf("      --iteraciones n  Repetir la multiplicación n veces (por defecto: 1)\n");
+    printf("      --arena     Tomar C de un espacio de trabajo reutilizable en lugar de malloc\n");
+    printf("      --algoritmo ingenuo|bloques|strassen|morton|syrk|symm|trmm|estrecho  Algoritmo (por defecto: ingenuo)\n");
+    printf("      --superior  Con trmm, usar el triángulo superior de A en lugar del inferior\n");
+    printf("      --bloque mc,kc,nc  Tamaños de bloque de caché (por defecto: 64,256,128)\n");
+    printf("      --verificar Comparar el resultado de --algoritmo contra el algoritmo ingenuo\n");
+    printf("      --cadena d0,d1,...,dn  Multiplicar una cadena de n matrices (la i es d(i-1) x di) en el\n"
+           "                  orden de menor coste estimado; con --verificar, comparar con el orden escrito\n");
+    printf("      --potencia k  Calcular A^k (A cuadrada, filas normalizadas a suma 1) por exponenciación binaria\n");
+    printf("      --vector    Con --potencia, calcular sólo x * A^k; itera productos vector-matriz si es más barato\n");
+    printf("      --afinidad ninguna|compacta|dispersa  Fijar cada hilo OpenMP a una CPU (por defecto: ninguna)\n");
+    printf("      --nucleos   Con --afinidad, como mucho un hilo por núcleo físico (sin hermanos SMT)\n");
+    printf("      --aproximado muestreo|gaussiano|countsketch  Producto aproximado con la dimensión interior\n"
+           "                  reducida por muestreo de columnas-filas o por un sketch de A y B\n");
+    printf("      --error e   Con --aproximado, error relativo de Frobenius objetivo (por defecto: 0.1)\n");
+    printf("      --muestras s  Con --aproximado, usar s muestras en lugar de un error objetivo\n");
+    printf("      --perfil ruta  Perfil de matrices_autotune (por defecto: ~/.cache/matrices/perfil.txt)\n");
     printf("  -a, --ayuda     Mostrar esta ayuda\n");
 }
 
-int main(int argc, char *argv[]) {
-    // Valores por defecto
-    int n = 3;           // Tamaño de la matriz
-    int num_hilos = 4;   // Número de hilos
-    int imprimir = 0;    // No imprimir matrices por defecto
+// Función para leer las opciones de la línea de comandos. Devuelve 0 si hay que
+// seguir, 1 si se mostró la ayuda y -1 si alguna opción no es válida.
+int parsear_opciones(int argc, char* argv[], Opciones* o) {
+    // Valores por defecto; los campos que no aparecen quedan a 0 (o NULL)
+    *o = (Opciones){
+        .filasA = 3, .columnasA = 3, .columnasB = 3,
+        .num_hilos = 4,
+        .dtype = DTYPE_F64,
+        .ep = {1.0, 0.0, NULL, 0},
+        .iteraciones = 1,
+        .algoritmo = ALG_INGENUO,
+        .bloques = BLOQUES_POR_DEFECTO,
+        .exponente = -1,
+        .afinidad = AFINIDAD_NINGUNA,
+        .aproximado = APROX_NINGUNO,
+    };
     
     // Definir las opciones para getopt_long
     static struct option opciones_largas[] = {
         {"tamano", required_argument, 0, 't'},
+        {"filasA", required_argument, 0, 'r'},
+        {"columnasA", required_argument, 0, 'c'},
+        {"columnasB", required_argument, 0, 'q'},
         {"hilos", required_argument, 0, 'h'},
         {"imprimir", no_argument, 0, 'p'},
+        {"dtype", required_argument, 0, 'd'},
+        {"alpha", required_argument, 0, 'A'},
+        {"beta", required_argument, 0, 'B'},
+        {"bias", no_argument, 0, 'S'},
+        {"relu", no_argument, 0, 'R'},
+        {"iteraciones", required_argument, 0, 'I'},
+        {"arena", no_argument, 0, 'W'},
+        {"vista", no_argument, 0, 'V'},
+        {"ta", no_argument, 0, 'X'},
+        {"tb", no_argument, 0, 'Y'},
+        {"algoritmo", required_argument, 0, 'L'},
+        {"bloque", required_argument, 0, 'K'},
+        {"verificar", no_argument, 0, 'E'},
+        {"perfil", required_argument, 0, 'F'},
+        {"superior", no_argument, 0, 'U'},
+        {"cadena", required_argument, 0, 'C'},
+        {"potencia", required_argument, 0, 'P'},
+        {"vector", no_argument, 0, 'G'},
+        {"afinidad", required_argument, 0, 'Z'},
+        {"nucleos", no_argument, 0, 'N'},
+        {"aproximado", required_argument, 0, 'M'},
+        {"error", required_argument, 0, 'J'},
+        {"muestras", required_argument, 0, 'Q'},
         {"ayuda", no_argument, 0, 'a'},
         {0, 0, 0, 0}
     };
@@ -108,87 +311,1160 @@ int main(int argc, char *argv[]) {
     int indice_opcion = 0;
     
     // Procesar los argumentos de la línea de comandos
-    while ((opcion = getopt_long(argc, argv, "t:h:pa", opciones_largas, &indice_opcion)) != -1) {
+    while ((opcion = getopt_long(argc, argv, "t:r:c:q:h:pd:a", opciones_largas, &indice_opcion)) != -1) {
         switch (opcion) {
-            case 't':
-                n = atoi(optarg);
+            case 't': {
+                int n = atoi(optarg);
                 if (n <= 0) {
                     fprintf(stderr, "El tamaño de la matriz debe ser positivo\n");
-                    return EXIT_FAILURE;
+                    return -1;
+                }
+                o->filasA = o->columnasA = o->columnasB = n;
+                break;
+            }
+            case 'r':
+            case 'c':
+            case 'q': {
+                int dim = atoi(optarg);
+                if (dim <= 0) {
+                    fprintf(stderr, "Las dimensiones de las matrices deben ser positivas\n");
+                    return -1;
                 }
+                if (opcion == 'r') o->filasA = dim;
+                if (opcion == 'c') o->columnasA = dim;
+                if (opcion == 'q') o->columnasB = dim;
                 break;
+            }
             case 'h':
-                num_hilos = atoi(optarg);
-                if (num_hilos <= 0) {
+                o->num_hilos = atoi(optarg);
+                if (o->num_hilos <= 0) {
                     fprintf(stderr, "El número de hilos debe ser positivo\n");
-                    return EXIT_FAILURE;
+                    return -1;
                 }
+                o->hilos_explicitos = 1;
                 break;
             case 'p':
-                imprimir = 1;
+                o->imprimir = 1;
+                break;
+            case 'd': {
+                int d = parsear_dtype(optarg);
+                if (d < 0) {
+                    fprintf(stderr, "Tipo de dato no válido: %s (use f32, f64 o mixed)\n", optarg);
+                    return -1;
+                }
+                o->dtype = (TipoDato)d;
+                break;
+            }
+            case 'A':
+                o->ep.alpha = atof(optarg);
+                o->usar_epilogo = 1;
+                break;
+            case 'B':
+                o->ep.beta = atof(optarg);
+                o->usar_epilogo = 1;
+                break;
+            case 'S':
+                o->usar_bias = 1;
+                o->usar_epilogo = 1;
+                break;
+            case 'R':
+                o->ep.relu = 1;
+                o->usar_epilogo = 1;
+                break;
+            case 'I':
+                o->iteraciones = atoi(optarg);
+                if (o->iteraciones <= 0) {
+                    fprintf(stderr, "El número de iteraciones debe ser positivo\n");
+                    return -1;
+                }
+                break;
+            case 'W':
+                o->usar_arena = 1;
+                break;
+            case 'V':
+                o->usar_vista = 1;
+                break;
+            case 'X':
+                o->transA = 1;
+                o->usar_vista = 1;
+                break;
+            case 'Y':
+                o->transB = 1;
+                o->usar_vista = 1;
+                break;
+            case 'L':
+                if (strcmp(optarg, "ingenuo") == 0) {
+                    o->algoritmo = ALG_INGENUO;
+                } else if (strcmp(optarg, "bloques") == 0) {
+                    o->algoritmo = ALG_BLOQUES;
+                } else if (strcmp(optarg, "strassen") == 0) {
+                    o->algoritmo = ALG_STRASSEN;
+                } else if (strcmp(optarg, "morton") == 0) {
+                    o->algoritmo = ALG_MORTON;
+                } else if (strcmp(optarg, "syrk") == 0) {
+                    o->algoritmo = ALG_SYRK;
+                } else if (strcmp(optarg, "symm") == 0) {
+                    o->algoritmo = ALG_SYMM;
+                } else if (strcmp(optarg, "trmm") == 0) {
+                    o->algoritmo = ALG_TRMM;
+                } else if (strcmp(optarg, "estrecho") == 0) {
+                    o->algoritmo = ALG_ESTRECHO;
+                } else {
+                    fprintf(stderr, "Algoritmo no válido: %s (use ingenuo, bloques, strassen, morton, syrk, symm, trmm"
+                            " o estrecho)\n", optarg);
+                    return -1;
+                }
+                break;
+            case 'K':
+                if (sscanf(optarg, "%d,%d,%d", &o->bloques.mc, &o->bloques.kc, &o->bloques.nc) != 3
+                    || o->bloques.mc <= 0 || o->bloques.kc <= 0 || o->bloques.nc <= 0) {
+                    fprintf(stderr, "Bloques no válidos: %s (use mc,kc,nc positivos)\n", optarg);
+                    return -1;
+                }
+                o->bloques_explicitos = 1;
+                break;
+            case 'E':
+                o->verificar = 1;
+                break;
+            case 'F':
+                o->ruta_perfil = optarg;
+                break;
+            case 'U':
+                o->superior = 1;
+                break;
+            case 'C': {
+                int num_dims = 0;
+                char* copia = strdup(optarg);
+                for (char* d = strtok(copia, ","); d != NULL; d = strtok(NULL, ",")) {
+                    if (num_dims == CADENA_MAX + 1 || atoi(d) <= 0) {
+                        num_dims = 0;
+                        break;
+                    }
+                    o->dims_cadena[num_dims++] = atoi(d);
+                }
+                free(copia);
+                if (num_dims < 2) {
+                    fprintf(stderr, "Cadena no válida: %s (use entre 2 y %d dimensiones positivas)\n",
+                            optarg, CADENA_MAX + 1);
+                    return -1;
+                }
+                o->num_cadena = num_dims - 1;
+                break;
+            }
+            case 'P':
+                o->exponente = atol(optarg);
+                if (o->exponente < 0) {
+                    fprintf(stderr, "El exponente de --potencia no puede ser negativo\n");
+                    return -1;
+                }
+                break;
+            case 'G':
+                o->solo_vector = 1;
+                break;
+            case 'Z':
+                if (parsear_afinidad(optarg, &o->afinidad) != 0) {
+                    fprintf(stderr, "Afinidad no válida: %s (use ninguna, compacta o dispersa)\n", optarg);
+                    return -1;
+                }
+                break;
+            case 'N':
+                o->un_hilo_por_nucleo = 1;
+                break;
+            case 'M':
+                if (parsear_aproximado(optarg, &o->aproximado) != 0) {
+                    fprintf(stderr, "Método aproximado no válido: %s (use muestreo, gaussiano o countsketch)\n",
+                            optarg);
+                    return -1;
+                }
+                break;
+            case 'J':
+                o->error_objetivo = atof(optarg);
+                if (o->error_objetivo <= 0.0) {
+                    fprintf(stderr, "El error objetivo debe ser positivo\n");
+                    return -1;
+                }
+                break;
+            case 'Q':
+                o->muestras = atol(optarg);
+                if (o->muestras <= 0) {
+                    fprintf(stderr, "El número de muestras debe ser positivo\n");
+                    return -1;
+                }
                 break;
             case 'a':
                 mostrar_ayuda();
-                return EXIT_SUCCESS;
+                return 1;
             case '?':
                 // getopt_long ya imprime un mensaje de error
                 mostrar_ayuda();
-                return EXIT_FAILURE;
+                return -1;
             default:
-                return EXIT_FAILURE;
+                return -1;
         }
     }
+    return 0;
+}
+
+// Función para comprobar que las opciones se pueden combinar; completa el error
+// objetivo por defecto de --aproximado. Devuelve 0 o -1 si no son compatibles.
+int validar_opciones(Opciones* o) {
+    // El epílogo fusionado y las vistas sólo están implementados en doble precisión
+    if ((o->usar_epilogo || o->usar_vista) && o->dtype != DTYPE_F64) {
+        fprintf(stderr, "Las opciones --alpha, --beta, --bias, --relu, --vista, --ta y --tb requieren -d f64\n");
+        return -1;
+    }
+    if (o->usar_epilogo && o->usar_vista) {
+        fprintf(stderr, "El epílogo fusionado no se combina con --vista, --ta o --tb\n");
+        return -1;
+    }
+    o->usar_bucle = o->iteraciones > 1 || o->usar_arena;
+    if (o->usar_bucle && (o->dtype != DTYPE_F64 || o->usar_epilogo || o->usar_vista)) {
+        fprintf(stderr, "--iteraciones y --arena sólo se combinan con la multiplicación f64 básica\n");
+        return -1;
+    }
+    if (o->algoritmo != ALG_INGENUO && (o->usar_epilogo || o->usar_vista || o->usar_bucle)) {
+        fprintf(stderr, "--algoritmo sólo se combina con la multiplicación básica\n");
+        return -1;
+    }
+    int admite_f32 = o->algoritmo == ALG_BLOQUES || o->algoritmo == ALG_SYRK || o->algoritmo == ALG_SYMM
+                     || o->algoritmo == ALG_TRMM;
+    if (o->algoritmo != ALG_INGENUO && o->dtype != DTYPE_F64 && !(admite_f32 && o->dtype == DTYPE_F32)) {
+        fprintf(stderr, "Strassen, morton y estrecho requieren -d f64; bloques, syrk, symm y trmm"
+                " admiten -d f64 o f32\n");
+        return -1;
+    }
+    if (o->algoritmo == ALG_ESTRECHO && o->columnasB > ESTRECHO_MAX_COLUMNAS) {
+        fprintf(stderr, "--algoritmo estrecho requiere como mucho %d columnas de B\n", ESTRECHO_MAX_COLUMNAS);
+        return -1;
+    }
+    if ((o->algoritmo == ALG_SYMM || o->algoritmo == ALG_TRMM) && o->filasA != o->columnasA) {
+        fprintf(stderr, "symm y trmm requieren A cuadrada (-r igual a -c)\n");
+        return -1;
+    }
+    
+    if (o->num_cadena > 0 && (o->dtype != DTYPE_F64 || o->algoritmo != ALG_INGENUO || o->usar_epilogo
+                              || o->usar_vista || o->usar_bucle)) {
+        fprintf(stderr, "--cadena sólo se combina con -d f64, -h, --perfil, --afinidad, --verificar y -p\n");
+        return -1;
+    }
+    
+    if (o->exponente >= 0 && (o->num_cadena > 0 || o->dtype != DTYPE_F64 || o->algoritmo != ALG_INGENUO
+                              || o->usar_epilogo || o->usar_vista || o->usar_bucle)) {
+        fprintf(stderr, "--potencia sólo se combina con -d f64, -h, --perfil, --vector, --verificar y -p\n");
+        return -1;
+    }
+    if (o->exponente >= 0 && o->filasA != o->columnasA) {
+        fprintf(stderr, "--potencia requiere A cuadrada (-r igual a -c)\n");
+        return -1;
+    }
+    if (o->solo_vector && o->exponente < 0) {
+        fprintf(stderr, "--vector requiere --potencia\n");
+        return -1;
+    }
+    
+    if (o->aproximado != APROX_NINGUNO && (o->exponente >= 0 || o->num_cadena > 0 || o->dtype != DTYPE_F64
+                                           || o->algoritmo != ALG_INGENUO || o->usar_epilogo || o->usar_vista
+                                           || o->usar_bucle)) {
+        fprintf(stderr, "--aproximado sólo se combina con -d f64, -h, --perfil, --error, --muestras, --verificar y -p\n");
+        return -1;
+    }
+    if ((o->error_objetivo > 0.0 || o->muestras > 0) && o->aproximado == APROX_NINGUNO) {
+        fprintf(stderr, "--error y --muestras requieren --aproximado\n");
+        return -1;
+    }
+    if (o->error_objetivo > 0.0 && o->muestras > 0) {
+        fprintf(stderr, "Indique un error objetivo (--error) o un número de muestras (--muestras), no ambos\n");
+        return -1;
+    }
+    if (o->aproximado != APROX_NINGUNO && o->muestras == 0 && o->error_objetivo == 0.0) {
+        o->error_objetivo = 0.1;
+    }
+    return 0;
+}
+
+// Producto aproximado: la dimensión interior se reduce a s muestras (elegidas
+// para el error objetivo o dadas) y queda un único producto denso m x s x n
+int ejecutar_aproximado(const Opciones* o) {
+    int filasA = o->filasA, columnasA = o->columnasA, columnasB = o->columnasB;
+    int num_hilos = o->num_hilos;
     
-    // Inicializar el generador de números aleatorios
     srand(time(NULL));
+    ModeloCadena modelo;
+    cargar_modelo_cadena(o->ruta_perfil, &modelo);
+    double** A = reservar_matriz(filasA, columnasA);
+    double** B = reservar_matriz(columnasA, columnasB);
+    double** C = reservar_matriz(filasA, columnasB);
+    llenar_matriz_aleatoria(A, filasA, columnasA);
+    llenar_matriz_aleatoria(B, columnasA, columnasB);
     
-    // Reservar memoria para las matrices
-    double** A = reservar_matriz(n);
-    double** B = reservar_matriz(n);
+    InformeAproximado inf;
+    double inicio = omp_get_wtime();
+    multiplicar_aproximado(A[0], B[0], C[0], filasA, columnasA, columnasB, o->aproximado, o->error_objetivo,
+                           o->muestras, (unsigned int)rand(), &modelo, num_hilos, &inf);
+    double tiempo = omp_get_wtime() - inicio;
+    
+    printf("- Producto aproximado (%s) de A %d x %d por B %d x %d\n", nombre_aproximado(o->aproximado),
+           filasA, columnasA, columnasA, columnasB);
+    if (o->error_objetivo > 0.0) {
+        printf("- Error relativo objetivo: %g\n", o->error_objetivo);
+    }
+    if (inf.exacto) {
+        printf("- Muestras necesarias >= coste del producto exacto: se calculó A * B exacto\n");
+    } else {
+        printf("- Muestras: %d", inf.muestras);
+        if (o->aproximado == APROX_MUESTREO) {
+            printf(" (%d columnas de A distintas)", inf.columnas_distintas);
+        }
+        printf(" de %d\n", columnasA);
+        printf("- Error relativo estimado (Frobenius): %e\n", inf.error_estimado);
+        if (inf.rondas > 1) {
+            printf("- Productos reducidos: %d (las muestras se corrigieron con la norma del resultado)\n",
+                   inf.rondas);
+        }
+    }
+    printf("- Tiempo de ejecución (%d hilos): %.6f segundos\n", num_hilos, tiempo);
+    
+    if (o->verificar) {
+        double** referencia = reservar_matriz(filasA, columnasB);
+        double inicio_ref = omp_get_wtime();
+        gemm_bloques_openmp(A[0], columnasA, B[0], columnasB, referencia[0], columnasB, filasA, columnasA,
+                            columnasB, modelo.bloques[clase_perfil(filasA, columnasA, columnasB)], num_hilos);
+        double tiempo_ref = omp_get_wtime() - inicio_ref;
+        printf("- Tiempo del producto exacto (bloques): %.6f segundos (%.2fx)\n", tiempo_ref,
+               tiempo_ref / tiempo);
+        printf("- Error relativo real frente al producto exacto: %e\n",
+               error_relativo(referencia, C, filasA, columnasB));
+        liberar_matriz(referencia, filasA);
+    }
+    if (o->imprimir) {
+        printf("\nMatriz Resultado (aproximada):\n");
+        imprimir_matriz(C, filasA, columnasB);
+    }
+    
+    liberar_matriz(A, filasA);
+    liberar_matriz(B, columnasA);
+    liberar_matriz(C, filasA);
+    return EXIT_SUCCESS;
+}
+
+// Potencia de una matriz de transición (filas con suma 1, como en una cadena de
+// Markov, para que A^k no se desborde): tres buffers n x n reservados una vez
+int ejecutar_potencia(const Opciones* o) {
+    int n = o->filasA;
+    int num_hilos = o->num_hilos;
+    
+    srand(time(NULL));
+    ModeloCadena modelo;
+    cargar_modelo_cadena(o->ruta_perfil, &modelo);
+    double** A = reservar_matriz(n, n);
+    llenar_matriz_aleatoria(A, n, n);
+    for (int i = 0; i < n; i++) {
+        double suma = 0.0;
+        for (int j = 0; j < n; j++) {
+            A[i][j] += 1.0;
+            suma += A[i][j];
+        }
+        for (int j = 0; j < n; j++) {
+            A[i][j] /= suma;
+        }
+    }
+    double** P = reservar_matriz(n, n);
+    double** trabajo1 = reservar_matriz(n, n);
+    double** trabajo2 = reservar_matriz(n, n);
+    double* x = (double*)malloc(n * sizeof(double));
+    double* y = (double*)malloc(n * sizeof(double));
+    if (x == NULL || y == NULL) {
+        fprintf(stderr, "Error en la asignación de memoria para los vectores\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < n; i++) {
+        x[i] = 1.0 / n;
+    }
+    
+    double inicio = omp_get_wtime();
+    int iterado = 0;
+    if (o->solo_vector) {
+        iterado = vector_potencia(x, A[0], n, o->exponente, y, P[0], trabajo1[0], trabajo2[0], -1, &modelo,
+                                  num_hilos);
+    } else {
+        potencia_matriz(A[0], n, o->exponente, P[0], trabajo1[0], trabajo2[0], &modelo, num_hilos);
+    }
+    double tiempo = omp_get_wtime() - inicio;
+    
+    printf("- Potencia A^%ld de una matriz %d x %d\n", o->exponente, n, n);
+    if (o->solo_vector) {
+        printf("- Ruta: %s\n", iterado ? "x * A, k veces (sin formar A^k)" : "A^k por exponenciación binaria y x * A^k");
+    }
+    if (!iterado) {
+        printf("- Productos de matrices: %d (multiplicando k veces: %ld)\n", productos_potencia(o->exponente),
+               o->exponente > 0 ? o->exponente - 1 : 0);
+    }
+    printf("- Tiempo de ejecución (%d hilos): %.6f segundos\n", num_hilos, tiempo);
+    
+    if (o->verificar) {
+        // Multiplicar k veces por A, como con llamadas sucesivas, y comparar
+        double** referencia = reservar_matriz(n, n);
+        memset(referencia[0], 0, (size_t)n * n * sizeof(double));
+        for (int i = 0; i < n; i++) {
+            referencia[i][i] = 1.0;
+        }
+        double inicio_ref = omp_get_wtime();
+        for (long t = 0; t < o->exponente; t++) {
+            double** siguiente = multiplicar_matrices_openmp(referencia, A, n, n, n, num_hilos);
+            liberar_matriz(referencia, n);
+            referencia = siguiente;
+        }
+        printf("- Tiempo multiplicando k veces (ingenuo): %.6f segundos\n", omp_get_wtime() - inicio_ref);
+        if (o->solo_vector) {
+            double num = 0.0, den = 0.0;
+            for (int j = 0; j < n; j++) {
+                double r = 0.0;
+                for (int i = 0; i < n; i++) {
+                    r += x[i] * referencia[i][j];
+                }
+                num += (y[j] - r) * (y[j] - r);
+                den += r * r;
+            }
+            printf("- Error relativo de x * A^k frente a la referencia: %e\n", den > 0.0 ? sqrt(num / den) : sqrt(num));
+        } else {
+            printf("- Error relativo frente a multiplicar k veces (Frobenius): %e\n",
+                   error_relativo(referencia, P, n, n));
+        }
+        liberar_matriz(referencia, n);
+    }
+    if (o->imprimir) {
+        if (o->solo_vector) {
+            printf("\nVector resultado (x * A^%ld):\n", o->exponente);
+            for (int j = 0; j < n; j++) {
+                printf("%lf ", y[j]);
+            }
+            printf("\n");
+        } else {
+            printf("\nMatriz Resultado (A^%ld):\n", o->exponente);
+            imprimir_matriz(P, n, n);
+        }
+    }
+    
+    free(x);
+    free(y);
+    liberar_matriz(A, n);
+    liberar_matriz(P, n);
+    liberar_matriz(trabajo1, n);
+    liberar_matriz(trabajo2, n);
+    return EXIT_SUCCESS;
+}
+
+// Cadena de matrices: el orden sale de la programación dinámica con el modelo del
+// perfil y los intermedios alternan entre dos buffers de una arena
+int ejecutar_cadena_matrices(const Opciones* o) {
+    int num_hilos = o->num_hilos;
+    
+    srand(time(NULL));
+    ModeloCadena modelo;
+    cargar_modelo_cadena(o->ruta_perfil, &modelo);
+    double** M[CADENA_MAX];
+    const double* datos[CADENA_MAX];
+    for (int i = 0; i < o->num_cadena; i++) {
+        M[i] = reservar_matriz(o->dims_cadena[i], o->dims_cadena[i + 1]);
+        llenar_matriz_aleatoria(M[i], o->dims_cadena[i], o->dims_cadena[i + 1]);
+        datos[i] = M[i][0];
+    }
+    int filasC = o->dims_cadena[0], columnasC = o->dims_cadena[o->num_cadena];
+    double** C = reservar_matriz(filasC, columnasC);
+    
+    double inicio = omp_get_wtime();
+    OrdenCadena orden = ordenar_cadena(o->dims_cadena, o->num_cadena, &modelo);
+    double fin_orden = omp_get_wtime();
+    size_t espacio = espacio_cadena(&orden);
+    Arena* arena = arena_crear(espacio + ARENA_ALINEACION);
+    if (arena == NULL) {
+        fprintf(stderr, "No se pudo crear el espacio de trabajo de la cadena\n");
+        return EXIT_FAILURE;
+    }
+    ejecutar_cadena(&orden, &modelo, datos, C[0], arena, num_hilos);
+    double fin = omp_get_wtime();
+    
+    char texto[16 * CADENA_MAX] = "";
+    describir_orden(&orden, 0, o->num_cadena - 1, texto, sizeof(texto));
+    double flops = flops_orden(&orden, 0, o->num_cadena - 1);
+    double flops_escrito = flops_izquierda(o->dims_cadena, o->num_cadena);
+    printf("- Cadena de %d matrices, resultado %d x %d\n", o->num_cadena, filasC, columnasC);
+    printf("- Orden elegido: %s\n", texto);
+    if (o->num_cadena > 1) {
+        printf("- Flops: %.0f (de izquierda a derecha: %.0f, %.2fx)\n", flops, flops_escrito, flops_escrito / flops);
+    }
+    if (modelo.clases_medidas > 0) {
+        printf("- Tiempo estimado por el perfil: %.6f segundos\n", orden.coste[o->num_cadena - 1]);
+    }
+    printf("- Espacio de trabajo (pares de buffers): %zu bytes\n", arena_pico(arena));
+    printf("- Tiempo de planificación: %.6f segundos\n", fin_orden - inicio);
+    printf("- Tiempo de ejecución (cadena, %d hilos): %.6f segundos\n", num_hilos, fin - fin_orden);
+    if (o->num_cadena > 1) {
+        printf("- Rendimiento: %.3f GFLOP/s\n", flops / (fin - fin_orden) / 1e9);
+    }
     
-    // Llenar las matrices con valores aleatorios
-    llenar_matriz_aleatoria(A, n);
-    llenar_matriz_aleatoria(B, n);
+    if (o->verificar) {
+        // Orden escrito y un C nuevo por producto, como con llamadas sucesivas
+        double inicio_ref = omp_get_wtime();
+        double** referencia = M[0];
+        for (int i = 1; i < o->num_cadena; i++) {
+            double** siguiente = multiplicar_matrices_openmp(referencia, M[i], filasC, o->dims_cadena[i],
+                                                             o->dims_cadena[i + 1], num_hilos);
+            if (referencia != M[0]) {
+                liberar_matriz(referencia, filasC);
+            }
+            referencia = siguiente;
+        }
+        printf("- Tiempo de izquierda a derecha (ingenuo): %.6f segundos\n", omp_get_wtime() - inicio_ref);
+        printf("- Error relativo frente al orden escrito (Frobenius): %e\n",
+               error_relativo(referencia, C, filasC, columnasC));
+        if (referencia != M[0]) {
+            liberar_matriz(referencia, filasC);
+        }
+    }
+    if (o->imprimir) {
+        printf("\nMatriz Resultado (C = M1 * ... * M%d):\n", o->num_cadena);
+        imprimir_matriz(C, filasC, columnasC);
+    }
+    
+    arena_destruir(arena);
+    liberar_orden_cadena(&orden);
+    liberar_matriz(C, filasC);
+    for (int i = 0; i < o->num_cadena; i++) {
+        liberar_matriz(M[i], o->dims_cadena[i]);
+    }
+    return EXIT_SUCCESS;
+}
+
+// Modo bucle: repetir el producto como en un proceso de larga duración. Sin --arena
+// cada iteración reserva y libera C; con --arena C sale siempre de la misma región.
+int ejecutar_bucle(const Opciones* o, double** A, double** B) {
+    int filasA = o->filasA, columnasA = o->columnasA, columnasB = o->columnasB;
+    int num_hilos = o->num_hilos;
     
-    // Medir tiempo de ejecución con clock() como en el ejemplo proporcionado
-    clock_t inicio_clock = clock();
+    Arena* arena = NULL;
+    size_t marca = 0;
+    if (o->usar_arena) {
+        arena = arena_crear((size_t)filasA * (columnasB * sizeof(double) + sizeof(double*))
+                            + 2 * ARENA_ALINEACION);
+        if (arena == NULL) {
+            fprintf(stderr, "No se pudo crear el espacio de trabajo\n");
+            return EXIT_FAILURE;
+        }
+        marca = arena_marca(arena);
+    }
+    
+    double** C = NULL;
+    double inicio = omp_get_wtime();
+    for (int it = 0; it < o->iteraciones; it++) {
+        if (o->usar_arena) {
+            arena_restaurar(arena, marca);
+            C = arena_matriz(arena, filasA, columnasB);
+            multiplicar_matrices_openmp_en(A, B, C, filasA, columnasA, columnasB, num_hilos);
+        } else {
+            if (C != NULL) {
+                liberar_matriz(C, filasA);
+            }
+            C = multiplicar_matrices_openmp(A, B, filasA, columnasA, columnasB, num_hilos);
+        }
+    }
+    double tiempo = omp_get_wtime() - inicio;
+    printf("- Tiempo de ejecución de %d multiplicaciones (%s): %.6f segundos (%.6f por iteración)\n",
+           o->iteraciones, o->usar_arena ? "arena" : "malloc", tiempo, tiempo / o->iteraciones);
+    if (o->verificar) {
+        // El último C (de la arena o de malloc) frente a un producto nuevo
+        double** referencia = multiplicar_matrices_openmp(A, B, filasA, columnasA, columnasB, num_hilos);
+        printf("- Error relativo frente a una multiplicación aparte (Frobenius): %e\n",
+               error_relativo(referencia, C, filasA, columnasB));
+        liberar_matriz(referencia, filasA);
+    }
+    if (o->imprimir) {
+        printf("\nMatriz Resultado (C = A * B):\n");
+        imprimir_matriz(C, filasA, columnasB);
+    }
+    if (o->usar_arena) {
+        printf("- Uso máximo del espacio de trabajo: %zu bytes\n", arena_pico(arena));
+        arena_destruir(arena);
+    } else {
+        liberar_matriz(C, filasA);
+    }
+    return EXIT_SUCCESS;
+}
+
+// Modo con vistas: A, B y C son bloques interiores de matrices mayores (con un
+// margen de MARGEN filas y columnas) y A y/o B se guardan traspuestas si se pide.
+int ejecutar_vista(const Opciones* o, double** A, double** B) {
+    int filasA = o->filasA, columnasA = o->columnasA, columnasB = o->columnasB;
+    int num_hilos = o->num_hilos;
+    
+    const int MARGEN = 3;
+    int fA = o->transA ? columnasA : filasA, cA = o->transA ? filasA : columnasA;
+    int fB = o->transB ? columnasB : columnasA, cB = o->transB ? columnasA : columnasB;
+    double** padreA = reservar_matriz(fA + 2 * MARGEN, cA + 2 * MARGEN);
+    double** padreB = reservar_matriz(fB + 2 * MARGEN, cB + 2 * MARGEN);
+    double** padreC = reservar_matriz(filasA + 2 * MARGEN, columnasB + 2 * MARGEN);
+    llenar_matriz_aleatoria(padreC, filasA + 2 * MARGEN, columnasB + 2 * MARGEN);
+    for (int i = 0; i < filasA; i++) {
+        for (int j = 0; j < columnasA; j++) {
+            if (o->transA) {
+                padreA[MARGEN + j][MARGEN + i] = A[i][j];
+            } else {
+                padreA[MARGEN + i][MARGEN + j] = A[i][j];
+            }
+        }
+    }
+    for (int i = 0; i < columnasA; i++) {
+        for (int j = 0; j < columnasB; j++) {
+            if (o->transB) {
+                padreB[MARGEN + j][MARGEN + i] = B[i][j];
+            } else {
+                padreB[MARGEN + i][MARGEN + j] = B[i][j];
+            }
+        }
+    }
+    VistaMatriz vA = vista_matriz(padreA, cA + 2 * MARGEN, MARGEN, MARGEN, fA, cA);
+    VistaMatriz vB = vista_matriz(padreB, cB + 2 * MARGEN, MARGEN, MARGEN, fB, cB);
+    VistaMatriz vC = vista_matriz(padreC, columnasB + 2 * MARGEN, MARGEN, MARGEN, filasA, columnasB);
+    
+    double inicio = omp_get_wtime();
+    if (gemm_vista_openmp(o->transA, o->transB, 1.0, vA, vB, 0.0, vC, num_hilos) != 0) {
+        fprintf(stderr, "Dimensiones incompatibles para gemm_vista_openmp\n");
+        return EXIT_FAILURE;
+    }
+    printf("- Tiempo de ejecución sobre vistas (OpenMP): %.6f segundos\n", omp_get_wtime() - inicio);
+    
+    // Verificar el bloque resultado contra la multiplicación de matrices completas
+    double** referencia = multiplicar_matrices_openmp(A, B, filasA, columnasA, columnasB, num_hilos);
+    double max_diff = 0.0;
+    for (int i = 0; i < filasA; i++) {
+        for (int j = 0; j < columnasB; j++) {
+            double d = fabs(padreC[MARGEN + i][MARGEN + j] - referencia[i][j]);
+            if (d > max_diff) {
+                max_diff = d;
+            }
+        }
+    }
+    printf("- Diferencia máxima frente a multiplicar_matrices_openmp: %e\n", max_diff);
+    
+    liberar_matriz(referencia, filasA);
+    liberar_matriz(padreA, fA + 2 * MARGEN);
+    liberar_matriz(padreB, fB + 2 * MARGEN);
+    liberar_matriz(padreC, filasA + 2 * MARGEN);
+    return EXIT_SUCCESS;
+}
+
+// Modo con epílogo fusionado: C = relu(alpha * A * B + beta * C + bias) sobre un C existente
+int ejecutar_epilogo(const Opciones* o, double** A, double** B) {
+    int filasA = o->filasA, columnasA = o->columnasA, columnasB = o->columnasB;
+    int num_hilos = o->num_hilos;
+    Epilogo ep = o->ep;
     
-    // Medición de tiempo más precisa usando OpenMP
+    double** C = reservar_matriz(filasA, columnasB);
+    double** C_ref = reservar_matriz(filasA, columnasB);
+    double* bias = NULL;
+    llenar_matriz_aleatoria(C, filasA, columnasB);
+    for (int i = 0; i < filasA; i++) {
+        for (int j = 0; j < columnasB; j++) {
+            C[i][j] -= 5.0;  // valores negativos para que relu tenga efecto
+            C_ref[i][j] = C[i][j];
+        }
+    }
+    if (o->usar_bias) {
+        bias = (double*)malloc(columnasB * sizeof(double));
+        for (int j = 0; j < columnasB; j++) {
+            bias[j] = (double)(rand() % 10) - 5.0;
+        }
+        ep.bias = bias;
+    }
+    
+    double inicio = omp_get_wtime();
+    multiplicar_matrices_openmp_epilogo(A, B, C, filasA, columnasA, columnasB, o->bloques, num_hilos, &ep);
+    printf("- Tiempo de ejecución con epílogo (OpenMP, bloques %d,%d,%d): %.6f segundos\n",
+           o->bloques.mc, o->bloques.kc, o->bloques.nc, omp_get_wtime() - inicio);
+    
+    // Verificar contra el producto y el epílogo calculados por separado
+    double** AB = multiplicar_matrices_openmp(A, B, filasA, columnasA, columnasB, num_hilos);
+    aplicar_epilogo_referencia(AB, C_ref, filasA, columnasB, &ep);
+    printf("- Error relativo frente al cálculo sin fusionar: %e\n",
+           error_relativo(C_ref, C, filasA, columnasB));
+    
+    if (o->imprimir) {
+        printf("\nMatriz Resultado (C = epílogo(A * B)):\n");
+        imprimir_matriz(C, filasA, columnasB);
+    }
+    
+    liberar_matriz(AB, filasA);
+    liberar_matriz(C_ref, filasA);
+    liberar_matriz(C, filasA);
+    free(bias);
+    return EXIT_SUCCESS;
+}
+
+// Algoritmo por bloques en f32 sobre copias float de las entradas
+int ejecutar_bloques_f32(const Opciones* o, double** A, double** B) {
+    int filasA = o->filasA, columnasA = o->columnasA, columnasB = o->columnasB;
+    int num_hilos = o->num_hilos;
+    
+    float** A32 = reservar_matriz_f32(filasA, columnasA);
+    float** B32 = reservar_matriz_f32(columnasA, columnasB);
+    float** C32 = reservar_matriz_f32(filasA, columnasB);
+    convertir_a_f32(A, A32, filasA, columnasA);
+    convertir_a_f32(B, B32, columnasA, columnasB);
+    
+    double inicio = omp_get_wtime();
+    gemm_bloques_openmp_f32(A32[0], columnasA, B32[0], columnasB, C32[0], columnasB,
+                            filasA, columnasA, columnasB, o->bloques, num_hilos);
+    double tiempo = omp_get_wtime() - inicio;
+    printf("- Tiempo de ejecución (bloques f32, bloques %d,%d,%d): %.6f segundos\n",
+           o->bloques.mc, o->bloques.kc, o->bloques.nc, tiempo);
+    printf("- Rendimiento: %.3f GFLOP/s\n", 2.0 * filasA * columnasA * columnasB / tiempo / 1e9);
+    
+    if (o->verificar) {
+        double** referencia = multiplicar_matrices_openmp(A, B, filasA, columnasA, columnasB, num_hilos);
+        printf("- Error relativo frente a fp64 (Frobenius): %e\n",
+               error_relativo_f32(referencia, C32, filasA, columnasB));
+        liberar_matriz(referencia, filasA);
+    }
+    
+    liberar_matriz_f32(A32, filasA);
+    liberar_matriz_f32(B32, columnasA);
+    liberar_matriz_f32(C32, filasA);
+    return EXIT_SUCCESS;
+}
+
+// Multiplicación recursiva en orden Z con tareas; se informan por separado las
+// conversiones y el producto
+int ejecutar_morton(const Opciones* o, double** A, double** B) {
+    int filasA = o->filasA, columnasA = o->columnasA, columnasB = o->columnasB;
+    int num_hilos = o->num_hilos;
+    
+    int niveles = niveles_morton(filasA, columnasA, columnasB);
+    MatrizMorton zA = reservar_morton(filasA, columnasA, niveles);
+    MatrizMorton zB = reservar_morton(columnasA, columnasB, niveles);
+    MatrizMorton zC = reservar_morton(filasA, columnasB, niveles);
+    double** C = reservar_matriz(filasA, columnasB);
+    
+    double inicio = omp_get_wtime();
+    convertir_a_morton_openmp(A, &zA, num_hilos);
+    convertir_a_morton_openmp(B, &zB, num_hilos);
+    double fin_conversion = omp_get_wtime();
+    multiplicar_morton_openmp(&zA, &zB, &zC, num_hilos);
+    double fin_producto = omp_get_wtime();
+    convertir_desde_morton_openmp(&zC, C, num_hilos);
+    double fin = omp_get_wtime();
+    
+    printf("- Orden Z con %d niveles (bloques de A %dx%d, de B %dx%d)\n",
+           niveles, zA.tf, zA.tc, zB.tf, zB.tc);
+    printf("- Tiempo de conversión a orden Z: %.6f segundos\n", fin_conversion - inicio);
+    printf("- Tiempo de ejecución (morton, tareas OpenMP): %.6f segundos\n", fin_producto - fin_conversion);
+    printf("- Tiempo de conversión desde orden Z: %.6f segundos\n", fin - fin_producto);
+    printf("- Rendimiento (sin conversiones): %.3f GFLOP/s\n",
+           2.0 * filasA * columnasA * columnasB / (fin_producto - fin_conversion) / 1e9);
+    
+    if (o->verificar) {
+        double** referencia = multiplicar_matrices_openmp(A, B, filasA, columnasA, columnasB, num_hilos);
+        printf("- Error relativo frente al algoritmo ingenuo (Frobenius): %e\n",
+               error_relativo(referencia, C, filasA, columnasB));
+        liberar_matriz(referencia, filasA);
+    }
+    if (o->imprimir) {
+        printf("\nMatriz Resultado (C = A * B):\n");
+        imprimir_matriz(C, filasA, columnasB);
+    }
+    
+    liberar_morton(&zA);
+    liberar_morton(&zB);
+    liberar_morton(&zC);
+    liberar_matriz(C, filasA);
+    return EXIT_SUCCESS;
+}
+
+// GEMV y tall-skinny: limitado por la lectura de A, así que se informa el ancho de
+// banda efectivo; con pocas filas los hilos se reparten k en lugar de filas
+int ejecutar_estrecho(const Opciones* o, double** A, double** B) {
+    int filasA = o->filasA, columnasA = o->columnasA, columnasB = o->columnasB;
+    int num_hilos = o->num_hilos;
+    
+    double** C = reservar_matriz(filasA, columnasB);
+    
+    double inicio = omp_get_wtime();
+    gemm_estrecho_openmp(A[0], columnasA, B[0], columnasB, C[0], columnasB,
+                         filasA, columnasA, columnasB, num_hilos);
+    double tiempo = omp_get_wtime() - inicio;
+    double bytes = ((double)filasA * columnasA + (double)columnasA * columnasB
+                    + (double)filasA * columnasB) * sizeof(double);
+    printf("- Tiempo de ejecución (%s, reparto por %s): %.6f segundos\n",
+           columnasB == 1 ? "gemv" : "tall-skinny",
+           estrecho_reparte_k(filasA, num_hilos) ? "k" : "filas", tiempo);
+    printf("- Ancho de banda efectivo: %.3f GB/s\n", bytes / tiempo / 1e9);
+    
+    if (o->verificar) {
+        double** referencia = multiplicar_matrices_openmp(A, B, filasA, columnasA, columnasB, num_hilos);
+        printf("- Error relativo frente al algoritmo ingenuo (Frobenius): %e\n",
+               error_relativo(referencia, C, filasA, columnasB));
+        liberar_matriz(referencia, filasA);
+    }
+    if (o->imprimir) {
+        printf("\nMatriz Resultado (C = A * B):\n");
+        imprimir_matriz(C, filasA, columnasB);
+    }
+    
+    liberar_matriz(C, filasA);
+    return EXIT_SUCCESS;
+}
+
+// Productos con estructura: sólo se lee el triángulo de A que corresponde; la
+// referencia de --verificar usa la matriz completa equivalente con el producto general
+// (en fp64 también con -d f32, que calcula sobre copias float de las entradas)
+int ejecutar_estructurado(const Opciones* o, double** A, double** B) {
+    int filasA = o->filasA, columnasA = o->columnasA, columnasB = o->columnasB;
+    int num_hilos = o->num_hilos;
+    int columnasC = o->algoritmo == ALG_SYRK ? filasA : columnasB;
+    int f32 = o->dtype == DTYPE_F32;
+    
+    double** C = NULL;
+    float** A32 = NULL;
+    float** B32 = NULL;
+    float** C32 = NULL;
+    if (f32) {
+        A32 = reservar_matriz_f32(filasA, columnasA);
+        B32 = reservar_matriz_f32(columnasA, columnasB);
+        C32 = reservar_matriz_f32(filasA, columnasC);
+        convertir_a_f32(A, A32, filasA, columnasA);
+        convertir_a_f32(B, B32, columnasA, columnasB);
+    } else {
+        C = reservar_matriz(filasA, columnasC);
+    }
+    double flops;
+    const char* nombre;
+    
+    double inicio = omp_get_wtime();
+    if (o->algoritmo == ALG_SYRK) {
+        if (f32) {
+            syrk_bloques_openmp_f32(A32[0], columnasA, C32[0], columnasC, filasA, columnasA, o->bloques, num_hilos);
+        } else {
+            syrk_bloques_openmp(A[0], columnasA, C[0], columnasC, filasA, columnasA, o->bloques, num_hilos);
+        }
+        flops = (double)filasA * (filasA + 1) * columnasA;
+        nombre = "syrk";
+    } else if (o->algoritmo == ALG_SYMM) {
+        if (f32) {
+            symm_bloques_openmp_f32(A32[0], columnasA, B32[0], columnasB, C32[0], columnasC, filasA,
+                                    columnasB, o->bloques, num_hilos);
+        } else {
+            symm_bloques_openmp(A[0], columnasA, B[0], columnasB, C[0], columnasC, filasA, columnasB,
+                                o->bloques, num_hilos);
+        }
+        flops = 2.0 * filasA * filasA * columnasB;
+        nombre = "symm";
+    } else {
+        if (f32) {
+            trmm_bloques_openmp_f32(A32[0], columnasA, B32[0], columnasB, C32[0], columnasC, filasA,
+                                    columnasB, o->superior, o->bloques, num_hilos);
+        } else {
+            trmm_bloques_openmp(A[0], columnasA, B[0], columnasB, C[0], columnasC, filasA, columnasB,
+                                o->superior, o->bloques, num_hilos);
+        }
+        flops = (double)filasA * (filasA + 1) * columnasB;
+        nombre = o->superior ? "trmm superior" : "trmm inferior";
+    }
+    double tiempo = omp_get_wtime() - inicio;
+    printf("- Tiempo de ejecución (%s%s, bloques %d,%d,%d): %.6f segundos\n",
+           nombre, f32 ? " f32" : "", o->bloques.mc, o->bloques.kc, o->bloques.nc, tiempo);
+    printf("- Rendimiento (operaciones útiles): %.3f GFLOP/s\n", flops / tiempo / 1e9);
+    
+    if (o->verificar) {
+        // Operandos completos: A^T para syrk, S simetrizada o T con ceros para symm y trmm
+        double** izquierda = A;
+        double** derecha = B;
+        double** completa = NULL;
+        if (o->algoritmo == ALG_SYRK) {
+            completa = reservar_matriz(columnasA, filasA);
+            for (int i = 0; i < filasA; i++) {
+                for (int j = 0; j < columnasA; j++) {
+                    completa[j][i] = A[i][j];
+                }
+            }
+            derecha = completa;
+        } else {
+            completa = reservar_matriz(filasA, filasA);
+            for (int i = 0; i < filasA; i++) {
+                for (int j = 0; j < filasA; j++) {
+                    int en_triangulo = o->superior ? j >= i : j <= i;
+                    if (o->algoritmo == ALG_SYMM) {
+                        completa[i][j] = j <= i ? A[i][j] : A[j][i];
+                    } else {
+                        completa[i][j] = en_triangulo ? A[i][j] : 0.0;
+                    }
+                }
+            }
+            izquierda = completa;
+        }
+        double** referencia = multiplicar_matrices_openmp(izquierda, derecha, filasA, columnasA,
+                                                          columnasC, num_hilos);
+        printf("- Error relativo frente al producto general%s (Frobenius): %e\n", f32 ? " fp64" : "",
+               f32 ? error_relativo_f32(referencia, C32, filasA, columnasC)
+                   : error_relativo(referencia, C, filasA, columnasC));
+        liberar_matriz(referencia, filasA);
+        liberar_matriz(completa, o->algoritmo == ALG_SYRK ? columnasA : filasA);
+    }
+    if (o->imprimir && !f32) {
+        printf("\nMatriz Resultado (%s):\n", nombre);
+        imprimir_matriz(C, filasA, columnasC);
+    }
+    
+    if (f32) {
+        liberar_matriz_f32(A32, filasA);
+        liberar_matriz_f32(B32, columnasA);
+        liberar_matriz_f32(C32, filasA);
+    } else {
+        liberar_matriz(C, filasA);
+    }
+    return EXIT_SUCCESS;
+}
+
+// Algoritmos por bloques y Strassen (f64): C sale de reservar_matriz y los temporales
+// de Strassen de una arena dimensionada con espacio_strassen
+int ejecutar_bloques_strassen(const Opciones* o, double** A, double** B) {
+    int filasA = o->filasA, columnasA = o->columnasA, columnasB = o->columnasB;
+    int num_hilos = o->num_hilos;
+    
+    double** C = reservar_matriz(filasA, columnasB);
+    Arena* arena = NULL;
+    if (o->algoritmo == ALG_STRASSEN) {
+        arena = arena_crear(espacio_strassen(filasA, columnasA, columnasB, CORTE_STRASSEN));
+        if (arena == NULL) {
+            fprintf(stderr, "No se pudo crear el espacio de trabajo\n");
+            return EXIT_FAILURE;
+        }
+    }
+    
+    double inicio = omp_get_wtime();
+    if (o->algoritmo == ALG_BLOQUES) {
+        gemm_bloques_openmp(A[0], columnasA, B[0], columnasB, C[0], columnasB,
+                            filasA, columnasA, columnasB, o->bloques, num_hilos);
+    } else {
+        multiplicar_strassen_openmp_en(A, B, C, filasA, columnasA, columnasB,
+                                       o->bloques, CORTE_STRASSEN, num_hilos, arena);
+    }
+    double tiempo = omp_get_wtime() - inicio;
+    printf("- Tiempo de ejecución (%s, bloques %d,%d,%d): %.6f segundos\n",
+           o->algoritmo == ALG_BLOQUES ? "bloques" : "strassen",
+           o->bloques.mc, o->bloques.kc, o->bloques.nc, tiempo);
+    printf("- Rendimiento: %.3f GFLOP/s\n", 2.0 * filasA * columnasA * columnasB / tiempo / 1e9);
+    
+    if (o->verificar) {
+        double** referencia = multiplicar_matrices_openmp(A, B, filasA, columnasA, columnasB, num_hilos);
+        printf("- Error relativo frente al algoritmo ingenuo (Frobenius): %e\n",
+               error_relativo(referencia, C, filasA, columnasB));
+        liberar_matriz(referencia, filasA);
+    }
+    if (o->imprimir) {
+        printf("\nMatriz Resultado (C = A * B):\n");
+        imprimir_matriz(C, filasA, columnasB);
+    }
+    
+    arena_destruir(arena);
+    liberar_matriz(C, filasA);
+    return EXIT_SUCCESS;
+}
+
+// Multiplicación básica (ingenua) en f64, f32 o mixed
+int ejecutar_basico(const Opciones* o, double** A, double** B) {
+    int filasA = o->filasA, columnasA = o->columnasA, columnasB = o->columnasB;
+    int num_hilos = o->num_hilos;
+    
+    // Copias en simple precisión de las entradas para los modos f32 y mixed
+    float** A32 = NULL;
+    float** B32 = NULL;
+    float** C32 = NULL;
+    double** C = NULL;
+    if (o->dtype != DTYPE_F64) {
+        A32 = reservar_matriz_f32(filasA, columnasA);
+        B32 = reservar_matriz_f32(columnasA, columnasB);
+        convertir_a_f32(A, A32, filasA, columnasA);
+        convertir_a_f32(B, B32, columnasA, columnasB);
+    }
+    
+    // Medición de tiempo usando OpenMP
     double inicio_omp = omp_get_wtime();
     
     // Multiplicar las matrices usando OpenMP
-    double** C = multiplicar_matrices_openmp(A, B, n, num_hilos);
+    if (o->dtype == DTYPE_F64) {
+        C = multiplicar_matrices_openmp(A, B, filasA, columnasA, columnasB, num_hilos);
+    } else if (o->dtype == DTYPE_F32) {
+        C32 = reservar_matriz_f32(filasA, columnasB);
+        multiplicar_filas_openmp_f32(A32[0], columnasA, B32[0], columnasB, C32[0], columnasB,
+                                     filasA, columnasA, columnasB, num_hilos);
+    } else {
+        C = reservar_matriz(filasA, columnasB);
+        multiplicar_filas_openmp_mixta(A32[0], columnasA, B32[0], columnasB, C[0], columnasB,
+                                       filasA, columnasA, columnasB, num_hilos);
+    }
     
     // Finalizar medición del tiempo
     double fin_omp = omp_get_wtime();
-    clock_t fin_clock = clock();
     
-    double tiempo_clock = (double)(fin_clock - inicio_clock) / CLOCKS_PER_SEC;
     double tiempo_omp = fin_omp - inicio_omp;
     
     // Imprimir las matrices si se solicitó
-    if (imprimir) {
+    if (o->imprimir) {
         printf("\nMatriz A:\n");
-        imprimir_matriz(A, n);
-        
+        imprimir_matriz(A, filasA, columnasA);
+    
         printf("\nMatriz B:\n");
-        imprimir_matriz(B, n);
-        
+        imprimir_matriz(B, columnasA, columnasB);
+    
         printf("\nMatriz Resultado (C = A * B):\n");
-        imprimir_matriz(C, n);
+        if (C32 != NULL) {
+            for (int i = 0; i < filasA; i++) {
+                for (int j = 0; j < columnasB; j++) {
+                    printf("%f ", C32[i][j]);
+                }
+                printf("\n");
+            }
+        } else {
+            imprimir_matriz(C, filasA, columnasB);
+        }
     }
     
     // Imprimir estadísticas
     // printf("\nEstadísticas:\n");
     // printf("- Tamaño de la matriz: %d x %d\n", n, n);
     // printf("- Número de hilos utilizados: %d\n", num_hilos);
-    // printf("- Tiempo de ejecución (clock): %.6f segundos\n", tiempo_clock);
     printf("- Tiempo de ejecución (OpenMP): %.6f segundos\n", tiempo_omp);
     
+    // Comparar contra una referencia calculada en doble precisión
+    if (o->dtype != DTYPE_F64) {
+        double** referencia = multiplicar_matrices_openmp(A, B, filasA, columnasA, columnasB, num_hilos);
+        double error = (o->dtype == DTYPE_F32)
+            ? error_relativo_f32(referencia, C32, filasA, columnasB)
+            : error_relativo(referencia, C, filasA, columnasB);
+        printf("- Error relativo frente a fp64 (Frobenius): %e\n", error);
+        liberar_matriz(referencia, filasA);
+    }
+    
     // Liberar memoria
-    liberar_matriz(A, n);
-    liberar_matriz(B, n);
-    liberar_matriz(C, n);
+    if (C != NULL) {
+        liberar_matriz(C, filasA);
+    }
+    if (o->dtype != DTYPE_F64) {
+        liberar_matriz_f32(A32, filasA);
+        liberar_matriz_f32(B32, columnasA);
+    }
+    if (C32 != NULL) {
+        liberar_matriz_f32(C32, filasA);
+    }
     
     return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
+
+int main(int argc, char *argv[]) {
+    Opciones o;
+    int leidas = parsear_opciones(argc, argv, &o);
+    if (leidas != 0) {
+        return leidas > 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    if (validar_opciones(&o) != 0) {
+        return EXIT_FAILURE;
+    }
+    
+    // Afinidad: libgomp enlaza los hilos a las CPUs del plan (OMP_PLACES). La cadena
+    // reparte los lugares entre sus equipos anidados (spread); el resto pone el hilo w
+    // en la CPU w del plan (close). La potencia, la cadena y el producto aproximado ya
+    // conocen aquí sus hilos; el resto, tras leer el perfil.
+    static PlanAfinidad plan;
+    planificar_afinidad(&plan, o.afinidad, o.un_hilo_por_nucleo);
+    if (o.afinidad != AFINIDAD_NINGUNA) {
+        enlazar_hilos_openmp(&plan, o.num_cadena > 0 ? "spread" : "close", argv);
+        if (o.num_cadena > 0) {
+            informar_afinidad(&plan, plan.num_cpus, "Lugar");
+        } else if (o.exponente >= 0 || o.aproximado != APROX_NINGUNO) {
+            informar_afinidad(&plan, o.num_hilos, "Hilo");
+        }
+    }
+    
+    // Modos que generan sus propios operandos
+    if (o.aproximado != APROX_NINGUNO) {
+        return ejecutar_aproximado(&o);
+    }
+    if (o.exponente >= 0) {
+        return ejecutar_potencia(&o);
+    }
+    if (o.num_cadena > 0) {
+        return ejecutar_cadena_matrices(&o);
+    }
+    
+    // Con formas muy desiguales la rejilla del orden Z sería casi toda relleno
+    if (o.algoritmo == ALG_MORTON && !morton_compensa(o.filasA, o.columnasA, o.columnasB)) {
+        printf("- Forma demasiado desigual para el orden Z (relleno %.1fx): se usa el algoritmo por bloques\n",
+               relleno_morton(o.filasA, o.columnasA, o.columnasB));
+        o.algoritmo = ALG_BLOQUES;
+    }
+    
+    // Sin --bloque, los bloques (y sin -h también los hilos) salen del perfil de
+    // matrices_autotune para esta máquina, dtype y clase de tamaño, si existe; el
+    // epílogo fusionado también usa el kernel por bloques
+    if (((o.algoritmo != ALG_INGENUO && o.algoritmo != ALG_MORTON && o.algoritmo != ALG_ESTRECHO)
+         || o.usar_epilogo) && !o.bloques_explicitos) {
+        Bloques del_perfil;
+        int hilos_perfil;
+        const char* tipo_perfil = o.dtype == DTYPE_F32 ? "f32" : "f64";
+        if (cargar_perfil(o.ruta_perfil, tipo_perfil, o.filasA, o.columnasA, o.columnasB, &del_perfil,
+                          &hilos_perfil, NULL) == 0) {
+            o.bloques = del_perfil;
+            if (!o.hilos_explicitos) {
+                o.num_hilos = hilos_perfil;
+            }
+            printf("- Perfil %s/%s: bloques %d,%d,%d unroll %d orden %s, %d hilos\n", tipo_perfil,
+                   nombres_clase_perfil[clase_perfil(o.filasA, o.columnasA, o.columnasB)],
+                   o.bloques.mc, o.bloques.kc, o.bloques.nc, o.bloques.unroll, nombre_orden(o.bloques.orden),
+                   o.num_hilos);
+        }
+    }
+    
+    if (o.afinidad != AFINIDAD_NINGUNA) {
+        informar_afinidad(&plan, o.num_hilos, "Hilo");
+    }
+    
+    // Inicializar el generador de números aleatorios
+    srand(time(NULL));
+    
+    // Reservar memoria para las matrices
+    double** A = reservar_matriz(o.filasA, o.columnasA);
+    double** B = reservar_matriz(o.columnasA, o.columnasB);
+    
+    // Llenar las matrices con valores aleatorios (no enteros en f32 y mixed)
+    llenar_matriz_aleatoria(A, o.filasA, o.columnasA);
+    llenar_matriz_aleatoria(B, o.columnasA, o.columnasB);
+    if (o.dtype != DTYPE_F64) {
+        fraccionar_datos(A[0], (size_t)o.filasA * o.columnasA);
+        fraccionar_datos(B[0], (size_t)o.columnasA * o.columnasB);
+    }
+    
+    // Cada modo libera lo que reserva; A y B se liberan aquí
+    int resultado;
+    if (o.usar_bucle) {
+        resultado = ejecutar_bucle(&o, A, B);
+    } else if (o.usar_vista) {
+        resultado = ejecutar_vista(&o, A, B);
+    } else if (o.usar_epilogo) {
+        resultado = ejecutar_epilogo(&o, A, B);
+    } else if (o.algoritmo == ALG_BLOQUES && o.dtype == DTYPE_F32) {
+        resultado = ejecutar_bloques_f32(&o, A, B);
+    } else if (o.algoritmo == ALG_MORTON) {
+        resultado = ejecutar_morton(&o, A, B);
+    } else if (o.algoritmo == ALG_ESTRECHO) {
+        resultado = ejecutar_estrecho(&o, A, B);
+    } else if (o.algoritmo == ALG_SYRK || o.algoritmo == ALG_SYMM || o.algoritmo == ALG_TRMM) {
+        resultado = ejecutar_estructurado(&o, A, B);
+    } else if (o.algoritmo != ALG_INGENUO) {
+        resultado = ejecutar_bloques_strassen(&o, A, B);
+    } else {
+        resultado = ejecutar_basico(&o, A, B);
+    }
+    
+    liberar_matriz(A, o.filasA);
+    liberar_matriz(B, o.columnasA);
+    return resultado;
+}
@@ -0,0 +1,149 @@
+/*
+ * matrices_perfil.h
+ *
+ * Perfil de ajuste por máquina escrito por matrices_autotune y leído al arrancar
+ * por matrices_openmp y matrices_auto. Se guarda junto a la calibración, en
+ * $XDG_CACHE_HOME/matrices/perfil.txt (o ~/.cache/matrices/perfil.txt):
+ *
+ *   maquina=<nombre>|<cpus>|<modelo de CPU>
+ *   <dtype> <clase> mc=<n> kc=<n> nc=<n> unroll=<n> orden=ikj|kij hilos=<n> gflops=<x>
+ *
+ * La clase de tamaño se decide por la raíz cúbica de m * k * n (ver clase_perfil).
+ * Un perfil de otra máquina se ignora.
+ */
+
+#ifndef MATRICES_PERFIL_H
+#define MATRICES_PERFIL_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "matrices_bloques.h"
+
+/* Clases de tamaño: límite superior (exclusivo) de la raíz cúbica de m*k*n y
+ * tamaño representativo con el que las mide matrices_autotune
+ */
+#define NUM_CLASES_PERFIL 3
+static const char* const nombres_clase_perfil[NUM_CLASES_PERFIL] = {"pequeno", "mediano", "grande"};
+static const int limite_clase_perfil[NUM_CLASES_PERFIL] = {128, 768, 1 << 30};
+static const int tamano_clase_perfil[NUM_CLASES_PERFIL] = {64, 384, 1024};
+
+/* Índice de la clase de tamaño de un producto m x k x n */
+static inline int clase_perfil(int m, int k, int n) {
+    double lado = cbrt((double)m * k * n);
+    for (int c = 0; c < NUM_CLASES_PERFIL - 1; c++) {
+        if (lado < limite_clase_perfil[c]) {
+            return c;
+        }
+    }
+    return NUM_CLASES_PERFIL - 1;
+}
+
+/* Identificador de la máquina: nombre|cpus|modelo de CPU */
+static inline void identificar_maquina(char* destino, size_t tam) {
+    char nombre[64] = "desconocido";
+    char modelo[160] = "desconocido";
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    gethostname(nombre, sizeof(nombre) - 1);
+    FILE* f = fopen("/proc/cpuinfo", "r");
+    if (f != NULL) {
+        char linea[256];
+        while (fgets(linea, sizeof(linea), f) != NULL) {
+            if (strncmp(linea, "model name", 10) == 0) {
+                char* valor = strchr(linea, ':');
+                if (valor != NULL) {
+                    valor += valor[1] == ' ' ? 2 : 1;
+                    valor[strcspn(valor, "\n")] = '\0';
+                    snprintf(modelo, sizeof(modelo), "%s", valor);
+                }
+                break;
+            }
+        }
+        fclose(f);
+    }
+    snprintf(destino, tam, "%s|%ld|%s", nombre, ncpu < 1 ? 1 : ncpu, modelo);
+}
+
+/* Ruta de un archivo dentro de $XDG_CACHE_HOME/matrices (o ~/.cache/matrices);
+ * crea el directorio si hace falta
+ */
+static inline void ruta_cache_matrices(const char* archivo, char* destino, size_t tam) {
+    const char* base = getenv("XDG_CACHE_HOME");
+    char directorio[512];
+    if (base != NULL && base[0] != '\0') {
+        snprintf(directorio, sizeof(directorio), "%s", base);
+    } else {
+        const char* home = getenv("HOME");
+        snprintf(directorio, sizeof(directorio), "%s/.cache", home != NULL ? home : "/tmp");
+    }
+    mkdir(directorio, 0755);
+    strncat(directorio, "/matrices", sizeof(directorio) - strlen(directorio) - 1);
+    mkdir(directorio, 0755);
+    snprintf(destino, tam, "%s/%s", directorio, archivo);
+}
+
+/* Lee una línea de perfil; devuelve 0 si tiene todos los campos */
+static inline int parsear_linea_perfil(const char* linea, char* dtype, char* clase,
+                                       Bloques* bl, int* hilos, double* gflops) {
+    char orden[8];
+    if (sscanf(linea, "%7s %15s mc=%d kc=%d nc=%d unroll=%d orden=%7s hilos=%d gflops=%lf",
+               dtype, clase, &bl->mc, &bl->kc, &bl->nc, &bl->unroll, orden, hilos, gflops) != 9) {
+        return -1;
+    }
+    if (bl->mc <= 0 || bl->kc <= 0 || bl->nc <= 0 || *hilos <= 0
+        || (bl->unroll != 1 && bl->unroll != 2 && bl->unroll != 4)) {
+        return -1;
+    }
+    bl->orden = strcmp(orden, "kij") == 0 ? ORDEN_KIJ : ORDEN_IKJ;
+    return 0;
+}
+
+/* Busca en el perfil la entrada de dtype y la clase de m x k x n. Devuelve 0 y
+ * rellena bl, hilos y gflops (si no es NULL) cuando la encuentra y el perfil es de
+ * esta máquina; -1 si no. ruta NULL usa la ruta por defecto.
+ */
+static inline int cargar_perfil(const char* ruta, const char* dtype, int m, int k, int n,
+                                Bloques* bl, int* hilos, double* gflops) {
+    char ruta_defecto[600];
+    if (ruta == NULL) {
+        ruta_cache_matrices("perfil.txt", ruta_defecto, sizeof(ruta_defecto));
+        ruta = ruta_defecto;
+    }
+    FILE* f = fopen(ruta, "r");
+    if (f == NULL) {
+        return -1;
+    }
+    char maquina[256];
+    identificar_maquina(maquina, sizeof(maquina));
+    const char* clase = nombres_clase_perfil[clase_perfil(m, k, n)];
+
+    char linea[512];
+    int de_esta_maquina = 0, encontrado = -1;
+    while (fgets(linea, sizeof(linea), f) != NULL) {
+        linea[strcspn(linea, "\n")] = '\0';
+        if (strncmp(linea, "maquina=", 8) == 0) {
+            de_esta_maquina = strcmp(linea + 8, maquina) == 0;
+            continue;
+        }
+        char d[8], c[16];
+        Bloques leido;
+        int h;
+        double g;
+        if (de_esta_maquina && parsear_linea_perfil(linea, d, c, &leido, &h, &g) == 0
+            && strcmp(d, dtype) == 0 && strcmp(c, clase) == 0) {
+            *bl = leido;
+            *hilos = h;
+            if (gflops != NULL) {
+                *gflops = g;
+            }
+            encontrado = 0;
+        }
+    }
+    fclose(f);
+    return encontrado;
+}
+
+#endif /* MATRICES_PERFIL_H */
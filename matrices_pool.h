@@ -0,0 +1,206 @@
+/*
+ * matrices_pool.h
+ *
+ * Conjunto de hilos (pthreads) creado una vez con una cola de tareas, compartido por
+ * matrices_servicio y por el ejecutor asíncrono de matrices_asincrono.h. Una tarea es
+ * una función y sus datos más un rango [inicio, fin) (normalmente una banda de filas);
+ * los hilos la ejecutan fuera del cerrojo del conjunto.
+ *
+ *   acotada  pool_encolar espera mientras la cola esté llena (el servicio: limita la
+ *            memoria y frena a los clientes)
+ *   creciente  la cola se amplía si hace falta, así que encolar nunca bloquea y se
+ *            puede hacer desde una tarea en curso (el ejecutor asíncrono encola los
+ *            productos que dependían del que acaba de terminar)
+ *
+ * Cada hilo retira hasta lote_max tareas por vez, dejando trabajo para los demás
+ * (cantidad / num_hilos): con muchas tareas pequeñas se toma el cerrojo menos veces.
+ * pool_detener deja que la cola se vacíe y espera a los hilos.
+ *
+ * Uso:
+ *   PoolHilos p;
+ *   pool_iniciar(&p, num_hilos, 4096, POOL_ACOTADA, 16);
+ *   TareaPool t = {funcion, datos, 0, m};
+ *   pool_encolar(&p, &t, 1);
+ *   pool_detener(&p);
+ *
+ * Todas las funciones son static inline, como en matrices_arena.h. Requiere -pthread.
+ */
+
+#ifndef MATRICES_POOL_H
+#define MATRICES_POOL_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+/* Número máximo de tareas que un hilo puede retirar de una vez */
+#define POOL_LOTE_MAX 64
+
+typedef enum {
+    POOL_ACOTADA,
+    POOL_CRECIENTE
+} TipoColaPool;
+
+/* Función de una tarea: datos y rango [inicio, fin) */
+typedef void (*FuncionTarea)(void* datos, int inicio, int fin);
+
+typedef struct {
+    FuncionTarea funcion;
+    void* datos;
+    int inicio;
+    int fin;
+} TareaPool;
+
+typedef struct {
+    pthread_t* hilos;
+    int num_hilos;
+    TareaPool* cola;       /* circular */
+    int capacidad;
+    int cabeza;
+    int cantidad;
+    TipoColaPool tipo;
+    int lote_max;
+    int terminar;
+    pthread_mutex_t mutex;
+    pthread_cond_t no_vacia;
+    pthread_cond_t no_llena;
+} PoolHilos;
+
+/* Función de cada hilo: retira lotes de tareas y las ejecuta */
+static inline void* pool_trabajador(void* arg) {
+    PoolHilos* p = (PoolHilos*)arg;
+    TareaPool lote[POOL_LOTE_MAX];
+
+    for (;;) {
+        pthread_mutex_lock(&p->mutex);
+        while (p->cantidad == 0 && !p->terminar) {
+            pthread_cond_wait(&p->no_vacia, &p->mutex);
+        }
+        if (p->cantidad == 0) {
+            pthread_mutex_unlock(&p->mutex);
+            break;
+        }
+
+        /* Retirar hasta lote_max tareas, dejando trabajo para los demás hilos */
+        int tomar = p->cantidad / p->num_hilos;
+        if (tomar < 1) tomar = 1;
+        if (tomar > p->lote_max) tomar = p->lote_max;
+        for (int i = 0; i < tomar; i++) {
+            lote[i] = p->cola[p->cabeza];
+            p->cabeza = (p->cabeza + 1) % p->capacidad;
+        }
+        p->cantidad -= tomar;
+        pthread_cond_broadcast(&p->no_llena);
+        pthread_mutex_unlock(&p->mutex);
+
+        for (int i = 0; i < tomar; i++) {
+            lote[i].funcion(lote[i].datos, lote[i].inicio, lote[i].fin);
+        }
+    }
+    return NULL;
+}
+
+/* Crea los hilos; quedan esperando tareas. capacidad es la de la cola (la inicial si
+ * es creciente) y lote_max se limita a POOL_LOTE_MAX. Devuelve 0, o -1 si no se
+ * pudieron crear todos los hilos (num_hilos queda en los creados y pool_detener los
+ * recoge).
+ */
+static inline int pool_iniciar(PoolHilos* p, int num_hilos, int capacidad, TipoColaPool tipo, int lote_max) {
+    p->num_hilos = 0;
+    p->capacidad = capacidad > 0 ? capacidad : 1;
+    p->cabeza = 0;
+    p->cantidad = 0;
+    p->tipo = tipo;
+    p->lote_max = lote_max < 1 ? 1 : lote_max > POOL_LOTE_MAX ? POOL_LOTE_MAX : lote_max;
+    p->terminar = 0;
+    p->cola = (TareaPool*)malloc(p->capacidad * sizeof(TareaPool));
+    p->hilos = (pthread_t*)malloc(num_hilos * sizeof(pthread_t));
+    if (p->cola == NULL || p->hilos == NULL) {
+        fprintf(stderr, "Error en la asignación de memoria del conjunto de hilos\n");
+        exit(EXIT_FAILURE);
+    }
+    pthread_mutex_init(&p->mutex, NULL);
+    pthread_cond_init(&p->no_vacia, NULL);
+    pthread_cond_init(&p->no_llena, NULL);
+
+    p->num_hilos = num_hilos;
+    for (int h = 0; h < num_hilos; h++) {
+        if (pthread_create(&p->hilos[h], NULL, pool_trabajador, p) != 0) {
+            /* Los hilos ya creados leen num_hilos con el cerrojo tomado */
+            pthread_mutex_lock(&p->mutex);
+            p->num_hilos = h;
+            pthread_mutex_unlock(&p->mutex);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* Amplía una cola creciente al doble (con el cerrojo tomado) */
+static inline void pool_ampliar(PoolHilos* p) {
+    int nueva = 2 * p->capacidad;
+    TareaPool* cola = (TareaPool*)malloc(nueva * sizeof(TareaPool));
+    if (cola == NULL) {
+        fprintf(stderr, "Error en la asignación de memoria de la cola de tareas\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int t = 0; t < p->cantidad; t++) {
+        cola[t] = p->cola[(p->cabeza + t) % p->capacidad];
+    }
+    free(p->cola);
+    p->cola = cola;
+    p->capacidad = nueva;
+    p->cabeza = 0;
+}
+
+/* Encola num tareas (con la cola acotada, espera a que haya sitio) y despierta a los
+ * hilos. Devuelve la profundidad de la cola justo después de encolar.
+ */
+static inline int pool_encolar(PoolHilos* p, const TareaPool* tareas, int num) {
+    pthread_mutex_lock(&p->mutex);
+    for (int t = 0; t < num; t++) {
+        while (p->cantidad == p->capacidad) {
+            if (p->tipo == POOL_CRECIENTE) {
+                pool_ampliar(p);
+            } else {
+                pthread_cond_broadcast(&p->no_vacia);
+                pthread_cond_wait(&p->no_llena, &p->mutex);
+            }
+        }
+        p->cola[(p->cabeza + p->cantidad) % p->capacidad] = tareas[t];
+        p->cantidad++;
+    }
+    int profundidad = p->cantidad;
+    pthread_cond_broadcast(&p->no_vacia);
+    pthread_mutex_unlock(&p->mutex);
+    return profundidad;
+}
+
+/* Tareas en la cola (aún sin retirar) */
+static inline int pool_pendientes(PoolHilos* p) {
+    pthread_mutex_lock(&p->mutex);
+    int cantidad = p->cantidad;
+    pthread_mutex_unlock(&p->mutex);
+    return cantidad;
+}
+
+/* Pide a los hilos que terminen cuando la cola se vacíe, los espera y libera el
+ * conjunto
+ */
+static inline void pool_detener(PoolHilos* p) {
+    pthread_mutex_lock(&p->mutex);
+    p->terminar = 1;
+    pthread_cond_broadcast(&p->no_vacia);
+    pthread_mutex_unlock(&p->mutex);
+
+    for (int h = 0; h < p->num_hilos; h++) {
+        pthread_join(p->hilos[h], NULL);
+    }
+    pthread_mutex_destroy(&p->mutex);
+    pthread_cond_destroy(&p->no_vacia);
+    pthread_cond_destroy(&p->no_llena);
+    free(p->hilos);
+    free(p->cola);
+}
+
+#endif /* MATRICES_POOL_H */
@@ -0,0 +1,179 @@
+/*
+ * matrices_potencia.h
+ *
+ * Potencia A^k de una matriz cuadrada n x n (contigua por filas) por exponenciación
+ * binaria: floor(log2 k) cuadrados más un producto por cada bit a 1 de k, en lugar
+ * de k - 1 productos. Se trabaja con tres buffers reservados por el llamador y que
+ * sólo se intercambian como punteros:
+ *
+ *   R  resultado acumulado (A elevada a los bits de k ya vistos)
+ *   X  A^(2^t) para el bit t actual
+ *   T  destino del siguiente producto; tras cada producto T y R (o T y X) cambian
+ *      de papel
+ *
+ * El resultado acaba en uno de los tres; si no es P se copia al final. Cada producto
+ * usa gemm_bloques_openmp con los bloques del perfil (mismo ModeloCadena que
+ * matrices_cadena.h).
+ *
+ * vector_potencia calcula y = x * A^k (x fila) y elige, según el modelo, entre k
+ * productos vector-matriz, sin formar nunca A^k (O(k n^2)), o formar A^k y hacer un
+ * único producto vector-matriz (O(log k n^3)).
+ *
+ * Sólo se define al compilar con -fopenmp, como los kernels de matrices_bloques.h.
+ */
+
+#ifndef MATRICES_POTENCIA_H
+#define MATRICES_POTENCIA_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "matrices_cadena.h"
+
+/* Productos de matrices que hace la exponenciación binaria para el exponente k */
+static inline int productos_potencia(long k) {
+    int productos = 0;
+    for (int primero = 1; k > 0; k >>= 1) {
+        if (k & 1) {
+            productos += primero ? 0 : 1;
+            primero = 0;
+        }
+        productos += k > 1 ? 1 : 0;
+    }
+    return productos;
+}
+
+/* Indica si para x * A^k compensa más iterar productos vector-matriz que formar A^k */
+static inline int vector_iterado_mas_barato(const ModeloCadena* modelo, int n, long k) {
+    double iterado = (double)k * coste_producto(modelo, 1, n, n);
+    double potencia = productos_potencia(k) * coste_producto(modelo, n, n, n) + coste_producto(modelo, 1, n, n);
+    return iterado <= potencia;
+}
+
+#ifdef _OPENMP
+#include <omp.h>
+#include "matrices_bloques.h"
+
+/* Columnas de y que se reparte cada hilo en vector_por_matriz (una línea de caché) */
+#define POTENCIA_COLUMNAS_MIN 8
+
+/* y (1 x n) = x (1 x n) * A (n x n). Cada hilo se queda con un tramo de columnas y
+ * recorre las filas de A de cuatro en cuatro con acumular_fila.
+ */
+static inline void vector_por_matriz(const double* x, const double* A, int n, double* y, int num_hilos) {
+    int partes = (n + POTENCIA_COLUMNAS_MIN - 1) / POTENCIA_COLUMNAS_MIN;
+    num_hilos = num_hilos < partes ? num_hilos : partes;
+    #pragma omp parallel num_threads(num_hilos)
+    {
+        int h = omp_get_thread_num(), total = omp_get_num_threads();
+        int j0 = (int)((long)partes * h / total) * POTENCIA_COLUMNAS_MIN;
+        int j1 = (int)((long)partes * (h + 1) / total) * POTENCIA_COLUMNAS_MIN;
+        j1 = j1 < n ? j1 : n;
+        if (j0 < j1) {
+            memset(y + j0, 0, (j1 - j0) * sizeof(double));
+            int i = 0;
+            for (; i + 4 <= n; i += 4) {
+                acumular_fila(y, x + i, A + (size_t)i * n, n, j0, j1, 4);
+            }
+            for (; i < n; i++) {
+                acumular_fila(y, x + i, A + (size_t)i * n, n, j0, j1, 1);
+            }
+        }
+    }
+}
+
+/* Primero de los tres buffers que no es ni R ni X (siempre queda uno) */
+static inline double* buffer_libre(double* libres[3], const double* R, const double* X) {
+    for (int b = 0; b < 2; b++) {
+        if (libres[b] != R && libres[b] != X) {
+            return libres[b];
+        }
+    }
+    return libres[2];
+}
+
+/* P = A^k (k >= 0) usando P, trabajo1 y trabajo2 (n x n cada uno) como los tres
+ * buffers R, X y T. A no se modifica. Devuelve el número de productos hechos.
+ */
+static inline int potencia_matriz(const double* A, int n, long k, double* P, double* trabajo1, double* trabajo2,
+                                  const ModeloCadena* modelo, int num_hilos) {
+    size_t bytes = (size_t)n * n * sizeof(double);
+    Bloques bl = modelo->bloques[clase_perfil(n, n, n)];
+    if (k == 0) {
+        memset(P, 0, bytes);
+        for (int i = 0; i < n; i++) {
+            P[(size_t)i * n + i] = 1.0;
+        }
+        return 0;
+    }
+
+    /* R no existe hasta el primer bit a 1 (evita multiplicar por la identidad) y X
+     * empieza siendo A, que se lee directamente sin copiarla
+     */
+    double* libres[3] = {P, trabajo1, trabajo2};
+    double* R = NULL;
+    const double* X = A;
+    int productos = 0;
+    for (;;) {
+        if (k & 1) {
+            if (R == NULL && X == A) {
+                R = libres[0];
+                memcpy(R, A, bytes);
+            } else if (R == NULL) {
+                /* R comparte buffer con X: el siguiente cuadrado escribe en otro */
+                R = (double*)X;
+            } else {
+                double* T = buffer_libre(libres, R, X);
+                gemm_bloques_openmp(R, n, X, n, T, n, n, n, n, bl, num_hilos);
+                R = T;
+                productos++;
+            }
+        }
+        k >>= 1;
+        if (k == 0) {
+            break;
+        }
+        /* X^2 en un buffer que no sea ni R ni X */
+        double* T = buffer_libre(libres, R, X);
+        gemm_bloques_openmp(X, n, X, n, T, n, n, n, n, bl, num_hilos);
+        X = T;
+        productos++;
+    }
+    if (R != P) {
+        memcpy(P, R, bytes);
+    }
+    return productos;
+}
+
+/* y = x * A^k (x e y filas de n elementos). Con iterar != 0 hace k productos
+ * vector-matriz sin formar A^k; si no, forma A^k en los tres buffers n x n y hace
+ * un solo producto. iterar < 0 elige según el modelo. Devuelve 1 si iteró.
+ */
+static inline int vector_potencia(const double* x, const double* A, int n, long k, double* y,
+                                  double* P, double* trabajo1, double* trabajo2, int iterar,
+                                  const ModeloCadena* modelo, int num_hilos) {
+    if (iterar < 0) {
+        iterar = vector_iterado_mas_barato(modelo, n, k);
+    }
+    if (!iterar) {
+        potencia_matriz(A, n, k, P, trabajo1, trabajo2, modelo, num_hilos);
+        vector_por_matriz(x, P, n, y, num_hilos);
+        return 0;
+    }
+    /* Dos vectores que se alternan; trabajo1 sobra para los dos salvo con n == 1 */
+    double* actual = trabajo1;
+    double* siguiente = n > 1 ? trabajo1 + n : trabajo2;
+    memcpy(actual, x, n * sizeof(double));
+    for (long t = 0; t < k; t++) {
+        vector_por_matriz(actual, A, n, siguiente, num_hilos);
+        double* tmp = actual;
+        actual = siguiente;
+        siguiente = tmp;
+    }
+    memcpy(y, actual, n * sizeof(double));
+    return 1;
+}
+
+#endif /* _OPENMP */
+
+#endif /* MATRICES_POTENCIA_H */
@@ -0,0 +1,147 @@
+/*
+ * matrices_precision.h
+ *
+ * Tipos de dato de los modos f64, f32 y mixed, compartidos por matrices_secuencial,
+ * matrices_openmp, matrices_mpi y matrices_servicio:
+ *
+ *   f64    entradas, acumulación y salida en double
+ *   f32    entradas, acumulación y salida en float (con -mfma, FMA vectorial)
+ *   mixed  entradas en float, acumulación y salida en double
+ *
+ * El producto i-k-j de cada modo se genera una sola vez con una macro, como en
+ * matrices_bloques.h, a partir del tipo de entrada y del de acumulación:
+ *
+ *   multiplicar_filas<S>(A, lda, B, ldb, C, ldc, i0, i1, k, n)
+ *       filas [i0, i1) de C (m x n) = A (m x k) * B (k x n), por filas con dimensión
+ *       principal ld; S es _f64, _f32 o _mixta
+ *   multiplicar_filas_openmp<S>(..., num_hilos)
+ *       lo mismo repartiendo las filas entre hilos (sólo con -fopenmp)
+ *
+ * Los programas con matrices de punteros a fila (datos contiguos en M[0], como
+ * reservar_matriz) generan además sus utilidades con DEFINIR_MATRIZ_FILAS(S, TIPO):
+ * reservar_matriz<S>, liberar_matriz<S> y error_relativo<S> frente a una referencia
+ * fp64 (convertir_a_f32 pasa la matriz double a float). No se instancian aquí
+ * porque matrices_mpi y matrices_servicio usan matrices planas con esos nombres.
+ *
+ * Todas las funciones son static inline, como en matrices_arena.h.
+ */
+
+#ifndef MATRICES_PRECISION_H
+#define MATRICES_PRECISION_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/* Tipos de dato soportados para la multiplicación */
+typedef enum {
+    DTYPE_F64,   /* Almacenamiento y acumulación en double */
+    DTYPE_F32,   /* Almacenamiento y acumulación en float (FMA) */
+    DTYPE_MIXTO  /* Entradas en float, acumulación y salida en double */
+} TipoDato;
+
+/* Interpreta un dtype (f64, f32 o mixed); devuelve -1 si no es válido */
+static inline int parsear_dtype(const char* texto) {
+    if (strcmp(texto, "f64") == 0) return DTYPE_F64;
+    if (strcmp(texto, "f32") == 0) return DTYPE_F32;
+    if (strcmp(texto, "mixed") == 0) return DTYPE_MIXTO;
+    return -1;
+}
+
+#define DEFINIR_PRODUCTO_FILAS(S, TENTRADA, TACUM)                                            \
+    static inline void multiplicar_filas##S(const TENTRADA* A, int lda, const TENTRADA* B,   \
+                                            int ldb, TACUM* C, int ldc, int i0, int i1,       \
+                                            int k, int n) {                                   \
+        for (int i = i0; i < i1; i++) {                                                       \
+            const TENTRADA* a = A + (size_t)i * lda;                                          \
+            TACUM* c = C + (size_t)i * ldc;                                                   \
+            for (int j = 0; j < n; j++) {                                                     \
+                c[j] = 0;                                                                     \
+            }                                                                                 \
+            for (int p = 0; p < k; p++) {                                                     \
+                TACUM aip = (TACUM)a[p];                                                      \
+                const TENTRADA* b = B + (size_t)p * ldb;                                      \
+                for (int j = 0; j < n; j++) {                                                 \
+                    c[j] += aip * (TACUM)b[j];                                                \
+                }                                                                             \
+            }                                                                                 \
+        }                                                                                     \
+    }
+
+#define DEFINIR_PRODUCTO_FILAS_OPENMP(S, TENTRADA, TACUM)                                     \
+    static inline void multiplicar_filas_openmp##S(const TENTRADA* A, int lda,               \
+                                                   const TENTRADA* B, int ldb, TACUM* C,     \
+                                                   int ldc, int m, int k, int n,             \
+                                                   int num_hilos) {                          \
+        _Pragma("omp parallel for num_threads(num_hilos)")                                    \
+        for (int i = 0; i < m; i++) {                                                         \
+            multiplicar_filas##S(A, lda, B, ldb, C, ldc, i, i + 1, k, n);                     \
+        }                                                                                     \
+    }
+
+DEFINIR_PRODUCTO_FILAS(_f64, double, double)
+DEFINIR_PRODUCTO_FILAS(_f32, float, float)
+DEFINIR_PRODUCTO_FILAS(_mixta, float, double)
+
+#ifdef _OPENMP
+DEFINIR_PRODUCTO_FILAS_OPENMP(_f64, double, double)
+DEFINIR_PRODUCTO_FILAS_OPENMP(_f32, float, float)
+DEFINIR_PRODUCTO_FILAS_OPENMP(_mixta, float, double)
+#endif
+
+/* Añade a cada elemento una parte fraccionaria en [0, 1) con dos decimales. Con los
+ * enteros 0-9 de las demás pruebas los productos f32 son exactos (hasta 2^24) y el
+ * error frente a fp64 sería siempre 0; así se mide el redondeo de verdad.
+ */
+static inline void fraccionar_datos(double* datos, size_t elementos) {
+    for (size_t i = 0; i < elementos; i++) {
+        datos[i] += (double)(rand() % 100) / 100.0;
+    }
+}
+
+/* Copia una matriz de punteros a fila double en una float (redondeo a fp32) */
+static inline void convertir_a_f32(double* const* origen, float* const* destino, int filas, int columnas) {
+    for (int i = 0; i < filas; i++) {
+        for (int j = 0; j < columnas; j++) {
+            destino[i][j] = (float)origen[i][j];
+        }
+    }
+}
+
+/* Matrices de punteros a fila con los datos contiguos en M[0] */
+#define DEFINIR_MATRIZ_FILAS(S, TIPO)                                                         \
+    static inline TIPO** reservar_matriz##S(int filas, int columnas) {                        \
+        TIPO** matriz = (TIPO**)malloc(filas * sizeof(TIPO*));                                \
+        TIPO* datos = (TIPO*)malloc((size_t)filas * columnas * sizeof(TIPO));                 \
+        if (matriz == NULL || datos == NULL) {                                                \
+            fprintf(stderr, "Error en la asignación de memoria para la matriz\n");            \
+            exit(EXIT_FAILURE);                                                               \
+        }                                                                                     \
+        for (int i = 0; i < filas; i++) {                                                     \
+            matriz[i] = datos + (size_t)i * columnas;                                         \
+        }                                                                                     \
+        return matriz;                                                                        \
+    }                                                                                         \
+                                                                                              \
+    static inline void liberar_matriz##S(TIPO** matriz, int filas) {                          \
+        (void)filas;                                                                          \
+        free(matriz[0]);                                                                      \
+        free(matriz);                                                                         \
+    }                                                                                         \
+                                                                                              \
+    /* Error relativo en norma de Frobenius: ||C - Ref||_F / ||Ref||_F */                     \
+    static inline double error_relativo##S(double* const* referencia, TIPO* const* C,        \
+                                           int filas, int columnas) {                         \
+        double num = 0.0, den = 0.0;                                                          \
+        for (int i = 0; i < filas; i++) {                                                     \
+            for (int j = 0; j < columnas; j++) {                                              \
+                double d = (double)C[i][j] - referencia[i][j];                                \
+                num += d * d;                                                                 \
+                den += referencia[i][j] * referencia[i][j];                                   \
+            }                                                                                 \
+        }                                                                                     \
+        return den > 0.0 ? sqrt(num / den) : sqrt(num);                                       \
+    }
+
+#endif /* MATRICES_PRECISION_H */
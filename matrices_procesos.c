@@ -1,3 +1,4 @@
+#define _GNU_SOURCE // sched_setaffinity y CPU_SET (matrices_afinidad.h)
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -8,24 +9,55 @@
 #include <time.h>
 #include <getopt.h>
 #include <string.h>
+#include "matrices_traspuesta.h"
+#include "matrices_afinidad.h"
+
+// Plan de afinidad del programa (-a); NULL deja los procesos al planificador
+static const PlanAfinidad *plan_afinidad = NULL;
 
 // Prototipos de funciones
-int **crear_matriz_compartida(int n, const char *nombre);
-void llenar_matriz_aleatoria(int **matriz, int n);
-void imprimir_matriz(int **matriz, int n);
-void liberar_matriz_compartida(int **matriz, int n, const char *nombre);
-void multiplicar_matrices_proceso(int **A, int **B, int **C, int n, int fila_inicio, int fila_fin);
-void multiplicar_matrices(int **A, int **B, int **C, int n, int num_procesos);
-
-// Función para crear una matriz compartida usando memoria mapeada
-int **crear_matriz_compartida(int n, const char *nombre)
+double ahora();
+void nombre_compartido(char *destino, size_t tam, const char *nombre);
+int **crear_matriz_compartida(int filas, int columnas, const char *nombre);
+void llenar_matriz_aleatoria(int **matriz, int filas, int columnas);
+void imprimir_matriz(int **matriz, int filas, int columnas);
+void liberar_matriz_compartida(int **matriz, int filas, int columnas, const char *nombre);
+void multiplicar_matrices_proceso(int **A, int **B, int **C, int columnasA, int columnasB, int fila_inicio, int fila_fin);
+void multiplicar_traspuesta_proceso(int **A, int **Bt, int **C, int columnasA, int columnasB, int fila_inicio, int fila_fin);
+void repartir_filas_procesos(void (*funcion)(int **, int **, int **, int, int, int, int), int **A, int **B, int **C,
+                             int filasA, int columnasA, int columnasB, int num_procesos);
+void trasponer_matriz_procesos(int **origen, int **destino, int filas, int columnas, int num_procesos);
+void multiplicar_matrices(int **A, int **B, int **C, int filasA, int columnasA, int columnasB, int num_procesos);
+void multiplicar_matrices_traspuesta(int **A, int **B, int **C, int filasA, int columnasA, int columnasB, int num_procesos,
+                                     double *tiempo_traspuesta);
+
+// Función para obtener el tiempo real en segundos: clock() sólo mide la CPU del padre,
+// que se limita a crear a los hijos y esperarlos
+double ahora()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Función para formar el nombre del objeto de memoria compartida: se añade el pid del
+// padre para que dos ejecuciones simultáneas no compartan (ni se pisen) las matrices
+void nombre_compartido(char *destino, size_t tam, const char *nombre)
+{
+    snprintf(destino, tam, "%s_%d", nombre, (int)getpid());
+}
+
+// Función para crear una matriz compartida de filas x columnas usando memoria mapeada
+int **crear_matriz_compartida(int filas, int columnas, const char *nombre)
 {
     int shm_fd;
     int **matriz;
-    int total_size = n * sizeof(int *) + n * n * sizeof(int);
+    size_t total_size = filas * sizeof(int *) + (size_t)filas * columnas * sizeof(int);
+    char nombre_shm[64];
+    nombre_compartido(nombre_shm, sizeof(nombre_shm), nombre);
 
     // Crear o abrir el objeto de memoria compartida
-    shm_fd = shm_open(nombre, O_CREAT | O_RDWR, 0666);
+    shm_fd = shm_open(nombre_shm, O_CREAT | O_RDWR, 0666);
     if (shm_fd == -1)
     {
         perror("Error al abrir la memoria compartida");
@@ -49,11 +81,11 @@ int **crear_matriz_compartida(int n, const char *nombre)
 
     // Configurar la matriz
     matriz = (int **)ptr;
-    int *data = (int *)((char *)ptr + n * sizeof(int *));
+    int *data = (int *)((char *)ptr + filas * sizeof(int *));
 
-    for (int i = 0; i < n; i++)
+    for (int i = 0; i < filas; i++)
     {
-        matriz[i] = data + i * n;
+        matriz[i] = data + (size_t)i * columnas;
     }
 
     close(shm_fd);
@@ -61,11 +93,11 @@ int **crear_matriz_compartida(int n, const char *nombre)
 }
 
 // Función para llenar una matriz con números aleatorios
-void llenar_matriz_aleatoria(int **matriz, int n)
+void llenar_matriz_aleatoria(int **matriz, int filas, int columnas)
 {
-    for (int i = 0; i < n; i++)
+    for (int i = 0; i < filas; i++)
     {
-        for (int j = 0; j < n; j++)
+        for (int j = 0; j < columnas; j++)
         {
             matriz[i][j] = rand() % 10; // Números aleatorios entre 0 y 9
         }
@@ -73,11 +105,11 @@ void llenar_matriz_aleatoria(int **matriz, int n)
 }
 
 // Función para imprimir una matriz
-void imprimir_matriz(int **matriz, int n)
+void imprimir_matriz(int **matriz, int filas, int columnas)
 {
-    for (int i = 0; i < n; i++)
+    for (int i = 0; i < filas; i++)
     {
-        for (int j = 0; j < n; j++)
+        for (int j = 0; j < columnas; j++)
         {
             printf("%d ", matriz[i][j]);
         }
@@ -86,30 +118,32 @@ void imprimir_matriz(int **matriz, int n)
 }
 
 // Función para liberar la memoria de una matriz compartida
-void liberar_matriz_compartida(int **matriz, int n, const char *nombre)
+void liberar_matriz_compartida(int **matriz, int filas, int columnas, const char *nombre)
 {
-    int total_size = n * sizeof(int *) + n * n * sizeof(int);
+    size_t total_size = filas * sizeof(int *) + (size_t)filas * columnas * sizeof(int);
+    char nombre_shm[64];
+    nombre_compartido(nombre_shm, sizeof(nombre_shm), nombre);
 
     if (munmap((void *)matriz, total_size) == -1)
     {
         perror("Error al desmapear la memoria compartida");
     }
 
-    if (shm_unlink(nombre) == -1)
+    if (shm_unlink(nombre_shm) == -1)
     {
         perror("Error al desvincular la memoria compartida");
     }
 }
 
 // Función para multiplicar una porción de las matrices
-void multiplicar_matrices_proceso(int **A, int **B, int **C, int n, int fila_inicio, int fila_fin)
+void multiplicar_matrices_proceso(int **A, int **B, int **C, int columnasA, int columnasB, int fila_inicio, int fila_fin)
 {
     for (int i = fila_inicio; i < fila_fin; i++)
     {
-        for (int j = 0; j < n; j++)
+        for (int j = 0; j < columnasB; j++)
         {
             C[i][j] = 0;
-            for (int k = 0; k < n; k++)
+            for (int k = 0; k < columnasA; k++)
             {
                 C[i][j] += A[i][k] * B[k][j];
             }
@@ -117,12 +151,19 @@ void multiplicar_matrices_proceso(int **A, int **B, int **C, int n, int fila_ini
     }
 }
 
-// Función para multiplicar matrices utilizando procesos
-void multiplicar_matrices(int **A, int **B, int **C, int n, int num_procesos)
+// Función para multiplicar una porción de las matrices usando B traspuesta (filas contiguas)
+void multiplicar_traspuesta_proceso(int **A, int **Bt, int **C, int columnasA, int columnasB, int fila_inicio, int fila_fin)
+{
+    multiplicar_filas_traspuesta(A, Bt, C, columnasA, columnasB, fila_inicio, fila_fin);
+}
+
+// Función para repartir las filas de A entre procesos hijos que ejecutan la función dada
+void repartir_filas_procesos(void (*funcion)(int **, int **, int **, int, int, int, int), int **A, int **B, int **C,
+                             int filasA, int columnasA, int columnasB, int num_procesos)
 {
     pid_t pid;
-    int filas_por_proceso = n / num_procesos;
-    int filas_restantes = n % num_procesos;
+    int filas_por_proceso = filasA / num_procesos;
+    int filas_restantes = filasA % num_procesos;
     int fila_actual = 0;
 
     for (int i = 0; i < num_procesos; i++)
@@ -150,8 +191,9 @@ void multiplicar_matrices(int **A, int **B, int **C, int n, int num_procesos)
         }
         else if (pid == 0)
         {
-            // Código del proceso hijo
-            multiplicar_matrices_proceso(A, B, C, n, fila_inicio, fila_fin);
+            // Código del proceso hijo: se fija a su CPU antes de tocar sus filas
+            fijar_proceso(0, cpu_trabajador(plan_afinidad, i));
+            funcion(A, B, C, columnasA, columnasB, fila_inicio, fila_fin);
             exit(EXIT_SUCCESS);
         }
         // El proceso padre continúa creando más procesos hijos
@@ -164,12 +206,71 @@ void multiplicar_matrices(int **A, int **B, int **C, int n, int num_procesos)
     }
 }
 
+// Función para multiplicar matrices utilizando procesos
+void multiplicar_matrices(int **A, int **B, int **C, int filasA, int columnasA, int columnasB, int num_procesos)
+{
+    repartir_filas_procesos(multiplicar_matrices_proceso, A, B, C, filasA, columnasA, columnasB, num_procesos);
+}
+
+// Función para trasponer una matriz compartida (destino = origen traspuesta) repartiendo
+// franjas de filas del destino entre procesos hijos
+void trasponer_matriz_procesos(int **origen, int **destino, int filas, int columnas, int num_procesos)
+{
+    for (int i = 0; i < num_procesos; i++)
+    {
+        pid_t pid = fork();
+
+        if (pid < 0)
+        {
+            fprintf(stderr, "Error al crear el proceso %d\n", i);
+            exit(EXIT_FAILURE);
+        }
+        else if (pid == 0)
+        {
+            int j0, j1;
+            fijar_proceso(0, cpu_trabajador(plan_afinidad, i));
+            franja_traspuesta(columnas, i, num_procesos, &j0, &j1);
+            trasponer_franja(origen, destino, filas, columnas, j0, j1);
+            exit(EXIT_SUCCESS);
+        }
+    }
+
+    for (int i = 0; i < num_procesos; i++)
+    {
+        wait(NULL);
+    }
+}
+
+// Función para multiplicar matrices traspondiendo antes B: cada C[i][j] pasa a ser el
+// producto escalar de dos filas contiguas, A[i] y Bt[j], en lugar de recorrer B por columnas.
+// Bt vive en memoria compartida para que la escriban y la lean los hijos.
+void multiplicar_matrices_traspuesta(int **A, int **B, int **C, int filasA, int columnasA, int columnasB, int num_procesos,
+                                     double *tiempo_traspuesta)
+{
+    int **Bt = crear_matriz_compartida(columnasB, columnasA, "/matriz_Bt");
+
+    double inicio = ahora();
+    trasponer_matriz_procesos(B, Bt, columnasA, columnasB, num_procesos);
+    *tiempo_traspuesta = ahora() - inicio;
+
+    repartir_filas_procesos(multiplicar_traspuesta_proceso, A, Bt, C, filasA, columnasA, columnasB, num_procesos);
+
+    liberar_matriz_compartida(Bt, columnasB, columnasA, "/matriz_Bt");
+}
+
 void mostrar_ayuda()
 {
-    printf("Uso: ./programa [-n tamaño] [-p procesos] [-i]\n");
+    printf("Uso: ./programa [-n tamaño | -r filasA -c columnasA -q columnasB] [-p procesos] [-T] [-a afinidad] [-v] [-i]\n");
     printf("Opciones:\n");
     printf("  -n, --tamano     Tamaño de las matrices cuadradas (por defecto: 4)\n");
+    printf("  -r, --filasA     Filas de A (y de C)\n");
+    printf("  -c, --columnasA  Columnas de A (y filas de B)\n");
+    printf("  -q, --columnasB  Columnas de B (y de C)\n");
     printf("  -p, --procesos   Número de procesos a utilizar (por defecto: 2)\n");
+    printf("  -T, --traspuesta Trasponer B y multiplicar por productos escalares de filas\n");
+    printf("  -a, --afinidad   Fijar los procesos a CPUs: ninguna, compacta o dispersa (por defecto: ninguna)\n");
+    printf("  -N, --nucleos    Con -a, como mucho un proceso por núcleo físico (sin hermanos SMT)\n");
+    printf("  -v, --verificar  Comparar el resultado con la multiplicación secuencial\n");
     printf("  -i, --imprimir   Imprimir las matrices (opcional)\n");
     printf("  -h, --ayuda      Mostrar esta ayuda\n");
 }
@@ -178,13 +279,25 @@ int main(int argc, char *argv[])
 {
     // Valores por defecto
     int n = 4;            // Tamaño de la matriz
+    int filasA = -1, columnasA = -1, columnasB = -1; // Dimensiones rectangulares (por defecto n)
     int num_procesos = 2; // Número de procesos
     int imprimir = 0;     // No imprimir matrices por defecto
+    int traspuesta = 0;   // Multiplicar por B traspuesta
+    int verificar = 0;    // Comparar con la multiplicación secuencial
+    PoliticaAfinidad afinidad = AFINIDAD_NINGUNA;
+    int un_proceso_por_nucleo = 0;
 
     // Definir las opciones para getopt_long
     static struct option opciones_largas[] = {
         {"tamano", required_argument, 0, 'n'},
+        {"filasA", required_argument, 0, 'r'},
+        {"columnasA", required_argument, 0, 'c'},
+        {"columnasB", required_argument, 0, 'q'},
         {"procesos", required_argument, 0, 'p'},
+        {"traspuesta", no_argument, 0, 'T'},
+        {"afinidad", required_argument, 0, 'a'},
+        {"nucleos", no_argument, 0, 'N'},
+        {"verificar", no_argument, 0, 'v'},
         {"imprimir", no_argument, 0, 'i'},
         {"ayuda", no_argument, 0, 'h'},
         {0, 0, 0, 0}};
@@ -193,7 +306,7 @@ int main(int argc, char *argv[])
     int indice_opcion = 0;
 
     // Procesar los argumentos de la línea de comandos
-    while ((opcion = getopt_long(argc, argv, "n:p:ih", opciones_largas, &indice_opcion)) != -1)
+    while ((opcion = getopt_long(argc, argv, "n:r:c:q:p:Ta:Nvih", opciones_largas, &indice_opcion)) != -1)
     {
         switch (opcion)
         {
@@ -205,6 +318,24 @@ int main(int argc, char *argv[])
                 return EXIT_FAILURE;
             }
             break;
+        case 'r':
+        case 'c':
+        case 'q':
+        {
+            int dim = atoi(optarg);
+            if (dim <= 0)
+            {
+                fprintf(stderr, "Las dimensiones de las matrices deben ser positivas\n");
+                return EXIT_FAILURE;
+            }
+            if (opcion == 'r')
+                filasA = dim;
+            else if (opcion == 'c')
+                columnasA = dim;
+            else
+                columnasB = dim;
+            break;
+        }
         case 'p':
             num_procesos = atoi(optarg);
             if (num_procesos <= 0)
@@ -213,6 +344,22 @@ int main(int argc, char *argv[])
                 return EXIT_FAILURE;
             }
             break;
+        case 'T':
+            traspuesta = 1;
+            break;
+        case 'a':
+            if (parsear_afinidad(optarg, &afinidad) != 0)
+            {
+                fprintf(stderr, "Afinidad desconocida: %s (ninguna, compacta o dispersa)\n", optarg);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'N':
+            un_proceso_por_nucleo = 1;
+            break;
+        case 'v':
+            verificar = 1;
+            break;
         case 'i':
             imprimir = 1;
             break;
@@ -228,57 +375,99 @@ int main(int argc, char *argv[])
         }
     }
 
+    // Las dimensiones no indicadas toman el tamaño cuadrado n
+    if (filasA < 0)
+        filasA = n;
+    if (columnasA < 0)
+        columnasA = n;
+    if (columnasB < 0)
+        columnasB = n;
+
     // Ajustar el número de procesos si es mayor que el número de filas
-    if (num_procesos > n)
+    if (num_procesos > filasA)
     {
-        printf("Advertencia: Reduciendo el número de procesos a %d (igual al tamaño de la matriz)\n", n);
-        num_procesos = n;
+        printf("Advertencia: Reduciendo el número de procesos a %d (igual al número de filas de A)\n", filasA);
+        num_procesos = filasA;
     }
 
+    // Plan de afinidad: cada hijo se fija a la CPU de su índice nada más crearse
+    static PlanAfinidad plan;
+    planificar_afinidad(&plan, afinidad, un_proceso_por_nucleo);
+    plan_afinidad = &plan;
+
     // Inicializar el generador de números aleatorios
     srand(time(NULL));
 
     // Crear y llenar las matrices A y B usando memoria compartida
-    int **A = crear_matriz_compartida(n, "/matriz_A");
-    int **B = crear_matriz_compartida(n, "/matriz_B");
-    int **C = crear_matriz_compartida(n, "/matriz_C");
+    int **A = crear_matriz_compartida(filasA, columnasA, "/matriz_A");
+    int **B = crear_matriz_compartida(columnasA, columnasB, "/matriz_B");
+    int **C = crear_matriz_compartida(filasA, columnasB, "/matriz_C");
 
-    llenar_matriz_aleatoria(A, n);
-    llenar_matriz_aleatoria(B, n);
+    llenar_matriz_aleatoria(A, filasA, columnasA);
+    llenar_matriz_aleatoria(B, columnasA, columnasB);
 
-    // Registrar el tiempo de inicio
-    clock_t inicio = clock();
+    // Registrar el tiempo de inicio (tiempo real)
+    double inicio = ahora();
 
     // Multiplicar las matrices usando procesos
-    multiplicar_matrices(A, B, C, n, num_procesos);
+    double tiempo_traspuesta = 0.0;
+    if (traspuesta)
+        multiplicar_matrices_traspuesta(A, B, C, filasA, columnasA, columnasB, num_procesos, &tiempo_traspuesta);
+    else
+        multiplicar_matrices(A, B, C, filasA, columnasA, columnasB, num_procesos);
 
     // Registrar el tiempo de finalización
-    clock_t fin = clock();
-    double tiempo_total = (double)(fin - inicio) / CLOCKS_PER_SEC;
+    double tiempo_total = ahora() - inicio;
 
     // Imprimir las matrices si se solicitó
     if (imprimir)
     {
         printf("\nMatriz A:\n");
-        imprimir_matriz(A, n);
+        imprimir_matriz(A, filasA, columnasA);
 
         printf("\nMatriz B:\n");
-        imprimir_matriz(B, n);
+        imprimir_matriz(B, columnasA, columnasB);
 
         printf("\nMatriz Resultado (C = A * B):\n");
-        imprimir_matriz(C, n);
+        imprimir_matriz(C, filasA, columnasB);
     }
 
     // Imprimir estadísticas
     printf("\nEstadísticas:\n");
-    printf("- Tamaño de la matriz: %d x %d\n", n, n);
+    printf("- Tamaño de las matrices: %d x %d por %d x %d\n", filasA, columnasA, columnasA, columnasB);
     printf("- Número de procesos utilizados: %d\n", num_procesos);
+    informar_afinidad(&plan, num_procesos, "Proceso");
     printf("- Tiempo de ejecución: %.6f segundos\n", tiempo_total);
+    if (traspuesta)
+        printf("- Tiempo de trasposición de B: %.6f segundos\n", tiempo_traspuesta);
+
+    // Comparar con la multiplicación secuencial i-k-j en el proceso padre
+    if (verificar)
+    {
+        long diferencias = 0;
+        int *fila = (int *)malloc(columnasB * sizeof(int));
+        if (fila == NULL)
+        {
+            fprintf(stderr, "Error en la asignación de memoria para la verificación\n");
+            exit(EXIT_FAILURE);
+        }
+        for (int i = 0; i < filasA; i++)
+        {
+            memset(fila, 0, columnasB * sizeof(int));
+            for (int k = 0; k < columnasA; k++)
+                for (int j = 0; j < columnasB; j++)
+                    fila[j] += A[i][k] * B[k][j];
+            for (int j = 0; j < columnasB; j++)
+                diferencias += C[i][j] != fila[j];
+        }
+        printf("- Verificación: %ld elementos distintos de la multiplicación secuencial\n", diferencias);
+        free(fila);
+    }
 
     // Liberar memoria compartida
-    liberar_matriz_compartida(A, n, "/matriz_A");
-    liberar_matriz_compartida(B, n, "/matriz_B");
-    liberar_matriz_compartida(C, n, "/matriz_C");
+    liberar_matriz_compartida(A, filasA, columnasA, "/matriz_A");
+    liberar_matriz_compartida(B, columnasA, columnasB, "/matriz_B");
+    liberar_matriz_compartida(C, filasA, columnasB, "/matriz_C");
 
     return EXIT_SUCCESS;
 }
\ No newline at end of file
@@ -1,23 +1,35 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
+#include <math.h>
+#include <string.h>
 #include <getopt.h>
+#include "matrices_arena.h"
+#include "matrices_morton.h"
+#include "matrices_estrecho.h"
+#include "matrices_epilogo.h"
+#include "matrices_precision.h"
 
-// Función para reservar memoria para una matriz de tamaño filas x columnas
-double** reservar_matriz(int filas, int columnas) {
-    double** matriz = (double**)malloc(filas * sizeof(double*));
-    for (int i = 0; i < filas; i++) {
-        matriz[i] = (double*)malloc(columnas * sizeof(double));
-    }
-    return matriz;
-}
+// Vista (sin copia) de un bloque de una matriz guardada por filas: el elemento
+// (i, j) está en datos[i * ld + j], con ld >= columnas la dimensión principal.
+typedef struct {
+    double* datos;
+    int filas;
+    int columnas;
+    int ld;
+} VistaMatriz;
 
-// Función para liberar la memoria de una matriz
-void liberar_matriz(double** matriz, int filas) {
-    for (int i = 0; i < filas; i++) {
-        free(matriz[i]);
-    }
-    free(matriz);
+// reservar_matriz, liberar_matriz y error_relativo para double y float (sufijo _f32).
+// Los datos son un único bloque contiguo (matriz[0]) y matriz[i] apunta a cada
+// fila, de modo que se puede indexar con [i][j] y también crear vistas.
+DEFINIR_MATRIZ_FILAS(, double)
+DEFINIR_MATRIZ_FILAS(_f32, float)
+
+// Función para crear una vista del bloque filas x columnas que empieza en (fila0, col0)
+// de una matriz reservada con reservar_matriz (que tiene columnas_totales columnas)
+VistaMatriz vista_matriz(double** matriz, int columnas_totales, int fila0, int col0, int filas, int columnas) {
+    VistaMatriz v = {matriz[0] + (size_t)fila0 * columnas_totales + col0, filas, columnas, columnas_totales};
+    return v;
 }
 
 // Función para llenar una matriz con valores aleatorios
@@ -39,10 +51,9 @@ void imprimir_matriz(double** matriz, int filas, int columnas) {
     }
 }
 
-// Función para multiplicar dos matrices
-double** multiplicar_matrices(double** A, double** B, int filasA, int columnasA, int columnasB) {
-    
-    double** C = reservar_matriz(filasA, columnasB);
+// Función para multiplicar dos matrices escribiendo en un C ya reservado por el
+// llamador (por ejemplo con arena_matriz), sin reservar memoria
+void multiplicar_matrices_en(double** A, double** B, double** C, int filasA, int columnasA, int columnasB) {
     for (int i = 0; i < filasA; i++) {
         for (int j = 0; j < columnasB; j++) {
             C[i][j] = 0;
@@ -51,15 +62,106 @@ double** multiplicar_matrices(double** A, double** B, int filasA, int columnasA,
             }
         }
     }
+}
+
+// Función para multiplicar dos matrices
+double** multiplicar_matrices(double** A, double** B, int filasA, int columnasA, int columnasB) {
+    
+    double** C = reservar_matriz(filasA, columnasB);
+    multiplicar_matrices_en(A, B, C, filasA, columnasA, columnasB);
     return C;
 }
 
+// Función para multiplicar dos matrices aplicando el epílogo sobre un C del llamador
+// (matrices_epilogo.h): el epílogo se aplica a cada bloque de columnas de una fila
+// mientras sigue en registros, así que C se recorre una sola vez.
+void multiplicar_matrices_epilogo(double** A, double** B, double** C, int filasA, int columnasA,
+                                  int columnasB, const Epilogo* ep) {
+    gemm_epilogo_filas(A[0], columnasA, B[0], columnasB, C[0], columnasB, C[0], columnasB,
+                       0, filasA, columnasA, columnasB, ep);
+}
+
+// Multiplicación general sobre vistas: C = alpha * op(A) * op(B) + beta * C, donde
+// op(X) es X o su traspuesta según transA/transB. op(A) es m x k, op(B) es k x n y
+// C es m x n; todas pueden ser bloques de matrices mayores, sin copiar nada.
+// Devuelve 0 si tiene éxito o -1 si las dimensiones no son compatibles.
+int gemm_vista(int transA, int transB, double alpha, VistaMatriz A, VistaMatriz B,
+               double beta, VistaMatriz C) {
+    int m = transA ? A.columnas : A.filas;
+    int k = transA ? A.filas : A.columnas;
+    int kB = transB ? B.columnas : B.filas;
+    int n = transB ? B.filas : B.columnas;
+    if (k != kB || C.filas != m || C.columnas != n) {
+        return -1;
+    }
+
+    // Zancadas para recorrer op(A)(i, p) y op(B)(p, j) sin ramas en el bucle interno
+    long a_i = transA ? 1 : A.ld, a_p = transA ? A.ld : 1;
+    long b_p = transB ? 1 : B.ld, b_j = transB ? B.ld : 1;
+
+    for (int i = 0; i < m; i++) {
+        double* c = C.datos + (size_t)i * C.ld;
+        const double* a = A.datos + i * a_i;
+        if (!transB) {
+            // B por filas: orden i-k-j, el bucle interno recorre B y C con paso unitario
+            for (int j = 0; j < n; j++) {
+                c[j] = (beta == 0.0) ? 0.0 : beta * c[j];
+            }
+            for (int p = 0; p < k; p++) {
+                double aip = alpha * a[p * a_p];
+                const double* b = B.datos + p * b_p;
+                for (int j = 0; j < n; j++) {
+                    c[j] += aip * b[j];
+                }
+            }
+        } else {
+            // B traspuesta: cada C(i, j) es un producto escalar de filas contiguas
+            for (int j = 0; j < n; j++) {
+                const double* b = B.datos + j * b_j;
+                double sum = 0.0;
+                for (int p = 0; p < k; p++) {
+                    sum += a[p * a_p] * b[p];
+                }
+                c[j] = alpha * sum + ((beta == 0.0) ? 0.0 : beta * c[j]);
+            }
+        }
+    }
+    return 0;
+}
+
 int main(int argc, char *argv[]) {
     int filasA = 3, columnasA = 3, filasB = 3, columnasB = 3;
     int opt;
+    TipoDato dtype = DTYPE_F64;
+    Epilogo ep = {1.0, 0.0, NULL, 0};
+    int usar_epilogo = 0;
+    int usar_bias = 0;
+    int usar_vista = 0;
+    int transA = 0, transB = 0;
+    int iteraciones = 1;
+    int usar_arena = 0;
+    int usar_morton = 0;
+    int usar_estrecho = 0;
+    int verificar = 0;
+
+    static struct option opciones_largas[] = {
+        {"iteraciones", required_argument, 0, 'I'},
+        {"arena", no_argument, 0, 'W'},
+        {"vista", no_argument, 0, 'V'},
+        {"ta", no_argument, 0, 'X'},
+        {"tb", no_argument, 0, 'Y'},
+        {"dtype", required_argument, 0, 'd'},
+        {"alpha", required_argument, 0, 'A'},
+        {"beta", required_argument, 0, 'B'},
+        {"bias", no_argument, 0, 'S'},
+        {"relu", no_argument, 0, 'R'},
+        {"algoritmo", required_argument, 0, 'L'},
+        {"verificar", no_argument, 0, 'E'},
+        {0, 0, 0, 0}
+    };
 
     // Configurar opciones de línea de comandos
-    while ((opt = getopt(argc, argv, "t:")) != -1) {
+    while ((opt = getopt_long(argc, argv, "t:r:c:p:q:d:", opciones_largas, NULL)) != -1) {
         switch (opt) {
             case 't': {
                 filasA = atoi(optarg);
@@ -68,34 +170,406 @@ int main(int argc, char *argv[]) {
                 columnasB = atoi(optarg);
                 break;
             }
+            case 'r':
+                filasA = atoi(optarg);
+                break;
+            case 'c':
+                columnasA = atoi(optarg);
+                break;
+            case 'p':
+                filasB = atoi(optarg);
+                break;
+            case 'q':
+                columnasB = atoi(optarg);
+                break;
+            case 'I':
+                iteraciones = atoi(optarg);
+                if (iteraciones <= 0) {
+                    fprintf(stderr, "El número de iteraciones debe ser positivo\n");
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'W':
+                usar_arena = 1;
+                break;
+            case 'V':
+                usar_vista = 1;
+                break;
+            case 'X':
+                transA = 1;
+                usar_vista = 1;
+                break;
+            case 'Y':
+                transB = 1;
+                usar_vista = 1;
+                break;
+            case 'd': {
+                int d = parsear_dtype(optarg);
+                if (d < 0) {
+                    fprintf(stderr, "Tipo de dato no válido: %s (use f32, f64 o mixed)\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                dtype = (TipoDato)d;
+                break;
+            }
+            case 'A':
+                ep.alpha = atof(optarg);
+                usar_epilogo = 1;
+                break;
+            case 'B':
+                ep.beta = atof(optarg);
+                usar_epilogo = 1;
+                break;
+            case 'S':
+                usar_bias = 1;
+                usar_epilogo = 1;
+                break;
+            case 'R':
+                ep.relu = 1;
+                usar_epilogo = 1;
+                break;
+            case 'L':
+                usar_morton = strcmp(optarg, "morton") == 0;
+                usar_estrecho = strcmp(optarg, "estrecho") == 0;
+                if (!usar_morton && !usar_estrecho && strcmp(optarg, "ingenuo") != 0) {
+                    fprintf(stderr, "Algoritmo no válido: %s (use ingenuo, morton o estrecho)\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'E':
+                verificar = 1;
+                break;
             default:
-                fprintf(stderr, "Uso: %s -r filasA -c columnasA -p filasB -q columnasB\n", argv[0]);
+                fprintf(stderr, "Uso: %s [-t tamaño | -r filasA -c columnasA -p filasB -q columnasB]\n"
+                                "       [--dtype f32|f64|mixed] [--alpha a] [--beta b] [--bias] [--relu]\n"
+                                "       [--vista] [--ta] [--tb] [--iteraciones n] [--arena]\n"
+                                "       [--algoritmo ingenuo|morton|estrecho] [--verificar]\n", argv[0]);
                 exit(EXIT_FAILURE);
         }
     }
 
+    if (filasA <= 0 || columnasA <= 0 || filasB <= 0 || columnasB <= 0) {
+        fprintf(stderr, "Las dimensiones de las matrices deben ser positivas\n");
+        return 1;
+    }
+
     // Verificar compatibilidad de dimensiones para la multiplicación
     if (columnasA != filasB) {
         printf("No se pueden multiplicar las matrices, las columnas de A deben coincidir con las filas de B.\n");
         return 1;
     }
 
+    // El epílogo fusionado y las vistas sólo están implementados en doble precisión
+    if ((usar_epilogo || usar_vista) && dtype != DTYPE_F64) {
+        fprintf(stderr, "Las opciones --alpha, --beta, --bias, --relu, --vista, --ta y --tb requieren --dtype f64\n");
+        return 1;
+    }
+    if (usar_epilogo && usar_vista) {
+        fprintf(stderr, "El epílogo fusionado no se combina con --vista, --ta o --tb\n");
+        return 1;
+    }
+    int usar_bucle = iteraciones > 1 || usar_arena;
+    if (usar_bucle && (dtype != DTYPE_F64 || usar_epilogo || usar_vista)) {
+        fprintf(stderr, "--iteraciones y --arena sólo se combinan con la multiplicación f64 básica\n");
+        return 1;
+    }
+    if (usar_morton && (dtype != DTYPE_F64 || usar_epilogo || usar_vista || usar_bucle)) {
+        fprintf(stderr, "--algoritmo morton sólo se combina con la multiplicación f64 básica\n");
+        return 1;
+    }
+    if (usar_estrecho && (dtype != DTYPE_F64 || usar_epilogo || usar_vista || usar_arena)) {
+        fprintf(stderr, "--algoritmo estrecho sólo se combina con la multiplicación f64 básica y --iteraciones\n");
+        return 1;
+    }
+    if (usar_estrecho && columnasB > ESTRECHO_MAX_COLUMNAS) {
+        fprintf(stderr, "--algoritmo estrecho requiere como mucho %d columnas de B\n", ESTRECHO_MAX_COLUMNAS);
+        return 1;
+    }
+
     srand(time(NULL)); // Inicializar generador de números aleatorios
 
     // Reservar memoria para las matrices
     double** A = reservar_matriz(filasA, columnasA);
     double** B = reservar_matriz(filasB, columnasB);
 
-    // Llenar las matrices con valores aleatorios
+    // Llenar las matrices con valores aleatorios (no enteros en f32 y mixed)
     llenar_matriz(A, filasA, columnasA);
     llenar_matriz(B, filasB, columnasB);
+    if (dtype != DTYPE_F64) {
+        fraccionar_datos(A[0], (size_t)filasA * columnasA);
+        fraccionar_datos(B[0], (size_t)filasB * columnasB);
+    }
+
+    // Con formas muy desiguales la rejilla del orden Z sería casi toda relleno
+    if (usar_morton && !morton_compensa(filasA, columnasA, columnasB)) {
+        printf("Forma demasiado desigual para el orden Z (relleno %.1fx): se usa el algoritmo ingenuo\n",
+               relleno_morton(filasA, columnasA, columnasB));
+        usar_morton = 0;
+    }
+
+    // Multiplicación recursiva en orden Z: se convierten A y B, se multiplica y se
+    // convierte C de vuelta; los tres tiempos se informan por separado
+    if (usar_morton) {
+        int niveles = niveles_morton(filasA, columnasA, columnasB);
+        MatrizMorton zA = reservar_morton(filasA, columnasA, niveles);
+        MatrizMorton zB = reservar_morton(filasB, columnasB, niveles);
+        MatrizMorton zC = reservar_morton(filasA, columnasB, niveles);
+        double** C = reservar_matriz(filasA, columnasB);
+
+        clock_t inicio = clock();
+        convertir_a_morton(A, &zA);
+        convertir_a_morton(B, &zB);
+        clock_t fin_conversion = clock();
+        multiplicar_morton(&zA, &zB, &zC);
+        clock_t fin_producto = clock();
+        convertir_desde_morton(&zC, C);
+        clock_t fin = clock();
+
+        printf("Orden Z con %d niveles (bloques de A %dx%d, de B %dx%d)\n",
+               niveles, zA.tf, zA.tc, zB.tf, zB.tc);
+        printf("Tiempo de conversión a orden Z: %f segundos\n",
+               (double)(fin_conversion - inicio) / CLOCKS_PER_SEC);
+        printf("Tiempo de ejecución de la multiplicación: %f segundos\n",
+               (double)(fin_producto - fin_conversion) / CLOCKS_PER_SEC);
+        printf("Tiempo de conversión desde orden Z: %f segundos\n",
+               (double)(fin - fin_producto) / CLOCKS_PER_SEC);
+        if (verificar) {
+            double** referencia = multiplicar_matrices(A, B, filasA, columnasA, columnasB);
+            printf("Error relativo frente al algoritmo ingenuo: %e\n",
+                   error_relativo(referencia, C, filasA, columnasB));
+            liberar_matriz(referencia, filasA);
+        }
+
+        liberar_morton(&zA);
+        liberar_morton(&zB);
+        liberar_morton(&zC);
+        liberar_matriz(C, filasA);
+        liberar_matriz(A, filasA);
+        liberar_matriz(B, filasB);
+        return 0;
+    }
+
+    // GEMV y tall-skinny: el producto está limitado por la lectura de A, así que además
+    // del tiempo se informa el ancho de banda efectivo (A, B y C una vez por iteración)
+    if (usar_estrecho) {
+        double** C = reservar_matriz(filasA, columnasB);
+
+        clock_t inicio = clock();
+        for (int it = 0; it < iteraciones; it++) {
+            gemm_estrecho(A[0], columnasA, B[0], columnasB, C[0], columnasB, filasA, columnasA, columnasB);
+        }
+        double tiempo = (double)(clock() - inicio) / CLOCKS_PER_SEC / iteraciones;
+        double bytes = ((double)filasA * columnasA + (double)columnasA * columnasB
+                        + (double)filasA * columnasB) * sizeof(double);
+
+        printf("Tiempo de ejecución de la multiplicación (%s): %f segundos por iteración\n",
+               columnasB == 1 ? "gemv" : "tall-skinny", tiempo);
+        printf("Ancho de banda efectivo: %.3f GB/s\n", bytes / tiempo / 1e9);
+        if (verificar) {
+            double** referencia = multiplicar_matrices(A, B, filasA, columnasA, columnasB);
+            printf("Error relativo frente al algoritmo ingenuo: %e\n",
+                   error_relativo(referencia, C, filasA, columnasB));
+            liberar_matriz(referencia, filasA);
+        }
+
+        liberar_matriz(C, filasA);
+        liberar_matriz(A, filasA);
+        liberar_matriz(B, filasB);
+        return 0;
+    }
+
+    // Modo bucle: repetir el producto como en un proceso de larga duración. Sin --arena
+    // cada iteración reserva y libera C; con --arena C sale siempre de la misma región.
+    if (usar_bucle) {
+        Arena* arena = NULL;
+        size_t marca = 0;
+        if (usar_arena) {
+            arena = arena_crear((size_t)filasA * (columnasB * sizeof(double) + sizeof(double*))
+                                + 2 * ARENA_ALINEACION);
+            if (arena == NULL) {
+                fprintf(stderr, "No se pudo crear el espacio de trabajo\n");
+                return 1;
+            }
+            marca = arena_marca(arena);
+        }
+
+        double** C = NULL;
+        clock_t inicio = clock();
+        for (int it = 0; it < iteraciones; it++) {
+            if (usar_arena) {
+                arena_restaurar(arena, marca);
+                C = arena_matriz(arena, filasA, columnasB);
+                multiplicar_matrices_en(A, B, C, filasA, columnasA, columnasB);
+            } else {
+                if (C != NULL) {
+                    liberar_matriz(C, filasA);
+                }
+                C = multiplicar_matrices(A, B, filasA, columnasA, columnasB);
+            }
+        }
+        clock_t fin = clock();
+        double tiempo_ejecucion = (double)(fin - inicio) / CLOCKS_PER_SEC;
+        printf("Tiempo de ejecución de %d multiplicaciones (%s): %f segundos (%f por iteración)\n",
+               iteraciones, usar_arena ? "arena" : "malloc", tiempo_ejecucion, tiempo_ejecucion / iteraciones);
+        if (usar_arena) {
+            printf("Uso máximo del espacio de trabajo: %zu bytes\n", arena_pico(arena));
+            arena_destruir(arena);
+        } else {
+            liberar_matriz(C, filasA);
+        }
+        liberar_matriz(A, filasA);
+        liberar_matriz(B, filasB);
+        return 0;
+    }
+
+    // Modo con vistas: A, B y C son bloques interiores de matrices mayores (con un
+    // margen de MARGEN filas y columnas) y A y/o B se guardan traspuestas si se pide.
+    if (usar_vista) {
+        const int MARGEN = 3;
+        int fA = transA ? columnasA : filasA, cA = transA ? filasA : columnasA;
+        int fB = transB ? columnasB : filasB, cB = transB ? filasB : columnasB;
+        double** padreA = reservar_matriz(fA + 2 * MARGEN, cA + 2 * MARGEN);
+        double** padreB = reservar_matriz(fB + 2 * MARGEN, cB + 2 * MARGEN);
+        double** padreC = reservar_matriz(filasA + 2 * MARGEN, columnasB + 2 * MARGEN);
+        llenar_matriz(padreC, filasA + 2 * MARGEN, columnasB + 2 * MARGEN);
+        for (int i = 0; i < filasA; i++) {
+            for (int j = 0; j < columnasA; j++) {
+                if (transA) {
+                    padreA[MARGEN + j][MARGEN + i] = A[i][j];
+                } else {
+                    padreA[MARGEN + i][MARGEN + j] = A[i][j];
+                }
+            }
+        }
+        for (int i = 0; i < filasB; i++) {
+            for (int j = 0; j < columnasB; j++) {
+                if (transB) {
+                    padreB[MARGEN + j][MARGEN + i] = B[i][j];
+                } else {
+                    padreB[MARGEN + i][MARGEN + j] = B[i][j];
+                }
+            }
+        }
+        VistaMatriz vA = vista_matriz(padreA, cA + 2 * MARGEN, MARGEN, MARGEN, fA, cA);
+        VistaMatriz vB = vista_matriz(padreB, cB + 2 * MARGEN, MARGEN, MARGEN, fB, cB);
+        VistaMatriz vC = vista_matriz(padreC, columnasB + 2 * MARGEN, MARGEN, MARGEN, filasA, columnasB);
+
+        clock_t inicio = clock();
+        int estado = gemm_vista(transA, transB, 1.0, vA, vB, 0.0, vC);
+        clock_t fin = clock();
+        if (estado != 0) {
+            fprintf(stderr, "Dimensiones incompatibles para gemm_vista\n");
+            liberar_matriz(padreA, fA + 2 * MARGEN);
+            liberar_matriz(padreB, fB + 2 * MARGEN);
+            liberar_matriz(padreC, filasA + 2 * MARGEN);
+            liberar_matriz(A, filasA);
+            liberar_matriz(B, filasB);
+            return 1;
+        }
+        printf("Tiempo de ejecución de la multiplicación sobre vistas: %f segundos\n",
+               (double)(fin - inicio) / CLOCKS_PER_SEC);
+
+        // Verificar el bloque resultado contra la multiplicación de matrices completas
+        double** referencia = multiplicar_matrices(A, B, filasA, columnasA, columnasB);
+        double max_diff = 0.0;
+        for (int i = 0; i < filasA; i++) {
+            for (int j = 0; j < columnasB; j++) {
+                double d = fabs(padreC[MARGEN + i][MARGEN + j] - referencia[i][j]);
+                if (d > max_diff) {
+                    max_diff = d;
+                }
+            }
+        }
+        printf("Diferencia máxima frente a multiplicar_matrices: %e\n", max_diff);
+
+        liberar_matriz(referencia, filasA);
+        liberar_matriz(padreA, fA + 2 * MARGEN);
+        liberar_matriz(padreB, fB + 2 * MARGEN);
+        liberar_matriz(padreC, filasA + 2 * MARGEN);
+        liberar_matriz(A, filasA);
+        liberar_matriz(B, filasB);
+        return 0;
+    }
+
+    // Modo con epílogo fusionado: C = relu(alpha * A * B + beta * C + bias) sobre un C existente
+    if (usar_epilogo) {
+        double** C = reservar_matriz(filasA, columnasB);
+        double** C_ref = reservar_matriz(filasA, columnasB);
+        double* bias = NULL;
+        llenar_matriz(C, filasA, columnasB);
+        for (int i = 0; i < filasA; i++) {
+            for (int j = 0; j < columnasB; j++) {
+                C[i][j] -= 5.0;  // valores negativos para que relu tenga efecto
+                C_ref[i][j] = C[i][j];
+            }
+        }
+        if (usar_bias) {
+            bias = (double*)malloc(columnasB * sizeof(double));
+            for (int j = 0; j < columnasB; j++) {
+                bias[j] = (double)(rand() % 10) - 5.0;
+            }
+            ep.bias = bias;
+        }
+
+        clock_t inicio = clock();
+        multiplicar_matrices_epilogo(A, B, C, filasA, columnasA, columnasB, &ep);
+        clock_t fin = clock();
+        printf("Tiempo de ejecución de la multiplicación con epílogo: %f segundos\n",
+               (double)(fin - inicio) / CLOCKS_PER_SEC);
+
+        // Verificar contra el cálculo sin fusionar (producto y epílogo por separado)
+        double** AB = multiplicar_matrices(A, B, filasA, columnasA, columnasB);
+        aplicar_epilogo_referencia(AB, C_ref, filasA, columnasB, &ep);
+        printf("Error relativo frente al cálculo sin fusionar: %e\n",
+               error_relativo(C_ref, C, filasA, columnasB));
+
+        liberar_matriz(AB, filasA);
+        liberar_matriz(C_ref, filasA);
+        liberar_matriz(C, filasA);
+        free(bias);
+        liberar_matriz(A, filasA);
+        liberar_matriz(B, filasB);
+        return 0;
+    }
+
+    // Copias en simple precisión de las entradas para los modos f32 y mixed
+    float** A32 = NULL;
+    float** B32 = NULL;
+    float** C32 = NULL;
+    double** C = NULL;
+    if (dtype != DTYPE_F64) {
+        A32 = reservar_matriz_f32(filasA, columnasA);
+        B32 = reservar_matriz_f32(filasB, columnasB);
+        convertir_a_f32(A, A32, filasA, columnasA);
+        convertir_a_f32(B, B32, filasB, columnasB);
+    }
 
     // Multiplicar las matrices
     clock_t inicio = clock(); // Iniciar medición del tiempo
-    double** C = multiplicar_matrices(A, B, filasA, columnasA, columnasB);
+    if (dtype == DTYPE_F64) {
+        C = multiplicar_matrices(A, B, filasA, columnasA, columnasB);
+    } else if (dtype == DTYPE_F32) {
+        C32 = reservar_matriz_f32(filasA, columnasB);
+        multiplicar_filas_f32(A32[0], columnasA, B32[0], columnasB, C32[0], columnasB, 0, filasA,
+                              columnasA, columnasB);
+    } else {
+        C = reservar_matriz(filasA, columnasB);
+        multiplicar_filas_mixta(A32[0], columnasA, B32[0], columnasB, C[0], columnasB, 0, filasA,
+                                columnasA, columnasB);
+    }
     clock_t fin = clock(); // Finalizar medición del tiempo
     double tiempo_ejecucion = (double)(fin - inicio) / CLOCKS_PER_SEC;
     printf("Tiempo de ejecución de la multiplicación: %f segundos\n", tiempo_ejecucion);
+
+    // Comparar contra una referencia calculada en doble precisión
+    if (dtype != DTYPE_F64) {
+        double** referencia = multiplicar_matrices(A, B, filasA, columnasA, columnasB);
+        double error = (dtype == DTYPE_F32)
+            ? error_relativo_f32(referencia, C32, filasA, columnasB)
+            : error_relativo(referencia, C, filasA, columnasB);
+        printf("Error relativo frente a fp64 (norma de Frobenius): %e\n", error);
+        liberar_matriz(referencia, filasA);
+    }
     
     // // Mostrar resultado
     // printf("Matriz A:\n");
@@ -108,7 +582,16 @@ int main(int argc, char *argv[]) {
     // Liberar memoria
     liberar_matriz(A, filasA);
     liberar_matriz(B, filasB);
-    liberar_matriz(C, filasA);
+    if (C != NULL) {
+        liberar_matriz(C, filasA);
+    }
+    if (dtype != DTYPE_F64) {
+        liberar_matriz_f32(A32, filasA);
+        liberar_matriz_f32(B32, filasB);
+    }
+    if (C32 != NULL) {
+        liberar_matriz_f32(C32, filasA);
+    }
 
     return 0;
 }
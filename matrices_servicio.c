@@ -0,0 +1,760 @@
+/*
+ * matrices_servicio.c
+ *
+ * Servicio de multiplicación de matrices de larga duración sobre un socket Unix.
+ * En lugar de lanzar un proceso por producto (arranque, llenado aleatorio, creación
+ * y destrucción de hilos), el servicio mantiene un conjunto de hilos ya creados y un
+ * espacio de trabajo por conexión, y atiende peticiones de muchos clientes a la vez.
+ *
+ * Protocolo (una línea de texto por petición, una línea por respuesta):
+ *
+ *   MUL <m> <k> <n> <dtype> <A> <B> <C>
+ *       Calcula C (m x n) = A (m x k) * B (k x n), por filas.
+ *       dtype: f64, f32 (entradas y salida float) o mixed (entradas float, salida double)
+ *       A, B:  shm:/nombre  (memoria compartida POSIX, se mapea sin copiar)
+ *              file:/ruta   (archivo binario con los elementos en crudo)
+ *       C:     shm:/nombre  (creada por el cliente; el resultado se escribe directamente)
+ *              -            (el servicio crea /matmul_C_<id> y devuelve el nombre)
+ *       Respuesta: OK <id> <latencia_us> <nombre_C>   o   ERROR <mensaje>
+ *
+ *   METRICAS
+ *       Respuesta: OK trabajos=<n> cola=<actual> cola_max=<max> lat_media_us=<x>
+ *                  lat_max_us=<x> lat_p99_us=<x>
+ *
+ *   SALIR
+ *       Detiene el servicio.
+ *
+ * Los trabajos se dividen en bandas de filas cuando son grandes y se encolan en una
+ * única cola acotada; cada hilo del conjunto retira varias tareas por vez (lotes),
+ * de modo que muchos productos pequeños concurrentes comparten los hilos y un
+ * producto grande los usa todos. El conjunto de hilos es el de matrices_pool.h, el
+ * mismo sobre el que corre el ejecutor asíncrono de matrices_asincrono.h.
+ *
+ * Uso:
+ *   gcc -O2 matrices_servicio.c -o matrices_servicio -pthread -lrt
+ *   ./matrices_servicio -s /tmp/matmul.sock -h 4                 (servicio)
+ *   ./matrices_servicio -s /tmp/matmul.sock --cliente -n 32 -r 10000 (cliente de prueba)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "matrices_arena.h"
+#include "matrices_pool.h"
+#include "matrices_precision.h"
+
+/* Capacidad de la cola de tareas pendientes */
+#define CAPACIDAD_COLA 4096
+
+/* Número máximo de tareas que un hilo retira de la cola de una vez */
+#define LOTE_MAX 16
+
+/* A partir de este número de multiplicaciones-suma un trabajo se reparte en bandas */
+#define UMBRAL_DIVISION (1L << 20)
+
+/* Capacidad del espacio de trabajo de cada conexión (se compromete de forma perezosa) */
+#define CAPACIDAD_ARENA (256UL << 20)
+
+/* Cubetas del histograma de latencias (potencias de 2 en microsegundos) */
+#define CUBETAS_LATENCIA 32
+
+/* Un producto pedido por un cliente; las tareas de sus bandas lo comparten */
+typedef struct {
+    int m, k, n;
+    TipoDato dtype;
+    const void* A;
+    const void* B;
+    void* C;
+    int pendientes;          /* bandas aún sin terminar */
+    pthread_mutex_t mutex;
+    pthread_cond_t terminado;
+} Trabajo;
+
+/* Métricas globales del servicio */
+typedef struct {
+    pthread_mutex_t mutex;
+    long trabajos;
+    int cola_max;
+    double latencia_total_us;
+    double latencia_max_us;
+    long histograma[CUBETAS_LATENCIA];
+} Metricas;
+
+/* Conexiones abiertas: el servicio no detiene el conjunto de hilos mientras
+ * alguna siga dentro de una petición
+ */
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t ninguna;
+    int* fds;
+    int cantidad;
+    int capacidad;
+} Conexiones;
+
+/* Lector de líneas con búfer sobre un descriptor (evita una llamada read por byte) */
+typedef struct {
+    int fd;
+    char buf[4096];
+    size_t ini;
+    size_t fin;
+} LectorLinea;
+
+static PoolHilos pool;
+static Metricas metricas = {PTHREAD_MUTEX_INITIALIZER, 0, 0, 0.0, 0.0, {0}};
+static Conexiones conexiones = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, NULL, 0, 0};
+static atomic_int servicio_activo = 1;
+static int socket_escucha = -1;
+static long contador_trabajos = 0;
+static pthread_mutex_t mutex_contador = PTHREAD_MUTEX_INITIALIZER;
+
+/* Tiempo monótono en microsegundos */
+double ahora_us() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+/* Tamaño en bytes de un elemento de entrada y de salida según el dtype */
+size_t tam_entrada(TipoDato dtype) {
+    return dtype == DTYPE_F64 ? sizeof(double) : sizeof(float);
+}
+
+size_t tam_salida(TipoDato dtype) {
+    return dtype == DTYPE_F32 ? sizeof(float) : sizeof(double);
+}
+
+/* Tarea del conjunto de hilos: multiplica las filas [fila_inicio, fila_fin) de un
+ * trabajo con el kernel i-k-j de su dtype (matrices_precision.h) y avisa al cliente
+ * cuando termina la última banda
+ */
+void ejecutar_tarea(void* datos, int fila_inicio, int fila_fin) {
+    Trabajo* t = (Trabajo*)datos;
+    int k = t->k, n = t->n;
+    int i0 = fila_inicio, i1 = fila_fin;
+
+    if (t->dtype == DTYPE_F64) {
+        multiplicar_filas_f64((const double*)t->A, k, (const double*)t->B, n, (double*)t->C, n, i0, i1, k, n);
+    } else if (t->dtype == DTYPE_F32) {
+        multiplicar_filas_f32((const float*)t->A, k, (const float*)t->B, n, (float*)t->C, n, i0, i1, k, n);
+    } else {
+        multiplicar_filas_mixta((const float*)t->A, k, (const float*)t->B, n, (double*)t->C, n, i0, i1, k, n);
+    }
+
+    pthread_mutex_lock(&t->mutex);
+    if (--t->pendientes == 0) {
+        pthread_cond_signal(&t->terminado);
+    }
+    pthread_mutex_unlock(&t->mutex);
+}
+
+/* Crea los hilos del conjunto (matrices_pool.h) con su cola acotada; quedan
+ * esperando tareas
+ */
+void iniciar_pool(int num_hilos) {
+    if (pool_iniciar(&pool, num_hilos, CAPACIDAD_COLA, POOL_ACOTADA, LOTE_MAX) != 0) {
+        fprintf(stderr, "Error al crear el hilo %d\n", pool.num_hilos);
+        exit(EXIT_FAILURE);
+    }
+}
+
+/* Reparte un trabajo en bandas de filas, las encola y espera a que terminen */
+void ejecutar_trabajo(Trabajo* t) {
+    long operaciones = (long)t->m * t->k * t->n;
+    int bandas = 1;
+    if (operaciones >= UMBRAL_DIVISION) {
+        bandas = pool.num_hilos < t->m ? pool.num_hilos : t->m;
+    }
+
+    pthread_mutex_init(&t->mutex, NULL);
+    pthread_cond_init(&t->terminado, NULL);
+    t->pendientes = bandas;
+
+    /* Se encolan todas las bandas de una vez: con la cola llena pool_encolar espera */
+    TareaPool* tareas = (TareaPool*)malloc(bandas * sizeof(TareaPool));
+    if (tareas == NULL) {
+        fprintf(stderr, "Error en la asignación de memoria para las tareas\n");
+        exit(EXIT_FAILURE);
+    }
+    int base = t->m / bandas, resto = t->m % bandas, fila = 0;
+    for (int b = 0; b < bandas; b++) {
+        int filas = base + (b < resto ? 1 : 0);
+        tareas[b] = (TareaPool){ejecutar_tarea, t, fila, fila + filas};
+        fila += filas;
+    }
+    int profundidad = pool_encolar(&pool, tareas, bandas);
+    free(tareas);
+
+    pthread_mutex_lock(&metricas.mutex);
+    if (profundidad > metricas.cola_max) {
+        metricas.cola_max = profundidad;
+    }
+    pthread_mutex_unlock(&metricas.mutex);
+
+    pthread_mutex_lock(&t->mutex);
+    while (t->pendientes > 0) {
+        pthread_cond_wait(&t->terminado, &t->mutex);
+    }
+    pthread_mutex_unlock(&t->mutex);
+
+    pthread_mutex_destroy(&t->mutex);
+    pthread_cond_destroy(&t->terminado);
+}
+
+/* Registra la latencia de un trabajo terminado */
+void registrar_latencia(double latencia_us) {
+    int cubeta = 0;
+    while (cubeta < CUBETAS_LATENCIA - 1 && (double)(1L << (cubeta + 1)) <= latencia_us) {
+        cubeta++;
+    }
+
+    pthread_mutex_lock(&metricas.mutex);
+    metricas.trabajos++;
+    metricas.latencia_total_us += latencia_us;
+    if (latencia_us > metricas.latencia_max_us) {
+        metricas.latencia_max_us = latencia_us;
+    }
+    metricas.histograma[cubeta]++;
+    pthread_mutex_unlock(&metricas.mutex);
+}
+
+/* Escribe en buf la línea de respuesta de METRICAS */
+void formatear_metricas(char* buf, size_t cap) {
+    int cola = pool_pendientes(&pool);
+
+    pthread_mutex_lock(&metricas.mutex);
+    /* p99 aproximado: límite superior de la cubeta que acumula el 99% de los trabajos */
+    long objetivo = (long)ceil(metricas.trabajos * 0.99), acumulado = 0;
+    double p99 = 0.0;
+    for (int i = 0; i < CUBETAS_LATENCIA && metricas.trabajos > 0; i++) {
+        acumulado += metricas.histograma[i];
+        if (acumulado >= objetivo) {
+            p99 = (double)(1L << (i + 1));
+            break;
+        }
+    }
+    snprintf(buf, cap, "OK trabajos=%ld cola=%d cola_max=%d lat_media_us=%.1f lat_max_us=%.1f lat_p99_us=%.0f\n",
+             metricas.trabajos, cola, metricas.cola_max,
+             metricas.trabajos > 0 ? metricas.latencia_total_us / metricas.trabajos : 0.0,
+             metricas.latencia_max_us, p99);
+    pthread_mutex_unlock(&metricas.mutex);
+}
+
+/* Lee una línea (sin el salto final) en linea; devuelve su longitud o -1 al cerrar */
+int leer_linea(LectorLinea* lector, char* linea, size_t cap) {
+    size_t len = 0;
+    for (;;) {
+        while (lector->ini < lector->fin) {
+            char c = lector->buf[lector->ini++];
+            if (c == '\n') {
+                linea[len] = '\0';
+                return (int)len;
+            }
+            if (len + 1 < cap) {
+                linea[len++] = c;
+            }
+        }
+        ssize_t leidos = read(lector->fd, lector->buf, sizeof(lector->buf));
+        if (leidos <= 0) {
+            return -1;
+        }
+        lector->ini = 0;
+        lector->fin = (size_t)leidos;
+    }
+}
+
+/* Escribe toda la cadena en el descriptor */
+int escribir_todo(int fd, const char* texto) {
+    size_t len = strlen(texto), enviados = 0;
+    while (enviados < len) {
+        ssize_t e = write(fd, texto + enviados, len - enviados);
+        if (e <= 0) {
+            if (e < 0 && errno == EINTR) continue;
+            return -1;
+        }
+        enviados += (size_t)e;
+    }
+    return 0;
+}
+
+/* Mapea un objeto de memoria compartida existente de al menos bytes bytes */
+void* mapear_shm(const char* nombre, size_t bytes, int escritura) {
+    int fd = shm_open(nombre, escritura ? O_RDWR : O_RDONLY, 0);
+    if (fd == -1) {
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1 || (size_t)st.st_size < bytes) {
+        close(fd);
+        return NULL;
+    }
+    void* ptr = mmap(NULL, bytes, escritura ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    return ptr == MAP_FAILED ? NULL : ptr;
+}
+
+/* Crea un objeto de memoria compartida nuevo de bytes bytes y lo mapea */
+void* crear_shm(const char* nombre, size_t bytes) {
+    int fd = shm_open(nombre, O_CREAT | O_RDWR | O_TRUNC, 0600);
+    if (fd == -1) {
+        return NULL;
+    }
+    if (ftruncate(fd, (off_t)bytes) == -1) {
+        close(fd);
+        shm_unlink(nombre);
+        return NULL;
+    }
+    void* ptr = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    return ptr == MAP_FAILED ? NULL : ptr;
+}
+
+/* Obtiene un operando de entrada descrito como shm:/nombre o file:/ruta.
+ * Los archivos se leen en la arena de la conexión; la memoria compartida se mapea
+ * sin copiar y *mapeado queda a 1 para que el llamador la desmapee.
+ */
+const void* obtener_entrada(const char* spec, size_t bytes, Arena* arena, int* mapeado) {
+    *mapeado = 0;
+    if (strncmp(spec, "shm:", 4) == 0) {
+        void* ptr = mapear_shm(spec + 4, bytes, 0);
+        *mapeado = ptr != NULL;
+        return ptr;
+    }
+    if (strncmp(spec, "file:", 5) == 0) {
+        void* destino = arena_reservar(arena, bytes);
+        FILE* f = fopen(spec + 5, "rb");
+        if (destino == NULL || f == NULL) {
+            if (f != NULL) fclose(f);
+            return NULL;
+        }
+        size_t leidos = fread(destino, 1, bytes, f);
+        fclose(f);
+        return leidos == bytes ? destino : NULL;
+    }
+    return NULL;
+}
+
+/* Atiende una petición MUL y escribe la respuesta en respuesta */
+void atender_mul(char* argumentos, Arena* arena, char* respuesta, size_t cap) {
+    double llegada = ahora_us();
+    int m, k, n;
+    char dtype_txt[16], specA[256], specB[256], specC[256];
+
+    if (sscanf(argumentos, "%d %d %d %15s %255s %255s %255s", &m, &k, &n, dtype_txt, specA, specB, specC) != 7
+        || m <= 0 || k <= 0 || n <= 0) {
+        snprintf(respuesta, cap, "ERROR petición MUL mal formada\n");
+        return;
+    }
+    int d = parsear_dtype(dtype_txt);
+    if (d < 0) {
+        snprintf(respuesta, cap, "ERROR tipo de dato no válido: %s\n", dtype_txt);
+        return;
+    }
+
+    Trabajo t;
+    t.m = m;
+    t.k = k;
+    t.n = n;
+    t.dtype = (TipoDato)d;
+    size_t bytesA = (size_t)m * k * tam_entrada(t.dtype);
+    size_t bytesB = (size_t)k * n * tam_entrada(t.dtype);
+    size_t bytesC = (size_t)m * n * tam_salida(t.dtype);
+
+    pthread_mutex_lock(&mutex_contador);
+    long id = ++contador_trabajos;
+    pthread_mutex_unlock(&mutex_contador);
+
+    size_t marca = arena_marca(arena);
+    int mapeadoA, mapeadoB;
+    t.A = obtener_entrada(specA, bytesA, arena, &mapeadoA);
+    t.B = obtener_entrada(specB, bytesB, arena, &mapeadoB);
+
+    char nombreC[256];
+    if (strcmp(specC, "-") == 0) {
+        snprintf(nombreC, sizeof(nombreC), "/matmul_C_%d_%ld", (int)getpid(), id);
+        t.C = crear_shm(nombreC, bytesC);
+    } else if (strncmp(specC, "shm:", 4) == 0) {
+        snprintf(nombreC, sizeof(nombreC), "%s", specC + 4);
+        t.C = mapear_shm(nombreC, bytesC, 1);
+    } else {
+        t.C = NULL;
+    }
+
+    if (t.A == NULL || t.B == NULL || t.C == NULL) {
+        snprintf(respuesta, cap, "ERROR no se pudo acceder a %s\n",
+                 t.A == NULL ? specA : (t.B == NULL ? specB : specC));
+    } else {
+        ejecutar_trabajo(&t);
+        double latencia = ahora_us() - llegada;
+        registrar_latencia(latencia);
+        snprintf(respuesta, cap, "OK %ld %.1f %s\n", id, latencia, nombreC);
+    }
+
+    if (mapeadoA) munmap((void*)t.A, bytesA);
+    if (mapeadoB) munmap((void*)t.B, bytesB);
+    if (t.C != NULL) munmap(t.C, bytesC);
+    arena_restaurar(arena, marca);
+}
+
+/* Anota una conexión abierta; devuelve -1 si no queda memoria */
+int registrar_conexion(int fd) {
+    pthread_mutex_lock(&conexiones.mutex);
+    if (conexiones.cantidad == conexiones.capacidad) {
+        int capacidad = conexiones.capacidad > 0 ? 2 * conexiones.capacidad : 16;
+        int* fds = (int*)realloc(conexiones.fds, capacidad * sizeof(int));
+        if (fds == NULL) {
+            pthread_mutex_unlock(&conexiones.mutex);
+            return -1;
+        }
+        conexiones.fds = fds;
+        conexiones.capacidad = capacidad;
+    }
+    conexiones.fds[conexiones.cantidad++] = fd;
+    pthread_mutex_unlock(&conexiones.mutex);
+    return 0;
+}
+
+/* Quita una conexión de la lista y avisa si era la última */
+void retirar_conexion(int fd) {
+    pthread_mutex_lock(&conexiones.mutex);
+    for (int i = 0; i < conexiones.cantidad; i++) {
+        if (conexiones.fds[i] == fd) {
+            conexiones.fds[i] = conexiones.fds[--conexiones.cantidad];
+            break;
+        }
+    }
+    if (conexiones.cantidad == 0) {
+        pthread_cond_broadcast(&conexiones.ninguna);
+    }
+    pthread_mutex_unlock(&conexiones.mutex);
+}
+
+/* Cierra la lectura de todas las conexiones (la que está dentro de una petición la
+ * termina y responde; la siguiente lectura ve el fin) y espera a que se cierren
+ */
+void drenar_conexiones() {
+    pthread_mutex_lock(&conexiones.mutex);
+    for (int i = 0; i < conexiones.cantidad; i++) {
+        shutdown(conexiones.fds[i], SHUT_RD);
+    }
+    while (conexiones.cantidad > 0) {
+        pthread_cond_wait(&conexiones.ninguna, &conexiones.mutex);
+    }
+    pthread_mutex_unlock(&conexiones.mutex);
+    free(conexiones.fds);
+    conexiones.fds = NULL;
+    conexiones.capacidad = 0;
+}
+
+/* Hilo que atiende todas las peticiones de una conexión con su propio espacio de trabajo */
+void* atender_conexion(void* arg) {
+    int fd = (int)(long)arg;
+    LectorLinea lector = {fd, {0}, 0, 0};
+    char linea[1024], respuesta[512];
+    Arena* arena = arena_crear(CAPACIDAD_ARENA);
+
+    while (arena != NULL && leer_linea(&lector, linea, sizeof(linea)) >= 0) {
+        if (strncmp(linea, "MUL ", 4) == 0) {
+            atender_mul(linea + 4, arena, respuesta, sizeof(respuesta));
+        } else if (strcmp(linea, "METRICAS") == 0) {
+            formatear_metricas(respuesta, sizeof(respuesta));
+        } else if (strcmp(linea, "SALIR") == 0) {
+            escribir_todo(fd, "OK\n");
+            atomic_store(&servicio_activo, 0);
+            shutdown(socket_escucha, SHUT_RDWR);
+            break;
+        } else {
+            snprintf(respuesta, sizeof(respuesta), "ERROR orden desconocida\n");
+        }
+        if (escribir_todo(fd, respuesta) != 0) {
+            break;
+        }
+    }
+
+    arena_destruir(arena);
+    retirar_conexion(fd);
+    close(fd);
+    return NULL;
+}
+
+/* Bucle principal del servicio: acepta conexiones y crea un hilo por cada una */
+int ejecutar_servicio(const char* ruta, int num_hilos) {
+    struct sockaddr_un dir;
+    memset(&dir, 0, sizeof(dir));
+    dir.sun_family = AF_UNIX;
+    snprintf(dir.sun_path, sizeof(dir.sun_path), "%s", ruta);
+
+    socket_escucha = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (socket_escucha == -1) {
+        perror("Error al crear el socket");
+        return EXIT_FAILURE;
+    }
+    unlink(ruta);
+    if (bind(socket_escucha, (struct sockaddr*)&dir, sizeof(dir)) == -1 || listen(socket_escucha, 64) == -1) {
+        perror("Error al escuchar en el socket");
+        return EXIT_FAILURE;
+    }
+
+    iniciar_pool(num_hilos);
+    printf("Servicio escuchando en %s con %d hilos\n", ruta, num_hilos);
+    fflush(stdout);
+
+    while (atomic_load(&servicio_activo)) {
+        int fd = accept(socket_escucha, NULL, NULL);
+        if (fd == -1) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        /* Se registra antes de crear el hilo para que drenar_conexiones lo vea */
+        pthread_t hilo;
+        if (registrar_conexion(fd) != 0) {
+            fprintf(stderr, "Error al registrar la conexión\n");
+            close(fd);
+            continue;
+        }
+        if (pthread_create(&hilo, NULL, atender_conexion, (void*)(long)fd) != 0) {
+            fprintf(stderr, "Error al crear el hilo de la conexión\n");
+            retirar_conexion(fd);
+            close(fd);
+            continue;
+        }
+        pthread_detach(hilo);
+    }
+
+    /* Los hilos de conexión pueden seguir dentro de ejecutar_trabajo: el conjunto
+     * de hilos sólo se detiene cuando todos han respondido y cerrado
+     */
+    drenar_conexiones();
+
+    char resumen[512];
+    formatear_metricas(resumen, sizeof(resumen));
+    printf("Servicio detenido: %s", resumen + 3);
+
+    pool_detener(&pool);
+    close(socket_escucha);
+    unlink(ruta);
+    return EXIT_SUCCESS;
+}
+
+/* Conecta con el servicio; devuelve el descriptor o -1. Si el socket aún no existe
+ * o no escucha (servicio y cliente lanzados a la vez) reintenta durante ~2 s.
+ */
+int conectar(const char* ruta) {
+    struct sockaddr_un dir;
+    memset(&dir, 0, sizeof(dir));
+    dir.sun_family = AF_UNIX;
+    snprintf(dir.sun_path, sizeof(dir.sun_path), "%s", ruta);
+
+    for (int intento = 0; intento < 100; intento++) {
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd == -1) {
+            return -1;
+        }
+        if (connect(fd, (struct sockaddr*)&dir, sizeof(dir)) == 0) {
+            return fd;
+        }
+        int error = errno;
+        close(fd);
+        if (error != ENOENT && error != ECONNREFUSED) {
+            errno = error;
+            return -1;
+        }
+        usleep(20000);
+        errno = error;
+    }
+    return -1;
+}
+
+/* Envía una orden y lee la línea de respuesta */
+int pedir(int fd, LectorLinea* lector, const char* orden, char* respuesta, size_t cap) {
+    if (escribir_todo(fd, orden) != 0) {
+        return -1;
+    }
+    return leer_linea(lector, respuesta, cap);
+}
+
+int comparar_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+/* Cliente de prueba: crea A, B y C en memoria compartida, envía repeticiones
+ * peticiones MUL de n x n, verifica el resultado y muestra latencias y métricas.
+ */
+int ejecutar_cliente(const char* ruta, int n, int repeticiones, int detener) {
+    int fd = conectar(ruta);
+    if (fd == -1) {
+        perror("Error al conectar con el servicio");
+        return EXIT_FAILURE;
+    }
+    LectorLinea lector = {fd, {0}, 0, 0};
+
+    char nombreA[64], nombreB[64], nombreC[64];
+    snprintf(nombreA, sizeof(nombreA), "/matmul_cli_A_%d", (int)getpid());
+    snprintf(nombreB, sizeof(nombreB), "/matmul_cli_B_%d", (int)getpid());
+    snprintf(nombreC, sizeof(nombreC), "/matmul_cli_C_%d", (int)getpid());
+    size_t bytes = (size_t)n * n * sizeof(double);
+    double* A = (double*)crear_shm(nombreA, bytes);
+    double* B = (double*)crear_shm(nombreB, bytes);
+    double* C = (double*)crear_shm(nombreC, bytes);
+    if (A == NULL || B == NULL || C == NULL) {
+        perror("Error al crear la memoria compartida del cliente");
+        return EXIT_FAILURE;
+    }
+
+    srand(time(NULL));
+    for (size_t i = 0; i < (size_t)n * n; i++) {
+        A[i] = (double)(rand() % 10);
+        B[i] = (double)(rand() % 10);
+    }
+
+    char orden[512], respuesta[512];
+    snprintf(orden, sizeof(orden), "MUL %d %d %d f64 shm:%s shm:%s shm:%s\n", n, n, n, nombreA, nombreB, nombreC);
+
+    double* latencias = (double*)malloc(repeticiones * sizeof(double));
+    int errores = 0;
+    for (int r = 0; r < repeticiones; r++) {
+        double inicio = ahora_us();
+        if (pedir(fd, &lector, orden, respuesta, sizeof(respuesta)) < 0) {
+            fprintf(stderr, "El servicio cerró la conexión\n");
+            return EXIT_FAILURE;
+        }
+        latencias[r] = ahora_us() - inicio;
+        if (strncmp(respuesta, "OK", 2) != 0) {
+            if (errores++ == 0) {
+                fprintf(stderr, "Respuesta del servicio: %s\n", respuesta);
+            }
+        }
+    }
+
+    /* Verificar el último resultado, leído directamente de la memoria compartida */
+    double max_diff = 0.0;
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            double suma = 0.0;
+            for (int p = 0; p < n; p++) {
+                suma += A[i * n + p] * B[p * n + j];
+            }
+            double dif = fabs(suma - C[i * n + j]);
+            if (dif > max_diff) max_diff = dif;
+        }
+    }
+
+    qsort(latencias, repeticiones, sizeof(double), comparar_double);
+    printf("Peticiones MUL %dx%d: %d (%d errores)\n", n, n, repeticiones, errores);
+    printf("- Latencia de ida y vuelta: mediana %.1f us, p99 %.1f us, máxima %.1f us\n",
+           latencias[repeticiones / 2], latencias[(int)(repeticiones * 0.99)], latencias[repeticiones - 1]);
+    printf("- Diferencia máxima frente al cálculo local: %e\n", max_diff);
+
+    if (pedir(fd, &lector, "METRICAS\n", respuesta, sizeof(respuesta)) >= 0) {
+        printf("- Métricas del servicio: %s\n", respuesta + 3);
+    }
+    if (detener) {
+        pedir(fd, &lector, "SALIR\n", respuesta, sizeof(respuesta));
+    }
+
+    free(latencias);
+    munmap(A, bytes);
+    munmap(B, bytes);
+    munmap(C, bytes);
+    shm_unlink(nombreA);
+    shm_unlink(nombreB);
+    shm_unlink(nombreC);
+    close(fd);
+    return errores == 0 && max_diff == 0.0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* Función para mostrar ayuda */
+void mostrar_ayuda() {
+    printf("Uso: ./matrices_servicio [-s socket] [-h hilos] [--cliente [-n tamaño] [-r repeticiones] [--detener]]\n");
+    printf("Opciones:\n");
+    printf("  -s, --socket        Ruta del socket Unix (por defecto: /tmp/matmul.sock)\n");
+    printf("  -h, --hilos         Hilos del servicio (por defecto: 4)\n");
+    printf("  -c, --cliente       Ejecutar el cliente de prueba en lugar del servicio\n");
+    printf("  -n, --tamano        Tamaño de las matrices del cliente (por defecto: 32)\n");
+    printf("  -r, --repeticiones  Peticiones que envía el cliente (por defecto: 1000)\n");
+    printf("  -d, --detener       El cliente detiene el servicio al terminar\n");
+    printf("  -a, --ayuda         Mostrar esta ayuda\n");
+}
+
+int main(int argc, char* argv[]) {
+    const char* ruta = "/tmp/matmul.sock";
+    int num_hilos = 4;
+    int cliente = 0;
+    int n = 32;
+    int repeticiones = 1000;
+    int detener = 0;
+
+    static struct option opciones_largas[] = {
+        {"socket", required_argument, 0, 's'},
+        {"hilos", required_argument, 0, 'h'},
+        {"cliente", no_argument, 0, 'c'},
+        {"tamano", required_argument, 0, 'n'},
+        {"repeticiones", required_argument, 0, 'r'},
+        {"detener", no_argument, 0, 'd'},
+        {"ayuda", no_argument, 0, 'a'},
+        {0, 0, 0, 0}
+    };
+
+    int opcion;
+    while ((opcion = getopt_long(argc, argv, "s:h:cn:r:da", opciones_largas, NULL)) != -1) {
+        switch (opcion) {
+            case 's':
+                ruta = optarg;
+                break;
+            case 'h':
+                num_hilos = atoi(optarg);
+                if (num_hilos <= 0) {
+                    fprintf(stderr, "El número de hilos debe ser positivo\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'c':
+                cliente = 1;
+                break;
+            case 'n':
+                n = atoi(optarg);
+                if (n <= 0) {
+                    fprintf(stderr, "El tamaño de la matriz debe ser positivo\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'r':
+                repeticiones = atoi(optarg);
+                if (repeticiones <= 0) {
+                    fprintf(stderr, "El número de repeticiones debe ser positivo\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'd':
+                detener = 1;
+                break;
+            case 'a':
+                mostrar_ayuda();
+                return EXIT_SUCCESS;
+            default:
+                mostrar_ayuda();
+                return EXIT_FAILURE;
+        }
+    }
+
+    /* Un cliente que se desconecta no debe terminar el proceso al escribirle */
+    signal(SIGPIPE, SIG_IGN);
+
+    if (cliente) {
+        return ejecutar_cliente(ruta, n, repeticiones, detener);
+    }
+    return ejecutar_servicio(ruta, num_hilos);
+}
@@ -0,0 +1,179 @@
+/*
+ * matrices_simetricas.h
+ *
+ * Productos con estructura sobre la infraestructura de matrices_bloques.h (mismos
+ * Bloques, mismo reparto por bloques de mc filas con OpenMP, mismo acumular_fila):
+ *
+ *   syrk_bloques_openmp  C (m x m) = A * A^T. Sólo se calculan los bloques mc x mc del
+ *                        triángulo inferior de C (productos escalares de filas de A)
+ *                        y después se copian al superior: la mitad de operaciones.
+ *   symm_bloques_openmp  C (m x n) = S * B con S simétrica de la que sólo se lee el
+ *                        triángulo inferior; cada bloque mc x kc de S se empaqueta ya
+ *                        simetrizado y se multiplica como en gemm_bloques_openmp.
+ *   trmm_bloques_openmp  C (m x n) = T * B con T triangular inferior (o superior); el
+ *                        otro triángulo no se lee. Los bloques kc de T que caen por
+ *                        completo en la parte nula se saltan y en el bloque diagonal
+ *                        cada fila recorre sólo su parte no nula: la mitad de operaciones.
+ *
+ * Como en matrices_bloques.h, se generan con una macro para double (sin sufijo) y
+ * float (_f32) y sólo se definen al compilar con -fopenmp.
+ */
+
+#ifndef MATRICES_SIMETRICAS_H
+#define MATRICES_SIMETRICAS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "matrices_bloques.h"
+
+#ifdef _OPENMP
+
+#define DEFINIR_SIMETRICAS(S, TIPO)                                                          \
+    /* c[t] += a . b_t para cuatro filas b_t consecutivas de la misma matriz (ldb) */        \
+    static inline void punto_filas4##S(TIPO* c, const TIPO* a, const TIPO* b, int ldb,       \
+                                       int len) {                                            \
+        const TIPO *b0 = b, *b1 = b + ldb, *b2 = b + 2 * ldb, *b3 = b + 3 * ldb;             \
+        TIPO s0 = 0, s1 = 0, s2 = 0, s3 = 0;                                                 \
+        for (int p = 0; p < len; p++) {                                                      \
+            TIPO ap = a[p];                                                                  \
+            s0 += ap * b0[p];                                                                \
+            s1 += ap * b1[p];                                                                \
+            s2 += ap * b2[p];                                                                \
+            s3 += ap * b3[p];                                                                \
+        }                                                                                    \
+        c[0] += s0;                                                                          \
+        c[1] += s1;                                                                          \
+        c[2] += s2;                                                                          \
+        c[3] += s3;                                                                          \
+    }                                                                                        \
+                                                                                             \
+    static inline void syrk_bloques_openmp##S(const TIPO* A, int lda, TIPO* C, int ldc,      \
+                                              int m, int k, Bloques bl, int num_hilos) {     \
+        int nb = (m + bl.mc - 1) / bl.mc;                                                    \
+        long pares = (long)nb * (nb + 1) / 2;                                                \
+        /* Pares (bi, bj) con bj <= bi numerados por filas: t = bi * (bi + 1) / 2 + bj */    \
+        _Pragma("omp parallel for schedule(dynamic) num_threads(num_hilos)")                 \
+        for (long t = 0; t < pares; t++) {                                                   \
+            int bi = 0;                                                                      \
+            while ((long)(bi + 1) * (bi + 2) / 2 <= t) {                                     \
+                bi++;                                                                        \
+            }                                                                                \
+            int bj = (int)(t - (long)bi * (bi + 1) / 2);                                     \
+            int i0 = bi * bl.mc, i1 = i0 + bl.mc < m ? i0 + bl.mc : m;                       \
+            int j0 = bj * bl.mc, j1 = j0 + bl.mc < m ? j0 + bl.mc : m;                       \
+            for (int i = i0; i < i1; i++) {                                                  \
+                memset(C + (size_t)i * ldc + j0, 0, (j1 - j0) * sizeof(TIPO));               \
+            }                                                                                \
+            for (int pc = 0; pc < k; pc += bl.kc) {                                          \
+                int len = pc + bl.kc < k ? bl.kc : k - pc;                                   \
+                for (int i = i0; i < i1; i++) {                                              \
+                    const TIPO* a = A + (size_t)i * lda + pc;                                \
+                    TIPO* c = C + (size_t)i * ldc;                                           \
+                    int j_fin = bi == bj ? i + 1 : j1;                                       \
+                    int j = j0;                                                              \
+                    for (; j + 4 <= j_fin; j += 4) {                                         \
+                        punto_filas4##S(c + j, a, A + (size_t)j * lda + pc, lda, len);       \
+                    }                                                                        \
+                    for (; j < j_fin; j++) {                                                 \
+                        const TIPO* b = A + (size_t)j * lda + pc;                            \
+                        TIPO s = 0;                                                          \
+                        for (int p = 0; p < len; p++) {                                      \
+                            s += a[p] * b[p];                                                \
+                        }                                                                    \
+                        c[j] += s;                                                           \
+                    }                                                                        \
+                }                                                                            \
+            }                                                                                \
+        }                                                                                    \
+        /* Copiar el triángulo inferior al superior */                                       \
+        _Pragma("omp parallel for schedule(dynamic, 16) num_threads(num_hilos)")             \
+        for (int i = 0; i < m; i++) {                                                        \
+            for (int j = i + 1; j < m; j++) {                                                \
+                C[(size_t)i * ldc + j] = C[(size_t)j * ldc + i];                             \
+            }                                                                                \
+        }                                                                                    \
+    }                                                                                        \
+                                                                                             \
+    static inline void symm_bloques_openmp##S(const TIPO* Sm, int lds, const TIPO* B, int ldb,\
+                                              TIPO* C, int ldc, int m, int n, Bloques bl,    \
+                                              int num_hilos) {                               \
+        _Pragma("omp parallel num_threads(num_hilos)")                                       \
+        {                                                                                    \
+            /* Bloque mc x kc de S simetrizado, uno por hilo */                              \
+            TIPO* paquete = (TIPO*)malloc((size_t)bl.mc * bl.kc * sizeof(TIPO));             \
+            if (paquete == NULL) {                                                           \
+                fprintf(stderr, "Error en la asignación de memoria para SYMM\n");           \
+                exit(EXIT_FAILURE);                                                          \
+            }                                                                                \
+            _Pragma("omp for schedule(dynamic)")                                             \
+            for (int ic = 0; ic < m; ic += bl.mc) {                                          \
+                int i_fin = ic + bl.mc < m ? ic + bl.mc : m;                                 \
+                for (int i = ic; i < i_fin; i++) {                                           \
+                    memset(C + (size_t)i * ldc, 0, n * sizeof(TIPO));                        \
+                }                                                                            \
+                for (int pc = 0; pc < m; pc += bl.kc) {                                      \
+                    int p_fin = pc + bl.kc < m ? pc + bl.kc : m;                             \
+                    int p_par = pc + (p_fin - pc) / bl.unroll * bl.unroll;                   \
+                    for (int i = ic; i < i_fin; i++) {                                       \
+                        TIPO* fila = paquete + (size_t)(i - ic) * bl.kc;                     \
+                        for (int p = pc; p < p_fin; p++) {                                   \
+                            fila[p - pc] = p <= i ? Sm[(size_t)i * lds + p]                  \
+                                                  : Sm[(size_t)p * lds + i];                 \
+                        }                                                                    \
+                    }                                                                        \
+                    for (int jc = 0; jc < n; jc += bl.nc) {                                  \
+                        int j_fin = jc + bl.nc < n ? jc + bl.nc : n;                         \
+                        for (int i = ic; i < i_fin; i++) {                                   \
+                            const TIPO* a = paquete + (size_t)(i - ic) * bl.kc;              \
+                            TIPO* c = C + (size_t)i * ldc;                                   \
+                            for (int p = pc; p < p_fin; p += (p < p_par ? bl.unroll : 1)) {  \
+                                acumular_fila##S(c, a + (p - pc), B + (size_t)p * ldb, ldb,  \
+                                                 jc, j_fin, p < p_par ? bl.unroll : 1);      \
+                            }                                                                \
+                        }                                                                    \
+                    }                                                                        \
+                }                                                                            \
+            }                                                                                \
+            free(paquete);                                                                   \
+        }                                                                                    \
+    }                                                                                        \
+                                                                                             \
+    static inline void trmm_bloques_openmp##S(const TIPO* T, int ldt, const TIPO* B, int ldb,\
+                                              TIPO* C, int ldc, int m, int n, int superior,  \
+                                              Bloques bl, int num_hilos) {                   \
+        _Pragma("omp parallel for schedule(dynamic) num_threads(num_hilos)")                 \
+        for (int ic = 0; ic < m; ic += bl.mc) {                                              \
+            int i_fin = ic + bl.mc < m ? ic + bl.mc : m;                                     \
+            for (int i = ic; i < i_fin; i++) {                                               \
+                memset(C + (size_t)i * ldc, 0, n * sizeof(TIPO));                            \
+            }                                                                                \
+            /* Sólo los bloques de k que tocan la parte no nula de las filas ic..i_fin */    \
+            int p_inicio = superior ? ic : 0;                                                \
+            int p_limite = superior ? m : i_fin;                                             \
+            for (int jc = 0; jc < n; jc += bl.nc) {                                          \
+                int j_fin = jc + bl.nc < n ? jc + bl.nc : n;                                 \
+                for (int pc = p_inicio; pc < p_limite; pc += bl.kc) {                        \
+                    int p_fin = pc + bl.kc < p_limite ? pc + bl.kc : p_limite;               \
+                    for (int i = ic; i < i_fin; i++) {                                       \
+                        int p0 = superior && i > pc ? i : pc;                                \
+                        int p1 = !superior && i + 1 < p_fin ? i + 1 : p_fin;                 \
+                        int p_par = p0 + (p1 > p0 ? (p1 - p0) / bl.unroll * bl.unroll : 0);  \
+                        const TIPO* a = T + (size_t)i * ldt;                                 \
+                        TIPO* c = C + (size_t)i * ldc;                                       \
+                        for (int p = p0; p < p1; p += (p < p_par ? bl.unroll : 1)) {         \
+                            acumular_fila##S(c, a + p, B + (size_t)p * ldb, ldb, jc, j_fin,  \
+                                             p < p_par ? bl.unroll : 1);                     \
+                        }                                                                    \
+                    }                                                                        \
+                }                                                                            \
+            }                                                                                \
+        }                                                                                    \
+    }
+
+DEFINIR_SIMETRICAS(, double)
+DEFINIR_SIMETRICAS(_f32, float)
+
+#endif /* _OPENMP */
+
+#endif /* MATRICES_SIMETRICAS_H */
@@ -0,0 +1,228 @@
+/*
+ * matrices_strassen.h
+ *
+ * Multiplicación de Strassen con OpenMP, compartida por matrices_openmp y
+ * matrices_bench. Cada nivel divide A, B y C en cuadrantes y sustituye los ocho
+ * productos por siete; las hojas (por debajo de corte en alguna dimensión) usan
+ * gemm_bloques_openmp de matrices_bloques.h:
+ *
+ *   Arena* arena = arena_crear(espacio_strassen(m, k, n, CORTE_STRASSEN));
+ *   multiplicar_strassen_openmp_en(A, B, C, m, k, n, bloques, CORTE_STRASSEN,
+ *                                  num_hilos, arena);
+ *
+ * Los temporales (SA, SB y M por nivel, y las copias rellenadas con ceros hasta un
+ * múltiplo de 2^niveles si hace falta) salen de la arena de matrices_arena.h; A, B
+ * y C son matrices de punteros a fila con los datos contiguos en M[0].
+ *
+ * Como en matrices_simetricas.h, las funciones sólo se definen al compilar con
+ * -fopenmp; CORTE_STRASSEN está siempre disponible (matrices_auto lo usa en su
+ * modelo).
+ */
+
+#ifndef MATRICES_STRASSEN_H
+#define MATRICES_STRASSEN_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "matrices_arena.h"
+#include "matrices_bloques.h"
+
+/* Tamaño mínimo de las hojas de Strassen: por debajo el algoritmo por bloques es más rápido */
+#define CORTE_STRASSEN 128
+
+#ifdef _OPENMP
+
+/* Z = X + signo * Y sobre bloques filas x columnas (Y == NULL copia X) */
+static inline void combinar_bloques(const double* X, int ldx, const double* Y, int ldy, double signo,
+                                    double* Z, int ldz, int filas, int columnas, int num_hilos) {
+    #pragma omp parallel for num_threads(num_hilos)
+    for (int i = 0; i < filas; i++) {
+        const double* x = X + (size_t)i * ldx;
+        double* z = Z + (size_t)i * ldz;
+        if (Y == NULL) {
+            for (int j = 0; j < columnas; j++) {
+                z[j] = x[j];
+            }
+        } else {
+            const double* y = Y + (size_t)i * ldy;
+            for (int j = 0; j < columnas; j++) {
+                z[j] = x[j] + signo * y[j];
+            }
+        }
+    }
+}
+
+/* C += signo * M sobre bloques filas x columnas */
+static inline void acumular_bloque(double* C, int ldc, const double* M, int ldm, double signo,
+                                   int filas, int columnas, int num_hilos) {
+    #pragma omp parallel for num_threads(num_hilos)
+    for (int i = 0; i < filas; i++) {
+        double* c = C + (size_t)i * ldc;
+        const double* mm = M + (size_t)i * ldm;
+        for (int j = 0; j < columnas; j++) {
+            c[j] += signo * mm[j];
+        }
+    }
+}
+
+/* Número de niveles de Strassen para m x k x n: se divide mientras las tres
+ * dimensiones sigan siendo al menos 2 * corte
+ */
+static inline int niveles_strassen(int m, int k, int n, int corte) {
+    int niveles = 0;
+    while (m >= 2 * corte && k >= 2 * corte && n >= 2 * corte) {
+        m = (m + 1) / 2;
+        k = (k + 1) / 2;
+        n = (n + 1) / 2;
+        niveles++;
+    }
+    return niveles;
+}
+
+/* Redondea x hacia arriba a un múltiplo de 2^niveles */
+static inline int redondear_potencia(int x, int niveles) {
+    int paso = 1 << niveles;
+    return (x + paso - 1) / paso * paso;
+}
+
+/* Bytes de espacio de trabajo que necesita multiplicar_strassen_openmp_en */
+static inline size_t espacio_strassen(int m, int k, int n, int corte) {
+    int niveles = niveles_strassen(m, k, n, corte);
+    int mp = redondear_potencia(m, niveles), kp = redondear_potencia(k, niveles), np = redondear_potencia(n, niveles);
+    size_t bytes = 0;
+    if (mp != m || kp != k || np != n) {
+        bytes += ((size_t)mp * kp + (size_t)kp * np + (size_t)mp * np) * sizeof(double) + 3 * ARENA_ALINEACION;
+    }
+    for (int l = 0; l < niveles; l++) {
+        mp /= 2;
+        kp /= 2;
+        np /= 2;
+        bytes += ((size_t)mp * kp + (size_t)kp * np + (size_t)mp * np) * sizeof(double) + 3 * ARENA_ALINEACION;
+    }
+    return bytes;
+}
+
+/* Paso recursivo de Strassen: C = A * B con m, k y n divisibles por 2^niveles.
+ * Los siete productos se calculan de uno en uno en M y se acumulan en los cuadrantes
+ * de C, así que cada nivel sólo necesita tres temporales (SA, SB y M) de la arena.
+ */
+static inline void strassen_rec(const double* A, int lda, const double* B, int ldb, double* C, int ldc,
+                                int m, int k, int n, int niveles, Bloques bl, int num_hilos, Arena* arena) {
+    if (niveles == 0) {
+        gemm_bloques_openmp(A, lda, B, ldb, C, ldc, m, k, n, bl, num_hilos);
+        return;
+    }
+
+    int h = m / 2, q = k / 2, r = n / 2;
+    const double *A11 = A, *A12 = A + q, *A21 = A + (size_t)h * lda, *A22 = A21 + q;
+    const double *B11 = B, *B12 = B + r, *B21 = B + (size_t)q * ldb, *B22 = B21 + r;
+    double *C11 = C, *C12 = C + r, *C21 = C + (size_t)h * ldc, *C22 = C21 + r;
+
+    size_t marca = arena_marca(arena);
+    double* SA = (double*)arena_reservar(arena, (size_t)h * q * sizeof(double));
+    double* SB = (double*)arena_reservar(arena, (size_t)q * r * sizeof(double));
+    double* M = (double*)arena_reservar(arena, (size_t)h * r * sizeof(double));
+    if (SA == NULL || SB == NULL || M == NULL) {
+        fprintf(stderr, "Espacio de trabajo insuficiente para Strassen\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /* Operandos de cada producto: SA = X1 + sa * X2, SB = Y1 + sb * Y2 (X2/Y2 NULL si no hay suma) */
+    const double* X1[7] = {A11, A21, A11, A22, A11, A21, A12};
+    const double* X2[7] = {A22, A22, NULL, NULL, A12, A11, A22};
+    double sa[7] = {1, 1, 0, 0, 1, -1, -1};
+    const double* Y1[7] = {B11, B11, B12, B21, B22, B11, B21};
+    const double* Y2[7] = {B22, NULL, B22, B11, NULL, B12, B22};
+    double sb[7] = {1, 0, -1, -1, 0, 1, 1};
+    /* Contribución de cada Mi a C11, C12, C21 y C22 */
+    double signos[7][4] = {
+        {1, 0, 0, 1},    // M1 = (A11 + A22)(B11 + B22)
+        {0, 0, 1, -1},   // M2 = (A21 + A22) B11
+        {0, 1, 0, 1},    // M3 = A11 (B12 - B22)
+        {1, 0, 1, 0},    // M4 = A22 (B21 - B11)
+        {-1, 1, 0, 0},   // M5 = (A11 + A12) B22
+        {0, 0, 0, 1},    // M6 = (A21 - A11)(B11 + B12)
+        {1, 0, 0, 0}     // M7 = (A12 - A22)(B21 + B22)
+    };
+    double* cuadrantes[4] = {C11, C12, C21, C22};
+
+    for (int i = 0; i < h; i++) {
+        for (int j = 0; j < 2 * r; j++) {
+            C[(size_t)i * ldc + j] = 0.0;
+            C[(size_t)(i + h) * ldc + j] = 0.0;
+        }
+    }
+
+    for (int t = 0; t < 7; t++) {
+        const double* opA = X1[t];
+        int ldopA = lda;
+        if (X2[t] != NULL) {
+            combinar_bloques(X1[t], lda, X2[t], lda, sa[t], SA, q, h, q, num_hilos);
+            opA = SA;
+            ldopA = q;
+        }
+        const double* opB = Y1[t];
+        int ldopB = ldb;
+        if (Y2[t] != NULL) {
+            combinar_bloques(Y1[t], ldb, Y2[t], ldb, sb[t], SB, r, q, r, num_hilos);
+            opB = SB;
+            ldopB = r;
+        }
+        strassen_rec(opA, ldopA, opB, ldopB, M, r, h, q, r, niveles - 1, bl, num_hilos, arena);
+        for (int c = 0; c < 4; c++) {
+            if (signos[t][c] != 0.0) {
+                acumular_bloque(cuadrantes[c], ldc, M, r, signos[t][c], h, r, num_hilos);
+            }
+        }
+    }
+
+    arena_restaurar(arena, marca);
+}
+
+/* Multiplicación de Strassen con OpenMP escribiendo en un C del llamador. Las matrices
+ * se rellenan con ceros hasta un múltiplo de 2^niveles si hace falta; todos los
+ * temporales salen de la arena (ver espacio_strassen para su tamaño).
+ */
+static inline void multiplicar_strassen_openmp_en(double** A, double** B, double** C, int filasA, int columnasA,
+                                                  int columnasB, Bloques bl, int corte, int num_hilos, Arena* arena) {
+    int niveles = niveles_strassen(filasA, columnasA, columnasB, corte);
+    int mp = redondear_potencia(filasA, niveles);
+    int kp = redondear_potencia(columnasA, niveles);
+    int np = redondear_potencia(columnasB, niveles);
+
+    if (mp == filasA && kp == columnasA && np == columnasB) {
+        strassen_rec(A[0], columnasA, B[0], columnasB, C[0], columnasB, filasA, columnasA, columnasB,
+                     niveles, bl, num_hilos, arena);
+        return;
+    }
+
+    size_t marca = arena_marca(arena);
+    double* Ap = (double*)arena_reservar(arena, (size_t)mp * kp * sizeof(double));
+    double* Bp = (double*)arena_reservar(arena, (size_t)kp * np * sizeof(double));
+    double* Cp = (double*)arena_reservar(arena, (size_t)mp * np * sizeof(double));
+    if (Ap == NULL || Bp == NULL || Cp == NULL) {
+        fprintf(stderr, "Espacio de trabajo insuficiente para Strassen\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < mp; i++) {
+        for (int j = 0; j < kp; j++) {
+            Ap[(size_t)i * kp + j] = (i < filasA && j < columnasA) ? A[i][j] : 0.0;
+        }
+    }
+    for (int i = 0; i < kp; i++) {
+        for (int j = 0; j < np; j++) {
+            Bp[(size_t)i * np + j] = (i < columnasA && j < columnasB) ? B[i][j] : 0.0;
+        }
+    }
+    strassen_rec(Ap, kp, Bp, np, Cp, np, mp, kp, np, niveles, bl, num_hilos, arena);
+    for (int i = 0; i < filasA; i++) {
+        for (int j = 0; j < columnasB; j++) {
+            C[i][j] = Cp[(size_t)i * np + j];
+        }
+    }
+    arena_restaurar(arena, marca);
+}
+
+#endif /* _OPENMP */
+
+#endif /* MATRICES_STRASSEN_H */
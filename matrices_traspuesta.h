@@ -0,0 +1,245 @@
+/*
+ * matrices_traspuesta.h
+ *
+ * Trasposición por bloques de caché para las matrices de enteros por punteros a
+ * fila de matrices_hilos y matrices_procesos, y producto escalar de filas para el
+ * modo que multiplica A por la traspuesta de B (C[i][j] = A[i] . Bt[j]).
+ *
+ * La matriz se recorre en bloques de TRASPUESTA_BLOQUE x TRASPUESTA_BLOQUE, de modo
+ * que las filas de origen y destino de un bloque siguen en caché mientras se usan.
+ * Dentro de cada bloque se trasponen sub-bloques de TRASPUESTA_MICRO x TRASPUESTA_MICRO
+ * en registros: 8 x 8 con AVX2, 4 x 4 con SSE2 y en C escalar sin ninguno de los dos.
+ * Los bordes que no llenan un sub-bloque se copian elemento a elemento.
+ *
+ * El reparto entre hilos o procesos se hace por franjas de filas de bloque, que
+ * cada trabajador escribe en exclusiva:
+ *   - trasponer_franja: filas [j0, j1) del destino (columnas del origen). Los
+ *     límites de franja_traspuesta caen en bordes de bloque.
+ *   - trasponer_en_sitio_franja: filas de bloque bi con bi % partes == id (reparto
+ *     cíclico, porque la fila bi sólo recorre los bloques bj >= bi). Sólo para
+ *     matrices cuadradas: con punteros a fila una rectangular cambiaría de forma.
+ *
+ * Todas las funciones son static inline, como en matrices_arena.h.
+ */
+
+#ifndef MATRICES_TRASPUESTA_H
+#define MATRICES_TRASPUESTA_H
+
+#include <stddef.h>
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define TRASPUESTA_MICRO 8
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define TRASPUESTA_MICRO 4
+#else
+#define TRASPUESTA_MICRO 4
+#endif
+
+/* Lado del bloque de caché: dos bloques de 64 x 64 enteros (32 KiB) caben en L1/L2 */
+#define TRASPUESTA_BLOQUE 64
+
+/* Sub-bloque en registros: lee las TRASPUESTA_MICRO filas de origen desde la columna
+ * co y las deja traspuestas en las filas de destino desde la columna cd. Carga todo
+ * antes de guardar, así que origen y destino pueden ser el mismo sub-bloque.
+ */
+static inline void trasponer_micro(int* const* origen, int co, int* const* destino, int cd) {
+#if defined(__AVX2__)
+    __m256i r[8], t[8], u[8];
+    for (int f = 0; f < 8; f++) {
+        r[f] = _mm256_loadu_si256((const __m256i*)(origen[f] + co));
+    }
+    for (int f = 0; f < 8; f += 2) {
+        t[f] = _mm256_unpacklo_epi32(r[f], r[f + 1]);
+        t[f + 1] = _mm256_unpackhi_epi32(r[f], r[f + 1]);
+    }
+    for (int f = 0; f < 8; f += 4) {
+        u[f] = _mm256_unpacklo_epi64(t[f], t[f + 2]);
+        u[f + 1] = _mm256_unpackhi_epi64(t[f], t[f + 2]);
+        u[f + 2] = _mm256_unpacklo_epi64(t[f + 1], t[f + 3]);
+        u[f + 3] = _mm256_unpackhi_epi64(t[f + 1], t[f + 3]);
+    }
+    for (int f = 0; f < 4; f++) {
+        r[f] = _mm256_permute2x128_si256(u[f], u[f + 4], 0x20);
+        r[f + 4] = _mm256_permute2x128_si256(u[f], u[f + 4], 0x31);
+    }
+    for (int f = 0; f < 8; f++) {
+        _mm256_storeu_si256((__m256i*)(destino[f] + cd), r[f]);
+    }
+#elif defined(__SSE2__)
+    __m128i r0 = _mm_loadu_si128((const __m128i*)(origen[0] + co));
+    __m128i r1 = _mm_loadu_si128((const __m128i*)(origen[1] + co));
+    __m128i r2 = _mm_loadu_si128((const __m128i*)(origen[2] + co));
+    __m128i r3 = _mm_loadu_si128((const __m128i*)(origen[3] + co));
+    __m128i t0 = _mm_unpacklo_epi32(r0, r1);
+    __m128i t1 = _mm_unpacklo_epi32(r2, r3);
+    __m128i t2 = _mm_unpackhi_epi32(r0, r1);
+    __m128i t3 = _mm_unpackhi_epi32(r2, r3);
+    _mm_storeu_si128((__m128i*)(destino[0] + cd), _mm_unpacklo_epi64(t0, t1));
+    _mm_storeu_si128((__m128i*)(destino[1] + cd), _mm_unpackhi_epi64(t0, t1));
+    _mm_storeu_si128((__m128i*)(destino[2] + cd), _mm_unpacklo_epi64(t2, t3));
+    _mm_storeu_si128((__m128i*)(destino[3] + cd), _mm_unpackhi_epi64(t2, t3));
+#else
+    int r[TRASPUESTA_MICRO][TRASPUESTA_MICRO];
+    for (int f = 0; f < TRASPUESTA_MICRO; f++) {
+        for (int c = 0; c < TRASPUESTA_MICRO; c++) {
+            r[c][f] = origen[f][co + c];
+        }
+    }
+    for (int c = 0; c < TRASPUESTA_MICRO; c++) {
+        for (int f = 0; f < TRASPUESTA_MICRO; f++) {
+            destino[c][cd + f] = r[c][f];
+        }
+    }
+#endif
+}
+
+/* Traspone el bloque de origen [i0, i1) x [j0, j1) en destino [j0, j1) x [i0, i1) */
+static inline void trasponer_bloque(int* const* origen, int* const* destino, int i0, int i1, int j0, int j1) {
+    int i_micro = i0 + (i1 - i0) / TRASPUESTA_MICRO * TRASPUESTA_MICRO;
+    int j_micro = j0 + (j1 - j0) / TRASPUESTA_MICRO * TRASPUESTA_MICRO;
+    for (int i = i0; i < i_micro; i += TRASPUESTA_MICRO) {
+        for (int j = j0; j < j_micro; j += TRASPUESTA_MICRO) {
+            trasponer_micro(origen + i, j, destino + j, i);
+        }
+    }
+    /* Bordes: columnas sobrantes de las filas completas y filas sobrantes */
+    for (int j = j_micro; j < j1; j++) {
+        for (int i = i0; i < i_micro; i++) {
+            destino[j][i] = origen[i][j];
+        }
+    }
+    for (int j = j0; j < j1; j++) {
+        for (int i = i_micro; i < i1; i++) {
+            destino[j][i] = origen[i][j];
+        }
+    }
+}
+
+/* Calcula la franja [*j0, *j1) que le toca al trabajador id de partes al trasponer
+ * una matriz de columnas columnas; los límites caen en bordes de bloque
+ */
+static inline void franja_traspuesta(int columnas, int id, int partes, int* j0, int* j1) {
+    long bloques = (columnas + TRASPUESTA_BLOQUE - 1) / TRASPUESTA_BLOQUE;
+    long b0 = bloques * id / partes, b1 = bloques * (id + 1) / partes;
+    *j0 = (int)(b0 * TRASPUESTA_BLOQUE) < columnas ? (int)(b0 * TRASPUESTA_BLOQUE) : columnas;
+    *j1 = (int)(b1 * TRASPUESTA_BLOQUE) < columnas ? (int)(b1 * TRASPUESTA_BLOQUE) : columnas;
+}
+
+/* destino (columnas x filas) = origen (filas x columnas) traspuesta, sólo las
+ * filas [j0, j1) de destino
+ */
+static inline void trasponer_franja(int* const* origen, int* const* destino, int filas, int columnas,
+                                    int j0, int j1) {
+    if (j1 > columnas) {
+        j1 = columnas;
+    }
+    for (int jb = j0; jb < j1; jb += TRASPUESTA_BLOQUE) {
+        int jb_fin = jb + TRASPUESTA_BLOQUE < j1 ? jb + TRASPUESTA_BLOQUE : j1;
+        for (int ib = 0; ib < filas; ib += TRASPUESTA_BLOQUE) {
+            int ib_fin = ib + TRASPUESTA_BLOQUE < filas ? ib + TRASPUESTA_BLOQUE : filas;
+            trasponer_bloque(origen, destino, ib, ib_fin, jb, jb_fin);
+        }
+    }
+}
+
+/* destino (columnas x filas) = origen (filas x columnas) traspuesta */
+static inline void trasponer(int* const* origen, int* const* destino, int filas, int columnas) {
+    trasponer_franja(origen, destino, filas, columnas, 0, columnas);
+}
+
+/* Intercambia traspuestos los sub-bloques (i, j) y (j, i) de M; con i == j traspone
+ * el sub-bloque en su sitio
+ */
+static inline void intercambiar_micro(int* const* M, int i, int j) {
+    if (i == j) {
+        trasponer_micro(M + i, i, M + i, i);
+        return;
+    }
+    int copia[TRASPUESTA_MICRO][TRASPUESTA_MICRO];
+    int* filas_copia[TRASPUESTA_MICRO];
+    for (int f = 0; f < TRASPUESTA_MICRO; f++) {
+        filas_copia[f] = copia[f];
+        memcpy(copia[f], M[i + f] + j, sizeof(copia[f]));
+    }
+    trasponer_micro(M + j, i, M + i, j);        /* M[i..][j..] = (M[j..][i..])^T */
+    trasponer_micro(filas_copia, 0, M + j, i);  /* M[j..][i..] = (copia)^T */
+}
+
+/* Traspone en su sitio la matriz cuadrada M (n x n), sólo las filas de bloque que
+ * le tocan al trabajador id de partes
+ */
+static inline void trasponer_en_sitio_franja(int* const* M, int n, int id, int partes) {
+    int bloques = (n + TRASPUESTA_BLOQUE - 1) / TRASPUESTA_BLOQUE;
+    for (int bi = id; bi < bloques; bi += partes) {
+        int i0 = bi * TRASPUESTA_BLOQUE;
+        int i1 = i0 + TRASPUESTA_BLOQUE < n ? i0 + TRASPUESTA_BLOQUE : n;
+        int i_micro = i0 + (i1 - i0) / TRASPUESTA_MICRO * TRASPUESTA_MICRO;
+        for (int bj = bi; bj < bloques; bj++) {
+            int j0 = bj * TRASPUESTA_BLOQUE;
+            int j1 = j0 + TRASPUESTA_BLOQUE < n ? j0 + TRASPUESTA_BLOQUE : n;
+            int j_micro = j0 + (j1 - j0) / TRASPUESTA_MICRO * TRASPUESTA_MICRO;
+            /* En el bloque diagonal sólo se recorren los sub-bloques j >= i */
+            for (int i = i0; i < i_micro; i += TRASPUESTA_MICRO) {
+                for (int j = bj == bi ? i : j0; j < j_micro; j += TRASPUESTA_MICRO) {
+                    intercambiar_micro(M, i, j);
+                }
+            }
+            /* Bordes: cada par (i, j) fuera de los sub-bloques se intercambia una vez */
+            for (int i = i0; i < i1; i++) {
+                int j_inicio = i < i_micro ? j_micro : j0;
+                if (bj == bi && j_inicio <= i) {
+                    j_inicio = i + 1;
+                }
+                for (int j = j_inicio; j < j1; j++) {
+                    int tmp = M[i][j];
+                    M[i][j] = M[j][i];
+                    M[j][i] = tmp;
+                }
+            }
+        }
+    }
+}
+
+/* Traspone en su sitio la matriz cuadrada M (n x n) */
+static inline void trasponer_en_sitio(int* const* M, int n) {
+    trasponer_en_sitio_franja(M, n, 0, 1);
+}
+
+/* Producto escalar de a y b (k elementos contiguos); cuatro acumuladores
+ * independientes para que el compilador vectorice la suma
+ */
+static inline int producto_escalar(const int* a, const int* b, int k) {
+    int s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    int p = 0;
+    for (; p + 4 <= k; p += 4) {
+        s0 += a[p] * b[p];
+        s1 += a[p + 1] * b[p + 1];
+        s2 += a[p + 2] * b[p + 2];
+        s3 += a[p + 3] * b[p + 3];
+    }
+    for (; p < k; p++) {
+        s0 += a[p] * b[p];
+    }
+    return (s0 + s1) + (s2 + s3);
+}
+
+/* C[i][j] = A[i] . Bt[j] para las filas [fila_inicio, fila_fin) de C. Se recorren
+ * grupos de TRASPUESTA_BLOQUE filas de Bt para que se reutilicen desde caché en
+ * todas las filas de A del trabajador.
+ */
+static inline void multiplicar_filas_traspuesta(int* const* A, int* const* Bt, int* const* C, int columnasA,
+                                                int columnasB, int fila_inicio, int fila_fin) {
+    for (int jb = 0; jb < columnasB; jb += TRASPUESTA_BLOQUE) {
+        int jb_fin = jb + TRASPUESTA_BLOQUE < columnasB ? jb + TRASPUESTA_BLOQUE : columnasB;
+        for (int i = fila_inicio; i < fila_fin; i++) {
+            for (int j = jb; j < jb_fin; j++) {
+                C[i][j] = producto_escalar(A[i], Bt[j], columnasA);
+            }
+        }
+    }
+}
+
+#endif /* MATRICES_TRASPUESTA_H */
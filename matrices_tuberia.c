@@ -0,0 +1,658 @@
+/*
+ * matrices_tuberia.c
+ *
+ * Procesa un flujo de muchos productos C = A * B solapando la preparación de las
+ * entradas, la multiplicación y la salida. Tres hilos forman una tubería y cada
+ * uno se ocupa de una etapa:
+ *
+ *   cargar       lee A y B de archivos binarios (doubles en crudo, por filas) o las
+ *                genera de forma determinista a partir del número de trabajo
+ *   multiplicar  C = A * B con gemm_bloques_openmp (bloques del perfil) y h hilos
+ *   escribir     guarda C en un archivo binario o, sin destino, calcula su suma
+ *
+ * Las etapas se pasan ranuras (A, B y C de un trabajo) por colas acotadas. Hay
+ * profundidad ranuras por etapa (2 por defecto: doble búfer), de modo que mientras
+ * se multiplica un trabajo ya se está cargando el siguiente y escribiendo el
+ * anterior; cuando una etapa va más deprisa que la siguiente se bloquea en la cola
+ * en lugar de acumular memoria. Los búferes de las ranuras se reutilizan y sólo
+ * se vuelven a reservar si llega un trabajo mayor.
+ *
+ * Manifiesto: una línea por trabajo (las que empiezan por # se ignoran)
+ *
+ *   m k n A B C
+ *       A, B  ruta de un archivo con m x k (k x n) doubles, o - para generarla
+ *       C     ruta donde escribir m x n doubles, o - para no escribir nada
+ *
+ * Al terminar se informa de los trabajos por segundo sostenidos y, por etapa, del
+ * tiempo ocupado, del tiempo esperando entrada (etapa anterior lenta) y del tiempo
+ * esperando salida (etapa siguiente lenta). Con --comparar se ejecutan después los
+ * mismos trabajos uno tras otro, sin solapamiento, como referencia.
+ *
+ * Uso:
+ *   gcc -O3 -march=native matrices_tuberia.c -o matrices_tuberia -fopenmp -pthread -lm
+ *   ./matrices_tuberia -m manifiesto.txt [-h hilos] [-p profundidad] [-c] [-v]
+ *   ./matrices_tuberia -g 200 -n 256 [-h hilos] [-p profundidad] [-c] [-v]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <omp.h>
+#include "matrices_cadena.h"
+#include "matrices_bloques.h"
+
+/* Número de etapas de la tubería */
+#define NUM_ETAPAS 3
+
+/* Longitud máxima de una ruta del manifiesto */
+#define TAM_RUTA 512
+
+/* Filas de C que se comprueban por trabajo con --verificar */
+#define FILAS_VERIFICADAS 4
+
+/* Un trabajo del manifiesto */
+typedef struct {
+    int m, k, n;
+    char A[TAM_RUTA];   /* "-": generada */
+    char B[TAM_RUTA];
+    char C[TAM_RUTA];   /* "-": sólo suma de comprobación */
+} Trabajo;
+
+/* Búferes de un trabajo en vuelo; circulan de una etapa a la siguiente */
+typedef struct {
+    const Trabajo* trabajo;
+    long indice;
+    double* A;
+    double* B;
+    double* C;
+    size_t capA, capB, capC;   /* elementos reservados en cada búfer */
+    double suma;               /* suma de C (salida "-") */
+    double diferencia;         /* diferencia máxima con la referencia (--verificar) */
+    char error[TAM_RUTA + 64];  /* vacío si el trabajo va bien */
+} Ranura;
+
+/* Cola acotada de ranuras entre dos etapas */
+typedef struct {
+    Ranura** elementos;
+    int capacidad;
+    int cabeza;
+    int cantidad;
+    int cerrada;               /* la etapa anterior ya no enviará más */
+    pthread_mutex_t mutex;
+    pthread_cond_t no_vacia;
+    pthread_cond_t no_llena;
+} ColaRanuras;
+
+/* Tiempos de una etapa en segundos */
+typedef struct {
+    double ocupado;
+    double espera_entrada;
+    double espera_salida;
+    long trabajos;
+} TiemposEtapa;
+
+/* Estado compartido por los hilos de la tubería */
+typedef struct {
+    const Trabajo* trabajos;
+    long num_trabajos;
+    ColaRanuras libres;        /* escribir -> cargar */
+    ColaRanuras por_multiplicar;
+    ColaRanuras por_escribir;
+    TiemposEtapa etapas[NUM_ETAPAS];
+    const ModeloCadena* modelo;
+    int num_hilos;
+    int verificar;
+    long fallos;
+    double suma_total;
+    double diferencia_max;
+} Tuberia;
+
+static const char* const nombres_etapa[NUM_ETAPAS] = {"cargar", "multiplicar", "escribir"};
+
+/* Tiempo monótono en segundos */
+double ahora() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void iniciar_cola(ColaRanuras* cola, int capacidad) {
+    cola->elementos = (Ranura**)malloc(capacidad * sizeof(Ranura*));
+    if (cola->elementos == NULL) {
+        fprintf(stderr, "Error en la asignación de memoria para la cola\n");
+        exit(EXIT_FAILURE);
+    }
+    cola->capacidad = capacidad;
+    cola->cabeza = 0;
+    cola->cantidad = 0;
+    cola->cerrada = 0;
+    pthread_mutex_init(&cola->mutex, NULL);
+    pthread_cond_init(&cola->no_vacia, NULL);
+    pthread_cond_init(&cola->no_llena, NULL);
+}
+
+void destruir_cola(ColaRanuras* cola) {
+    free(cola->elementos);
+    pthread_mutex_destroy(&cola->mutex);
+    pthread_cond_destroy(&cola->no_vacia);
+    pthread_cond_destroy(&cola->no_llena);
+}
+
+/* Encola una ranura; bloquea mientras la cola está llena. Suma la espera a *espera. */
+void encolar(ColaRanuras* cola, Ranura* r, double* espera) {
+    double inicio = ahora();
+    pthread_mutex_lock(&cola->mutex);
+    while (cola->cantidad == cola->capacidad) {
+        pthread_cond_wait(&cola->no_llena, &cola->mutex);
+    }
+    cola->elementos[(cola->cabeza + cola->cantidad) % cola->capacidad] = r;
+    cola->cantidad++;
+    pthread_cond_signal(&cola->no_vacia);
+    pthread_mutex_unlock(&cola->mutex);
+    *espera += ahora() - inicio;
+}
+
+/* Retira una ranura; bloquea mientras la cola está vacía. Devuelve NULL si la cola
+ * está vacía y cerrada. Suma la espera a *espera.
+ */
+Ranura* desencolar(ColaRanuras* cola, double* espera) {
+    double inicio = ahora();
+    pthread_mutex_lock(&cola->mutex);
+    while (cola->cantidad == 0 && !cola->cerrada) {
+        pthread_cond_wait(&cola->no_vacia, &cola->mutex);
+    }
+    Ranura* r = NULL;
+    if (cola->cantidad > 0) {
+        r = cola->elementos[cola->cabeza];
+        cola->cabeza = (cola->cabeza + 1) % cola->capacidad;
+        cola->cantidad--;
+        pthread_cond_signal(&cola->no_llena);
+    }
+    pthread_mutex_unlock(&cola->mutex);
+    *espera += ahora() - inicio;
+    return r;
+}
+
+void cerrar_cola(ColaRanuras* cola) {
+    pthread_mutex_lock(&cola->mutex);
+    cola->cerrada = 1;
+    pthread_cond_broadcast(&cola->no_vacia);
+    pthread_mutex_unlock(&cola->mutex);
+}
+
+/* Garantiza que *buf tenga al menos elementos doubles (alineados a 64 bytes) */
+void asegurar_capacidad(double** buf, size_t* cap, size_t elementos) {
+    if (*cap >= elementos) {
+        return;
+    }
+    free(*buf);
+    size_t bytes = (elementos * sizeof(double) + 63) & ~(size_t)63;
+    *buf = (double*)aligned_alloc(64, bytes);
+    if (*buf == NULL) {
+        fprintf(stderr, "Error en la asignación de memoria para una ranura (%zu elementos)\n", elementos);
+        exit(EXIT_FAILURE);
+    }
+    *cap = elementos;
+}
+
+/* Llena un operando generado: valores pequeños que dependen sólo del trabajo y del
+ * operando, para que --verificar y --comparar vean los mismos datos
+ */
+void generar_operando(double* M, size_t elementos, long indice, int operando) {
+    unsigned int semilla = (unsigned int)(indice * 2 + operando + 1) * 2654435761u;
+    for (size_t i = 0; i < elementos; i++) {
+        M[i] = (double)(rand_r(&semilla) % 10);
+    }
+}
+
+/* Lee un operando de un archivo binario; devuelve -1 si no tiene los elementos esperados */
+int leer_operando(const char* ruta, double* M, size_t elementos) {
+    FILE* f = fopen(ruta, "rb");
+    if (f == NULL) {
+        return -1;
+    }
+    size_t leidos = fread(M, sizeof(double), elementos, f);
+    int sobra = fgetc(f) != EOF;
+    fclose(f);
+    return leidos == elementos && !sobra ? 0 : -1;
+}
+
+/* Etapa 1: prepara A y B del trabajo de la ranura */
+void cargar_ranura(Ranura* r) {
+    const Trabajo* t = r->trabajo;
+    size_t elemA = (size_t)t->m * t->k, elemB = (size_t)t->k * t->n;
+    r->error[0] = '\0';
+    asegurar_capacidad(&r->A, &r->capA, elemA);
+    asegurar_capacidad(&r->B, &r->capB, elemB);
+    asegurar_capacidad(&r->C, &r->capC, (size_t)t->m * t->n);
+
+    if (strcmp(t->A, "-") == 0) {
+        generar_operando(r->A, elemA, r->indice, 0);
+    } else if (leer_operando(t->A, r->A, elemA) != 0) {
+        snprintf(r->error, sizeof(r->error), "no se pudo leer A de %s (%d x %d)", t->A, t->m, t->k);
+        return;
+    }
+    if (strcmp(t->B, "-") == 0) {
+        generar_operando(r->B, elemB, r->indice, 1);
+    } else if (leer_operando(t->B, r->B, elemB) != 0) {
+        snprintf(r->error, sizeof(r->error), "no se pudo leer B de %s (%d x %d)", t->B, t->k, t->n);
+    }
+}
+
+/* Etapa 2: C = A * B con los bloques del perfil para la clase del trabajo */
+void multiplicar_ranura(Ranura* r, const ModeloCadena* modelo, int num_hilos) {
+    const Trabajo* t = r->trabajo;
+    if (r->error[0] != '\0') {
+        return;
+    }
+    Bloques bl = modelo->bloques[clase_perfil(t->m, t->k, t->n)];
+    gemm_bloques_openmp(r->A, t->k, r->B, t->n, r->C, t->n, t->m, t->k, t->n, bl, num_hilos);
+}
+
+/* Compara unas pocas filas de C repartidas por la matriz con el producto i-k-j */
+double verificar_ranura(const Ranura* r) {
+    const Trabajo* t = r->trabajo;
+    double max_diff = 0.0;
+    double* fila = (double*)malloc(t->n * sizeof(double));
+    if (fila == NULL) {
+        fprintf(stderr, "Error en la asignación de memoria para la verificación\n");
+        exit(EXIT_FAILURE);
+    }
+    int paso = t->m > FILAS_VERIFICADAS ? t->m / FILAS_VERIFICADAS : 1;
+    for (int i = 0; i < t->m; i += paso) {
+        memset(fila, 0, t->n * sizeof(double));
+        for (int p = 0; p < t->k; p++) {
+            double a = r->A[(size_t)i * t->k + p];
+            const double* b = r->B + (size_t)p * t->n;
+            for (int j = 0; j < t->n; j++) {
+                fila[j] += a * b[j];
+            }
+        }
+        for (int j = 0; j < t->n; j++) {
+            double d = fabs(fila[j] - r->C[(size_t)i * t->n + j]);
+            if (d > max_diff) {
+                max_diff = d;
+            }
+        }
+    }
+    free(fila);
+    return max_diff;
+}
+
+/* Etapa 3: escribe C en su archivo o calcula su suma si no tiene destino */
+void escribir_ranura(Ranura* r, int verificar) {
+    const Trabajo* t = r->trabajo;
+    size_t elemC = (size_t)t->m * t->n;
+    r->suma = 0.0;
+    r->diferencia = 0.0;
+    if (r->error[0] != '\0') {
+        return;
+    }
+    if (verificar) {
+        r->diferencia = verificar_ranura(r);
+    }
+    if (strcmp(t->C, "-") == 0) {
+        for (size_t i = 0; i < elemC; i++) {
+            r->suma += r->C[i];
+        }
+        return;
+    }
+    FILE* f = fopen(t->C, "wb");
+    if (f == NULL || fwrite(r->C, sizeof(double), elemC, f) != elemC) {
+        snprintf(r->error, sizeof(r->error), "no se pudo escribir C en %s", t->C);
+    }
+    if (f != NULL && fclose(f) != 0 && r->error[0] == '\0') {
+        snprintf(r->error, sizeof(r->error), "no se pudo escribir C en %s", t->C);
+    }
+}
+
+/* Acumula el resultado de un trabajo terminado (sólo lo llama la etapa escribir) */
+void contabilizar_ranura(Tuberia* tub, const Ranura* r) {
+    if (r->error[0] != '\0') {
+        fprintf(stderr, "Trabajo %ld: %s\n", r->indice, r->error);
+        tub->fallos++;
+        return;
+    }
+    tub->suma_total += r->suma;
+    if (r->diferencia > tub->diferencia_max) {
+        tub->diferencia_max = r->diferencia;
+    }
+}
+
+void* hilo_cargar(void* arg) {
+    Tuberia* tub = (Tuberia*)arg;
+    TiemposEtapa* e = &tub->etapas[0];
+    for (long i = 0; i < tub->num_trabajos; i++) {
+        Ranura* r = desencolar(&tub->libres, &e->espera_entrada);
+        double inicio = ahora();
+        r->trabajo = &tub->trabajos[i];
+        r->indice = i;
+        cargar_ranura(r);
+        e->ocupado += ahora() - inicio;
+        e->trabajos++;
+        encolar(&tub->por_multiplicar, r, &e->espera_salida);
+    }
+    cerrar_cola(&tub->por_multiplicar);
+    return NULL;
+}
+
+void* hilo_multiplicar(void* arg) {
+    Tuberia* tub = (Tuberia*)arg;
+    TiemposEtapa* e = &tub->etapas[1];
+    Ranura* r;
+    while ((r = desencolar(&tub->por_multiplicar, &e->espera_entrada)) != NULL) {
+        double inicio = ahora();
+        multiplicar_ranura(r, tub->modelo, tub->num_hilos);
+        e->ocupado += ahora() - inicio;
+        e->trabajos++;
+        encolar(&tub->por_escribir, r, &e->espera_salida);
+    }
+    cerrar_cola(&tub->por_escribir);
+    return NULL;
+}
+
+void* hilo_escribir(void* arg) {
+    Tuberia* tub = (Tuberia*)arg;
+    TiemposEtapa* e = &tub->etapas[2];
+    Ranura* r;
+    while ((r = desencolar(&tub->por_escribir, &e->espera_entrada)) != NULL) {
+        double inicio = ahora();
+        escribir_ranura(r, tub->verificar);
+        contabilizar_ranura(tub, r);
+        e->ocupado += ahora() - inicio;
+        e->trabajos++;
+        /* La cola de libres tiene sitio para todas las ranuras: nunca bloquea */
+        encolar(&tub->libres, r, &e->espera_salida);
+    }
+    return NULL;
+}
+
+/* Ejecuta la tubería con profundidad ranuras por etapa; devuelve el tiempo total */
+double ejecutar_tuberia(Tuberia* tub, int profundidad) {
+    int num_ranuras = profundidad * NUM_ETAPAS;
+    Ranura* ranuras = (Ranura*)calloc(num_ranuras, sizeof(Ranura));
+    if (ranuras == NULL) {
+        fprintf(stderr, "Error en la asignación de memoria para las ranuras\n");
+        exit(EXIT_FAILURE);
+    }
+    iniciar_cola(&tub->libres, num_ranuras);
+    iniciar_cola(&tub->por_multiplicar, profundidad);
+    iniciar_cola(&tub->por_escribir, profundidad);
+    double espera = 0.0;
+    for (int s = 0; s < num_ranuras; s++) {
+        encolar(&tub->libres, &ranuras[s], &espera);
+    }
+
+    void* (*funciones[NUM_ETAPAS])(void*) = {hilo_cargar, hilo_multiplicar, hilo_escribir};
+    pthread_t hilos[NUM_ETAPAS];
+    double inicio = ahora();
+    for (int e = 0; e < NUM_ETAPAS; e++) {
+        if (pthread_create(&hilos[e], NULL, funciones[e], tub) != 0) {
+            fprintf(stderr, "Error al crear el hilo de la etapa %s\n", nombres_etapa[e]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (int e = 0; e < NUM_ETAPAS; e++) {
+        pthread_join(hilos[e], NULL);
+    }
+    double tiempo = ahora() - inicio;
+
+    for (int s = 0; s < num_ranuras; s++) {
+        free(ranuras[s].A);
+        free(ranuras[s].B);
+        free(ranuras[s].C);
+    }
+    free(ranuras);
+    destruir_cola(&tub->libres);
+    destruir_cola(&tub->por_multiplicar);
+    destruir_cola(&tub->por_escribir);
+    return tiempo;
+}
+
+/* Los mismos trabajos uno tras otro con una sola ranura, sin solapar etapas */
+double ejecutar_secuencial(Tuberia* tub) {
+    Ranura r;
+    memset(&r, 0, sizeof(r));
+    double inicio = ahora();
+    for (long i = 0; i < tub->num_trabajos; i++) {
+        r.trabajo = &tub->trabajos[i];
+        r.indice = i;
+        cargar_ranura(&r);
+        multiplicar_ranura(&r, tub->modelo, tub->num_hilos);
+        escribir_ranura(&r, tub->verificar);
+        contabilizar_ranura(tub, &r);
+    }
+    double tiempo = ahora() - inicio;
+    free(r.A);
+    free(r.B);
+    free(r.C);
+    return tiempo;
+}
+
+/* Lee el manifiesto; devuelve el número de trabajos o -1 si hay una línea mal formada */
+long leer_manifiesto(const char* ruta, Trabajo** trabajos) {
+    FILE* f = fopen(ruta, "r");
+    if (f == NULL) {
+        fprintf(stderr, "No se pudo abrir el manifiesto %s\n", ruta);
+        return -1;
+    }
+    long num = 0, cap = 64, linea_num = 0;
+    *trabajos = (Trabajo*)malloc(cap * sizeof(Trabajo));
+    char linea[3 * TAM_RUTA + 64];
+    while (*trabajos != NULL && fgets(linea, sizeof(linea), f) != NULL) {
+        linea_num++;
+        char* p = linea + strspn(linea, " \t");
+        if (*p == '#' || *p == '\n' || *p == '\0') {
+            continue;
+        }
+        if (num == cap) {
+            cap *= 2;
+            Trabajo* nuevos = (Trabajo*)realloc(*trabajos, cap * sizeof(Trabajo));
+            if (nuevos == NULL) {
+                break;
+            }
+            *trabajos = nuevos;
+        }
+        Trabajo* t = &(*trabajos)[num];
+        if (sscanf(p, "%d %d %d %511s %511s %511s", &t->m, &t->k, &t->n, t->A, t->B, t->C) != 6
+            || t->m <= 0 || t->k <= 0 || t->n <= 0) {
+            fprintf(stderr, "Manifiesto %s, línea %ld: se esperaba \"m k n A B C\"\n", ruta, linea_num);
+            fclose(f);
+            return -1;
+        }
+        num++;
+    }
+    int sin_memoria = *trabajos == NULL || !feof(f);
+    fclose(f);
+    if (sin_memoria) {
+        fprintf(stderr, "Error en la asignación de memoria para el manifiesto\n");
+        return -1;
+    }
+    return num;
+}
+
+/* Imprime el informe de una ejecución de la tubería */
+void informar_tuberia(const Tuberia* tub, double tiempo, int profundidad) {
+    double flops = 0.0;
+    for (long i = 0; i < tub->num_trabajos; i++) {
+        flops += 2.0 * tub->trabajos[i].m * tub->trabajos[i].k * tub->trabajos[i].n;
+    }
+    printf("Tubería de %ld trabajos con %d ranuras por etapa y %d hilos de multiplicación.\n",
+           tub->num_trabajos, profundidad, tub->num_hilos);
+    printf("- Tiempo total: %.6f segundos\n", tiempo);
+    printf("- Trabajos por segundo: %.2f\n", tub->num_trabajos / tiempo);
+    printf("- Rendimiento: %.3f GFLOP/s\n", flops / tiempo / 1e9);
+    printf("- Etapas (ocupado / esperando entrada / esperando salida):\n");
+    for (int e = 0; e < NUM_ETAPAS; e++) {
+        const TiemposEtapa* t = &tub->etapas[e];
+        printf("  %-12s %5.1f%% / %5.1f%% / %5.1f%%  (%.3f s ocupado, %ld trabajos)\n", nombres_etapa[e],
+               100.0 * t->ocupado / tiempo, 100.0 * t->espera_entrada / tiempo, 100.0 * t->espera_salida / tiempo,
+               t->ocupado, t->trabajos);
+    }
+    int cuello = 0;
+    for (int e = 1; e < NUM_ETAPAS; e++) {
+        if (tub->etapas[e].ocupado > tub->etapas[cuello].ocupado) {
+            cuello = e;
+        }
+    }
+    printf("- Etapa limitante: %s\n", nombres_etapa[cuello]);
+}
+
+/* Función para mostrar ayuda */
+void mostrar_ayuda() {
+    printf("Uso: ./matrices_tuberia (-m manifiesto | -g trabajos [-n dimensión]) [-h hilos] [-p profundidad] [-c] [-v]\n");
+    printf("Opciones:\n");
+    printf("  -m, --manifiesto    Archivo con una línea \"m k n A B C\" por trabajo (- genera A/B u omite C)\n");
+    printf("  -g, --generar       Número de trabajos sintéticos n x n, generados y sin salida\n");
+    printf("  -n, --tamano        Dimensión de los trabajos sintéticos (por defecto: 256)\n");
+    printf("  -h, --hilos         Hilos OpenMP de la etapa de multiplicación (por defecto: 4)\n");
+    printf("  -p, --profundidad   Ranuras por etapa; 2 es doble búfer (por defecto: 2)\n");
+    printf("  -c, --comparar      Ejecutar también los trabajos uno tras otro, sin solapar\n");
+    printf("  -v, --verificar     Comprobar unas filas de cada C contra el producto i-k-j\n");
+    printf("  -a, --ayuda         Mostrar esta ayuda\n");
+}
+
+int main(int argc, char* argv[]) {
+    const char* manifiesto = NULL;
+    long generar = 0;
+    int tam = 256;
+    int num_hilos = 4;
+    int profundidad = 2;
+    int comparar = 0;
+    int verificar = 0;
+
+    static struct option opciones_largas[] = {
+        {"manifiesto", required_argument, 0, 'm'},
+        {"generar", required_argument, 0, 'g'},
+        {"tamano", required_argument, 0, 'n'},
+        {"hilos", required_argument, 0, 'h'},
+        {"profundidad", required_argument, 0, 'p'},
+        {"comparar", no_argument, 0, 'c'},
+        {"verificar", no_argument, 0, 'v'},
+        {"ayuda", no_argument, 0, 'a'},
+        {0, 0, 0, 0}
+    };
+
+    int opcion;
+    while ((opcion = getopt_long(argc, argv, "m:g:n:h:p:cva", opciones_largas, NULL)) != -1) {
+        switch (opcion) {
+            case 'm':
+                manifiesto = optarg;
+                break;
+            case 'g':
+                generar = atol(optarg);
+                if (generar <= 0) {
+                    fprintf(stderr, "El número de trabajos debe ser positivo\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'n':
+                tam = atoi(optarg);
+                if (tam <= 0) {
+                    fprintf(stderr, "La dimensión de las matrices debe ser positiva\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'h':
+                num_hilos = atoi(optarg);
+                if (num_hilos <= 0) {
+                    fprintf(stderr, "El número de hilos debe ser positivo\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'p':
+                profundidad = atoi(optarg);
+                if (profundidad <= 0) {
+                    fprintf(stderr, "La profundidad debe ser positiva\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'c':
+                comparar = 1;
+                break;
+            case 'v':
+                verificar = 1;
+                break;
+            case 'a':
+                mostrar_ayuda();
+                return EXIT_SUCCESS;
+            default:
+                mostrar_ayuda();
+                return EXIT_FAILURE;
+        }
+    }
+    if ((manifiesto == NULL) == (generar == 0)) {
+        fprintf(stderr, "Indique un manifiesto (-m) o un número de trabajos sintéticos (-g), no ambos\n");
+        mostrar_ayuda();
+        return EXIT_FAILURE;
+    }
+
+    Trabajo* trabajos = NULL;
+    long num_trabajos;
+    if (manifiesto != NULL) {
+        num_trabajos = leer_manifiesto(manifiesto, &trabajos);
+        if (num_trabajos < 0) {
+            free(trabajos);
+            return EXIT_FAILURE;
+        }
+        if (num_trabajos == 0) {
+            fprintf(stderr, "El manifiesto %s no contiene trabajos\n", manifiesto);
+            free(trabajos);
+            return EXIT_FAILURE;
+        }
+    } else {
+        num_trabajos = generar;
+        trabajos = (Trabajo*)malloc(num_trabajos * sizeof(Trabajo));
+        if (trabajos == NULL) {
+            fprintf(stderr, "Error en la asignación de memoria para los trabajos\n");
+            return EXIT_FAILURE;
+        }
+        for (long i = 0; i < num_trabajos; i++) {
+            trabajos[i].m = trabajos[i].k = trabajos[i].n = tam;
+            strcpy(trabajos[i].A, "-");
+            strcpy(trabajos[i].B, "-");
+            strcpy(trabajos[i].C, "-");
+        }
+    }
+
+    ModeloCadena modelo;
+    cargar_modelo_cadena(NULL, &modelo);
+
+    Tuberia tub;
+    memset(&tub, 0, sizeof(tub));
+    tub.trabajos = trabajos;
+    tub.num_trabajos = num_trabajos;
+    tub.modelo = &modelo;
+    tub.num_hilos = num_hilos;
+    tub.verificar = verificar;
+
+    double tiempo = ejecutar_tuberia(&tub, profundidad);
+    informar_tuberia(&tub, tiempo, profundidad);
+    printf("- Suma de las C sin destino: %.6e\n", tub.suma_total);
+    if (verificar) {
+        printf("- Diferencia máxima frente al producto i-k-j: %e\n", tub.diferencia_max);
+    }
+    long fallos = tub.fallos;
+    if (fallos > 0) {
+        printf("- Trabajos con error: %ld\n", fallos);
+    }
+
+    if (comparar) {
+        double suma_tuberia = tub.suma_total;
+        tub.suma_total = 0.0;
+        tub.fallos = 0;
+        double secuencial = ejecutar_secuencial(&tub);
+        printf("Sin solapamiento (una ranura, etapas una tras otra):\n");
+        printf("- Tiempo total: %.6f segundos\n", secuencial);
+        printf("- Trabajos por segundo: %.2f\n", num_trabajos / secuencial);
+        printf("- Aceleración de la tubería: %.2fx\n", secuencial / tiempo);
+        printf("- Misma suma que la tubería: %s\n", tub.suma_total == suma_tuberia ? "sí" : "no");
+    }
+
+    free(trabajos);
+    return fallos > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,30 @@
+# Comprueba que matrices_bench detecta una regresión: guarda una referencia en un
+# archivo temporal, la infla (antepone "1000" a cada GFLOP/s) y exige que la
+# comparación termine con código 1 y marque REGRESIÓN.
+#
+#   cmake -DBENCH=<matrices_bench> -DREFERENCIA=<archivo> -P bench_regresion.cmake
+
+set(opciones --casos cuadrada_256,gemv --repeticiones 1 --hilos 2 --referencia ${REFERENCIA})
+file(REMOVE ${REFERENCIA})
+
+execute_process(COMMAND ${BENCH} ${opciones} --guardar RESULT_VARIABLE resultado OUTPUT_VARIABLE salida)
+message("${salida}")
+if(NOT resultado EQUAL 0 OR NOT EXISTS ${REFERENCIA})
+    message(FATAL_ERROR "No se pudo guardar la referencia (código ${resultado})")
+endif()
+
+file(READ ${REFERENCIA} texto)
+string(REGEX MATCHALL "gflops=" medidas "${texto}")
+list(LENGTH medidas num_medidas)
+if(NOT num_medidas EQUAL 4)
+    message(FATAL_ERROR "Se esperaban 4 medidas en la referencia y hay ${num_medidas}")
+endif()
+string(REPLACE "gflops=" "gflops=1000" texto "${texto}")
+file(WRITE ${REFERENCIA} "${texto}")
+
+execute_process(COMMAND ${BENCH} ${opciones} RESULT_VARIABLE resultado OUTPUT_VARIABLE salida)
+message("${salida}")
+if(NOT resultado EQUAL 1 OR NOT salida MATCHES "REGRESIÓN")
+    message(FATAL_ERROR "La referencia inflada no se detectó como regresión (código ${resultado})")
+endif()
+file(REMOVE ${REFERENCIA})
@@ -0,0 +1,46 @@
+# Ejecuta un programa y comprueba el error que imprime frente a su referencia.
+#
+#   cmake -DPATRON=<regex> -DTOLERANCIA=<x> -P comprobar_salida.cmake -- <programa> [argumentos...]
+#
+# PATRON debe capturar en su primer grupo un número (admite notación científica);
+# la prueba falla si el programa termina con error, si ninguna línea casa con
+# PATRON o si alguno de los números capturados supera TOLERANCIA.
+
+if(NOT DEFINED PATRON OR NOT DEFINED TOLERANCIA)
+    message(FATAL_ERROR "Faltan -DPATRON y -DTOLERANCIA")
+endif()
+
+# Lo que sigue a "--" es la orden a ejecutar
+set(orden "")
+set(en_orden FALSE)
+math(EXPR ultimo "${CMAKE_ARGC} - 1")
+foreach(i RANGE ${ultimo})
+    if(en_orden)
+        list(APPEND orden "${CMAKE_ARGV${i}}")
+    elseif(CMAKE_ARGV${i} STREQUAL "--")
+        set(en_orden TRUE)
+    endif()
+endforeach()
+if(NOT orden)
+    message(FATAL_ERROR "Falta la orden a ejecutar después de --")
+endif()
+
+execute_process(COMMAND ${orden}
+                OUTPUT_VARIABLE salida
+                ERROR_VARIABLE errores
+                RESULT_VARIABLE resultado)
+message("${salida}${errores}")
+if(NOT resultado EQUAL 0)
+    message(FATAL_ERROR "La orden terminó con código ${resultado}")
+endif()
+
+string(REGEX MATCHALL "${PATRON}" coincidencias "${salida}")
+if(NOT coincidencias)
+    message(FATAL_ERROR "Ninguna línea de la salida casa con: ${PATRON}")
+endif()
+foreach(linea IN LISTS coincidencias)
+    string(REGEX REPLACE "${PATRON}" "\\1" valor "${linea}")
+    if(NOT valor LESS_EQUAL TOLERANCIA)
+        message(FATAL_ERROR "Error ${valor} por encima de la tolerancia ${TOLERANCIA}: ${linea}")
+    endif()
+endforeach()
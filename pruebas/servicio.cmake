@@ -0,0 +1,28 @@
+# Arranca matrices_servicio y, a la vez, su cliente de prueba con --detener: el
+# cliente envía peticiones MUL (y verifica la última), pide METRICAS y termina el
+# servicio con SALIR. La prueba falla si cualquiera de los dos termina con error
+# o si el servicio no se detiene (límite de tiempo de la prueba).
+#
+#   cmake -DSERVICIO=<matrices_servicio> -DSOCKET=<ruta> -P servicio.cmake
+
+# Las dos órdenes se ejecutan a la vez; el cliente reintenta la conexión hasta que
+# el servicio escucha. La salida del servicio va a la entrada del cliente, que no
+# la lee; la que se comprueba es la del cliente.
+execute_process(COMMAND ${SERVICIO} -s ${SOCKET} -h 2
+                COMMAND ${SERVICIO} -s ${SOCKET} --cliente -n 48 -r 200 --detener
+                RESULTS_VARIABLE resultados
+                OUTPUT_VARIABLE salida
+                ERROR_VARIABLE errores)
+message("${salida}${errores}")
+if(NOT resultados STREQUAL "0;0")
+    message(FATAL_ERROR "Servicio y cliente terminaron con códigos ${resultados}")
+endif()
+if(NOT salida MATCHES "Peticiones MUL 48x48: 200 \\(0 errores\\)")
+    message(FATAL_ERROR "El cliente no completó las peticiones MUL")
+endif()
+if(NOT salida MATCHES "Diferencia máxima frente al cálculo local: 0\\.000000e\\+00")
+    message(FATAL_ERROR "El resultado del servicio difiere del cálculo local")
+endif()
+if(NOT salida MATCHES "Métricas del servicio: trabajos=200 ")
+    message(FATAL_ERROR "METRICAS no informa de los 200 trabajos")
+endif()